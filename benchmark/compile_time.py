@@ -0,0 +1,157 @@
+import os
+import sys
+import json
+import time
+import shutil
+import argparse
+import subprocess
+import tempfile
+
+def create_argument_parser():
+    DEFAULT_SETS="10,100,400"
+    DEFAULT_FLAGS="8,32,60"
+
+    parser = argparse.ArgumentParser(description='Measure compile time of generated flag sets')
+
+    parser.add_argument(
+        "-c", "--compiler",
+        default=os.environ.get('CXX', 'c++'), type=str,
+        help='C++ compiler (default: %(default)s)',
+        metavar='COMPILER', dest='compiler'
+    )
+
+    parser.add_argument(
+        "-i", "--include-dir",
+        default=os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'include'), type=str,
+        help='Path to bitflags include directory (default: %(default)s)',
+        metavar='INCLUDE_DIR', dest='include_dir'
+    )
+
+    parser.add_argument(
+        "-s", "--sets",
+        default=DEFAULT_SETS, type=str,
+        help='Comma separated numbers of flag sets (default: %(default)s)',
+        metavar='SETS', dest='sets'
+    )
+
+    parser.add_argument(
+        "-f", "--flags",
+        default=DEFAULT_FLAGS, type=str,
+        help='Comma separated numbers of flags per set (default: %(default)s)',
+        metavar='FLAGS', dest='flags'
+    )
+
+    parser.add_argument(
+        "--std",
+        default=17, type=int,
+        help='C++ standard (default: %(default)s)'
+    )
+
+    parser.add_argument(
+        "-r", "--repetitions",
+        default=3, type=int,
+        help='Number of compilations per configuration (default: %(default)s)'
+    )
+
+    parser.add_argument(
+        "-t", "--time-trace",
+        action='store_true',
+        help='Keep -ftime-trace output next to the generated sources (Clang only)'
+    )
+
+    parser.add_argument(
+        "-o", "--output",
+        default='compile_time_benchmark.json', type=str,
+        help='Output file in Google Benchmark JSON format (default: %(default)s)'
+    )
+
+    return parser
+
+def generate_source(sets, flags, raw):
+    begin, flag, end = ('BEGIN_RAW_BITFLAGS', 'RAW_FLAG', 'END_RAW_BITFLAGS') if raw \
+        else ('BEGIN_BITFLAGS', 'FLAG', 'END_BITFLAGS')
+
+    lines = [ '#include <bitflags/bitflags.hpp>', '' ]
+    for s in range(sets):
+        lines.append('{}(Flags{})'.format(begin, s))
+        lines.append('    {}(none)'.format(flag))
+        for f in range(flags):
+            lines.append('    {}(flag_{})'.format(flag, f))
+        lines.append('{}(Flags{})'.format(end, s))
+        lines.append('')
+
+    # use every set, so that the whole bitflags class is instantiated
+    lines.append('int main() {')
+    lines.append('    int result = 0;')
+    for s in range(sets):
+        lines.append('    Flags{0} flags{0}(Flags{0}::flag_0);'.format(s))
+        lines.append('    result += flags{0}.contains(Flags{0}::flag_{1}) ? 1 : 0;'.format(s, flags - 1))
+    lines.append('    return result;')
+    lines.append('}')
+
+    return '\n'.join(lines) + '\n'
+
+def compile_source(args, source_path, object_path):
+    command = [
+        args.compiler, '-std=c++{}'.format(args.std), '-fsyntax-only' if not args.time_trace else '-c',
+        '-I', args.include_dir, source_path
+    ]
+    if args.time_trace:
+        command += [ '-ftime-trace', '-o', object_path ]
+
+    start = time.perf_counter()
+    process = subprocess.Popen(command)
+    _, status, usage = os.wait4(process.pid, 0)
+    elapsed = time.perf_counter() - start
+    process.returncode = -os.WTERMSIG(status) if os.WIFSIGNALED(status) else os.WEXITSTATUS(status)
+
+    if process.returncode != 0:
+        raise subprocess.CalledProcessError(process.returncode, command)
+
+    return elapsed, usage.ru_utime + usage.ru_stime, usage.ru_maxrss
+
+if __name__ == "__main__":
+    parser = create_argument_parser()
+    args = parser.parse_args()
+
+    sets = [ int(s) for s in args.sets.split(',') ]
+    flags = [ int(f) for f in args.flags.split(',') ]
+
+    benchmarks = []
+    work_dir = tempfile.mkdtemp(prefix='bitflags_compile_time_')
+
+    try:
+        for raw in [ True, False ]:
+            for s in sets:
+                for f in flags:
+                    name = '{}/sets:{}/flags:{}'.format('raw_bitflags' if raw else 'bitflags', s, f)
+                    source_path = os.path.join(work_dir, name.replace('/', '_').replace(':', '') + '.cpp')
+                    object_path = source_path[:-4] + '.o'
+
+                    with open(source_path, encoding='utf-8', mode='w') as source_file:
+                        source_file.write(generate_source(s, f, raw))
+
+                    for repetition in range(args.repetitions):
+                        elapsed, cpu, max_rss = compile_source(args, source_path, object_path)
+                        benchmarks.append({
+                            'name': name,
+                            'run_name': name,
+                            'run_type': 'iteration',
+                            'repetition_index': repetition,
+                            'real_time': elapsed * 1e3,
+                            'cpu_time': cpu * 1e3,
+                            'time_unit': 'ms',
+                            'max_rss_kb': max_rss
+                        })
+                        print('{:<36} {:>10.1f} ms {:>10.1f} ms cpu {:>8.1f} MB'.format(name, elapsed * 1e3, cpu * 1e3, max_rss / 1024.0))
+                        sys.stdout.flush()
+    finally:
+        # generated sources are kept only for the time traces next to them
+        if not args.time_trace:
+            shutil.rmtree(work_dir, ignore_errors=True)
+
+    with open(args.output, encoding='utf-8', mode='w') as output_file:
+        json.dump({ 'context': { 'compiler': args.compiler, 'std': args.std }, 'benchmarks': benchmarks }, output_file, indent=2)
+
+    if args.time_trace:
+        print('Time traces are in {}'.format(work_dir))
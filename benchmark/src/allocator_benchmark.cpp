@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <bitflags/arena.hpp>
+#include <bitflags/counted_flags.hpp>
+#include <bitflags/flags_map.hpp>
+#include <bitflags/mask_matcher.hpp>
+
+#include "perf_counters.hpp"
+
+#if defined(_MSC_VER)
+#    define REPLACEMENT __declspec(noinline)
+#else
+#    define REPLACEMENT __attribute__((noinline))
+#endif
+
+// every allocation made through the global operator new is counted,
+// replacements are kept out of line so that the compiler does not
+// pair the inlined malloc and free with the new and delete expressions
+static std::atomic<std::size_t> allocations_count{ 0 };
+
+REPLACEMENT void* operator new(std::size_t const size) {
+    allocations_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* const ptr = std::malloc(size != 0 ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+REPLACEMENT void operator delete(void* const ptr) noexcept {
+    std::free(ptr);
+}
+
+REPLACEMENT void operator delete(void* const ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+// over-aligned allocations, e.g. of the standard memory resources
+REPLACEMENT void* operator new(std::size_t const size, std::align_val_t const alignment) {
+    allocations_count.fetch_add(1, std::memory_order_relaxed);
+    std::size_t const align = static_cast<std::size_t>(alignment);
+#if defined(_MSC_VER)
+    if (void* const ptr = _aligned_malloc(size != 0 ? size : 1, align)) {
+#else
+    if (void* const ptr = std::aligned_alloc(align, (size + align) / align * align)) {
+#endif
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+REPLACEMENT void operator delete(void* const ptr, std::align_val_t) noexcept {
+#if defined(_MSC_VER)
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+REPLACEMENT void operator delete(void* const ptr, std::size_t, std::align_val_t const alignment) noexcept {
+    operator delete(ptr, alignment);
+}
+
+BEGIN_RAW_BITFLAGS(Flags)
+    RAW_FLAG(none)
+    RAW_FLAG(flag_a)
+    RAW_FLAG(flag_b)
+    RAW_FLAG(flag_c)
+    RAW_FLAG(flag_d)
+    RAW_FLAG(flag_e)
+    RAW_FLAG(flag_f)
+    RAW_FLAG(flag_g)
+    RAW_FLAG(flag_h)
+    RAW_FLAG(flag_i)
+    RAW_FLAG(flag_j)
+    RAW_FLAG(flag_k)
+    RAW_FLAG(flag_l)
+    RAW_FLAG(flag_m)
+    RAW_FLAG(flag_n)
+    RAW_FLAG(flag_o)
+END_RAW_BITFLAGS(Flags)
+
+namespace {
+
+// allocators used by the containers of a single request
+struct heap_memory {
+    template <typename T>
+    using allocator = std::allocator<T>;
+
+    template <typename T>
+    allocator<T> get() noexcept { return allocator<T>(); }
+
+    void reset() noexcept {}
+};
+
+template <typename ArenaT>
+struct arena_memory {
+    template <typename T>
+    using allocator = bf::arena_allocator<T, ArenaT>;
+
+    template <typename T>
+    allocator<T> get() noexcept { return allocator<T>(arena); }
+
+    void reset() noexcept { arena.reset(); }
+
+    ArenaT arena;
+};
+
+#if BITFLAGS_HAS_PMR
+struct pmr_memory {
+    template <typename T>
+    using allocator = std::pmr::polymorphic_allocator<T>;
+
+    template <typename T>
+    allocator<T> get() noexcept { return allocator<T>(&resource); }
+
+    void reset() noexcept { resource.release(); }
+
+    std::pmr::monotonic_buffer_resource resource;
+};
+#endif
+
+std::vector<Flags> random_events(std::size_t const count) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<unsigned> distribution(0, Flags::all().bits);
+
+    std::vector<Flags> events;
+    events.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        events.push_back(Flags(static_cast<Flags::underlying_type>(distribution(generator))));
+    }
+    return events;
+}
+
+// per-request structures: the events with their counters, the number
+// of occurrences of each combination of flags, the distinct
+// combinations and the filters matched by each event
+template <typename MemoryT>
+std::size_t handle_request(MemoryT& memory, std::vector<Flags> const& events) {
+    using id_type = std::size_t;
+
+    bf::counted_flags<Flags, typename MemoryT::template allocator<Flags>> counted(memory.template get<Flags>());
+    bf::flags_map<Flags, int, typename MemoryT::template allocator<int>> occurrences(memory.template get<int>());
+    bf::flags_set<Flags, typename MemoryT::template allocator<Flags>> distinct(memory.template get<Flags>());
+    bf::mask_matcher<Flags, typename MemoryT::template allocator<Flags>> matcher(memory.template get<Flags>());
+    std::vector<id_type, typename MemoryT::template allocator<id_type>> matched(memory.template get<id_type>());
+
+    for (unsigned i = 0; i < 16; ++i) {
+        matcher.add(Flags(static_cast<Flags::underlying_type>(1U << i)), Flags(static_cast<Flags::underlying_type>(1U << ((i + 1) % 16))));
+    }
+
+    for (Flags const& event : events) {
+        counted.push_back(event);
+        ++occurrences[event];
+        distinct.insert(event);
+        matcher.match(event, matched);
+    }
+
+    return counted.count(Flags::flag_a) + occurrences.size() + distinct.size() + matched.size();
+}
+
+} // namespace
+
+template <typename MemoryT>
+void Request(benchmark::State& state) {
+    std::vector<Flags> const events = random_events(static_cast<std::size_t>(state.range(0)));
+    MemoryT memory;
+
+    bench::perf_counters counters(state);
+    std::size_t const before = allocations_count.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(handle_request(memory, events));
+        memory.reset();
+    }
+    std::size_t const allocations = allocations_count.load(std::memory_order_relaxed) - before;
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["allocs_per_request"] = static_cast<double>(allocations) / static_cast<double>(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(Request, heap_memory)->ArgName("events")->Arg(16)->Arg(256);
+BENCHMARK_TEMPLATE(Request, arena_memory<bf::bump_arena>)->ArgName("events")->Arg(16)->Arg(256);
+BENCHMARK_TEMPLATE(Request, arena_memory<bf::pool_arena>)->ArgName("events")->Arg(16)->Arg(256);
+#if BITFLAGS_HAS_PMR
+BENCHMARK_TEMPLATE(Request, pmr_memory)->ArgName("events")->Arg(16)->Arg(256);
+#endif
+
+BENCHMARK_MAIN();
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <bitflags/dispatch_table.hpp>
+
+#include "perf_counters.hpp"
+
+BEGIN_RAW_BITFLAGS(Flags)
+    RAW_FLAG(none)
+    RAW_FLAG(flag_a)
+    RAW_FLAG(flag_b)
+    RAW_FLAG(flag_c)
+    RAW_FLAG(flag_d)
+    RAW_FLAG(flag_e)
+END_RAW_BITFLAGS(Flags)
+
+#if defined(_MSC_VER)
+#    define HANDLER __declspec(noinline)
+#else
+#    define HANDLER __attribute__((noinline))
+#endif
+
+namespace {
+
+constexpr std::size_t inputs_count = 4096;
+
+// handlers are never inlined, the same as real protocol handlers
+
+HANDLER int on_none(int x) { return x; }
+HANDLER int on_a(int x) { return x + 1; }
+HANDLER int on_b(int x) { return x * 2; }
+HANDLER int on_a_c(int x) { return x - 3; }
+HANDLER int on_d(int x) { return x ^ 5; }
+HANDLER int on_e(int x) { return x >> 1; }
+
+using handler_type = int(*)(int);
+
+constexpr handler_type select_handler(Flags const& flags) {
+    if (flags.contains(Flags::flag_a, Flags::flag_c)) {
+        return &on_a_c;
+    } else if (flags & Flags::flag_a) {
+        return &on_a;
+    } else if (flags & Flags::flag_b) {
+        return &on_b;
+    } else if (flags & Flags::flag_d) {
+        return &on_d;
+    } else if (flags & Flags::flag_e) {
+        return &on_e;
+    }
+    return &on_none;
+}
+
+std::vector<Flags> random_inputs() {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<unsigned> distribution(0, Flags::all().bits);
+
+    std::vector<Flags> inputs;
+    inputs.reserve(inputs_count);
+    for (std::size_t i = 0; i < inputs_count; ++i) {
+        inputs.emplace_back(static_cast<Flags::underlying_type>(distribution(generator)));
+    }
+    return inputs;
+}
+
+} // namespace
+
+void Branchy(benchmark::State& state) {
+    std::vector<Flags> const inputs = random_inputs();
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        int result = 0;
+        for (auto const& flags : inputs) {
+            if (flags.contains(Flags::flag_a, Flags::flag_c)) {
+                result = on_a_c(result);
+            } else if (flags & Flags::flag_a) {
+                result = on_a(result);
+            } else if (flags & Flags::flag_b) {
+                result = on_b(result);
+            } else if (flags & Flags::flag_d) {
+                result = on_d(result);
+            } else if (flags & Flags::flag_e) {
+                result = on_e(result);
+            } else {
+                result = on_none(result);
+            }
+        }
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(inputs.size()));
+}
+
+BENCHMARK(Branchy);
+
+void DispatchTable(benchmark::State& state) {
+    std::vector<Flags> const inputs = random_inputs();
+    static constexpr bf::dispatch_table<Flags, int(int)> table{ &select_handler };
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        int result = 0;
+        for (auto const& flags : inputs) {
+            result = table(flags, result);
+        }
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(inputs.size()));
+}
+
+BENCHMARK(DispatchTable);
+
+BENCHMARK_MAIN();
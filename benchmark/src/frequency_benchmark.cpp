@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <bitflags/frequency.hpp>
+
+#include "perf_counters.hpp"
+
+BEGIN_RAW_BITFLAGS(Flags8)
+    RAW_FLAG(none)
+    RAW_FLAG(flag_0)
+    RAW_FLAG(flag_1)
+    RAW_FLAG(flag_2)
+    RAW_FLAG(flag_3)
+    RAW_FLAG(flag_4)
+    RAW_FLAG(flag_5)
+    RAW_FLAG(flag_6)
+END_RAW_BITFLAGS(Flags8)
+
+BEGIN_RAW_BITFLAGS(Flags32)
+    RAW_FLAG(none)
+    RAW_FLAG(flag_0)
+    RAW_FLAG(flag_1)
+    RAW_FLAG(flag_2)
+    RAW_FLAG(flag_3)
+    RAW_FLAG(flag_4)
+    RAW_FLAG(flag_5)
+    RAW_FLAG(flag_6)
+    RAW_FLAG(flag_7)
+    RAW_FLAG(flag_8)
+    RAW_FLAG(flag_9)
+    RAW_FLAG(flag_10)
+    RAW_FLAG(flag_11)
+    RAW_FLAG(flag_12)
+    RAW_FLAG(flag_13)
+    RAW_FLAG(flag_14)
+    RAW_FLAG(flag_15)
+    RAW_FLAG(flag_16)
+    RAW_FLAG(flag_17)
+    RAW_FLAG(flag_18)
+    RAW_FLAG(flag_19)
+    RAW_FLAG(flag_20)
+    RAW_FLAG(flag_21)
+    RAW_FLAG(flag_22)
+    RAW_FLAG(flag_23)
+END_RAW_BITFLAGS(Flags32)
+
+BEGIN_RAW_BITFLAGS(Flags64)
+    RAW_FLAG(none)
+    RAW_FLAG(flag_0)
+    RAW_FLAG(flag_1)
+    RAW_FLAG(flag_2)
+    RAW_FLAG(flag_3)
+    RAW_FLAG(flag_4)
+    RAW_FLAG(flag_5)
+    RAW_FLAG(flag_6)
+    RAW_FLAG(flag_7)
+    RAW_FLAG(flag_8)
+    RAW_FLAG(flag_9)
+    RAW_FLAG(flag_10)
+    RAW_FLAG(flag_11)
+    RAW_FLAG(flag_12)
+    RAW_FLAG(flag_13)
+    RAW_FLAG(flag_14)
+    RAW_FLAG(flag_15)
+    RAW_FLAG(flag_16)
+    RAW_FLAG(flag_17)
+    RAW_FLAG(flag_18)
+    RAW_FLAG(flag_19)
+    RAW_FLAG(flag_20)
+    RAW_FLAG(flag_21)
+    RAW_FLAG(flag_22)
+    RAW_FLAG(flag_23)
+    RAW_FLAG(flag_24)
+    RAW_FLAG(flag_25)
+    RAW_FLAG(flag_26)
+    RAW_FLAG(flag_27)
+    RAW_FLAG(flag_28)
+    RAW_FLAG(flag_29)
+    RAW_FLAG(flag_30)
+    RAW_FLAG(flag_31)
+    RAW_FLAG(flag_32)
+    RAW_FLAG(flag_33)
+    RAW_FLAG(flag_34)
+    RAW_FLAG(flag_35)
+    RAW_FLAG(flag_36)
+    RAW_FLAG(flag_37)
+    RAW_FLAG(flag_38)
+    RAW_FLAG(flag_39)
+    RAW_FLAG(flag_40)
+    RAW_FLAG(flag_41)
+    RAW_FLAG(flag_42)
+    RAW_FLAG(flag_43)
+    RAW_FLAG(flag_44)
+    RAW_FLAG(flag_45)
+    RAW_FLAG(flag_46)
+    RAW_FLAG(flag_47)
+    RAW_FLAG(flag_48)
+    RAW_FLAG(flag_49)
+    RAW_FLAG(flag_50)
+    RAW_FLAG(flag_51)
+    RAW_FLAG(flag_52)
+    RAW_FLAG(flag_53)
+    RAW_FLAG(flag_54)
+    RAW_FLAG(flag_55)
+    RAW_FLAG(flag_56)
+    RAW_FLAG(flag_57)
+    RAW_FLAG(flag_58)
+    RAW_FLAG(flag_59)
+END_RAW_BITFLAGS(Flags64)
+
+namespace {
+
+constexpr std::size_t inputs_count = 1 << 16;
+
+// skewed stream of distinct sets of flags, as seen in real traffic
+template <typename BitflagsT>
+std::vector<BitflagsT> random_inputs(int const width, std::uint64_t const distinct) {
+    std::mt19937_64 generator(42);
+    std::vector<typename BitflagsT::underlying_type> values(distinct);
+    for (auto& value : values) {
+        value = static_cast<typename BitflagsT::underlying_type>(generator() & ((std::uint64_t{1} << width) - 1));
+    }
+
+    std::vector<BitflagsT> inputs;
+    inputs.reserve(inputs_count);
+    for (std::size_t i = 0; i < inputs_count; ++i) {
+        std::uint64_t const r = generator() % distinct;
+        inputs.emplace_back(values[(r * r) / distinct]);
+    }
+    return inputs;
+}
+
+template <typename BitflagsT, int Width>
+void UnorderedMap(benchmark::State& state) {
+    std::vector<BitflagsT> const inputs = random_inputs<BitflagsT>(Width, 4096);
+    std::unordered_map<typename BitflagsT::underlying_type, std::uint64_t> counts;
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        for (auto const& flags : inputs) {
+            ++counts[flags.bits()];
+        }
+        benchmark::DoNotOptimize(counts.size());
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(inputs.size()));
+}
+
+template <typename BitflagsT, int Width>
+void FrequencyTracker(benchmark::State& state) {
+    std::vector<BitflagsT> const inputs = random_inputs<BitflagsT>(Width, 4096);
+    bf::frequency_tracker<BitflagsT> tracker;
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        tracker.add(inputs.begin(), inputs.end());
+        benchmark::DoNotOptimize(tracker.total());
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(inputs.size()));
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(UnorderedMap, Flags8, 7);
+BENCHMARK_TEMPLATE(FrequencyTracker, Flags8, 7);
+BENCHMARK_TEMPLATE(UnorderedMap, Flags32, 24);
+BENCHMARK_TEMPLATE(FrequencyTracker, Flags32, 24);
+BENCHMARK_TEMPLATE(UnorderedMap, Flags64, 60);
+BENCHMARK_TEMPLATE(FrequencyTracker, Flags64, 60);
+
+BENCHMARK_MAIN();
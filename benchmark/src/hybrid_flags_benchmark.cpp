@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <bitflags/hybrid_flags.hpp>
+
+#include "perf_counters.hpp"
+
+namespace {
+
+constexpr std::size_t universe = 4096;
+constexpr std::size_t entities_count = 1024;
+
+using hybrid_type = bf::hybrid_flags<universe>;
+using dense_type  = bf::dynamic_flags<universe>;
+
+// flags of each entity are either scattered randomly over the universe
+// or clustered within a few runs of consecutive flags
+std::vector<std::vector<std::size_t>> random_entities(std::size_t const cardinality, bool const clustered) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<std::size_t> bit(0, universe - 1);
+
+    std::vector<std::vector<std::size_t>> entities(entities_count);
+    for (auto& bits : entities) {
+        if (clustered) {
+            std::size_t const runs = std::max<std::size_t>(1, cardinality / 64);
+            for (std::size_t r = 0; r < runs; ++r) {
+                std::size_t const first = bit(generator) % (universe - cardinality / runs);
+                for (std::size_t i = 0; i < cardinality / runs; ++i) {
+                    bits.push_back(first + i);
+                }
+            }
+        } else {
+            for (std::size_t i = 0; i < cardinality; ++i) {
+                bits.push_back(bit(generator));
+            }
+        }
+    }
+    return entities;
+}
+
+std::vector<std::size_t> random_queries(std::size_t const count) {
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<std::size_t> bit(0, universe - 1);
+
+    std::vector<std::size_t> queries(count);
+    for (auto& query : queries) {
+        query = bit(generator);
+    }
+    return queries;
+}
+
+template <typename SetT>
+std::vector<SetT> make_sets(std::vector<std::vector<std::size_t>> const& entities);
+
+template <>
+std::vector<hybrid_type> make_sets(std::vector<std::vector<std::size_t>> const& entities) {
+    std::vector<hybrid_type> sets(entities.size());
+    for (std::size_t i = 0; i < entities.size(); ++i) {
+        for (std::size_t const bit : entities[i]) {
+            sets[i].set(bit);
+        }
+    }
+    return sets;
+}
+
+template <>
+std::vector<dense_type> make_sets(std::vector<std::vector<std::size_t>> const& entities) {
+    std::vector<dense_type> sets(entities.size());
+    for (std::size_t i = 0; i < entities.size(); ++i) {
+        for (std::size_t const bit : entities[i]) {
+            sets[i].set(dense_type::flag_type(bit, ""));
+        }
+    }
+    return sets;
+}
+
+bool contains(hybrid_type const& set, std::size_t const bit) { return set.contains(bit); }
+bool contains(dense_type const& set, std::size_t const bit) { return set.contains(dense_type::flag_type(bit, "")); }
+
+std::size_t heap_bytes(hybrid_type const& set) {
+    switch (set.kind()) {
+    case bf::representation::sparse: return 0;
+    case bf::representation::dense:  return universe / 8;
+    default: {
+        std::size_t runs = 0;
+        std::size_t last = universe;
+        set.for_each_bit([&runs, &last](std::size_t const bit) {
+            runs += bit != last + 1 ? 1 : 0;
+            last = bit;
+        });
+        return runs * 8;
+    }
+    }
+}
+
+std::size_t heap_bytes(dense_type const&) { return 0; }
+
+template <typename SetT>
+void set_bytes(benchmark::State& state, std::vector<SetT> const& sets) {
+    std::size_t bytes = 0;
+    for (auto const& set : sets) {
+        bytes += sizeof(SetT) + heap_bytes(set);
+    }
+    state.counters["bytes_per_set"] = static_cast<double>(bytes) / static_cast<double>(sets.size());
+}
+
+} // namespace
+
+template <typename SetT>
+void Contains(benchmark::State& state) {
+    std::vector<SetT> const sets = make_sets<SetT>(random_entities(static_cast<std::size_t>(state.range(0)), state.range(1) != 0));
+    std::vector<std::size_t> const queries = random_queries(64);
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        std::size_t found = 0;
+        for (auto const& set : sets) {
+            for (std::size_t const query : queries) {
+                found += contains(set, query) ? 1 : 0;
+            }
+        }
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(sets.size() * queries.size()));
+    set_bytes(state, sets);
+}
+
+template <typename SetT>
+void Union(benchmark::State& state) {
+    std::vector<SetT> const sets = make_sets<SetT>(random_entities(static_cast<std::size_t>(state.range(0)), state.range(1) != 0));
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i + 1 < sets.size(); i += 2) {
+            SetT result = sets[i] | sets[i + 1];
+            benchmark::DoNotOptimize(result);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(sets.size() / 2));
+}
+
+template <typename SetT>
+void Intersection(benchmark::State& state) {
+    std::vector<SetT> const sets = make_sets<SetT>(random_entities(static_cast<std::size_t>(state.range(0)), state.range(1) != 0));
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i + 1 < sets.size(); i += 2) {
+            SetT result = sets[i] & sets[i + 1];
+            benchmark::DoNotOptimize(result);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(sets.size() / 2));
+}
+
+// cardinalities of typical entities (a few flags), of heavy ones and of
+// those clustered within runs, e.g. all the flags of a product tier
+void cardinalities(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({ "cardinality", "clustered" });
+    for (int const cardinality : { 4, 10, 64, 1024 }) {
+        benchmark->Args({ cardinality, 0 });
+    }
+    for (int const cardinality : { 256, 1024 }) {
+        benchmark->Args({ cardinality, 1 });
+    }
+}
+
+BENCHMARK_TEMPLATE(Contains, hybrid_type)->Apply(cardinalities);
+BENCHMARK_TEMPLATE(Contains, dense_type)->Apply(cardinalities);
+BENCHMARK_TEMPLATE(Union, hybrid_type)->Apply(cardinalities);
+BENCHMARK_TEMPLATE(Union, dense_type)->Apply(cardinalities);
+BENCHMARK_TEMPLATE(Intersection, hybrid_type)->Apply(cardinalities);
+BENCHMARK_TEMPLATE(Intersection, dense_type)->Apply(cardinalities);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <benchmark/benchmark.h>
+#include <bitflags/instrumentation.hpp>
+#include <bitflags/tracing.hpp>
+
+BEGIN_RAW_BITFLAGS(Flags)
+    RAW_FLAG(none)
+    RAW_FLAG(flag_a)
+    RAW_FLAG(flag_b)
+    RAW_FLAG(flag_c)
+END_RAW_BITFLAGS(Flags)
+
+// Overhead of the instrumentation policies per modification
+
+template <typename FlagsT>
+void Toggle(benchmark::State& state) {
+    FlagsT flags;
+
+    for (auto _ : state) {
+        flags.toggle(Flags::flag_a);
+        benchmark::DoNotOptimize(flags);
+    }
+}
+
+BENCHMARK_TEMPLATE(Toggle, Flags);
+BENCHMARK_TEMPLATE(Toggle, bf::instrumented<Flags>);
+BENCHMARK_TEMPLATE(Toggle, bf::traced<Flags>);
+
+template <typename FlagsT>
+void Contains(benchmark::State& state) {
+    FlagsT flags(Flags::flag_a);
+
+    for (auto _ : state) {
+        bool const contains = flags.contains(Flags::flag_b);
+        benchmark::DoNotOptimize(flags);
+        benchmark::DoNotOptimize(contains);
+    }
+}
+
+BENCHMARK_TEMPLATE(Contains, Flags);
+BENCHMARK_TEMPLATE(Contains, bf::instrumented<Flags>);
+BENCHMARK_TEMPLATE(Contains, bf::traced<Flags>);
+
+BENCHMARK_MAIN();
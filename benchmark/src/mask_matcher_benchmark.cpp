@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <bitflags/mask_matcher.hpp>
+
+#include "perf_counters.hpp"
+
+BEGIN_RAW_BITFLAGS(Flags)
+    RAW_FLAG(none)
+    RAW_FLAG(flag_a)
+    RAW_FLAG(flag_b)
+    RAW_FLAG(flag_c)
+    RAW_FLAG(flag_d)
+    RAW_FLAG(flag_e)
+    RAW_FLAG(flag_f)
+    RAW_FLAG(flag_g)
+    RAW_FLAG(flag_h)
+    RAW_FLAG(flag_i)
+    RAW_FLAG(flag_j)
+    RAW_FLAG(flag_k)
+    RAW_FLAG(flag_l)
+END_RAW_BITFLAGS(Flags)
+
+namespace {
+
+struct filter {
+    Flags required;
+    Flags forbidden;
+};
+
+// each filter requires and forbids a couple of random flags
+std::vector<filter> random_filters(std::size_t const count) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> bit(0, 11);
+
+    std::vector<filter> filters;
+    filters.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        Flags::underlying_type const required = static_cast<Flags::underlying_type>((1U << bit(generator)) | (1U << bit(generator)));
+        Flags::underlying_type const forbidden = static_cast<Flags::underlying_type>((1U << bit(generator)) & ~required);
+        filters.push_back(filter{ required, forbidden });
+    }
+    return filters;
+}
+
+std::vector<Flags> random_events(std::size_t const count) {
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<unsigned> distribution(0, Flags::all().bits);
+
+    std::vector<Flags> events;
+    events.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        events.emplace_back(static_cast<Flags::underlying_type>(distribution(generator)));
+    }
+    return events;
+}
+
+} // namespace
+
+void Build(benchmark::State& state) {
+    std::vector<filter> const filters = random_filters(static_cast<std::size_t>(state.range(0)));
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        bf::mask_matcher<Flags> matcher;
+        for (auto const& f : filters) {
+            matcher.add(f.required, f.forbidden);
+        }
+        benchmark::DoNotOptimize(matcher);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(Build)->RangeMultiplier(8)->Range(1 << 9, 1 << 18);
+
+void Update(benchmark::State& state) {
+    std::vector<filter> const filters = random_filters(static_cast<std::size_t>(state.range(0)));
+
+    bf::mask_matcher<Flags> matcher;
+    for (auto const& f : filters) {
+        matcher.add(f.required, f.forbidden);
+    }
+
+    std::size_t id = 0;
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        filter const& f = filters[(id * 7) % filters.size()];
+        matcher.update(id, f.required, f.forbidden);
+        id = id + 1 == filters.size() ? 0 : id + 1;
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(Update)->RangeMultiplier(8)->Range(1 << 9, 1 << 18);
+
+void LinearMatch(benchmark::State& state) {
+    std::vector<filter> const filters = random_filters(static_cast<std::size_t>(state.range(0)));
+    std::vector<Flags> const events = random_events(64);
+
+    std::vector<std::size_t> matched;
+    matched.reserve(filters.size());
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        for (auto const& event : events) {
+            matched.clear();
+            for (std::size_t i = 0; i < filters.size(); ++i) {
+                if ((event & filters[i].required) == filters[i].required && !(event & filters[i].forbidden)) {
+                    matched.push_back(i);
+                }
+            }
+            benchmark::DoNotOptimize(matched.data());
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(events.size()));
+}
+
+BENCHMARK(LinearMatch)->RangeMultiplier(8)->Range(1 << 9, 1 << 18);
+
+void IndexedMatch(benchmark::State& state) {
+    std::vector<filter> const filters = random_filters(static_cast<std::size_t>(state.range(0)));
+    std::vector<Flags> const events = random_events(64);
+
+    bf::mask_matcher<Flags> matcher;
+    for (auto const& f : filters) {
+        matcher.add(f.required, f.forbidden);
+    }
+
+    std::vector<std::size_t> matched;
+    matched.reserve(filters.size());
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        for (auto const& event : events) {
+            matched.clear();
+            matcher.match(event, matched);
+            benchmark::DoNotOptimize(matched.data());
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(events.size()));
+}
+
+BENCHMARK(IndexedMatch)->RangeMultiplier(8)->Range(1 << 9, 1 << 18);
+
+BENCHMARK_MAIN();
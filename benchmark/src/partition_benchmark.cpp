@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <bitflags/partition.hpp>
+
+#include "perf_counters.hpp"
+
+BEGIN_RAW_BITFLAGS(Flags)
+    RAW_FLAG(none)
+    RAW_FLAG(flag_0)
+    RAW_FLAG(flag_1)
+    RAW_FLAG(flag_2)
+    RAW_FLAG(flag_3)
+    RAW_FLAG(flag_4)
+    RAW_FLAG(flag_5)
+    RAW_FLAG(flag_6)
+    RAW_FLAG(flag_7)
+    RAW_FLAG(flag_8)
+    RAW_FLAG(flag_9)
+END_RAW_BITFLAGS(Flags)
+
+namespace {
+
+struct record {
+    Flags flags;
+    std::uint32_t id;
+};
+
+struct flags_of {
+    Flags const& operator()(record const& r) const { return r.flags; }
+};
+
+std::vector<record> random_records(std::size_t const count) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<unsigned> distribution(0, Flags::all().bits);
+
+    std::vector<record> records(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        records[i].flags = Flags(static_cast<Flags::underlying_type>(distribution(generator)));
+        records[i].id = static_cast<std::uint32_t>(i);
+    }
+    return records;
+}
+
+bool key_less(record const& lhs, record const& rhs) {
+    return lhs.flags.bits() < rhs.flags.bits();
+}
+
+} // namespace
+
+void StdSort(benchmark::State& state) {
+    std::vector<record> const records = random_records(static_cast<std::size_t>(state.range(0)));
+    std::vector<record> out(records.size());
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        std::copy(records.begin(), records.end(), out.begin());
+        std::sort(out.begin(), out.end(), &key_less);
+        benchmark::DoNotOptimize(out.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(StdSort)->Range(1 << 12, 1 << 22);
+
+void StdStableSort(benchmark::State& state) {
+    std::vector<record> const records = random_records(static_cast<std::size_t>(state.range(0)));
+    std::vector<record> out(records.size());
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        std::copy(records.begin(), records.end(), out.begin());
+        std::stable_sort(out.begin(), out.end(), &key_less);
+        benchmark::DoNotOptimize(out.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(StdStableSort)->Range(1 << 12, 1 << 22);
+
+void RadixScatter(benchmark::State& state) {
+    std::vector<record> const records = random_records(static_cast<std::size_t>(state.range(0)));
+    std::vector<record> out(records.size());
+    bf::radix_partition<Flags> partition;
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        partition.scatter(records.data(), records.size(), flags_of{}, out.data());
+        benchmark::DoNotOptimize(out.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(RadixScatter)->Range(1 << 12, 1 << 22);
+
+void RadixPermutation(benchmark::State& state) {
+    std::vector<record> const records = random_records(static_cast<std::size_t>(state.range(0)));
+    std::vector<std::uint32_t> perm(records.size());
+    bf::radix_partition<Flags> partition;
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        partition.permutation(records.data(), records.size(), flags_of{}, perm.data());
+        benchmark::DoNotOptimize(perm.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(RadixPermutation)->Range(1 << 12, 1 << 22);
+
+// selected flags, keys compressed by pext
+void RadixScatterSelected(benchmark::State& state) {
+    std::vector<record> const records = random_records(static_cast<std::size_t>(state.range(0)));
+    std::vector<record> out(records.size());
+    bf::radix_partition<Flags, 0x0155> partition;
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        partition.scatter(records.data(), records.size(), flags_of{}, out.data());
+        benchmark::DoNotOptimize(out.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(RadixScatterSelected)->Range(1 << 12, 1 << 22);
+
+void RadixScatterParallel(benchmark::State& state) {
+    std::vector<record> const records = random_records(static_cast<std::size_t>(state.range(0)));
+    std::vector<record> out(records.size());
+    bf::radix_partition<Flags> partition(std::max(1U, std::thread::hardware_concurrency()));
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        partition.scatter(records.data(), records.size(), flags_of{}, out.data());
+        benchmark::DoNotOptimize(out.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(RadixScatterParallel)->Range(1 << 18, 1 << 22)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_BENCHMARK_PERF_COUNTERS_HPP
+#define BITFLAGS_BENCHMARK_PERF_COUNTERS_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <benchmark/benchmark.h>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace bench {
+
+/**
+ * Collects hardware performance counters around the benchmark loop and
+ * reports them per iteration as Google Benchmark user counters:
+ *
+ *   - cycles, instructions and IPC
+ *   - branch-misses
+ *   - L1D and LLC read misses
+ *   - cycles spent in AVX frequency licenses 1 and 2 (Intel CPUs with
+ *     AVX-512 only)
+ *
+ * Counters are collected via Linux perf_event_open. Counters that can't
+ * be opened (e.g. not supported by the CPU, running in a VM or not
+ * permitted by kernel.perf_event_paranoid) are silently left out, so
+ * on other platforms or without permissions benchmarks report only the
+ * wall time. Setting BITFLAGS_PERF_COUNTERS=0 in environment turns the
+ * collection off.
+ *
+ * Usage:
+ *
+ *     void Benchmark(benchmark::State& state) {
+ *         // setup
+ *         bench::perf_counters counters(state);
+ *         for (auto _ : state) {
+ *             // measured code
+ *         }
+ *     } // counters are reported here
+ */
+class perf_counters {
+public:
+    explicit perf_counters(benchmark::State& state)
+        : state_(state)
+        , count_(0)
+    {
+#if defined(__linux__)
+        if (!enabled()) {
+            return;
+        }
+
+        open("cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        open("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        open("branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        open("l1d_misses", PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_L1D));
+        open("llc_misses", PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_LL));
+
+    #if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+        if (__builtin_cpu_is("intel") && __builtin_cpu_supports("avx512f")) {
+            // CORE_POWER.LVL1_TURBO_LICENSE and CORE_POWER.LVL2_TURBO_LICENSE
+            open("avx_license1_cycles", PERF_TYPE_RAW, 0x1828);
+            open("avx_license2_cycles", PERF_TYPE_RAW, 0x2028);
+        }
+    #endif
+
+        if (count_ == 0) {
+            warn();
+        }
+
+        for (std::size_t i = 0; i < count_; ++i) {
+            ioctl(counters_[i].fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(counters_[i].fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    ~perf_counters() {
+#if defined(__linux__)
+        for (std::size_t i = 0; i < count_; ++i) {
+            ioctl(counters_[i].fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+
+        double cycles = 0;
+        double instructions = 0;
+
+        for (std::size_t i = 0; i < count_; ++i) {
+            double const value = read(counters_[i].fd);
+            close(counters_[i].fd);
+
+            if (value < 0) {
+                continue;
+            }
+
+            state_.counters[counters_[i].name] = benchmark::Counter(value, benchmark::Counter::kAvgIterations);
+
+            if (std::strcmp(counters_[i].name, "cycles") == 0) {
+                cycles = value;
+            } else if (std::strcmp(counters_[i].name, "instructions") == 0) {
+                instructions = value;
+            }
+        }
+
+        if (cycles > 0 && instructions > 0) {
+            state_.counters["IPC"] = instructions / cycles;
+        }
+#endif
+    }
+
+    perf_counters(perf_counters const&) = delete;
+    perf_counters& operator=(perf_counters const&) = delete;
+
+private:
+#if defined(__linux__)
+    static bool enabled() {
+        char const* value = std::getenv("BITFLAGS_PERF_COUNTERS");
+        return value == nullptr || std::strcmp(value, "0") != 0;
+    }
+
+    static void warn() {
+        static bool warned = false;
+        if (!warned) {
+            warned = true;
+            std::fprintf(
+                stderr,
+                "perf_counters: hardware counters are not available, "
+                "check /proc/sys/kernel/perf_event_paranoid\n"
+            );
+        }
+    }
+
+    static std::uint64_t cache_miss(std::uint64_t const cache) {
+        return cache
+            | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+
+    void open(char const* name, std::uint32_t const type, std::uint64_t const config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        int const fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (fd >= 0) {
+            counters_[count_++] = counter{ name, fd };
+        }
+    }
+
+    // reads the counter value scaled for the time it was multiplexed,
+    // returns negative value if the counter didn't run at all
+    static double read(int const fd) {
+        std::uint64_t values[3] = { 0, 0, 0 };
+        if (::read(fd, values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)) || values[2] == 0) {
+            return -1;
+        }
+        return static_cast<double>(values[0]) * static_cast<double>(values[1]) / static_cast<double>(values[2]);
+    }
+
+    struct counter {
+        char const* name;
+        int fd;
+    };
+
+    counter counters_[8];
+#endif
+
+    benchmark::State& state_;
+    std::size_t count_;
+};
+
+} // namespace bench
+
+#endif // BITFLAGS_BENCHMARK_PERF_COUNTERS_HPP
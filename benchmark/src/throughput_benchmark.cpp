@@ -0,0 +1,648 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <bitflags/bitflags.hpp>
+
+#include "perf_counters.hpp"
+
+// Flag sets covering all the underlying widths. Number of flags is
+// the maximum one that still fits into the given underlying type.
+
+BEGIN_RAW_BITFLAGS(RawFlags8)
+    RAW_FLAG(none)
+    RAW_FLAG(flag_0)
+    RAW_FLAG(flag_1)
+    RAW_FLAG(flag_2)
+    RAW_FLAG(flag_3)
+    RAW_FLAG(flag_4)
+END_RAW_BITFLAGS(RawFlags8)
+
+BEGIN_BITFLAGS(Flags8)
+    FLAG(none)
+    FLAG(flag_0)
+    FLAG(flag_1)
+    FLAG(flag_2)
+    FLAG(flag_3)
+    FLAG(flag_4)
+END_BITFLAGS(Flags8)
+
+BEGIN_RAW_BITFLAGS(RawFlags16)
+    RAW_FLAG(none)
+    RAW_FLAG(flag_0)
+    RAW_FLAG(flag_1)
+    RAW_FLAG(flag_2)
+    RAW_FLAG(flag_3)
+    RAW_FLAG(flag_4)
+    RAW_FLAG(flag_5)
+    RAW_FLAG(flag_6)
+    RAW_FLAG(flag_7)
+    RAW_FLAG(flag_8)
+    RAW_FLAG(flag_9)
+    RAW_FLAG(flag_10)
+    RAW_FLAG(flag_11)
+    RAW_FLAG(flag_12)
+END_RAW_BITFLAGS(RawFlags16)
+
+BEGIN_BITFLAGS(Flags16)
+    FLAG(none)
+    FLAG(flag_0)
+    FLAG(flag_1)
+    FLAG(flag_2)
+    FLAG(flag_3)
+    FLAG(flag_4)
+    FLAG(flag_5)
+    FLAG(flag_6)
+    FLAG(flag_7)
+    FLAG(flag_8)
+    FLAG(flag_9)
+    FLAG(flag_10)
+    FLAG(flag_11)
+    FLAG(flag_12)
+END_BITFLAGS(Flags16)
+
+BEGIN_RAW_BITFLAGS(RawFlags32)
+    RAW_FLAG(none)
+    RAW_FLAG(flag_0)
+    RAW_FLAG(flag_1)
+    RAW_FLAG(flag_2)
+    RAW_FLAG(flag_3)
+    RAW_FLAG(flag_4)
+    RAW_FLAG(flag_5)
+    RAW_FLAG(flag_6)
+    RAW_FLAG(flag_7)
+    RAW_FLAG(flag_8)
+    RAW_FLAG(flag_9)
+    RAW_FLAG(flag_10)
+    RAW_FLAG(flag_11)
+    RAW_FLAG(flag_12)
+    RAW_FLAG(flag_13)
+    RAW_FLAG(flag_14)
+    RAW_FLAG(flag_15)
+    RAW_FLAG(flag_16)
+    RAW_FLAG(flag_17)
+    RAW_FLAG(flag_18)
+    RAW_FLAG(flag_19)
+    RAW_FLAG(flag_20)
+    RAW_FLAG(flag_21)
+    RAW_FLAG(flag_22)
+    RAW_FLAG(flag_23)
+    RAW_FLAG(flag_24)
+    RAW_FLAG(flag_25)
+    RAW_FLAG(flag_26)
+    RAW_FLAG(flag_27)
+    RAW_FLAG(flag_28)
+END_RAW_BITFLAGS(RawFlags32)
+
+BEGIN_BITFLAGS(Flags32)
+    FLAG(none)
+    FLAG(flag_0)
+    FLAG(flag_1)
+    FLAG(flag_2)
+    FLAG(flag_3)
+    FLAG(flag_4)
+    FLAG(flag_5)
+    FLAG(flag_6)
+    FLAG(flag_7)
+    FLAG(flag_8)
+    FLAG(flag_9)
+    FLAG(flag_10)
+    FLAG(flag_11)
+    FLAG(flag_12)
+    FLAG(flag_13)
+    FLAG(flag_14)
+    FLAG(flag_15)
+    FLAG(flag_16)
+    FLAG(flag_17)
+    FLAG(flag_18)
+    FLAG(flag_19)
+    FLAG(flag_20)
+    FLAG(flag_21)
+    FLAG(flag_22)
+    FLAG(flag_23)
+    FLAG(flag_24)
+    FLAG(flag_25)
+    FLAG(flag_26)
+    FLAG(flag_27)
+    FLAG(flag_28)
+END_BITFLAGS(Flags32)
+
+BEGIN_RAW_BITFLAGS(RawFlags64)
+    RAW_FLAG(none)
+    RAW_FLAG(flag_0)
+    RAW_FLAG(flag_1)
+    RAW_FLAG(flag_2)
+    RAW_FLAG(flag_3)
+    RAW_FLAG(flag_4)
+    RAW_FLAG(flag_5)
+    RAW_FLAG(flag_6)
+    RAW_FLAG(flag_7)
+    RAW_FLAG(flag_8)
+    RAW_FLAG(flag_9)
+    RAW_FLAG(flag_10)
+    RAW_FLAG(flag_11)
+    RAW_FLAG(flag_12)
+    RAW_FLAG(flag_13)
+    RAW_FLAG(flag_14)
+    RAW_FLAG(flag_15)
+    RAW_FLAG(flag_16)
+    RAW_FLAG(flag_17)
+    RAW_FLAG(flag_18)
+    RAW_FLAG(flag_19)
+    RAW_FLAG(flag_20)
+    RAW_FLAG(flag_21)
+    RAW_FLAG(flag_22)
+    RAW_FLAG(flag_23)
+    RAW_FLAG(flag_24)
+    RAW_FLAG(flag_25)
+    RAW_FLAG(flag_26)
+    RAW_FLAG(flag_27)
+    RAW_FLAG(flag_28)
+    RAW_FLAG(flag_29)
+    RAW_FLAG(flag_30)
+    RAW_FLAG(flag_31)
+    RAW_FLAG(flag_32)
+    RAW_FLAG(flag_33)
+    RAW_FLAG(flag_34)
+    RAW_FLAG(flag_35)
+    RAW_FLAG(flag_36)
+    RAW_FLAG(flag_37)
+    RAW_FLAG(flag_38)
+    RAW_FLAG(flag_39)
+    RAW_FLAG(flag_40)
+    RAW_FLAG(flag_41)
+    RAW_FLAG(flag_42)
+    RAW_FLAG(flag_43)
+    RAW_FLAG(flag_44)
+    RAW_FLAG(flag_45)
+    RAW_FLAG(flag_46)
+    RAW_FLAG(flag_47)
+    RAW_FLAG(flag_48)
+    RAW_FLAG(flag_49)
+    RAW_FLAG(flag_50)
+    RAW_FLAG(flag_51)
+    RAW_FLAG(flag_52)
+    RAW_FLAG(flag_53)
+    RAW_FLAG(flag_54)
+    RAW_FLAG(flag_55)
+    RAW_FLAG(flag_56)
+    RAW_FLAG(flag_57)
+    RAW_FLAG(flag_58)
+    RAW_FLAG(flag_59)
+    RAW_FLAG(flag_60)
+END_RAW_BITFLAGS(RawFlags64)
+
+BEGIN_BITFLAGS(Flags64)
+    FLAG(none)
+    FLAG(flag_0)
+    FLAG(flag_1)
+    FLAG(flag_2)
+    FLAG(flag_3)
+    FLAG(flag_4)
+    FLAG(flag_5)
+    FLAG(flag_6)
+    FLAG(flag_7)
+    FLAG(flag_8)
+    FLAG(flag_9)
+    FLAG(flag_10)
+    FLAG(flag_11)
+    FLAG(flag_12)
+    FLAG(flag_13)
+    FLAG(flag_14)
+    FLAG(flag_15)
+    FLAG(flag_16)
+    FLAG(flag_17)
+    FLAG(flag_18)
+    FLAG(flag_19)
+    FLAG(flag_20)
+    FLAG(flag_21)
+    FLAG(flag_22)
+    FLAG(flag_23)
+    FLAG(flag_24)
+    FLAG(flag_25)
+    FLAG(flag_26)
+    FLAG(flag_27)
+    FLAG(flag_28)
+    FLAG(flag_29)
+    FLAG(flag_30)
+    FLAG(flag_31)
+    FLAG(flag_32)
+    FLAG(flag_33)
+    FLAG(flag_34)
+    FLAG(flag_35)
+    FLAG(flag_36)
+    FLAG(flag_37)
+    FLAG(flag_38)
+    FLAG(flag_39)
+    FLAG(flag_40)
+    FLAG(flag_41)
+    FLAG(flag_42)
+    FLAG(flag_43)
+    FLAG(flag_44)
+    FLAG(flag_45)
+    FLAG(flag_46)
+    FLAG(flag_47)
+    FLAG(flag_48)
+    FLAG(flag_49)
+    FLAG(flag_50)
+    FLAG(flag_51)
+    FLAG(flag_52)
+    FLAG(flag_53)
+    FLAG(flag_54)
+    FLAG(flag_55)
+    FLAG(flag_56)
+    FLAG(flag_57)
+    FLAG(flag_58)
+    FLAG(flag_59)
+    FLAG(flag_60)
+END_BITFLAGS(Flags64)
+
+namespace {
+
+static_assert(sizeof(RawFlags8::underlying_type) == 1, "RawFlags8 should be 8-bit");
+static_assert(sizeof(RawFlags16::underlying_type) == 2, "RawFlags16 should be 16-bit");
+static_assert(sizeof(RawFlags32::underlying_type) == 4, "RawFlags32 should be 32-bit");
+static_assert(sizeof(RawFlags64::underlying_type) == 8, "RawFlags64 should be 64-bit");
+
+constexpr std::int64_t min_working_set = std::int64_t{1} << 14; // fits into L1
+constexpr std::int64_t max_working_set = std::int64_t{1} << 28; // well beyond LLC
+
+/**
+ * Fills the vector with random words.
+ */
+template <typename T>
+std::vector<T> random_words(std::size_t const count) {
+    std::mt19937_64 generator(42);
+    std::vector<T> words(count);
+    for (auto& word : words) {
+        word = static_cast<T>(generator());
+    }
+    return words;
+}
+
+/**
+ * Number of bits set in the given word.
+ */
+template <typename T>
+int popcount(T const word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(static_cast<unsigned long long>(word));
+#else
+    return static_cast<int>(std::bitset<64>(static_cast<unsigned long long>(word)).count());
+#endif
+}
+
+/**
+ * Number of entities of the model within the working set given in
+ * bytes, rounded down to the power of 2.
+ */
+std::size_t entities_count(std::int64_t const working_set, std::size_t const entity_bytes) {
+    std::size_t const count = static_cast<std::size_t>(working_set) / entity_bytes;
+    std::size_t power = 1;
+    while (power * 2 <= count) {
+        power *= 2;
+    }
+    return power;
+}
+
+/**
+ * Models of a set of flags per entity. Each model provides the same
+ * operations over the array of entities, using the highest declared
+ * flag as the probe and the lowest one as the second flag.
+ */
+
+template <typename FlagsT>
+struct bitflags_model {
+    using underlying_type = typename FlagsT::underlying_type;
+
+    static constexpr std::size_t entity_bytes = sizeof(FlagsT);
+
+    explicit bitflags_model(std::size_t const count)
+        : probe(bf::declared_flags<FlagsT>()[bf::declared_flags<FlagsT>().size() - 1])
+        , other(bf::declared_flags<FlagsT>()[1])
+    {
+        for (auto const word : random_words<underlying_type>(count)) {
+            values.emplace_back(word);
+        }
+    }
+
+    std::size_t size() const { return values.size(); }
+
+    void set(std::size_t const i) { values[i].set(probe); }
+    void set_other(std::size_t const i) { values[i].set(other); }
+    void remove_other(std::size_t const i) { values[i].remove(other); }
+    bool test(std::size_t const i) const { return values[i].contains(probe); }
+    int count(std::size_t const i) const { return popcount(values[i].bits()); }
+
+    typename FlagsT::flag_type probe;
+    typename FlagsT::flag_type other;
+    std::vector<FlagsT> values;
+};
+
+template <std::size_t Bits>
+struct bitset_model {
+    using word_type = bf::internal::min_t<Bits>;
+
+    static constexpr std::size_t entity_bytes = sizeof(std::bitset<Bits>);
+
+    explicit bitset_model(std::size_t const count) {
+        for (auto const word : random_words<word_type>(count)) {
+            values.emplace_back(static_cast<unsigned long long>(word));
+        }
+    }
+
+    std::size_t size() const { return values.size(); }
+
+    void set(std::size_t const i) { values[i].set(Bits - 1); }
+    void set_other(std::size_t const i) { values[i].set(0); }
+    void remove_other(std::size_t const i) { values[i].reset(0); }
+    bool test(std::size_t const i) const { return values[i].test(Bits - 1); }
+    int count(std::size_t const i) const { return static_cast<int>(values[i].count()); }
+
+    std::vector<std::bitset<Bits>> values;
+};
+
+template <std::size_t Bits>
+struct enum_class_model {
+    using underlying_type = bf::internal::min_t<Bits>;
+
+    enum class flags : underlying_type {
+        other = 1,
+        probe = static_cast<underlying_type>(underlying_type{1} << (Bits - 1))
+    };
+
+    static constexpr std::size_t entity_bytes = sizeof(flags);
+
+    static underlying_type raw(flags const f) { return static_cast<underlying_type>(f); }
+
+    explicit enum_class_model(std::size_t const count) {
+        for (auto const word : random_words<underlying_type>(count)) {
+            values.push_back(static_cast<flags>(word));
+        }
+    }
+
+    std::size_t size() const { return values.size(); }
+
+    void set(std::size_t const i) { values[i] = static_cast<flags>(raw(values[i]) | raw(flags::probe)); }
+    void set_other(std::size_t const i) { values[i] = static_cast<flags>(raw(values[i]) | raw(flags::other)); }
+    void remove_other(std::size_t const i) { values[i] = static_cast<flags>(raw(values[i]) & ~raw(flags::other)); }
+    bool test(std::size_t const i) const { return raw(values[i]) & raw(flags::probe); }
+    int count(std::size_t const i) const { return popcount(raw(values[i])); }
+
+    std::vector<flags> values;
+};
+
+template <std::size_t Bits>
+struct vector_bool_model {
+    // vector<bool> packs bits, so an entity occupies Bits / 8 bytes
+    static constexpr std::size_t entity_bytes = Bits / 8;
+
+    explicit vector_bool_model(std::size_t const count)
+        : values(count * Bits)
+    {
+        std::mt19937 generator(42);
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            values[i] = generator() & 1U;
+        }
+    }
+
+    std::size_t size() const { return values.size() / Bits; }
+
+    void set(std::size_t const i) { values[i * Bits + Bits - 1] = true; }
+    void set_other(std::size_t const i) { values[i * Bits] = true; }
+    void remove_other(std::size_t const i) { values[i * Bits] = false; }
+    bool test(std::size_t const i) const { return values[i * Bits + Bits - 1]; }
+
+    int count(std::size_t const i) const {
+        int total = 0;
+        for (std::size_t bit = 0; bit < Bits; ++bit) {
+            total += values[i * Bits + bit];
+        }
+        return total;
+    }
+
+    std::vector<bool> values;
+};
+
+/**
+ * Access patterns over the array of entities. Random access visits
+ * all the entities exactly once in a pseudo-random order by applying
+ * a bijective hash to the index.
+ */
+
+struct sequential {
+    static constexpr char const* name = "sequential";
+
+    explicit sequential(std::size_t) {}
+
+    std::size_t operator()(std::size_t const i) const { return i; }
+};
+
+struct random {
+    static constexpr char const* name = "random";
+
+    explicit random(std::size_t const count)
+        : mask(count - 1)
+        , shift(0)
+    {
+        while ((std::size_t{1} << shift) < count) {
+            ++shift;
+        }
+        shift = shift / 2 + 1;
+    }
+
+    std::size_t operator()(std::size_t const i) const {
+        std::size_t x = (i * 0x9E3779B97F4A7C15ULL) & mask;
+        x ^= x >> shift;
+        return (x * 0xBF58476D1CE4E5B9ULL) & mask;
+    }
+
+    std::size_t mask;
+    unsigned shift;
+};
+
+template <typename ModelT>
+void report(benchmark::State& state, ModelT const& model) {
+    auto const items = state.iterations() * static_cast<std::int64_t>(model.size());
+    state.SetItemsProcessed(items);
+    state.SetBytesProcessed(items * static_cast<std::int64_t>(ModelT::entity_bytes));
+}
+
+/**
+ * Operations
+ */
+
+template <typename ModelT, typename AccessT>
+void Set(benchmark::State& state) {
+    ModelT model(entities_count(state.range(0), ModelT::entity_bytes));
+    AccessT const access(model.size());
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < model.size(); ++i) {
+            model.set(access(i));
+        }
+        benchmark::ClobberMemory();
+    }
+
+    report(state, model);
+}
+
+template <typename ModelT, typename AccessT>
+void Test(benchmark::State& state) {
+    ModelT model(entities_count(state.range(0), ModelT::entity_bytes));
+    AccessT const access(model.size());
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        std::size_t matched = 0;
+        for (std::size_t i = 0; i < model.size(); ++i) {
+            matched += model.test(access(i));
+        }
+        benchmark::DoNotOptimize(matched);
+    }
+
+    report(state, model);
+}
+
+template <typename ModelT, typename AccessT>
+void Count(benchmark::State& state) {
+    ModelT model(entities_count(state.range(0), ModelT::entity_bytes));
+    AccessT const access(model.size());
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < model.size(); ++i) {
+            total += static_cast<std::size_t>(model.count(access(i)));
+        }
+        benchmark::DoNotOptimize(total);
+    }
+
+    report(state, model);
+}
+
+template <typename ModelT, typename AccessT>
+void Filter(benchmark::State& state) {
+    ModelT model(entities_count(state.range(0), ModelT::entity_bytes));
+    AccessT const access(model.size());
+    std::vector<std::size_t> selected(model.size());
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < model.size(); ++i) {
+            std::size_t const index = access(i);
+            selected[count] = index;
+            count += model.test(index);
+        }
+        benchmark::DoNotOptimize(selected.data());
+        benchmark::DoNotOptimize(count);
+    }
+
+    report(state, model);
+}
+
+template <typename ModelT, typename AccessT>
+void Mix(benchmark::State& state) {
+    ModelT model(entities_count(state.range(0), ModelT::entity_bytes));
+    AccessT const access(model.size());
+
+    bench::perf_counters counters(state);
+    for (auto _ : state) {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < model.size(); ++i) {
+            std::size_t const index = access(i);
+            if (model.test(index)) {
+                model.remove_other(index);
+            } else {
+                model.set_other(index);
+            }
+            total += static_cast<std::size_t>(model.count(index));
+        }
+        benchmark::DoNotOptimize(total);
+    }
+
+    report(state, model);
+}
+
+template <typename ModelT, typename AccessT>
+void register_access(std::string const& model, std::size_t const bits) {
+    std::string const suffix = "/" + model + "/" + std::to_string(bits) + "/" + AccessT::name;
+
+    benchmark::RegisterBenchmark(("Set" + suffix).c_str(), &Set<ModelT, AccessT>)
+        ->RangeMultiplier(16)->Range(min_working_set, max_working_set);
+    benchmark::RegisterBenchmark(("Test" + suffix).c_str(), &Test<ModelT, AccessT>)
+        ->RangeMultiplier(16)->Range(min_working_set, max_working_set);
+    benchmark::RegisterBenchmark(("Count" + suffix).c_str(), &Count<ModelT, AccessT>)
+        ->RangeMultiplier(16)->Range(min_working_set, max_working_set);
+    benchmark::RegisterBenchmark(("Filter" + suffix).c_str(), &Filter<ModelT, AccessT>)
+        ->RangeMultiplier(16)->Range(min_working_set, max_working_set);
+    benchmark::RegisterBenchmark(("Mix" + suffix).c_str(), &Mix<ModelT, AccessT>)
+        ->RangeMultiplier(16)->Range(min_working_set, max_working_set);
+}
+
+template <typename ModelT>
+void register_model(std::string const& model, std::size_t const bits) {
+    register_access<ModelT, sequential>(model, bits);
+    register_access<ModelT, random>(model, bits);
+}
+
+template <std::size_t Bits, typename RawFlagsT, typename FlagsT>
+void register_width() {
+    register_model<bitflags_model<RawFlagsT>>("raw_bitflags", Bits);
+    register_model<bitflags_model<FlagsT>>("bitflags", Bits);
+    register_model<bitset_model<Bits>>("bitset", Bits);
+    register_model<enum_class_model<Bits>>("enum_class", Bits);
+    register_model<vector_bool_model<Bits>>("vector_bool", Bits);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    register_width<8, RawFlags8, Flags8>();
+    register_width<16, RawFlags16, Flags16>();
+    register_width<32, RawFlags32, Flags32>();
+    register_width<64, RawFlags64, Flags64>();
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,282 @@
+import os
+import sys
+import glob
+import json
+import math
+import shutil
+import argparse
+
+TIME_UNITS = { 'ns': 1.0, 'us': 1e3, 'ms': 1e6, 's': 1e9 }
+
+class BenchmarkRuns:
+    def __init__(self, name):
+        self.name = name
+        self.times = [] # nanoseconds
+
+    def add(self, time, unit):
+        self.times.append(time * TIME_UNITS[unit])
+
+    def median(self):
+        return median(self.times)
+
+    def mad(self):
+        m = self.median()
+        return median([ abs(t - m) for t in self.times ])
+
+    def confidence_interval(self, z):
+        # normal approximation of the median standard error based on
+        # the MAD scaled to the standard deviation of normal distribution
+        n = len(self.times)
+        error = z * 1.2533 * 1.4826 * self.mad() / math.sqrt(n)
+        return (self.median() - error, self.median() + error)
+
+class Comparison:
+    def __init__(self, name, baseline, current, p_value):
+        self.name = name
+        self.baseline = baseline
+        self.current = current
+        self.p_value = p_value
+        self.change = (current.median() - baseline.median()) / baseline.median() * 100.0
+
+def median(values):
+    ordered = sorted(values)
+    n = len(ordered)
+    if n == 0:
+        return 0.0
+    if n % 2 == 1:
+        return ordered[n // 2]
+    return (ordered[n // 2 - 1] + ordered[n // 2]) / 2.0
+
+def mann_whitney_u(xs, ys):
+    # two-sided Mann-Whitney U test using normal approximation with
+    # tie correction, returns p-value
+    n1 = len(xs)
+    n2 = len(ys)
+    if n1 < 2 or n2 < 2:
+        return 1.0
+
+    values = sorted([ (x, 0) for x in xs ] + [ (y, 1) for y in ys ])
+
+    ranks = [ 0.0 ] * len(values)
+    ties = 0.0
+    i = 0
+    while i < len(values):
+        j = i
+        while j + 1 < len(values) and values[j + 1][0] == values[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2.0 + 1.0
+        t = j - i + 1
+        ties += t ** 3 - t
+        i = j + 1
+
+    r1 = sum(rank for rank, value in zip(ranks, values) if value[1] == 0)
+    u1 = r1 - n1 * (n1 + 1) / 2.0
+    mean = n1 * n2 / 2.0
+
+    n = n1 + n2
+    variance = n1 * n2 / 12.0 * ((n + 1) - ties / (n * (n - 1)))
+    if variance <= 0:
+        return 1.0
+
+    z = (abs(u1 - mean) - 0.5) / math.sqrt(variance)
+    return math.erfc(max(z, 0.0) / math.sqrt(2))
+
+def create_argument_parser():
+    DEFAULT_BENCHMARKS_DIR="./"
+    DEFAULT_BASELINES_DIR="./baselines"
+
+    parser = argparse.ArgumentParser(description='Store and compare Google Benchmark baselines')
+
+    parser.add_argument(
+        "-b", "--benchmarks-dir",
+        default=DEFAULT_BENCHMARKS_DIR, type=str,
+        help='Path to Google Benchmark JSON files (default: %(default)s)',
+        metavar='BENCHMARKS_DIR', dest='benchmarks_dir'
+    )
+
+    parser.add_argument(
+        "-d", "--baselines-dir",
+        default=DEFAULT_BASELINES_DIR, type=str,
+        help='Path to stored baselines (default: %(default)s)',
+        metavar='BASELINES_DIR', dest='baselines_dir'
+    )
+
+    subparsers = parser.add_subparsers(dest='command', required=True)
+
+    save_parser = subparsers.add_parser('save', help='Store benchmark results as named baseline')
+    save_parser.add_argument('name', help='Name of the baseline')
+
+    compare_parser = subparsers.add_parser('compare', help='Compare benchmark results against named baseline')
+    compare_parser.add_argument('name', help='Name of the baseline')
+    compare_parser.add_argument(
+        "-t", "--threshold",
+        default=5.0, type=float,
+        help='Slowdown of the median in percents reported as regression (default: %(default)s)'
+    )
+    compare_parser.add_argument(
+        "-a", "--alpha",
+        default=0.05, type=float,
+        help='Significance level of the Mann-Whitney U test (default: %(default)s)'
+    )
+    compare_parser.add_argument(
+        "-c", "--chart",
+        action='store_true',
+        help='Plot chart of changes per benchmark'
+    )
+
+    return parser
+
+def extract_benchmark_name(filename):
+    start = filename.rfind('/') + 1
+    end = filename.find('_benchmark.json')
+    return filename[start:end]
+
+def load_runs(filename):
+    runs = {}
+
+    with open(filename, encoding='utf-8', mode='r') as json_file:
+        data = json.load(json_file)
+
+        for item in data["benchmarks"]:
+            # skip mean, median and stddev aggregates of repetitions
+            if item.get("run_type", "iteration") != "iteration":
+                continue
+
+            name = item.get("run_name", item["name"])
+            if name not in runs:
+                runs[name] = BenchmarkRuns(name)
+            runs[name].add(item["real_time"], item["time_unit"])
+
+    return runs
+
+def load_benchmarks(directory):
+    benchmarks = {}
+    for filename in glob.glob(os.path.join(directory, '*_benchmark.json')):
+        benchmarks[extract_benchmark_name(filename)] = load_runs(filename)
+    return benchmarks
+
+def save_baseline(args):
+    baseline_dir = os.path.join(args.baselines_dir, args.name)
+    os.makedirs(baseline_dir, exist_ok=True)
+
+    filenames = glob.glob(os.path.join(args.benchmarks_dir, '*_benchmark.json'))
+    if not filenames:
+        print('No *_benchmark.json files found in {}'.format(args.benchmarks_dir))
+        return 1
+
+    for filename in filenames:
+        shutil.copy(filename, baseline_dir)
+        print('Saved {} to {}'.format(os.path.basename(filename), baseline_dir))
+
+    return 0
+
+def format_time(ns):
+    for unit in [ 's', 'ms', 'us' ]:
+        if ns >= TIME_UNITS[unit]:
+            return '{:.3f} {}'.format(ns / TIME_UNITS[unit], unit)
+    return '{:.3f} ns'.format(ns)
+
+def classify(comparison, args):
+    significant = comparison.p_value < args.alpha
+    if significant and comparison.change > args.threshold:
+        return 'REGRESSION'
+    if significant and comparison.change < -args.threshold:
+        return 'improvement'
+    return ''
+
+def print_table(benchmark, comparisons, args):
+    print()
+    print(benchmark)
+
+    width = max([ len(c.name) for c in comparisons ] + [ len('Name') ])
+    header = '{:<{w}}  {:>14}  {:>14}  {:>10}  {:>8}  {:>8}  {:>8}  {}'.format(
+        'Name', 'Baseline', 'Current', 'Change', 'MAD', '95% CI', 'p-value', '', w=width
+    )
+    print(header)
+    print('-' * len(header))
+
+    for c in comparisons:
+        m = c.current.median()
+        low, high = c.current.confidence_interval(1.96)
+        print('{:<{w}}  {:>14}  {:>14}  {:>+9.2f}%  {:>7.2f}%  {:>7.2f}%  {:>8.4f}  {}'.format(
+            c.name,
+            format_time(c.baseline.median()),
+            format_time(m),
+            c.change,
+            c.current.mad() / m * 100.0 if m else 0.0,
+            (high - low) / 2.0 / m * 100.0 if m else 0.0,
+            c.p_value,
+            classify(c, args),
+            w=width
+        ))
+
+def generate_chart(benchmark, comparisons, args):
+    import matplotlib.pyplot as plt
+
+    fig, ax = plt.subplots(figsize=(10, max(3, 0.3 * len(comparisons))))
+
+    colors = []
+    for c in comparisons:
+        status = classify(c, args)
+        colors.append('tab:red' if status == 'REGRESSION' else 'tab:green' if status else 'tab:gray')
+
+    ax.barh([ c.name for c in comparisons ], [ c.change for c in comparisons ], color=colors)
+    ax.axvline(args.threshold, color='tab:red', linestyle='--', linewidth=0.8)
+    ax.axvline(-args.threshold, color='tab:green', linestyle='--', linewidth=0.8)
+    ax.invert_yaxis()
+    ax.set_xlabel('Change of median time (%)')
+    ax.set_title('{} vs {}'.format(benchmark, args.name))
+
+    fig.tight_layout()
+    plt.show()
+
+def compare_baseline(args):
+    baseline_dir = os.path.join(args.baselines_dir, args.name)
+    if not os.path.isdir(baseline_dir):
+        print('Baseline {} does not exist in {}'.format(args.name, args.baselines_dir))
+        return 1
+
+    baselines = load_benchmarks(baseline_dir)
+    currents = load_benchmarks(args.benchmarks_dir)
+
+    regressions = 0
+
+    for benchmark in sorted(currents.keys()):
+        if benchmark not in baselines:
+            print('\n{}: no baseline, skipped'.format(benchmark))
+            continue
+
+        comparisons = []
+        for name, current in currents[benchmark].items():
+            baseline = baselines[benchmark].get(name)
+            if baseline is None or baseline.median() == 0:
+                continue
+
+            comparisons.append(Comparison(
+                name, baseline, current,
+                mann_whitney_u(baseline.times, current.times)
+            ))
+
+        if not comparisons:
+            continue
+
+        print_table(benchmark, comparisons, args)
+        regressions += len([ c for c in comparisons if classify(c, args) == 'REGRESSION' ])
+
+        if args.chart:
+            generate_chart(benchmark, comparisons, args)
+
+    print()
+    print('{} regression(s) above {}% threshold'.format(regressions, args.threshold))
+
+    return 1 if regressions > 0 else 0
+
+if __name__ == "__main__":
+    parser = create_argument_parser()
+    args = parser.parse_args()
+
+    if args.command == 'save':
+        sys.exit(save_baseline(args))
+    else:
+        sys.exit(compare_baseline(args))
@@ -0,0 +1,428 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_ARENA_HPP
+#define BITFLAGS_ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+
+#include "bitflags.hpp"
+
+#if BITFLAGS_HAS_PMR
+#include <memory_resource>
+#endif
+
+namespace bf {
+
+/**
+ * class bump_arena
+ *
+ * Arena allocating by bumping a pointer within chunks of memory that
+ * are released all at once. Deallocation is a no-op, unless the
+ * memory is the most recent allocation, which is given back, e.g. when
+ * a vector grows in place. Each new chunk is twice as large as the
+ * previous one, and reset() keeps only the most recent, i.e. the
+ * largest, chunk, so that repeated workloads of the same size stop
+ * allocating after the first round.
+ */
+class bump_arena {
+public:
+    static constexpr std::size_t default_chunk_size = 4096;
+
+    explicit bump_arena(std::size_t const chunk_size = default_chunk_size) noexcept
+        : chunks_(nullptr)
+        , first_(nullptr)
+        , first_size_(0)
+        , current_(nullptr)
+        , end_(nullptr)
+        , next_size_(chunk_size < sizeof(chunk) * 2 ? sizeof(chunk) * 2 : chunk_size)
+    {}
+
+    /**
+     * Constructs the arena allocating from the buffer first, e.g. from
+     * a buffer on the stack. The buffer is not owned by the arena.
+     *
+     * @param buffer Initial buffer
+     * @param size   Size of the buffer
+     */
+    bump_arena(void* const buffer, std::size_t const size) noexcept
+        : chunks_(nullptr)
+        , first_(static_cast<unsigned char*>(buffer))
+        , first_size_(size)
+        , current_(first_)
+        , end_(first_ + size)
+        , next_size_(size < default_chunk_size ? default_chunk_size : size * 2)
+    {}
+
+    bump_arena(bump_arena const& rhs) = delete;
+    bump_arena& operator=(bump_arena const& rhs) = delete;
+
+    ~bump_arena() {
+        release();
+    }
+
+    /**
+     * Allocates memory within the arena.
+     *
+     * @param bytes     Size of the memory
+     * @param alignment Alignment of the memory, power of two
+     *
+     * @return Pointer to the memory
+     */
+    NODISCARD void* allocate(std::size_t const bytes, std::size_t const alignment = alignof(std::max_align_t)) {
+        if (current_ != nullptr) {
+            std::size_t const padding = padding_for(current_, alignment);
+            if (padding <= static_cast<std::size_t>(end_ - current_) && bytes <= static_cast<std::size_t>(end_ - current_) - padding) {
+                unsigned char* const result = current_ + padding;
+                current_ = result + bytes;
+                return result;
+            }
+        }
+        grow(bytes + alignment);
+        unsigned char* const result = current_ + padding_for(current_, alignment);
+        current_ = result + bytes;
+        return result;
+    }
+
+    /**
+     * Gives the memory back if it is the most recent allocation.
+     * Otherwise, the memory is reclaimed by reset() or release().
+     *
+     * @param ptr   Pointer to the memory
+     * @param bytes Size of the memory
+     */
+    void deallocate(void* const ptr, std::size_t const bytes, std::size_t const = alignof(std::max_align_t)) noexcept {
+        if (static_cast<unsigned char*>(ptr) + bytes == current_) {
+            current_ = static_cast<unsigned char*>(ptr);
+        }
+    }
+
+    /**
+     * Releases all the allocations at once, keeping the largest chunk
+     * for further allocations. Containers allocating from the arena
+     * have to be destroyed before.
+     */
+    void reset() noexcept {
+        if (chunks_ == nullptr) {
+            current_ = first_;
+            return;
+        }
+        free_chunks(chunks_->prev);
+        chunks_->prev = nullptr;
+        current_ = reinterpret_cast<unsigned char*>(chunks_ + 1);
+        end_ = reinterpret_cast<unsigned char*>(chunks_) + chunks_->size;
+    }
+
+    /**
+     * Releases all the allocations and all the chunks.
+     */
+    void release() noexcept {
+        free_chunks(chunks_);
+        chunks_ = nullptr;
+        current_ = first_;
+        end_ = first_ + first_size_;
+    }
+
+    /**
+     * Gets the total size of the chunks allocated by the arena.
+     *
+     * @return Size of the chunks in bytes
+     */
+    NODISCARD std::size_t capacity() const noexcept {
+        std::size_t result = 0;
+        for (chunk const* c = chunks_; c != nullptr; c = c->prev) {
+            result += c->size;
+        }
+        return result;
+    }
+
+private:
+    struct alignas(std::max_align_t) chunk {
+        chunk* prev;
+        std::size_t size;
+    };
+
+    static std::size_t padding_for(unsigned char const* const ptr, std::size_t const alignment) noexcept {
+        std::uintptr_t const address = reinterpret_cast<std::uintptr_t>(ptr);
+        return static_cast<std::size_t>((alignment - (address & (alignment - 1))) & (alignment - 1));
+    }
+
+    void grow(std::size_t const bytes) {
+        std::size_t size = next_size_;
+        while (size - sizeof(chunk) < bytes) {
+            size *= 2;
+        }
+        chunk* const c = static_cast<chunk*>(::operator new(size));
+        c->prev = chunks_;
+        c->size = size;
+        chunks_ = c;
+        current_ = reinterpret_cast<unsigned char*>(c + 1);
+        end_ = reinterpret_cast<unsigned char*>(c) + size;
+        next_size_ = size * 2;
+    }
+
+    static void free_chunks(chunk* c) noexcept {
+        while (c != nullptr) {
+            chunk* const prev = c->prev;
+            ::operator delete(c);
+            c = prev;
+        }
+    }
+
+    chunk* chunks_;
+    unsigned char* first_;
+    std::size_t first_size_;
+    unsigned char* current_;
+    unsigned char* end_;
+    std::size_t next_size_;
+};
+
+/**
+ * class pool_arena
+ *
+ * Pool of blocks of power-of-two size classes from 8 bytes, i.e. the
+ * size of the widest set of flags, up to 1024 bytes, carved out of the
+ * bump arena. Deallocated blocks are kept in the free list of their
+ * size class for reuse, so that containers repeatedly growing and
+ * shrinking within a request do not leak memory into the arena. Larger
+ * or over-aligned memory is allocated from the arena directly. All the
+ * memory is released at once by reset().
+ */
+class pool_arena {
+public:
+    static constexpr std::size_t min_block_size = 8;
+    static constexpr std::size_t classes_count = 8;
+    static constexpr std::size_t max_block_size = min_block_size << (classes_count - 1);
+
+    explicit pool_arena(std::size_t const chunk_size = bump_arena::default_chunk_size) noexcept
+        : arena_(chunk_size)
+        , free_()
+    {}
+
+    pool_arena(void* const buffer, std::size_t const size) noexcept
+        : arena_(buffer, size)
+        , free_()
+    {}
+
+    pool_arena(pool_arena const& rhs) = delete;
+    pool_arena& operator=(pool_arena const& rhs) = delete;
+
+    /**
+     * Allocates memory, taking a free block of its size class if any.
+     *
+     * @param bytes     Size of the memory
+     * @param alignment Alignment of the memory, power of two
+     *
+     * @return Pointer to the memory
+     */
+    NODISCARD void* allocate(std::size_t const bytes, std::size_t const alignment = alignof(std::max_align_t)) {
+        std::size_t const index = size_class(bytes);
+        if (index >= classes_count || alignment > block_alignment(index)) {
+            return arena_.allocate(bytes, alignment);
+        }
+        if (free_[index] != nullptr) {
+            node* const block = free_[index];
+            free_[index] = block->next;
+            return block;
+        }
+        return arena_.allocate(min_block_size << index, block_alignment(index));
+    }
+
+    /**
+     * Puts the block into the free list of its size class.
+     *
+     * @param ptr       Pointer to the memory
+     * @param bytes     Size of the memory
+     * @param alignment Alignment of the memory
+     */
+    void deallocate(void* const ptr, std::size_t const bytes, std::size_t const alignment = alignof(std::max_align_t)) noexcept {
+        std::size_t const index = size_class(bytes);
+        if (index >= classes_count || alignment > block_alignment(index)) {
+            arena_.deallocate(ptr, bytes, alignment);
+            return;
+        }
+        node* const block = static_cast<node*>(ptr);
+        block->next = free_[index];
+        free_[index] = block;
+    }
+
+    /**
+     * Releases all the allocations at once, keeping the largest chunk
+     * of the arena for further allocations. Containers allocating from
+     * the pool have to be destroyed before, since their blocks would
+     * be put back into the emptied free lists.
+     */
+    void reset() noexcept {
+        arena_.reset();
+        std::fill_n(free_, classes_count, nullptr);
+    }
+
+    /**
+     * Releases all the allocations and all the chunks.
+     */
+    void release() noexcept {
+        arena_.release();
+        std::fill_n(free_, classes_count, nullptr);
+    }
+
+    NODISCARD std::size_t capacity() const noexcept {
+        return arena_.capacity();
+    }
+
+private:
+    struct node {
+        node* next;
+    };
+
+    static_assert(sizeof(node) <= min_block_size, "pool_arena: blocks are too small for free list");
+
+    static std::size_t size_class(std::size_t const bytes) noexcept {
+        std::size_t index = 0;
+        for (std::size_t size = min_block_size; size < bytes && index < classes_count; size <<= 1) {
+            ++index;
+        }
+        return index;
+    }
+
+    static std::size_t block_alignment(std::size_t const index) noexcept {
+        std::size_t const size = min_block_size << index;
+        return size < alignof(std::max_align_t) ? size : alignof(std::max_align_t);
+    }
+
+    bump_arena arena_;
+    node* free_[classes_count];
+};
+
+#if __cplusplus < 201703L
+constexpr std::size_t bump_arena::default_chunk_size;
+constexpr std::size_t pool_arena::min_block_size;
+constexpr std::size_t pool_arena::classes_count;
+constexpr std::size_t pool_arena::max_block_size;
+#endif
+
+/**
+ * class arena_allocator
+ *
+ * Allocator allocating from the bump arena or the pool arena, to be
+ * used with the containers of flags, e.g.
+ *
+ *     bf::bump_arena arena;
+ *     bf::counted_flags<Flags, bf::arena_allocator<Flags>> flags(bf::arena_allocator<Flags>(arena));
+ *
+ * Allocators are equal if they allocate from the same arena.
+ */
+template <typename T, typename ArenaT = bump_arena>
+class arena_allocator {
+public:
+    using value_type = T;
+
+    explicit arena_allocator(ArenaT& arena) noexcept
+        : arena_(&arena)
+    {}
+
+    template <typename U>
+    arena_allocator(arena_allocator<U, ArenaT> const& rhs) noexcept
+        : arena_(rhs.arena())
+    {}
+
+    NODISCARD T* allocate(std::size_t const n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* const ptr, std::size_t const n) noexcept {
+        arena_->deallocate(ptr, n * sizeof(T), alignof(T));
+    }
+
+    NODISCARD ArenaT* arena() const noexcept {
+        return arena_;
+    }
+
+private:
+    ArenaT* arena_;
+};
+
+template <typename T, typename U, typename ArenaT>
+NODISCARD bool operator==(arena_allocator<T, ArenaT> const& lhs, arena_allocator<U, ArenaT> const& rhs) noexcept {
+    return lhs.arena() == rhs.arena();
+}
+
+template <typename T, typename U, typename ArenaT>
+NODISCARD bool operator!=(arena_allocator<T, ArenaT> const& lhs, arena_allocator<U, ArenaT> const& rhs) noexcept {
+    return lhs.arena() != rhs.arena();
+}
+
+#if BITFLAGS_HAS_PMR
+/**
+ * class arena_resource
+ *
+ * Memory resource allocating from the bump arena or the pool arena,
+ * to be used with the std::pmr containers of flags, e.g.
+ *
+ *     bf::pool_arena arena;
+ *     bf::arena_resource<bf::pool_arena> resource(arena);
+ *     bf::pmr::flags_map<Flags, int> map(&resource);
+ */
+template <typename ArenaT>
+class arena_resource : public std::pmr::memory_resource {
+public:
+    explicit arena_resource(ArenaT& arena) noexcept
+        : arena_(&arena)
+    {}
+
+    NODISCARD ArenaT* arena() const noexcept {
+        return arena_;
+    }
+
+private:
+    void* do_allocate(std::size_t const bytes, std::size_t const alignment) override {
+        return arena_->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* const ptr, std::size_t const bytes, std::size_t const alignment) override {
+        arena_->deallocate(ptr, bytes, alignment);
+    }
+
+    bool do_is_equal(std::pmr::memory_resource const& rhs) const noexcept override {
+        return this == &rhs;
+    }
+
+    ArenaT* arena_;
+};
+#endif
+
+} // bf
+
+#endif // BITFLAGS_ARENA_HPP
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_ATOMIC_HPP
+#define BITFLAGS_ATOMIC_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#include "bitflags.hpp"
+
+namespace bf {
+
+/**
+ * class atomic_bitflags
+ *
+ * Set of flags that may be modified and checked concurrently from
+ * multiple threads. Each operation is a single atomic read-modify-write
+ * of the underlying integer. Instrumentation policy of BitflagsT is
+ * not applied.
+ */
+template <typename BitflagsT>
+class atomic_bitflags {
+public:
+    using value_type      = BitflagsT;
+    using flag_type       = typename BitflagsT::flag_type;
+    using group_type      = typename BitflagsT::group_type;
+    using underlying_type = typename BitflagsT::underlying_type;
+
+    constexpr atomic_bitflags() noexcept
+        : bits_(0)
+    {}
+
+    constexpr atomic_bitflags(BitflagsT const& rhs) noexcept
+        : bits_(rhs.bits())
+    {}
+
+    atomic_bitflags(atomic_bitflags const& rhs) = delete;
+    atomic_bitflags& operator=(atomic_bitflags const& rhs) = delete;
+
+    ~atomic_bitflags() = default;
+
+    /**
+     * Gets a copy of the current set of flags.
+     *
+     * @param order Memory order of the operation
+     *
+     * @return Current set of flags
+     */
+    NODISCARD BitflagsT load(std::memory_order const order = std::memory_order_seq_cst) const noexcept {
+        return BitflagsT(bits_.load(order));
+    }
+
+    /**
+     * Replaces the current set of flags.
+     *
+     * @param rhs   New set of flags
+     * @param order Memory order of the operation
+     */
+    void store(BitflagsT const& rhs, std::memory_order const order = std::memory_order_seq_cst) noexcept {
+        bits_.store(rhs.bits(), order);
+    }
+
+    /**
+     * Replaces the current set of flags.
+     *
+     * @param rhs   New set of flags
+     * @param order Memory order of the operation
+     *
+     * @return Previous set of flags
+     */
+    BitflagsT exchange(BitflagsT const& rhs, std::memory_order const order = std::memory_order_seq_cst) noexcept {
+        return BitflagsT(bits_.exchange(rhs.bits(), order));
+    }
+
+    /**
+     * Replaces the current set of flags if it equals to the expected
+     * one. Otherwise, loads the current set of flags into expected.
+     *
+     * @param expected Expected set of flags
+     * @param desired  New set of flags
+     * @param order    Memory order of the operation
+     *
+     * @return True if the set of flags has been replaced, otherwise false
+     */
+    bool compare_exchange(BitflagsT& expected, BitflagsT const& desired, std::memory_order const order = std::memory_order_seq_cst) noexcept {
+        underlying_type bits = expected.bits();
+        bool const exchanged = bits_.compare_exchange_strong(bits, desired.bits(), order);
+        expected = BitflagsT(bits);
+        return exchanged;
+    }
+
+    /**
+     * Checks whether specified flag is contained within the current
+     * set of flags. Zero flags are treated as always present.
+     *
+     * @param rhs   Flag to check
+     * @param order Memory order of the operation
+     *
+     * @return True if the specified flags is contained within the
+     *         current set of flags, otherwise false
+     */
+    NODISCARD bool contains(flag_type const& rhs, std::memory_order const order = std::memory_order_seq_cst) const noexcept {
+        return (bits_.load(order) & rhs.bits) != 0 || rhs.bits == 0;
+    }
+
+    /**
+     * Sets specified flag.
+     *
+     * @param rhs   Flag to be set
+     * @param order Memory order of the operation
+     *
+     * @return Previous set of flags
+     */
+    BitflagsT set(flag_type const& rhs, std::memory_order const order = std::memory_order_seq_cst) noexcept {
+        return BitflagsT(bits_.fetch_or(rhs.bits, order));
+    }
+
+    /**
+     * Unsets specified flag.
+     *
+     * @param rhs   Flag to be unset
+     * @param order Memory order of the operation
+     *
+     * @return Previous set of flags
+     */
+    BitflagsT remove(flag_type const& rhs, std::memory_order const order = std::memory_order_seq_cst) noexcept {
+        return BitflagsT(bits_.fetch_and(static_cast<underlying_type>(~rhs.bits), order));
+    }
+
+    /**
+     * Sets specified flag if not already present.
+     * Otherwise, unsets the specified flag.
+     *
+     * @param rhs   Flag to be toggled
+     * @param order Memory order of the operation
+     *
+     * @return Previous set of flags
+     */
+    BitflagsT toggle(flag_type const& rhs, std::memory_order const order = std::memory_order_seq_cst) noexcept {
+        return BitflagsT(bits_.fetch_xor(rhs.bits, order));
+    }
+
+    /**
+     * Clears all flags currently set.
+     *
+     * @param order Memory order of the operation
+     *
+     * @return Previous set of flags
+     */
+    BitflagsT clear(std::memory_order const order = std::memory_order_seq_cst) noexcept {
+        return BitflagsT(bits_.exchange(0, order));
+    }
+
+    /**
+     * Sets specified flag and unsets all the flags that are mutually
+     * exclusive with it, in a single atomic masked write.
+     *
+     * @param rhs   Flag to switch to
+     * @param order Memory order of the operation
+     *
+     * @return Previous set of flags
+     */
+    BitflagsT switch_to(flag_type const& rhs, std::memory_order const order = std::memory_order_seq_cst) noexcept {
+        underlying_type const keep = static_cast<underlying_type>(~internal::exclusive_mask<BitflagsT>(rhs.bits));
+        underlying_type bits = bits_.load(std::memory_order_relaxed);
+        while (!bits_.compare_exchange_weak(bits, static_cast<underlying_type>((bits & keep) | rhs.bits), order, std::memory_order_relaxed)) {}
+        return BitflagsT(bits);
+    }
+
+    /**
+     * Gets the flag of the group that is currently set.
+     *
+     * @param group Group of mutually exclusive flags
+     * @param order Memory order of the operation
+     *
+     * @return Flag of the group that is currently set, or an empty
+     *         flag if none of them is set
+     */
+    NODISCARD flag_type which(group_type const& group, std::memory_order const order = std::memory_order_seq_cst) const noexcept {
+        return internal::group_member<BitflagsT>(static_cast<underlying_type>(bits_.load(order) & group.mask));
+    }
+
+private:
+    std::atomic<underlying_type> bits_;
+};
+
+} // bf
+
+#endif // BITFLAGS_ATOMIC_HPP
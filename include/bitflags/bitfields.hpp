@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_BITFIELDS_HPP
+#define BITFLAGS_BITFIELDS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "bitflags.hpp"
+
+namespace bf {
+
+namespace internal {
+
+/**
+ * struct rank
+ *
+ * Tag type used for looking up the last declaration preceding the
+ * specific line within the set of bitfields. Each rank derives from
+ * the previous one, so the overload declared for the closest lower
+ * rank is always the best match.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <int N>
+struct rank : rank<N - 1> {};
+
+template <>
+struct rank<0> {};
+
+/**
+ * struct bit_offset
+ *
+ * Offset of the first bit that is not yet occupied by any of the
+ * flags or fields declared so far.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <int N>
+struct bit_offset {
+    static constexpr int value = N;
+};
+
+/**
+ * Gets the mask of width lowest bits.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param width Number of bits
+ *
+ * @return Mask of the lowest bits
+ */
+constexpr std::uint64_t low_mask(int const width) noexcept {
+    return width >= 64 ? ~std::uint64_t{} : (std::uint64_t{1} << width) - 1;
+}
+
+} // internal
+
+/**
+ * struct field
+ *
+ * Multi-bit field occupying Width bits starting from the bit Offset
+ * of the underlying type T. Values are read and written as ValueT,
+ * which may be any integral or enumeration type.
+ */
+template <typename T, typename ValueT, int Offset, int Width>
+struct field {
+    static_assert(Width > 0, "bitfields: field has to be at least one bit wide");
+    static_assert(Offset + Width <= static_cast<int>(sizeof(T) * 8), "bitfields: fields do not fit into the underlying type");
+
+    using underlying_type = T;
+    using value_type      = ValueT;
+
+    static constexpr int offset = Offset;
+    static constexpr int width  = Width;
+
+    /**
+     * Gets the mask of the bits occupied by the field.
+     *
+     * @return Mask of the field
+     */
+    NODISCARD static constexpr T mask() noexcept {
+        return static_cast<T>(internal::low_mask(Width) << Offset);
+    }
+
+    /**
+     * Extracts value of the field from the underlying bits.
+     *
+     * @param bits Underlying bits
+     *
+     * @return Value of the field
+     */
+    NODISCARD static constexpr ValueT get(T const bits) noexcept {
+        return static_cast<ValueT>((static_cast<std::uint64_t>(bits) >> Offset) & internal::low_mask(Width));
+    }
+
+    /**
+     * Replaces value of the field within the underlying bits.
+     * Bits of the value that do not fit into the field are ignored.
+     *
+     * @param bits  Underlying bits
+     * @param value New value of the field
+     *
+     * @return Underlying bits with the field replaced
+     */
+    NODISCARD static constexpr T put(T const bits, ValueT const value) noexcept {
+        return static_cast<T>(
+            (bits & ~mask()) | ((static_cast<std::uint64_t>(value) & internal::low_mask(Width)) << Offset)
+        );
+    }
+};
+
+#if __cplusplus < 201703L
+template <typename T, typename ValueT, int Offset, int Width>
+constexpr int field<T, ValueT, Offset, Width>::offset;
+
+template <typename T, typename ValueT, int Offset, int Width>
+constexpr int field<T, ValueT, Offset, Width>::width;
+#endif
+
+/**
+ * class bitfields
+ *
+ * Set of raw flags and multi-bit fields packed into the single
+ * minimal underlying integer. All the operations over the flags are
+ * inherited from bitflags, fields are accessed by get and set.
+ *
+ * Flags and fields are declared over std::uint64_t, so that the
+ * layout is instantiated only once, and are narrowed to T on use.
+ */
+template <typename ImplT, typename T>
+class bitfields : public bitflags<ImplT, T, internal::raw_flag> {
+    using base_type = bitflags<ImplT, T, internal::raw_flag>;
+
+public:
+    using base_type::base_type;
+    using base_type::set;
+
+    constexpr bitfields() = default;
+
+    constexpr bitfields(base_type const& rhs) noexcept
+        : base_type(rhs)
+    {}
+
+    constexpr bitfields(typename ImplT::flag const& rhs) noexcept
+        : base_type(rhs)
+    {}
+
+    /**
+     * Gets value of the specified field.
+     *
+     * @param field Field to get
+     *
+     * @return Value of the field
+     */
+    template <typename FieldT>
+    NODISCARD constexpr typename FieldT::value_type get(FieldT) const noexcept {
+        static_assert(FieldT::offset + FieldT::width <= static_cast<int>(sizeof(T) * 8), "bitfields: field of another set");
+        return FieldT::get(this->bits());
+    }
+
+    /**
+     * Sets value of the specified field. Bits of the value that do
+     * not fit into the field are ignored.
+     *
+     * @param field Field to set
+     * @param value New value of the field
+     */
+    template <typename FieldT>
+    NON_CONST_CONSTEXPR void set(FieldT, typename FieldT::value_type const value) noexcept {
+        static_assert(FieldT::offset + FieldT::width <= static_cast<int>(sizeof(T) * 8), "bitfields: field of another set");
+        static_cast<base_type&>(*this) = base_type(static_cast<T>(FieldT::put(this->bits(), value)));
+    }
+};
+
+/**
+ * Extracts value of the field from each element of the array.
+ * The loop contains only shifts and masks so that the compiler
+ * vectorizes it.
+ *
+ * @param src   Bitfields to extract from
+ * @param count Number of bitfields
+ * @param field Field to extract
+ * @param dst   Destination array of at least count values
+ */
+template <typename BitfieldsT, typename FieldT>
+inline void extract(BitfieldsT const* src, std::size_t const count, FieldT, typename FieldT::value_type* dst) noexcept {
+    static_assert(FieldT::offset + FieldT::width <= static_cast<int>(sizeof(typename BitfieldsT::underlying_type) * 8), "bitfields: field of another set");
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = FieldT::get(src[i].bits());
+    }
+}
+
+} // bf
+
+/**
+ * Macros used for creating set of bitfields, i.e. raw flags and
+ * multi-bit fields packed into the same underlying integer. Each
+ * declaration occupies the bits right after the previous one.
+ */
+
+#define BITFIELDS_OFFSET \
+    decltype(offset_at_(bf::internal::rank<__LINE__ - begin_>{}))::value
+
+#define BITFIELDS_ADVANCE(WIDTH) \
+    static bf::internal::bit_offset<BITFIELDS_OFFSET + (WIDTH)> offset_at_(bf::internal::rank<__LINE__ - begin_ + 1>);
+
+#define BEGIN_BITFIELDS(NAME)                                                    \
+    template <typename T>                                                        \
+    struct NAME##Impl {                                                          \
+        using flag = bf::internal::raw_flag<NAME##Impl, T>;                      \
+        template <int I>                                                         \
+        static constexpr flag flag_at_(bf::internal::position<I>) { return {}; } \
+        static bf::internal::bit_offset<0> offset_at_(bf::internal::rank<0>);    \
+        static constexpr int begin_ = __LINE__;
+
+#define END_BITFIELDS(NAME)                                                      \
+        static constexpr int bits_  = BITFIELDS_OFFSET;                          \
+        static constexpr int end_   = begin_ + bits_ + 2;                        \
+    };                                                                           \
+    using NAME = bf::bitfields<                                                  \
+        NAME##Impl<std::uint64_t>,                                               \
+        bf::internal::min_t<NAME##Impl<std::uint64_t>::bits_>                    \
+    >;
+
+#define FIELD_FLAG(NAME)                                                                 \
+    static constexpr flag NAME{ bf::internal::shift<T>(BITFIELDS_OFFSET) };              \
+    static constexpr flag flag_at_(bf::internal::position<BITFIELDS_OFFSET + 1>) { return NAME; } \
+    BITFIELDS_ADVANCE(1)
+
+#define TYPED_FIELD(NAME, TYPE, WIDTH)                                                   \
+    static constexpr bf::field<T, TYPE, BITFIELDS_OFFSET, (WIDTH)> NAME{};               \
+    BITFIELDS_ADVANCE(WIDTH)
+
+#define FIELD(NAME, WIDTH) \
+    TYPED_FIELD(NAME, bf::internal::min_t<WIDTH>, WIDTH)
+
+#endif // BITFLAGS_BITFIELDS_HPP
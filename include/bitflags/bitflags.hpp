@@ -30,11 +30,21 @@
 #ifndef BITFLAGS_HPP
 #define BITFLAGS_HPP
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
 #include <utility>
 #if __cplusplus >= 201703L
 #include <string_view>
 #endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__BMI2__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 #if defined(__has_cpp_attribute)
 #    if __has_cpp_attribute(nodiscard)
@@ -53,6 +63,15 @@
 #    define NON_CONST_CONSTEXPR
 #endif
 
+#if __cplusplus >= 201703L && defined(__has_include)
+#    if __has_include(<memory_resource>)
+#        define BITFLAGS_HAS_PMR 1
+#    endif
+#endif
+#ifndef BITFLAGS_HAS_PMR
+#    define BITFLAGS_HAS_PMR 0
+#endif
+
 namespace bf {
 
 namespace internal {
@@ -115,6 +134,9 @@ struct raw_flag : flag_helper<raw_flag<TagT, T>> {
 
     constexpr raw_flag(T bits) noexcept : bits(bits) {}
 
+    template <typename U, typename = typename std::enable_if<!std::is_same<U, T>::value>::type>
+    constexpr raw_flag(raw_flag<TagT, U> const& rhs) noexcept : bits(static_cast<T>(rhs.bits)) {}
+
     NODISCARD explicit constexpr operator T() const noexcept { return bits; }
 
     /**
@@ -144,9 +166,9 @@ struct flag : flag_helper<flag<TagT, T>> {
     char const * name;
 #endif
 
-    constexpr flag() noexcept : bits(0) {}
+    constexpr flag() noexcept : bits(0), name("") {}
 
-    constexpr flag(T bits) noexcept : bits(bits) {}
+    constexpr flag(T bits) noexcept : bits(bits), name("") {}
 
 #if __cplusplus >= 201703L
     constexpr flag(T bits, std::string_view name) noexcept
@@ -170,6 +192,80 @@ struct flag : flag_helper<flag<TagT, T>> {
     NON_CONST_CONSTEXPR flag& operator^=(flag const& rhs) noexcept { bits ^= rhs.bits; return *this; }
 };
 
+/**
+ * struct group
+ *
+ * Group of mutually exclusive flags, i.e. at most one of the flags
+ * within the group is expected to be set at any time.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <typename TagT, typename T = std::uint8_t>
+struct group {
+    T mask;
+
+    constexpr group() noexcept : mask(0) {}
+
+    constexpr group(T mask) noexcept : mask(mask) {}
+};
+
+/**
+ * struct rule
+ *
+ * Rule between flags, i.e. either the flag from implies all the flags
+ * to, or the flag from conflicts with all the flags to.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <typename TagT, typename T = std::uint8_t>
+struct rule {
+    T from;
+    T to;
+    bool conflict;
+
+    constexpr rule() noexcept : from(0), to(0), conflict(false) {}
+
+    constexpr rule(T from, T to, bool conflict) noexcept : from(from), to(to), conflict(conflict) {}
+};
+
+/**
+ * Gets the bits of all the specified flags.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @return Bits of all the flags
+ */
+template <typename T>
+constexpr T group_bits() noexcept {
+    return T{};
+}
+
+template <typename T, typename FlagT, typename ... FlagsT>
+constexpr T group_bits(FlagT const& head, FlagsT const& ... tail) noexcept {
+    return static_cast<T>(head.bits | group_bits<T>(tail...));
+}
+
+/**
+ * Checks whether each of the specified flags occupies exactly one
+ * bit and no two flags occupy the same bit.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @return True if the flags are one-hot and distinct, otherwise false
+ */
+template <typename T>
+constexpr bool one_hot() noexcept {
+    return true;
+}
+
+template <typename T, typename FlagT, typename ... FlagsT>
+constexpr bool one_hot(FlagT const& head, FlagsT const& ... tail) noexcept {
+    return head.bits != 0
+        && (head.bits & (head.bits - 1)) == 0
+        && (head.bits & group_bits<T>(tail...)) == 0
+        && one_hot<T>(tail...);
+}
+
 /**
  * struct min
  *
@@ -217,19 +313,282 @@ template <typename T>
 constexpr T shift(int const offset) {
     return offset < 0
         ? static_cast<T>(0)
-        : static_cast<T>(1U << offset);
+        : static_cast<T>(T{1} << offset);
+}
+
+/**
+ * Counts trailing zero bits of non-zero integer.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param x Non-zero integer
+ *
+ * @return Index of the lowest set bit
+ */
+inline int ctz(std::uint64_t const x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return static_cast<int>(index);
+#else
+    int index = 0;
+    while (!((x >> index) & 1U)) {
+        ++index;
+    }
+    return index;
+#endif
 }
 
+/**
+ * Counts set bits of the integer. Usable at compile time as well.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param bits Integer
+ *
+ * @return Number of set bits
+ */
+constexpr int count_bits(std::uint64_t const bits) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(bits);
+#else
+    return bits ? 1 + count_bits(bits & (bits - 1)) : 0;
+#endif
+}
+
+/**
+ * Gathers bits selected by mask into contiguous low-order bits, i.e.
+ * portable equivalent of BMI2 pext instruction usable at compile time.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param bits Bits to gather from
+ * @param mask Bits to be gathered
+ *
+ * @return Gathered bits
+ */
+NON_CONST_CONSTEXPR std::uint64_t portable_extract_bits(std::uint64_t const bits, std::uint64_t mask) noexcept {
+    std::uint64_t result = 0;
+    for (std::uint64_t k = 1; mask; mask &= mask - 1, k <<= 1) {
+        if (bits & mask & (~mask + 1)) {
+            result |= k;
+        }
+    }
+    return result;
+}
+
+/**
+ * Scatters contiguous low-order bits to the positions selected by
+ * mask, i.e. portable equivalent of BMI2 pdep instruction usable at
+ * compile time.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param bits Bits to scatter
+ * @param mask Positions to scatter to
+ *
+ * @return Scattered bits
+ */
+NON_CONST_CONSTEXPR std::uint64_t portable_deposit_bits(std::uint64_t const bits, std::uint64_t mask) noexcept {
+    std::uint64_t result = 0;
+    for (std::uint64_t k = 1; mask; mask &= mask - 1, k <<= 1) {
+        if (bits & k) {
+            result |= mask & (~mask + 1);
+        }
+    }
+    return result;
+}
+
+/**
+ * Gathers bits selected by mask into contiguous low-order bits using
+ * BMI2 pext instruction when available.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param bits Bits to gather from
+ * @param mask Bits to be gathered
+ *
+ * @return Gathered bits
+ */
+inline std::uint64_t extract_bits(std::uint64_t const bits, std::uint64_t const mask) noexcept {
+#if defined(__BMI2__) && defined(__x86_64__)
+    return _pext_u64(bits, mask);
+#else
+    return portable_extract_bits(bits, mask);
+#endif
+}
+
+/**
+ * Scatters contiguous low-order bits to the positions selected by
+ * mask using BMI2 pdep instruction when available.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param bits Bits to scatter
+ * @param mask Positions to scatter to
+ *
+ * @return Scattered bits
+ */
+inline std::uint64_t deposit_bits(std::uint64_t const bits, std::uint64_t const mask) noexcept {
+#if defined(__BMI2__) && defined(__x86_64__)
+    return _pdep_u64(bits, mask);
+#else
+    return portable_deposit_bits(bits, mask);
+#endif
+}
+
+/**
+ * struct position
+ *
+ * Tag type used for looking up the flag declared at specific
+ * position within the set of flags.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <int I>
+struct position {};
+
+/**
+ * struct sequence
+ *
+ * Compile-time sequence of indices, i.e. C++11 equivalent of
+ * std::index_sequence.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <std::size_t ... I>
+struct sequence {};
+
+template <std::size_t N, std::size_t ... I>
+struct make_sequence : make_sequence<N - 1, N - 1, I...> {};
+
+template <std::size_t ... I>
+struct make_sequence<0, I...> {
+    using type = sequence<I...>;
+};
+
+/**
+ * Loads underlying bits of count flags into destination buffer.
+ * Raw flags have the same layout as their underlying type so they
+ * are copied at once, ordinary flags are loaded one by one.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param src   Flags to load
+ * @param count Number of flags to load
+ * @param dst   Destination buffer
+ */
+template <typename BitflagsT>
+inline void load_bits(BitflagsT const* src, std::size_t const count, typename BitflagsT::underlying_type* dst, std::true_type) noexcept {
+    std::memcpy(dst, src, count * sizeof(BitflagsT));
+}
+
+template <typename BitflagsT>
+inline void load_bits(BitflagsT const* src, std::size_t const count, typename BitflagsT::underlying_type* dst, std::false_type) noexcept {
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = src[i].bits();
+    }
+}
+
+template <typename BitflagsT>
+inline void load_bits(BitflagsT const* src, std::size_t const count, typename BitflagsT::underlying_type* dst) noexcept {
+    load_bits(src, count, dst, std::integral_constant<bool, sizeof(BitflagsT) == sizeof(typename BitflagsT::underlying_type)>{});
+}
+
+/**
+ * Loads underlying bits of at most N flags into the block. Unlike
+ * load_bits, the size of the block bounds the loop, so the compiler
+ * does not assume writes past its end.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param src   Flags to load
+ * @param count Number of flags to load
+ * @param dst   Destination block
+ */
+template <typename BitflagsT, std::size_t N>
+inline void load_block(BitflagsT const* src, std::size_t const count, typename BitflagsT::underlying_type (&dst)[N], std::true_type) noexcept {
+    std::memcpy(dst, src, std::min(count, N) * sizeof(BitflagsT));
+}
+
+template <typename BitflagsT, std::size_t N>
+inline void load_block(BitflagsT const* src, std::size_t const count, typename BitflagsT::underlying_type (&dst)[N], std::false_type) noexcept {
+    for (std::size_t i = 0; i < N && i < count; ++i) {
+        dst[i] = src[i].bits();
+    }
+}
+
+template <typename BitflagsT, std::size_t N>
+inline void load_block(BitflagsT const* src, std::size_t const count, typename BitflagsT::underlying_type (&dst)[N]) noexcept {
+    load_block(src, count, dst, std::integral_constant<bool, sizeof(BitflagsT) == sizeof(typename BitflagsT::underlying_type)>{});
+}
+
+/**
+ * Gets the mask of all bits that can be occupied by the flags
+ * declared within the set of flags.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @return Mask of declared bits
+ */
+template <typename ImplT, typename T>
+constexpr T declared_mask() noexcept {
+    return ImplT::end_ - ImplT::begin_ - 2 >= static_cast<int>(sizeof(T) * 8)
+        ? static_cast<T>(~T{})
+        : static_cast<T>((std::uint64_t{1} << (ImplT::end_ - ImplT::begin_ - 2)) - 1);
+}
+
+template <typename BitflagsT>
+typename BitflagsT::underlying_type exclusive_mask(typename BitflagsT::underlying_type bits) noexcept;
+
+template <typename BitflagsT>
+typename BitflagsT::flag_type group_member(typename BitflagsT::underlying_type bits) noexcept;
+
+template <typename BitflagsT>
+typename BitflagsT::underlying_type implied_mask(typename BitflagsT::underlying_type bits) noexcept;
+
 } // internal
 
+/**
+ * struct no_instrumentation
+ *
+ * Default instrumentation policy of bitflags. Policy hooks are called
+ * with the implementation type and the bits of the flag whenever the
+ * flag is set, removed, toggled or checked, and with the address of
+ * the object and its bits before and after every modification other
+ * than copy or move assignment. Hooks return value is ignored. All
+ * the hooks of this policy are empty so that the bitflags compile to
+ * exactly the same code as without instrumentation. Custom policies
+ * may derive from this one and hide only the hooks they need.
+ */
+struct no_instrumentation {
+    template <typename ImplT, typename T>
+    static constexpr bool on_set(T) noexcept { return true; }
+
+    template <typename ImplT, typename T>
+    static constexpr bool on_remove(T) noexcept { return true; }
+
+    template <typename ImplT, typename T>
+    static constexpr bool on_toggle(T) noexcept { return true; }
+
+    template <typename ImplT, typename T>
+    static constexpr bool on_contains(T) noexcept { return true; }
+
+    template <typename ImplT, typename T>
+    static constexpr bool on_change(void const*, T, T) noexcept { return true; }
+};
+
 template <
     typename ImplT,
     typename T,
 #if __cplusplus >= 201703L
-    template <typename, typename> typename FlagT
+    template <typename, typename> typename FlagT,
 #else
-    template <typename, typename> class FlagT
+    template <typename, typename> class FlagT,
 #endif
+    typename PolicyT
 >
 class bitflags;
 
@@ -245,45 +604,49 @@ template <
     typename ImplT,
     typename T,
 #if __cplusplus >= 201703L
-    template <typename, typename> typename FlagT
+    template <typename, typename> typename FlagT,
 #else
-    template <typename, typename> class FlagT
+    template <typename, typename> class FlagT,
 #endif
+    typename PolicyT
 >
-NODISCARD constexpr T operator~(bitflags<ImplT, T, FlagT> const& rhs) noexcept;
+NODISCARD constexpr T operator~(bitflags<ImplT, T, FlagT, PolicyT> const& rhs) noexcept;
 
 template <
     typename ImplT,
     typename T,
 #if __cplusplus >= 201703L
-    template <typename, typename> typename FlagT
+    template <typename, typename> typename FlagT,
 #else
-    template <typename, typename> class FlagT
+    template <typename, typename> class FlagT,
 #endif
+    typename PolicyT
 >
-NODISCARD constexpr T operator&(bitflags<ImplT, T, FlagT> const& lhs, FlagT<ImplT, T> const& rhs) noexcept;
+NODISCARD constexpr T operator&(bitflags<ImplT, T, FlagT, PolicyT> const& lhs, FlagT<ImplT, T> const& rhs) noexcept;
 
 template <
     typename ImplT,
     typename T,
 #if __cplusplus >= 201703L
-    template <typename, typename> typename FlagT
+    template <typename, typename> typename FlagT,
 #else
-    template <typename, typename> class FlagT
+    template <typename, typename> class FlagT,
 #endif
+    typename PolicyT
 >
-NODISCARD constexpr T operator|(bitflags<ImplT, T, FlagT> const& lhs, FlagT<ImplT, T> const& rhs) noexcept;
+NODISCARD constexpr T operator|(bitflags<ImplT, T, FlagT, PolicyT> const& lhs, FlagT<ImplT, T> const& rhs) noexcept;
 
 template <
     typename ImplT,
     typename T,
 #if __cplusplus >= 201703L
-    template <typename, typename> typename FlagT
+    template <typename, typename> typename FlagT,
 #else
-    template <typename, typename> class FlagT
+    template <typename, typename> class FlagT,
 #endif
+    typename PolicyT
 >
-NODISCARD constexpr T operator^(bitflags<ImplT, T, FlagT> const& lhs, FlagT<ImplT, T> const& rhs) noexcept;
+NODISCARD constexpr T operator^(bitflags<ImplT, T, FlagT, PolicyT> const& lhs, FlagT<ImplT, T> const& rhs) noexcept;
 
 /**
  * class bitflags
@@ -298,18 +661,23 @@ template <
     template <
         typename,
         typename
-    > typename FlagT = internal::flag
+    > typename FlagT = internal::flag,
 #else
     template <
         typename,
         typename
-    > class FlagT = internal::flag
+    > class FlagT = internal::flag,
 #endif
+    typename PolicyT = no_instrumentation
 >
 class bitflags : public ImplT {
 public:
     using flag_type       = FlagT<ImplT, T>;
     using underlying_type = T;
+    using impl_type       = ImplT;
+    using policy_type     = PolicyT;
+    using group_type      = internal::group<ImplT, T>;
+    using rule_type       = internal::rule<ImplT, T>;
 
     constexpr bitflags() = default;
     constexpr bitflags(bitflags&& rhs) = default;
@@ -339,17 +707,20 @@ public:
     bitflags& operator=(bitflags const& rhs) = default;
 
     bitflags& operator=(T bits) noexcept {
+        PolicyT::template on_change<ImplT>(this, curr_.bits, bits);
         curr_.bits = bits;
         curr_.name = "";
         return *this;
     }
 
     bitflags& operator=(flag_type&& rhs) noexcept {
+        PolicyT::template on_change<ImplT>(this, curr_.bits, rhs.bits);
         curr_ = std::move(rhs);
         return *this;
     }
 
     bitflags& operator=(flag_type const& rhs) noexcept {
+        PolicyT::template on_change<ImplT>(this, curr_.bits, rhs.bits);
         curr_ = rhs;
         return *this;
     }
@@ -379,9 +750,23 @@ public:
     NODISCARD friend constexpr bitflags operator|(bitflags const& lhs, flag_type const& rhs) noexcept { return lhs.curr_ | rhs; }
     NODISCARD friend constexpr bitflags operator^(bitflags const& lhs, flag_type const& rhs) noexcept { return lhs.curr_ ^ rhs; }
 
-    NON_CONST_CONSTEXPR bitflags& operator&=(flag_type const& rhs) noexcept { curr_ &= rhs; return *this; }
-    NON_CONST_CONSTEXPR bitflags& operator|=(flag_type const& rhs) noexcept { curr_ |= rhs; return *this; }
-    NON_CONST_CONSTEXPR bitflags& operator^=(flag_type const& rhs) noexcept { curr_ ^= rhs; return *this; }
+    NON_CONST_CONSTEXPR bitflags& operator&=(flag_type const& rhs) noexcept {
+        PolicyT::template on_change<ImplT>(this, curr_.bits, static_cast<T>(curr_.bits & rhs.bits));
+        curr_ &= rhs;
+        return *this;
+    }
+
+    NON_CONST_CONSTEXPR bitflags& operator|=(flag_type const& rhs) noexcept {
+        PolicyT::template on_change<ImplT>(this, curr_.bits, static_cast<T>(curr_.bits | rhs.bits));
+        curr_ |= rhs;
+        return *this;
+    }
+
+    NON_CONST_CONSTEXPR bitflags& operator^=(flag_type const& rhs) noexcept {
+        PolicyT::template on_change<ImplT>(this, curr_.bits, static_cast<T>(curr_.bits ^ rhs.bits));
+        curr_ ^= rhs;
+        return *this;
+    }
 
     /**
      * Gets an underlying bits of current set of flags.
@@ -438,7 +823,8 @@ public:
      *         current set of flags, otherwise false
      */
     NODISCARD constexpr bool contains(flag_type const& rhs) const noexcept {
-        return static_cast<T>(curr_ & rhs) || rhs == empty();
+        return (void)PolicyT::template on_contains<ImplT>(rhs.bits),
+            static_cast<T>(curr_ & rhs) || rhs == empty();
     }
 
     /**
@@ -462,15 +848,32 @@ public:
      * @param rhs Flag to be set
      */
     NON_CONST_CONSTEXPR void set(flag_type const& rhs) noexcept {
+        PolicyT::template on_set<ImplT>(rhs.bits);
+        PolicyT::template on_change<ImplT>(this, curr_.bits, static_cast<T>(curr_.bits | rhs.bits));
         curr_ |= rhs;
     }
 
+    /**
+     * Sets specified flag together with all the flags it implies,
+     * directly or transitively.
+     *
+     * @param rhs Flag to be set
+     */
+    void set_with_implied(flag_type const& rhs) noexcept {
+        T const bits = static_cast<T>(curr_.bits | internal::implied_mask<bitflags>(rhs.bits));
+        PolicyT::template on_set<ImplT>(rhs.bits);
+        PolicyT::template on_change<ImplT>(this, curr_.bits, bits);
+        curr_.bits = bits;
+    }
+
     /**
      * Unsets specified flag.
      *
      * @param rhs Flag to be unset
      */
     NON_CONST_CONSTEXPR void remove(flag_type const& rhs) noexcept {
+        PolicyT::template on_remove<ImplT>(rhs.bits);
+        PolicyT::template on_change<ImplT>(this, curr_.bits, static_cast<T>(curr_.bits & ~rhs.bits));
         curr_ &= ~rhs;
     }
 
@@ -481,6 +884,8 @@ public:
      * @param rhs Flag to be toggled
      */
     NON_CONST_CONSTEXPR void toggle(flag_type const& rhs) noexcept {
+        PolicyT::template on_toggle<ImplT>(rhs.bits);
+        PolicyT::template on_change<ImplT>(this, curr_.bits, static_cast<T>(curr_.bits ^ rhs.bits));
         curr_ ^= rhs;
     }
 
@@ -488,13 +893,450 @@ public:
      * Clears all flags currently set.
      */
     NON_CONST_CONSTEXPR void clear() noexcept {
+        PolicyT::template on_change<ImplT>(this, curr_.bits, T{});
         curr_ = T{};
     }
 
+    /**
+     * Sets specified flag and unsets all the flags that are mutually
+     * exclusive with it, in a single masked write. Flags that do not
+     * belong to any group are just set.
+     *
+     * @param rhs Flag to switch to
+     */
+    void switch_to(flag_type const& rhs) noexcept {
+        T const bits = static_cast<T>((curr_.bits & ~internal::exclusive_mask<bitflags>(rhs.bits)) | rhs.bits);
+        PolicyT::template on_set<ImplT>(rhs.bits);
+        PolicyT::template on_change<ImplT>(this, curr_.bits, bits);
+        curr_.bits = bits;
+    }
+
+    /**
+     * Gets the flag of the group that is currently set.
+     *
+     * @param group Group of mutually exclusive flags
+     *
+     * @return Flag of the group that is currently set, or an empty
+     *         flag if none of them is set
+     */
+    NODISCARD flag_type which(group_type const& group) const noexcept {
+        return internal::group_member<bitflags>(static_cast<T>(curr_.bits & group.mask));
+    }
+
 private:
     flag_type curr_;
 };
 
+namespace internal {
+
+/**
+ * struct flags_table
+ *
+ * Table of all the flags declared within the set of flags, in the
+ * order of their declaration.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <
+    typename BitflagsT,
+    typename IndicesT = typename make_sequence<BitflagsT::end_ - BitflagsT::begin_ - 1>::type
+>
+struct flags_table;
+
+template <typename BitflagsT, std::size_t ... I>
+struct flags_table<BitflagsT, sequence<I...>> {
+    using flag_type = typename BitflagsT::flag_type;
+
+    static constexpr flag_type values[sizeof...(I)] = {
+        BitflagsT::flag_at_(position<static_cast<int>(I)>{})...
+    };
+};
+
+#if __cplusplus < 201703L
+template <typename BitflagsT, std::size_t ... I>
+constexpr typename BitflagsT::flag_type flags_table<BitflagsT, sequence<I...>>::values[sizeof...(I)];
+#endif
+
+/**
+ * Gets the bits of the group if it contains the specified bit.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param group Group of mutually exclusive flags
+ * @param bit   Index of the bit
+ *
+ * @return Bits of the group if it contains the bit, otherwise 0
+ */
+template <typename GroupT>
+constexpr std::uint64_t group_containing(GroupT const& group, int const bit) noexcept {
+    return (static_cast<std::uint64_t>(group.mask) >> bit) & 1U ? group.mask : 0;
+}
+
+/**
+ * Gets the bitwise OR of all the specified masks.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @return Bitwise OR of the masks
+ */
+constexpr std::uint64_t or_all() noexcept {
+    return 0;
+}
+
+template <typename ... U>
+constexpr std::uint64_t or_all(std::uint64_t const head, U const ... tail) noexcept {
+    return head | or_all(tail...);
+}
+
+/**
+ * struct exclusion_table
+ *
+ * Table of the flags that are mutually exclusive with each bit, i.e.
+ * bits of all the groups containing the bit.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <
+    typename BitflagsT,
+    typename IndicesT = typename make_sequence<BitflagsT::end_ - BitflagsT::begin_ - 1>::type,
+    typename BitsT = typename make_sequence<sizeof(typename BitflagsT::underlying_type) * 8>::type
+>
+struct exclusion_table;
+
+template <typename BitflagsT, std::size_t ... I, std::size_t ... B>
+struct exclusion_table<BitflagsT, sequence<I...>, sequence<B...>> {
+    using underlying_type = typename BitflagsT::underlying_type;
+
+    static constexpr underlying_type exclusive(int const bit) noexcept {
+        return static_cast<underlying_type>(
+            or_all(group_containing(BitflagsT::group_at_(position<static_cast<int>(I)>{}), bit)...)
+        );
+    }
+
+    static constexpr underlying_type values[sizeof...(B)] = {
+        exclusive(static_cast<int>(B))...
+    };
+};
+
+#if __cplusplus < 201703L
+template <typename BitflagsT, std::size_t ... I, std::size_t ... B>
+constexpr typename BitflagsT::underlying_type exclusion_table<BitflagsT, sequence<I...>, sequence<B...>>::values[sizeof...(B)];
+#endif
+
+/**
+ * Gets the flags that are mutually exclusive with the lowest set bit,
+ * including the bit itself.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param bits Bits of the flag
+ *
+ * @return Mask of the mutually exclusive flags
+ */
+template <typename BitflagsT>
+inline typename BitflagsT::underlying_type exclusive_mask(typename BitflagsT::underlying_type const bits) noexcept {
+    return bits == 0 ? bits : exclusion_table<BitflagsT>::values[ctz(bits)];
+}
+
+/**
+ * Gets the declared flag occupying the single set bit. Raw flags
+ * consist of bits only, so the bits are the flag itself. Ordinary
+ * flags are looked up in the table of declared flags for their name.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param bits Bits of the flag
+ *
+ * @return Declared flag or an empty flag if no bit is set
+ */
+template <typename BitflagsT>
+inline typename BitflagsT::flag_type group_member(typename BitflagsT::underlying_type const bits) noexcept {
+    using flag_type = typename BitflagsT::flag_type;
+    if (sizeof(flag_type) == sizeof(bits) || bits == 0) {
+        return flag_type(bits);
+    }
+    return flags_table<BitflagsT>::values[ctz(bits) + 1];
+}
+
+/**
+ * Gets the flags implied by the rule if it applies to any of the
+ * specified bits.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param rule Rule between flags
+ * @param bits Bits of the flags
+ *
+ * @return Implied flags, or 0 if the rule does not apply
+ */
+template <typename RuleT>
+constexpr std::uint64_t rule_implies(RuleT const& rule, std::uint64_t const bits) noexcept {
+    return !rule.conflict && (rule.from & bits) ? rule.to : 0;
+}
+
+/**
+ * Gets the flags conflicting with the specified bit by the rule.
+ * Conflicts are symmetric.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param rule Rule between flags
+ * @param bit  Index of the bit
+ *
+ * @return Conflicting flags, or 0 if the rule does not apply
+ */
+template <typename RuleT>
+constexpr std::uint64_t rule_conflicts(RuleT const& rule, int const bit) noexcept {
+    return !rule.conflict ? 0
+        : ((static_cast<std::uint64_t>(rule.from) >> bit) & 1U ? rule.to : 0)
+        | ((static_cast<std::uint64_t>(rule.to) >> bit) & 1U ? rule.from : 0);
+}
+
+/**
+ * Checks whether all the specified conditions hold.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @return True if all the conditions hold, otherwise false
+ */
+constexpr bool all_of() noexcept {
+    return true;
+}
+
+template <typename ... U>
+constexpr bool all_of(bool const head, U const ... tail) noexcept {
+    return head && all_of(tail...);
+}
+
+/**
+ * struct rules_table
+ *
+ * Tables of the flags implied by each bit, closed transitively, and
+ * of the flags conflicting with each bit. Declared rules are checked
+ * so that no flag implies two conflicting flags.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <
+    typename BitflagsT,
+    typename IndicesT = typename make_sequence<BitflagsT::end_ - BitflagsT::begin_ - 1>::type,
+    typename BitsT = typename make_sequence<sizeof(typename BitflagsT::underlying_type) * 8>::type
+>
+struct rules_table;
+
+template <typename BitflagsT, std::size_t ... I, std::size_t ... B>
+struct rules_table<BitflagsT, sequence<I...>, sequence<B...>> {
+    using underlying_type = typename BitflagsT::underlying_type;
+
+    static constexpr std::uint64_t expand(std::uint64_t const bits) noexcept {
+        return bits | or_all(rule_implies(BitflagsT::rule_at_(position<static_cast<int>(I)>{}), bits)...);
+    }
+
+    static constexpr std::uint64_t close(std::uint64_t const bits, std::uint64_t const expanded) noexcept {
+        return bits == expanded ? bits : close(expanded, expand(expanded));
+    }
+
+    static constexpr std::uint64_t implied_by(int const bit) noexcept {
+        return close(std::uint64_t{1} << bit, expand(std::uint64_t{1} << bit));
+    }
+
+    static constexpr std::uint64_t conflicting_with(int const bit) noexcept {
+        return or_all(rule_conflicts(BitflagsT::rule_at_(position<static_cast<int>(I)>{}), bit)...);
+    }
+
+    static constexpr bool consistent(std::uint64_t const bits, int const bit = 0) noexcept {
+        return bit == static_cast<int>(sizeof...(B))
+            || (!(((bits >> bit) & 1U) && (conflicting_with(bit) & bits)) && consistent(bits, bit + 1));
+    }
+
+    static_assert(all_of(consistent(implied_by(static_cast<int>(B)))...), "bitflags: flag implies conflicting flags");
+
+    static constexpr underlying_type implied[sizeof...(B)] = {
+        static_cast<underlying_type>(implied_by(static_cast<int>(B)))...
+    };
+
+    static constexpr underlying_type conflicting[sizeof...(B)] = {
+        static_cast<underlying_type>(conflicting_with(static_cast<int>(B)))...
+    };
+};
+
+#if __cplusplus < 201703L
+template <typename BitflagsT, std::size_t ... I, std::size_t ... B>
+constexpr typename BitflagsT::underlying_type rules_table<BitflagsT, sequence<I...>, sequence<B...>>::implied[sizeof...(B)];
+
+template <typename BitflagsT, std::size_t ... I, std::size_t ... B>
+constexpr typename BitflagsT::underlying_type rules_table<BitflagsT, sequence<I...>, sequence<B...>>::conflicting[sizeof...(B)];
+#endif
+
+/**
+ * Gets the specified flags together with all the flags they imply.
+ * Costs a single table lookup per set bit.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param bits Bits of the flags
+ *
+ * @return Bits of the flags and their implied flags
+ */
+template <typename BitflagsT>
+inline typename BitflagsT::underlying_type implied_mask(typename BitflagsT::underlying_type bits) noexcept {
+    using underlying_type = typename BitflagsT::underlying_type;
+    underlying_type result = bits;
+    while (bits != 0) {
+        result = static_cast<underlying_type>(result | rules_table<BitflagsT>::implied[ctz(bits)]);
+        bits = static_cast<underlying_type>(bits & (bits - 1));
+    }
+    return result;
+}
+
+/**
+ * struct flags_range
+ *
+ * Range over the flags declared within the set of flags.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <typename FlagT>
+struct flags_range {
+    FlagT const* first;
+    FlagT const* last;
+
+    NODISCARD constexpr FlagT const* begin() const noexcept { return first; }
+    NODISCARD constexpr FlagT const* end() const noexcept { return last; }
+
+    NODISCARD constexpr std::size_t size() const noexcept {
+        return static_cast<std::size_t>(last - first);
+    }
+
+    NODISCARD constexpr FlagT const& operator[](std::size_t const index) const noexcept {
+        return first[index];
+    }
+};
+
+/**
+ * struct rebind_policy
+ *
+ * Provides member typedef type which is defined as the same set of
+ * flags with the instrumentation policy replaced by PolicyT.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <typename BitflagsT, typename PolicyT>
+struct rebind_policy;
+
+template <
+    typename ImplT,
+    typename T,
+#if __cplusplus >= 201703L
+    template <typename, typename> typename FlagT,
+#else
+    template <typename, typename> class FlagT,
+#endif
+    typename OldPolicyT,
+    typename PolicyT
+>
+struct rebind_policy<bitflags<ImplT, T, FlagT, OldPolicyT>, PolicyT> {
+    using type = bitflags<ImplT, T, FlagT, PolicyT>;
+};
+
+} // internal
+
+/**
+ * Gets all the flags declared within the set of flags, in the order
+ * of their declaration. Flag declared at index i occupies the bit
+ * i - 1, i.e. the first declared flag is always the empty one.
+ * Lines within the declaration that do not declare any flag show up
+ * as empty flags.
+ *
+ * NOTE: In C++11, all the flags need to be defined by DEFINE_FLAG.
+ *
+ * @return Range of declared flags
+ */
+template <typename BitflagsT>
+NODISCARD constexpr internal::flags_range<typename BitflagsT::flag_type> declared_flags() noexcept {
+    return {
+        internal::flags_table<BitflagsT>::values,
+        internal::flags_table<BitflagsT>::values + (BitflagsT::end_ - BitflagsT::begin_ - 1)
+    };
+}
+
+/**
+ * Gets the specified flags together with all the flags they imply,
+ * directly or transitively.
+ *
+ * @param flags Set of flags
+ *
+ * @return Closure of the set of flags
+ */
+template <typename BitflagsT>
+NODISCARD inline BitflagsT closure(BitflagsT const& flags) noexcept {
+    return BitflagsT(internal::implied_mask<BitflagsT>(flags.bits()));
+}
+
+/**
+ * Checks whether the closure of the specified flags contains two
+ * flags declared as conflicting.
+ *
+ * @param flags Set of flags
+ *
+ * @return True if any two flags conflict, otherwise false
+ */
+template <typename BitflagsT>
+NODISCARD inline bool has_conflicts(BitflagsT const& flags) noexcept {
+    using underlying_type = typename BitflagsT::underlying_type;
+    underlying_type const all = internal::implied_mask<BitflagsT>(flags.bits());
+    for (underlying_type bits = all; bits != 0; bits = static_cast<underlying_type>(bits & (bits - 1))) {
+        if (internal::rules_table<BitflagsT>::conflicting[internal::ctz(bits)] & all) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Replaces each set of flags within the array by its closure. Arrays
+ * are processed in blocks, one implying bit at a time, so that the
+ * inner loop is branchless and vectorized by the compiler.
+ *
+ * @param flags Array of sets of flags
+ * @param count Number of sets of flags
+ */
+template <typename BitflagsT>
+inline void normalize(BitflagsT* flags, std::size_t const count) noexcept {
+    using underlying_type = typename BitflagsT::underlying_type;
+    using table = internal::rules_table<BitflagsT>;
+
+    constexpr std::size_t block_size = 256;
+    underlying_type src[block_size];
+    underlying_type dst[block_size];
+
+    for (std::size_t first = 0; first < count; first += block_size) {
+        std::size_t const size = std::min(count - first, block_size);
+        internal::load_block(flags + first, size, src);
+        std::memcpy(dst, src, size * sizeof(underlying_type));
+
+        for (int bit = 0; bit < static_cast<int>(sizeof(underlying_type) * 8); ++bit) {
+            underlying_type const implied = table::implied[bit];
+            if (implied == static_cast<underlying_type>(underlying_type{1} << bit)) {
+                continue;
+            }
+            for (std::size_t i = 0; i < size; ++i) {
+                dst[i] = static_cast<underlying_type>(dst[i] | (implied & (0 - ((src[i] >> bit) & 1U))));
+            }
+        }
+
+        for (std::size_t i = 0; i < size; ++i) {
+            flags[first + i] = BitflagsT(dst[i]);
+        }
+    }
+}
+
+/**
+ * Same set of flags as BitflagsT, but instrumented by PolicyT.
+ */
+template <typename BitflagsT, typename PolicyT>
+using with_policy = typename internal::rebind_policy<BitflagsT, PolicyT>::type;
+
 } // bf
 
 /**
@@ -502,54 +1344,106 @@ private:
  * i.e. flags without string representation.
  */
 
-#define BEGIN_RAW_BITFLAGS(NAME)                            \
-    template <typename T>                                   \
-    struct NAME##Impl {                                     \
-        using flag = bf::internal::raw_flag<NAME##Impl, T>; \
+#define BEGIN_RAW_BITFLAGS(NAME)                                                   \
+    struct NAME##Begin { static constexpr int line = __LINE__; };                  \
+    template <typename T>                                                          \
+    struct NAME##Impl {                                                            \
+        using flag = bf::internal::raw_flag<NAME##Impl, T>;                        \
+        using group = bf::internal::group<NAME##Impl, T>;                          \
+        using rule = bf::internal::rule<NAME##Impl, T>;                            \
+        template <int I>                                                           \
+        static constexpr flag flag_at_(bf::internal::position<I>) { return {}; }   \
+        template <int I>                                                           \
+        static constexpr group group_at_(bf::internal::position<I>) { return {}; } \
+        template <int I>                                                           \
+        static constexpr rule rule_at_(bf::internal::position<I>) { return {}; }   \
         static constexpr int begin_ = __LINE__;
 
 #define END_RAW_BITFLAGS(NAME)                                                   \
         static constexpr int end_   = __LINE__;                                  \
     };                                                                           \
     using NAME = bf::bitflags<                                                   \
-        NAME##Impl< bf::bitflags< NAME##Impl<std::uint8_t> >::underlying_type >, \
-        bf::bitflags< NAME##Impl<std::uint8_t> >::underlying_type,               \
+        NAME##Impl< bf::internal::min_t<__LINE__ - NAME##Begin::line + 1> >,     \
+        bf::internal::min_t<__LINE__ - NAME##Begin::line + 1>,                   \
         bf::internal::raw_flag                                                   \
     >;
 
-#define RAW_FLAG(NAME) \
-    static constexpr flag NAME{ bf::internal::shift<T>(__LINE__ - begin_ - 2) };
+#define RAW_FLAG(NAME)                                                                 \
+    static constexpr flag NAME{ bf::internal::shift<T>(__LINE__ - begin_ - 2) };       \
+    static constexpr flag flag_at_(bf::internal::position<__LINE__ - begin_ - 1>) { return NAME; }
 
 /**
  * Macros used for creating set of ordinary flags,
  * i.e. flags with string representation.
  */
 
-#define BEGIN_BITFLAGS(NAME)                            \
-    template <typename T>                               \
-    struct NAME##Impl {                                 \
-        using flag = bf::internal::flag<NAME##Impl, T>; \
+#define BEGIN_BITFLAGS(NAME)                                                       \
+    struct NAME##Begin { static constexpr int line = __LINE__; };                  \
+    template <typename T>                                                          \
+    struct NAME##Impl {                                                            \
+        using flag = bf::internal::flag<NAME##Impl, T>;                            \
+        using group = bf::internal::group<NAME##Impl, T>;                          \
+        using rule = bf::internal::rule<NAME##Impl, T>;                            \
+        template <int I>                                                           \
+        static constexpr flag flag_at_(bf::internal::position<I>) { return {}; }   \
+        template <int I>                                                           \
+        static constexpr group group_at_(bf::internal::position<I>) { return {}; } \
+        template <int I>                                                           \
+        static constexpr rule rule_at_(bf::internal::position<I>) { return {}; }   \
         static constexpr int begin_ = __LINE__;
 
 #define END_BITFLAGS(NAME)                                                      \
         static constexpr int end_   = __LINE__;                                 \
     };                                                                          \
     using NAME = bf::bitflags<                                                  \
-        NAME##Impl< bf::bitflags< NAME##Impl<std::uint8_t> >::underlying_type > \
+        NAME##Impl< bf::internal::min_t<__LINE__ - NAME##Begin::line + 1> >,    \
+        bf::internal::min_t<__LINE__ - NAME##Begin::line + 1>                   \
     >;
 
-#define FLAG(NAME) \
-    static constexpr flag NAME{ bf::internal::shift<T>(__LINE__ - begin_ - 2), #NAME };
+#define FLAG(NAME)                                                                     \
+    static constexpr flag NAME{ bf::internal::shift<T>(__LINE__ - begin_ - 2), #NAME }; \
+    static constexpr flag flag_at_(bf::internal::position<__LINE__ - begin_ - 1>) { return NAME; }
+
+/**
+ * Macro used for declaring group of mutually exclusive flags within
+ * the set of flags. Group has to be declared after all of its flags.
+ */
+
+#define GROUP(NAME, ...)                                                                             \
+    static_assert(bf::internal::one_hot<T>(__VA_ARGS__), "bitflags: group of non-single flags");    \
+    static constexpr group NAME{ bf::internal::group_bits<T>(__VA_ARGS__) };                         \
+    static constexpr group group_at_(bf::internal::position<__LINE__ - begin_ - 1>) { return NAME; }
+
+/**
+ * Macros used for declaring rules between flags within the set of
+ * flags. Rules have to be declared after all of their flags.
+ */
+
+#define IMPLIES(FROM, ...)                                                                           \
+    static_assert(bf::internal::one_hot<T>(FROM), "bitflags: rule of non-single flag");             \
+    static constexpr rule rule_at_(bf::internal::position<__LINE__ - begin_ - 1>) {                  \
+        return { FROM.bits, bf::internal::group_bits<T>(__VA_ARGS__), false };                       \
+    }
+
+#define CONFLICTS(FROM, ...)                                                                         \
+    static_assert(bf::internal::one_hot<T>(FROM), "bitflags: rule of non-single flag");             \
+    static constexpr rule rule_at_(bf::internal::position<__LINE__ - begin_ - 1>) {                  \
+        return { FROM.bits, bf::internal::group_bits<T>(__VA_ARGS__), true };                        \
+    }
 
 #if __cplusplus < 201703L
 #   define DEFINE_FLAG(BITFLAGS_NAME, FLAG_NAME) \
         template <typename T>                    \
         typename BITFLAGS_NAME##Impl<T>::flag const BITFLAGS_NAME##Impl<T>::FLAG_NAME;
+#   define DEFINE_GROUP(BITFLAGS_NAME, GROUP_NAME) \
+        template <typename T>                      \
+        typename BITFLAGS_NAME##Impl<T>::group const BITFLAGS_NAME##Impl<T>::GROUP_NAME;
 #else
     // C++17 and greater:
     // An inline static data member can be defined in the class definition and may specify an initializer.
     // It does not need an out-of-class definition.
 #   define DEFINE_FLAG(BITFLAGS_NAME, FLAG_NAME)
+#   define DEFINE_GROUP(BITFLAGS_NAME, GROUP_NAME)
 #endif
 
 #endif // BITFLAGS_HPP
\ No newline at end of file
@@ -0,0 +1,397 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_COMPOSITE_HPP
+#define BITFLAGS_COMPOSITE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "bitflags.hpp"
+
+namespace bf {
+
+namespace internal {
+
+/**
+ * struct declared_width
+ *
+ * Number of bits that can be occupied by the flags declared within
+ * the set of flags.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <typename BitflagsT>
+struct declared_width {
+    static constexpr int value = BitflagsT::end_ - BitflagsT::begin_ - 2;
+};
+
+/**
+ * struct total_width
+ *
+ * Sum of the declared widths of all the sets of flags.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <typename ... BitflagsT>
+struct total_width {
+    static constexpr int value = 0;
+};
+
+template <typename HeadT, typename ... TailT>
+struct total_width<HeadT, TailT...> {
+    static constexpr int value = declared_width<HeadT>::value + total_width<TailT...>::value;
+};
+
+/**
+ * struct member_offset
+ *
+ * Offset of the set of flags BitflagsT within the composite of
+ * MembersT, i.e. the sum of the declared widths of all the sets
+ * preceding it. Undefined if BitflagsT is not a member.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <typename BitflagsT, typename ... MembersT>
+struct member_offset;
+
+template <typename BitflagsT, typename ... TailT>
+struct member_offset<BitflagsT, BitflagsT, TailT...> {
+    static constexpr int value = 0;
+};
+
+template <typename BitflagsT, typename HeadT, typename ... TailT>
+struct member_offset<BitflagsT, HeadT, TailT...> {
+    static constexpr int value = declared_width<HeadT>::value + member_offset<BitflagsT, TailT...>::value;
+};
+
+/**
+ * Places bits of the set of flags at the specified offset of the
+ * composite word. Bits outside of the declared flags are dropped.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param bits Underlying bits of the set of flags
+ *
+ * @return Bits within the composite word
+ */
+template <typename T, typename BitflagsT, int Offset>
+constexpr T place(typename BitflagsT::underlying_type const bits) noexcept {
+    return static_cast<T>(
+        static_cast<T>(bits & declared_mask<BitflagsT, typename BitflagsT::underlying_type>()) << Offset
+    );
+}
+
+/**
+ * Packs all the sets of flags into the composite word.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @return Composite word
+ */
+template <typename T, typename ... MembersT>
+constexpr T pack() noexcept {
+    return T{};
+}
+
+template <typename T, typename ... MembersT, typename HeadT, typename ... TailT>
+constexpr T pack(HeadT const& head, TailT const& ... tail) noexcept {
+    return static_cast<T>(
+        place<T, HeadT, member_offset<HeadT, MembersT...>::value>(head.bits()) | pack<T, MembersT...>(tail...)
+    );
+}
+
+} // internal
+
+/**
+ * class composite_view
+ *
+ * Typed view of the set of flags BitflagsT stored at the offset
+ * Offset within the composite word of type WordT. All the operations
+ * are done directly on the composite word. Views of const words
+ * support only non-modifying operations.
+ */
+template <typename WordT, typename BitflagsT, int Offset>
+class composite_view {
+public:
+    using value_type      = BitflagsT;
+    using flag_type       = typename BitflagsT::flag_type;
+    using underlying_type = typename BitflagsT::underlying_type;
+    using word_type       = typename std::remove_const<WordT>::type;
+
+    explicit constexpr composite_view(WordT& word) noexcept
+        : word_(word)
+    {}
+
+    constexpr composite_view(composite_view const& rhs) = default;
+
+    composite_view& operator=(composite_view const& rhs) noexcept {
+        return *this = rhs.value();
+    }
+
+    NON_CONST_CONSTEXPR composite_view& operator=(BitflagsT const& rhs) noexcept {
+        word_ = static_cast<word_type>((word_ & ~mask()) | internal::place<word_type, BitflagsT, Offset>(rhs.bits()));
+        return *this;
+    }
+
+    NON_CONST_CONSTEXPR composite_view& operator=(flag_type const& rhs) noexcept {
+        word_ = static_cast<word_type>((word_ & ~mask()) | internal::place<word_type, BitflagsT, Offset>(rhs.bits));
+        return *this;
+    }
+
+    NODISCARD constexpr operator BitflagsT() const noexcept {
+        return value();
+    }
+
+    NODISCARD constexpr bool operator==(flag_type const& rhs) const noexcept { return bits() == rhs.bits; }
+    NODISCARD constexpr bool operator!=(flag_type const& rhs) const noexcept { return bits() != rhs.bits; }
+
+    /**
+     * Bitwise operators overloads
+     *
+     *     <op> composite_view
+     *
+     *     composite_view <op>  flag_type
+     *
+     *     composite_view <op>= flag_type
+     */
+
+    NODISCARD friend constexpr BitflagsT operator~(composite_view const& rhs) noexcept { return ~rhs.value(); }
+
+    NODISCARD friend constexpr BitflagsT operator&(composite_view const& lhs, flag_type const& rhs) noexcept { return lhs.value() & rhs; }
+    NODISCARD friend constexpr BitflagsT operator|(composite_view const& lhs, flag_type const& rhs) noexcept { return lhs.value() | rhs; }
+    NODISCARD friend constexpr BitflagsT operator^(composite_view const& lhs, flag_type const& rhs) noexcept { return lhs.value() ^ rhs; }
+
+    NON_CONST_CONSTEXPR composite_view& operator&=(flag_type const& rhs) noexcept {
+        word_ = static_cast<word_type>(word_ & (internal::place<word_type, BitflagsT, Offset>(rhs.bits) | ~mask()));
+        return *this;
+    }
+
+    NON_CONST_CONSTEXPR composite_view& operator|=(flag_type const& rhs) noexcept {
+        word_ = static_cast<word_type>(word_ | internal::place<word_type, BitflagsT, Offset>(rhs.bits));
+        return *this;
+    }
+
+    NON_CONST_CONSTEXPR composite_view& operator^=(flag_type const& rhs) noexcept {
+        word_ = static_cast<word_type>(word_ ^ internal::place<word_type, BitflagsT, Offset>(rhs.bits));
+        return *this;
+    }
+
+    /**
+     * Gets the mask of the bits occupied by the set of flags within
+     * the composite word.
+     *
+     * @return Mask of the set of flags
+     */
+    NODISCARD static constexpr word_type mask() noexcept {
+        return internal::place<word_type, BitflagsT, Offset>(static_cast<underlying_type>(~underlying_type{}));
+    }
+
+    /**
+     * Gets an underlying bits of the set of flags.
+     *
+     * @return Underlying bits
+     */
+    NODISCARD constexpr underlying_type bits() const noexcept {
+        return static_cast<underlying_type>((word_ & mask()) >> Offset);
+    }
+
+    /**
+     * Gets a copy of the set of flags.
+     *
+     * @return Set of flags
+     */
+    NODISCARD constexpr BitflagsT value() const noexcept {
+        return BitflagsT(bits());
+    }
+
+    /**
+     * Checks whether no flag is currently set.
+     *
+     * @return True if no flag is currently set, otherwise false
+     */
+    NODISCARD constexpr bool is_empty() const noexcept {
+        return (word_ & mask()) == 0;
+    }
+
+    /**
+     * Checks whether all declared flags are currently set.
+     *
+     * @return True if all declared flags are currently set, otherwise false
+     */
+    NODISCARD constexpr bool is_all() const noexcept {
+        return (word_ & mask()) == mask();
+    }
+
+    /**
+     * Checks whether specified flag is contained within the current
+     * set of flags. Zero flags are treated as always present.
+     *
+     * @param rhs Flag to check
+     *
+     * @return True if the specified flags is contained within the
+     *         current set of flags, otherwise false
+     */
+    NODISCARD constexpr bool contains(flag_type const& rhs) const noexcept {
+        return (word_ & internal::place<word_type, BitflagsT, Offset>(rhs.bits)) != 0 || rhs.bits == 0;
+    }
+
+    /**
+     * Checks whether all the specified flags are contained within the
+     * current set of flags. Zero flags are treated as always present.
+     *
+     * @param rhs_1 First flag to check
+     * @param rhs_n Other flags to check
+     *
+     * @return True if all the specified flags are contained within the
+     *         current set of flags, otherwise false
+     */
+    template <typename ... U>
+    NODISCARD constexpr bool contains(flag_type const& rhs_1, U const& ... rhs_n) const noexcept {
+        return contains(rhs_1) && contains(rhs_n...);
+    }
+
+    /**
+     * Sets specified flag.
+     *
+     * @param rhs Flag to be set
+     */
+    NON_CONST_CONSTEXPR void set(flag_type const& rhs) noexcept {
+        *this |= rhs;
+    }
+
+    /**
+     * Unsets specified flag.
+     *
+     * @param rhs Flag to be unset
+     */
+    NON_CONST_CONSTEXPR void remove(flag_type const& rhs) noexcept {
+        word_ = static_cast<word_type>(word_ & ~internal::place<word_type, BitflagsT, Offset>(rhs.bits));
+    }
+
+    /**
+     * Sets specified flag if not already present.
+     * Otherwise, unsets the specified flag.
+     *
+     * @param rhs Flag to be toggled
+     */
+    NON_CONST_CONSTEXPR void toggle(flag_type const& rhs) noexcept {
+        *this ^= rhs;
+    }
+
+    /**
+     * Clears all flags currently set.
+     */
+    NON_CONST_CONSTEXPR void clear() noexcept {
+        word_ = static_cast<word_type>(word_ & ~mask());
+    }
+
+private:
+    WordT& word_;
+};
+
+/**
+ * class composite
+ *
+ * Several independent sets of flags laid out one after another into
+ * the single minimal underlying integer. Each set occupies only the
+ * bits of its declared flags and is accessed through the typed view.
+ */
+template <typename ... BitflagsT>
+class composite {
+public:
+    using underlying_type = internal::min_t<internal::total_width<BitflagsT...>::value>;
+
+    static_assert(internal::total_width<BitflagsT...>::value <= 64, "composite: flags do not fit into 64 bits");
+
+    template <typename MemberT>
+    using view_type = composite_view<underlying_type, MemberT, internal::member_offset<MemberT, BitflagsT...>::value>;
+
+    template <typename MemberT>
+    using const_view_type = composite_view<underlying_type const, MemberT, internal::member_offset<MemberT, BitflagsT...>::value>;
+
+    constexpr composite() noexcept
+        : bits_(0)
+    {}
+
+    explicit constexpr composite(BitflagsT const& ... members) noexcept
+        : bits_(internal::pack<underlying_type, BitflagsT...>(members...))
+    {}
+
+    NODISCARD constexpr bool operator==(composite const& rhs) const noexcept { return bits_ == rhs.bits_; }
+    NODISCARD constexpr bool operator!=(composite const& rhs) const noexcept { return bits_ != rhs.bits_; }
+
+    /**
+     * Gets the typed view of the member set of flags.
+     *
+     * @return View of the member set of flags
+     */
+    template <typename MemberT>
+    NODISCARD NON_CONST_CONSTEXPR view_type<MemberT> get() noexcept {
+        return view_type<MemberT>(bits_);
+    }
+
+    template <typename MemberT>
+    NODISCARD constexpr const_view_type<MemberT> get() const noexcept {
+        return const_view_type<MemberT>(bits_);
+    }
+
+    /**
+     * Gets an underlying bits of all the sets of flags.
+     *
+     * @return Underlying bits
+     */
+    NODISCARD constexpr underlying_type bits() const noexcept {
+        return bits_;
+    }
+
+    /**
+     * Checks whether no flag of any set is currently set.
+     *
+     * @return True if no flag is currently set, otherwise false
+     */
+    NODISCARD constexpr bool is_empty() const noexcept {
+        return bits_ == 0;
+    }
+
+    /**
+     * Clears all flags of all the sets.
+     */
+    NON_CONST_CONSTEXPR void clear() noexcept {
+        bits_ = 0;
+    }
+
+private:
+    underlying_type bits_;
+};
+
+} // bf
+
+#endif // BITFLAGS_COMPOSITE_HPP
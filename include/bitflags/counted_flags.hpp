@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_COUNTED_FLAGS_HPP
+#define BITFLAGS_COUNTED_FLAGS_HPP
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "bitflags.hpp"
+
+#if BITFLAGS_HAS_PMR
+#include <memory_resource>
+#endif
+
+namespace bf {
+
+/**
+ * class counted_flags
+ *
+ * Array of flags that keeps the number of elements having each of
+ * the flags set up to date. Every modification updates the counters
+ * by visiting only the bits that have actually changed, so that
+ * reading the counters never requires a pass over the elements.
+ * Elements are allocated by AllocatorT.
+ */
+template <typename BitflagsT, typename AllocatorT = std::allocator<BitflagsT>>
+class counted_flags {
+public:
+    using value_type      = BitflagsT;
+    using flag_type       = typename BitflagsT::flag_type;
+    using underlying_type = typename BitflagsT::underlying_type;
+    using size_type       = std::size_t;
+    using allocator_type  = AllocatorT;
+    using const_iterator  = typename std::vector<BitflagsT, AllocatorT>::const_iterator;
+
+    static constexpr std::size_t bits_count = sizeof(underlying_type) * 8;
+
+    counted_flags() noexcept
+        : counts_()
+    {}
+
+    explicit counted_flags(AllocatorT const& alloc) noexcept
+        : values_(alloc)
+        , counts_()
+    {}
+
+    explicit counted_flags(size_type const count, BitflagsT const& value = BitflagsT{}, AllocatorT const& alloc = AllocatorT())
+        : values_(count, value, alloc)
+        , counts_()
+    {
+        add(underlying_type{}, value.bits(), count);
+    }
+
+    template <typename InputIt>
+    counted_flags(InputIt first, InputIt last, AllocatorT const& alloc = AllocatorT())
+        : values_(first, last, alloc)
+        , counts_()
+    {
+        for (auto const& value : values_) {
+            add(underlying_type{}, value.bits(), 1);
+        }
+    }
+
+    NODISCARD allocator_type get_allocator() const noexcept {
+        return values_.get_allocator();
+    }
+
+    /**
+     * Gets the number of elements.
+     *
+     * @return Number of elements
+     */
+    NODISCARD size_type size() const noexcept {
+        return values_.size();
+    }
+
+    /**
+     * Checks whether there are no elements.
+     *
+     * @return True if there are no elements, otherwise false
+     */
+    NODISCARD bool empty() const noexcept {
+        return values_.empty();
+    }
+
+    /**
+     * Gets flags of the specified element. Elements are read-only
+     * since counters would get out of sync otherwise.
+     *
+     * @param index Index of the element
+     *
+     * @return Flags of the element
+     */
+    NODISCARD BitflagsT const& operator[](size_type const index) const noexcept {
+        return values_[index];
+    }
+
+    NODISCARD BitflagsT const* data() const noexcept { return values_.data(); }
+
+    NODISCARD const_iterator begin() const noexcept { return values_.begin(); }
+    NODISCARD const_iterator end() const noexcept { return values_.end(); }
+
+    /**
+     * Gets the number of elements that have specified flag set.
+     * Zero flags are treated as always present.
+     *
+     * @param rhs Single flag to count
+     *
+     * @return Number of elements having the flag set
+     */
+    NODISCARD size_type count(flag_type const& rhs) const noexcept {
+        return rhs.bits
+            ? counts_[static_cast<std::size_t>(internal::ctz(rhs.bits))]
+            : values_.size();
+    }
+
+    /**
+     * Gets the number of elements having each bit set, indexed by
+     * bit position.
+     *
+     * @return Counters of all bits
+     */
+    NODISCARD std::array<size_type, bits_count> const& counts() const noexcept {
+        return counts_;
+    }
+
+    /**
+     * Appends an element at the end.
+     *
+     * @param value Flags of the new element
+     */
+    void push_back(BitflagsT const& value) {
+        values_.push_back(value);
+        add(underlying_type{}, value.bits(), 1);
+    }
+
+    /**
+     * Removes the last element.
+     */
+    void pop_back() noexcept {
+        add(values_.back().bits(), underlying_type{}, 1);
+        values_.pop_back();
+    }
+
+    /**
+     * Replaces flags of the specified element.
+     *
+     * @param index Index of the element
+     * @param value New flags of the element
+     */
+    void assign(size_type const index, BitflagsT const& value) noexcept {
+        update(index, value.bits());
+    }
+
+    /**
+     * Sets specified flag of the specified element.
+     *
+     * @param index Index of the element
+     * @param rhs   Flag to be set
+     */
+    void set(size_type const index, flag_type const& rhs) noexcept {
+        update(index, static_cast<underlying_type>(values_[index].bits() | rhs.bits));
+    }
+
+    /**
+     * Unsets specified flag of the specified element.
+     *
+     * @param index Index of the element
+     * @param rhs   Flag to be unset
+     */
+    void remove(size_type const index, flag_type const& rhs) noexcept {
+        update(index, static_cast<underlying_type>(values_[index].bits() & ~rhs.bits));
+    }
+
+    /**
+     * Toggles specified flag of the specified element.
+     *
+     * @param index Index of the element
+     * @param rhs   Flag to be toggled
+     */
+    void toggle(size_type const index, flag_type const& rhs) noexcept {
+        update(index, static_cast<underlying_type>(values_[index].bits() ^ rhs.bits));
+    }
+
+    /**
+     * Clears all flags of the specified element.
+     *
+     * @param index Index of the element
+     */
+    void clear(size_type const index) noexcept {
+        update(index, underlying_type{});
+    }
+
+    /**
+     * Removes all elements and resets counters.
+     */
+    void clear() noexcept {
+        values_.clear();
+        counts_.fill(0);
+    }
+
+private:
+    void update(size_type const index, underlying_type const after) noexcept {
+        underlying_type const before = values_[index].bits();
+        values_[index] = BitflagsT(after);
+        add(before, after, 1);
+    }
+
+    void add(underlying_type const before, underlying_type const after, size_type const n) noexcept {
+        std::uint64_t changed = static_cast<underlying_type>(before ^ after);
+        while (changed) {
+            int const bit = internal::ctz(changed);
+            changed &= changed - 1;
+
+            if ((after >> bit) & 1U) {
+                counts_[static_cast<std::size_t>(bit)] += n;
+            } else {
+                counts_[static_cast<std::size_t>(bit)] -= n;
+            }
+        }
+    }
+
+    std::vector<BitflagsT, AllocatorT> values_;
+    std::array<size_type, bits_count> counts_;
+};
+
+#if __cplusplus < 201703L
+template <typename BitflagsT, typename AllocatorT>
+constexpr std::size_t counted_flags<BitflagsT, AllocatorT>::bits_count;
+#endif
+
+#if BITFLAGS_HAS_PMR
+namespace pmr {
+
+template <typename BitflagsT>
+using counted_flags = bf::counted_flags<BitflagsT, std::pmr::polymorphic_allocator<BitflagsT>>;
+
+} // pmr
+#endif
+
+} // bf
+
+#endif // BITFLAGS_COUNTED_FLAGS_HPP
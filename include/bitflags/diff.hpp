@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_DIFF_HPP
+#define BITFLAGS_DIFF_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "bitflags.hpp"
+
+namespace bf {
+
+/**
+ * struct flag_change
+ *
+ * Single entry of the diff between two arrays of flags.
+ * Masks are kept as underlying type so that the entry stays compact.
+ * Both of them implicitly convert to BitflagsT.
+ */
+template <typename BitflagsT>
+struct flag_change {
+    using underlying_type = typename BitflagsT::underlying_type;
+
+    std::size_t index;
+    underlying_type raised;
+    underlying_type cleared;
+};
+
+namespace internal {
+
+/**
+ * struct diff_block
+ *
+ * Number of elements compared at once. One block spans a single
+ * cache line of underlying values so that unchanged regions are
+ * skipped with a handful of wide XOR and OR instructions.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <typename T>
+struct diff_block {
+    static constexpr std::size_t size = 64 / sizeof(T);
+};
+
+/**
+ * Compares two arrays of flags and calls emit for each index whose
+ * flags differ.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param prev  Previous flags
+ * @param curr  Current flags
+ * @param count Number of flags in each array
+ * @param emit  Function called with each change
+ */
+template <typename BitflagsT, typename EmitT>
+inline void diff(BitflagsT const* prev, BitflagsT const* curr, std::size_t const count, EmitT& emit) {
+    using T = typename BitflagsT::underlying_type;
+
+    constexpr std::size_t block = diff_block<T>::size;
+
+    T a[block];
+    T b[block];
+    T x[block];
+
+    for (std::size_t offset = 0; offset < count; offset += block) {
+        std::size_t const n = count - offset < block ? count - offset : block;
+
+        load_bits(prev + offset, n, a);
+        load_bits(curr + offset, n, b);
+
+        // XOR step: the whole block is reduced first so that unchanged
+        // blocks cost a single branch
+        T any = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            x[i] = static_cast<T>(a[i] ^ b[i]);
+            any = static_cast<T>(any | x[i]);
+        }
+
+        if (!any) {
+            continue;
+        }
+
+        // compress step: only indices of changed elements are visited
+        std::uint64_t changed = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            changed |= static_cast<std::uint64_t>(x[i] != 0) << i;
+        }
+
+        while (changed) {
+            std::size_t const i = static_cast<std::size_t>(ctz(changed));
+            changed &= changed - 1;
+
+            flag_change<BitflagsT> const change{
+                offset + i,
+                static_cast<T>(x[i] & b[i]),
+                static_cast<T>(x[i] & a[i])
+            };
+            emit(change);
+        }
+    }
+}
+
+/**
+ * struct diff_writer
+ *
+ * Emitter that writes changes into an output array.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <typename BitflagsT>
+struct diff_writer {
+    flag_change<BitflagsT>* out;
+    std::size_t size;
+
+    void operator()(flag_change<BitflagsT> const& change) noexcept {
+        out[size++] = change;
+    }
+};
+
+/**
+ * struct diff_batcher
+ *
+ * Emitter that buffers changes and hands them over to the callback
+ * in batches.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <typename BitflagsT, typename CallbackT, std::size_t BatchSize>
+struct diff_batcher {
+    CallbackT& callback;
+    flag_change<BitflagsT> batch[BatchSize];
+    std::size_t size;
+    std::size_t total;
+
+    void operator()(flag_change<BitflagsT> const& change) {
+        batch[size++] = change;
+        if (size == BatchSize) {
+            flush();
+        }
+    }
+
+    void flush() {
+        if (size) {
+            callback(static_cast<flag_change<BitflagsT> const*>(batch), size);
+            total += size;
+            size = 0;
+        }
+    }
+};
+
+} // internal
+
+/**
+ * Compares previous and current flags of each entity and writes one
+ * entry per entity whose flags have changed. Entries are written in
+ * the increasing order of indices.
+ *
+ * @param prev  Previous flags
+ * @param curr  Current flags
+ * @param count Number of flags in each array
+ * @param out   Output array with the capacity of at least count entries
+ *
+ * @return Number of entries written
+ */
+template <typename BitflagsT>
+std::size_t diff(
+    BitflagsT const* prev,
+    BitflagsT const* curr,
+    std::size_t const count,
+    flag_change<BitflagsT>* out
+) {
+    internal::diff_writer<BitflagsT> writer{ out, 0 };
+    internal::diff(prev, curr, count, writer);
+    return writer.size;
+}
+
+/**
+ * Compares previous and current flags of each entity and passes the
+ * changes to the callback in batches of at most BatchSize entries.
+ * Callback is invoked as callback(flag_change<BitflagsT> const*, std::size_t).
+ *
+ * @param prev     Previous flags
+ * @param curr     Current flags
+ * @param count    Number of flags in each array
+ * @param callback Batch handler
+ *
+ * @return Total number of changes
+ */
+template <std::size_t BatchSize = 256, typename BitflagsT, typename CallbackT>
+std::size_t diff_batched(
+    BitflagsT const* prev,
+    BitflagsT const* curr,
+    std::size_t const count,
+    CallbackT&& callback
+) {
+    static_assert(BatchSize > 0, "Batch size must be greater than 0");
+
+    internal::diff_batcher<BitflagsT, CallbackT, BatchSize> batcher{ callback, {}, 0, 0 };
+    internal::diff(prev, curr, count, batcher);
+    batcher.flush();
+    return batcher.total;
+}
+
+} // bf
+
+#endif // BITFLAGS_DIFF_HPP
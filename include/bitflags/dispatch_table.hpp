@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_DISPATCH_TABLE_HPP
+#define BITFLAGS_DISPATCH_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "bitflags.hpp"
+
+namespace bf {
+
+template <
+    typename BitflagsT,
+    typename SignatureT,
+    typename BitflagsT::underlying_type Mask =
+        internal::declared_mask<BitflagsT, typename BitflagsT::underlying_type>()
+>
+class dispatch_table;
+
+/**
+ * class dispatch_table
+ *
+ * Table that maps every combination of the relevant flags directly
+ * to a handler, so that dispatching on a set of flags is a single
+ * indexed load followed by an indirect call instead of the chain of
+ * conditional branches. Relevant flags are selected by the Mask, all
+ * other flags are ignored while dispatching.
+ */
+template <
+    typename BitflagsT,
+    typename R,
+    typename ... Args,
+    typename BitflagsT::underlying_type Mask
+>
+class dispatch_table<BitflagsT, R(Args...), Mask> {
+public:
+    using handler_type    = R(*)(Args...);
+    using underlying_type = typename BitflagsT::underlying_type;
+
+    static constexpr std::size_t size = std::size_t{1} << internal::count_bits(Mask);
+
+    static_assert(Mask != 0, "Dispatch table requires at least one relevant flag");
+    static_assert(internal::count_bits(Mask) <= 16, "Dispatch table supports up to 16 relevant flags");
+
+    /**
+     * Creates the table with all the entries set to fallback.
+     *
+     * @param fallback Handler used for all the combinations of flags
+     */
+    NON_CONST_CONSTEXPR explicit dispatch_table(handler_type const fallback) noexcept
+        : table_{}
+    {
+        for (std::size_t i = 0; i < size; ++i) {
+            table_[i] = fallback;
+        }
+    }
+
+    /**
+     * Creates the table by asking the selector for the handler of
+     * each combination of the relevant flags. Table is built at
+     * compile time if the selector can be evaluated at compile time.
+     *
+     * @param select Function mapping BitflagsT to handler_type
+     */
+    template <typename SelectorT>
+    NON_CONST_CONSTEXPR explicit dispatch_table(SelectorT const& select)
+        : table_{}
+    {
+        for (std::size_t i = 0; i < size; ++i) {
+            table_[i] = select(BitflagsT(static_cast<underlying_type>(internal::portable_deposit_bits(i, Mask))));
+        }
+    }
+
+    /**
+     * Assigns handler to the exact combination of the relevant flags.
+     *
+     * @param key     Combination of flags
+     * @param handler Handler to be called for the combination
+     */
+    void assign(BitflagsT const& key, handler_type const handler) noexcept {
+        table_[index(key.bits())] = handler;
+    }
+
+    /**
+     * Gets the handler of the combination of flags.
+     *
+     * @param key Combination of flags
+     *
+     * @return Handler
+     */
+    NODISCARD handler_type operator[](BitflagsT const& key) const noexcept {
+        return table_[index(key.bits())];
+    }
+
+    /**
+     * Calls the handler of the combination of flags.
+     *
+     * @param key  Combination of flags
+     * @param args Arguments passed to the handler
+     *
+     * @return Result of the handler
+     */
+    template <typename ... U>
+    R operator()(BitflagsT const& key, U&& ... args) const {
+        return table_[index(key.bits())](std::forward<U>(args)...);
+    }
+
+private:
+    /**
+     * Computes index of the combination of flags. Low contiguous
+     * masks are plain AND, other masks are compressed by pext.
+     */
+    static std::size_t index(underlying_type const bits) noexcept {
+        return (Mask & (Mask + 1)) == 0
+            ? static_cast<std::size_t>(bits & Mask)
+            : static_cast<std::size_t>(internal::extract_bits(bits, Mask));
+    }
+
+    handler_type table_[size];
+};
+
+#if __cplusplus < 201703L
+template <
+    typename BitflagsT,
+    typename R,
+    typename ... Args,
+    typename BitflagsT::underlying_type Mask
+>
+constexpr std::size_t dispatch_table<BitflagsT, R(Args...), Mask>::size;
+#endif
+
+} // bf
+
+#endif // BITFLAGS_DISPATCH_TABLE_HPP
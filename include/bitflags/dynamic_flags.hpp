@@ -0,0 +1,559 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_DYNAMIC_FLAGS_HPP
+#define BITFLAGS_DYNAMIC_FLAGS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+#include "bitflags.hpp"
+
+namespace bf {
+
+template <std::size_t Bits>
+class dynamic_flags;
+
+/**
+ * struct dynamic_flag
+ *
+ * Flag registered at runtime within the flag registry. Keeps the word
+ * and the mask of its bit, so that checking the flag is a single mask
+ * test. The empty flag has zero mask.
+ */
+template <std::size_t Bits>
+struct dynamic_flag {
+    std::uint32_t word;
+    std::uint64_t mask;
+#if __cplusplus >= 201703L
+    std::string_view name;
+#else
+    char const * name;
+#endif
+
+    constexpr dynamic_flag() noexcept : word(0), mask(0), name("") {}
+
+#if __cplusplus >= 201703L
+    constexpr dynamic_flag(std::size_t const bit, std::string_view name) noexcept
+#else
+    constexpr dynamic_flag(std::size_t const bit, char const * const name) noexcept
+#endif
+        : word(static_cast<std::uint32_t>(bit / 64))
+        , mask(std::uint64_t{1} << (bit % 64))
+        , name(name)
+    {}
+
+    /**
+     * Gets the bit of the flag.
+     *
+     * @return Index of the bit, or Bits for the empty flag
+     */
+    NODISCARD std::size_t bit() const noexcept {
+        return mask != 0 ? word * 64 + static_cast<std::size_t>(internal::ctz(mask)) : Bits;
+    }
+
+    NODISCARD friend constexpr bool operator==(dynamic_flag const& lhs, dynamic_flag const& rhs) noexcept {
+        return lhs.word == rhs.word && lhs.mask == rhs.mask;
+    }
+
+    NODISCARD friend constexpr bool operator!=(dynamic_flag const& lhs, dynamic_flag const& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+    /**
+     * Bitwise operators overloads
+     *
+     *     dynamic_flag <op> dynamic_flag
+     */
+
+    NODISCARD friend dynamic_flags<Bits> operator&(dynamic_flag const& lhs, dynamic_flag const& rhs) noexcept { return dynamic_flags<Bits>(lhs) & rhs; }
+    NODISCARD friend dynamic_flags<Bits> operator|(dynamic_flag const& lhs, dynamic_flag const& rhs) noexcept { return dynamic_flags<Bits>(lhs) | rhs; }
+    NODISCARD friend dynamic_flags<Bits> operator^(dynamic_flag const& lhs, dynamic_flag const& rhs) noexcept { return dynamic_flags<Bits>(lhs) ^ rhs; }
+};
+
+/**
+ * class dynamic_flags
+ *
+ * Set of flags registered at runtime, backed by an array of 64-bit
+ * words wide enough for Bits flags. Provides the same operators and
+ * checks as bitflags.
+ */
+template <std::size_t Bits>
+class dynamic_flags {
+    static_assert(Bits > 0, "dynamic_flags: set has to hold at least one flag");
+
+public:
+    static constexpr std::size_t words_count = (Bits + 63) / 64;
+
+    using flag_type = dynamic_flag<Bits>;
+    using word_type = std::uint64_t;
+    using bits_type = std::array<word_type, words_count>;
+
+    dynamic_flags() noexcept
+        : words_()
+    {}
+
+    dynamic_flags(flag_type const& rhs) noexcept
+        : words_()
+    {
+        words_[rhs.word] = rhs.mask;
+    }
+
+    NODISCARD friend bool operator==(dynamic_flags const& lhs, dynamic_flags const& rhs) noexcept { return lhs.words_ == rhs.words_; }
+    NODISCARD friend bool operator!=(dynamic_flags const& lhs, dynamic_flags const& rhs) noexcept { return lhs.words_ != rhs.words_; }
+
+    /**
+     * Bitwise operators overloads
+     *
+     *     <op> dynamic_flags<Bits>
+     *
+     *     dynamic_flags<Bits> <op>  dynamic_flags<Bits>
+     *
+     *     dynamic_flags<Bits> <op>= dynamic_flags<Bits>
+     *
+     * Complement keeps the bits beyond Bits cleared.
+     */
+
+    NODISCARD friend dynamic_flags operator~(dynamic_flags const& rhs) noexcept {
+        dynamic_flags result;
+        for (std::size_t i = 0; i < words_count; ++i) {
+            result.words_[i] = ~rhs.words_[i];
+        }
+        result.words_[words_count - 1] &= tail_mask();
+        return result;
+    }
+
+    NODISCARD friend dynamic_flags operator&(dynamic_flags lhs, dynamic_flags const& rhs) noexcept { return lhs &= rhs; }
+    NODISCARD friend dynamic_flags operator|(dynamic_flags lhs, dynamic_flags const& rhs) noexcept { return lhs |= rhs; }
+    NODISCARD friend dynamic_flags operator^(dynamic_flags lhs, dynamic_flags const& rhs) noexcept { return lhs ^= rhs; }
+
+    dynamic_flags& operator&=(dynamic_flags const& rhs) noexcept {
+        for (std::size_t i = 0; i < words_count; ++i) {
+            words_[i] &= rhs.words_[i];
+        }
+        return *this;
+    }
+
+    dynamic_flags& operator|=(dynamic_flags const& rhs) noexcept {
+        for (std::size_t i = 0; i < words_count; ++i) {
+            words_[i] |= rhs.words_[i];
+        }
+        return *this;
+    }
+
+    dynamic_flags& operator^=(dynamic_flags const& rhs) noexcept {
+        for (std::size_t i = 0; i < words_count; ++i) {
+            words_[i] ^= rhs.words_[i];
+        }
+        return *this;
+    }
+
+    /**
+     * Gets the underlying words of current set of flags. Flag at bit
+     * i is stored as bit i % 64 of word i / 64.
+     *
+     * @return Underlying words
+     */
+    NODISCARD bits_type const& bits() const noexcept {
+        return words_;
+    }
+
+    /**
+     * Gets an empty set of flags.
+     *
+     * @return Empty set of flags
+     */
+    NODISCARD static dynamic_flags empty() noexcept {
+        return dynamic_flags();
+    }
+
+    /**
+     * Gets the set of all Bits flags, registered or not.
+     *
+     * @return Set of all flags
+     */
+    NODISCARD static dynamic_flags all() noexcept {
+        return ~dynamic_flags();
+    }
+
+    /**
+     * Checks whether no flag is currently set.
+     *
+     * @return True if no flag is currently set, otherwise false
+     */
+    NODISCARD bool is_empty() const noexcept {
+        word_type any = 0;
+        for (std::size_t i = 0; i < words_count; ++i) {
+            any |= words_[i];
+        }
+        return any == 0;
+    }
+
+    /**
+     * Checks whether all flags are currently set.
+     *
+     * @return True if all flags are currently set, otherwise false
+     */
+    NODISCARD bool is_all() const noexcept {
+        return *this == all();
+    }
+
+    /**
+     * Checks whether specified flag is contained within the current
+     * set of flags. Empty flag is treated as always present.
+     *
+     * @param rhs Flag to check
+     *
+     * @return True if the specified flag is contained within the
+     *         current set of flags, otherwise false
+     */
+    NODISCARD bool contains(flag_type const& rhs) const noexcept {
+        return (words_[rhs.word] & rhs.mask) == rhs.mask;
+    }
+
+    /**
+     * Checks whether all the specified flags are contained within the
+     * current set of flags. Empty flags are treated as always present.
+     *
+     * @param rhs_1 First flag to check
+     * @param rhs_n Other flags to check
+     *
+     * @return True if all the specified flags are contained within the
+     *         current set of flags, otherwise false
+     */
+    template <typename ... U>
+    NODISCARD bool contains(flag_type const& rhs_1, U const& ... rhs_n) const noexcept {
+        return contains(rhs_1) && contains(rhs_n...);
+    }
+
+    /**
+     * Checks whether all the flags of the mask are contained within
+     * the current set of flags.
+     *
+     * @param mask Flags to check
+     *
+     * @return True if the mask is contained, otherwise false
+     */
+    NODISCARD bool contains_all(dynamic_flags const& mask) const noexcept {
+        word_type missing = 0;
+        for (std::size_t i = 0; i < words_count; ++i) {
+            missing |= mask.words_[i] & ~words_[i];
+        }
+        return missing == 0;
+    }
+
+    /**
+     * Sets specified flag.
+     *
+     * @param rhs Flag to be set
+     */
+    void set(flag_type const& rhs) noexcept {
+        words_[rhs.word] |= rhs.mask;
+    }
+
+    /**
+     * Unsets specified flag.
+     *
+     * @param rhs Flag to be unset
+     */
+    void remove(flag_type const& rhs) noexcept {
+        words_[rhs.word] &= ~rhs.mask;
+    }
+
+    /**
+     * Sets specified flag if not already present. Otherwise, unsets
+     * the specified flag.
+     *
+     * @param rhs Flag to be toggled
+     */
+    void toggle(flag_type const& rhs) noexcept {
+        words_[rhs.word] ^= rhs.mask;
+    }
+
+    /**
+     * Clears all flags currently set.
+     */
+    void clear() noexcept {
+        words_.fill(0);
+    }
+
+    /**
+     * Calls f with the bit of every flag currently set, in ascending
+     * order.
+     *
+     * @param f Function called as f(std::size_t)
+     */
+    template <typename F>
+    void for_each_bit(F&& f) const {
+        for (std::size_t i = 0; i < words_count; ++i) {
+            for (word_type word = words_[i]; word != 0; word &= word - 1) {
+                f(i * 64 + static_cast<std::size_t>(internal::ctz(word)));
+            }
+        }
+    }
+
+private:
+    static constexpr word_type tail_mask() noexcept {
+        return Bits % 64 == 0 ? ~word_type{} : (word_type{1} << (Bits % 64)) - 1;
+    }
+
+    bits_type words_;
+};
+
+#if __cplusplus < 201703L
+template <std::size_t Bits>
+constexpr std::size_t dynamic_flags<Bits>::words_count;
+#endif
+
+/**
+ * class flag_registry
+ *
+ * Assigns bits to the names of flags known only at runtime, e.g. from
+ * configuration, and interns the names in an open addressing hash
+ * table. Up to Bits flags can be registered. The registry is meant to
+ * be populated at startup; lookups may run concurrently afterwards,
+ * but not concurrently with registration.
+ */
+template <std::size_t Bits = 256>
+class flag_registry {
+    static_assert(Bits > 0, "dynamic_flags: registry has to hold at least one flag");
+
+public:
+    using flag_type  = dynamic_flag<Bits>;
+    using flags_type = dynamic_flags<Bits>;
+    using size_type  = std::size_t;
+
+    static constexpr std::size_t capacity = Bits;
+
+    flag_registry()
+        : slots_(table_size(), -1)
+    {
+        flags_.reserve(Bits);
+    }
+
+    flag_registry(flag_registry const& rhs) = delete;
+    flag_registry& operator=(flag_registry const& rhs) = delete;
+
+    ~flag_registry() = default;
+
+    /**
+     * Registers the flag of the specified name, unless it is already
+     * registered.
+     *
+     * @param name Name of the flag
+     *
+     * @return Registered flag
+     *
+     * @throws std::length_error if the registry is full
+     */
+#if __cplusplus >= 201703L
+    flag_type add(std::string_view const name) {
+        return add(name.data(), name.size());
+    }
+#else
+    flag_type add(std::string const& name) {
+        return add(name.data(), name.size());
+    }
+
+    flag_type add(char const * const name) {
+        return add(name, std::strlen(name));
+    }
+#endif
+
+    /**
+     * Looks the flag up by its name. The flag stays at the same address
+     * while the registry lives.
+     *
+     * @param name Name of the flag
+     *
+     * @return Pointer to the flag, or nullptr if no flag of the name is
+     *         registered
+     */
+#if __cplusplus >= 201703L
+    NODISCARD flag_type const* find(std::string_view const name) const noexcept {
+        return find(name.data(), name.size());
+    }
+#else
+    NODISCARD flag_type const* find(std::string const& name) const noexcept {
+        return find(name.data(), name.size());
+    }
+
+    NODISCARD flag_type const* find(char const * const name) const noexcept {
+        return find(name, std::strlen(name));
+    }
+#endif
+
+    /**
+     * Gets the flag registered at the specified bit.
+     *
+     * @param bit Bit of the flag, less than size()
+     *
+     * @return Flag
+     */
+    NODISCARD flag_type const& operator[](std::size_t const bit) const noexcept {
+        return flags_[bit];
+    }
+
+    NODISCARD size_type size() const noexcept {
+        return flags_.size();
+    }
+
+    /**
+     * Gets all the flags registered so far, in the order of their
+     * registration, i.e. by ascending bits. The range stays valid
+     * while the registry lives, but does not cover flags registered
+     * later on.
+     *
+     * @return Range of registered flags
+     */
+    NODISCARD internal::flags_range<flag_type> declared_flags() const noexcept {
+        return { flags_.data(), flags_.data() + flags_.size() };
+    }
+
+    /**
+     * Gets the set of all the flags registered so far.
+     *
+     * @return Set of registered flags
+     */
+    NODISCARD flags_type all() const noexcept {
+        flags_type result;
+        for (flag_type const& f : flags_) {
+            result.set(f);
+        }
+        return result;
+    }
+
+    /**
+     * Calls f with every flag contained within the set of flags, in
+     * ascending order of bits.
+     *
+     * @param flags Set of flags
+     * @param f     Function called as f(flag_type const&)
+     */
+    template <typename F>
+    void for_each(flags_type const& flags, F&& f) const {
+        flags.for_each_bit([this, &f](std::size_t const bit) {
+            if (bit < flags_.size()) {
+                f(flags_[bit]);
+            }
+        });
+    }
+
+    /**
+     * Formats the set of flags as names of its flags joined by the
+     * separator. Bits without a registered flag are skipped.
+     *
+     * @param flags     Set of flags
+     * @param separator Separator of the names
+     *
+     * @return Names of the flags
+     */
+    NODISCARD std::string to_string(flags_type const& flags, char const * const separator = " | ") const {
+        std::string result;
+        for_each(flags, [&result, separator](flag_type const& f) {
+            if (!result.empty()) {
+                result += separator;
+            }
+            result += f.name;
+        });
+        return result;
+    }
+
+private:
+    static constexpr std::size_t table_size(std::size_t const size = 1) noexcept {
+        return size >= 2 * Bits ? size : table_size(size * 2);
+    }
+
+    static std::uint64_t hash(char const * const name, std::size_t const size) noexcept {
+        std::uint64_t h = 0xcbf29ce484222325ULL;
+        for (std::size_t i = 0; i < size; ++i) {
+            h = (h ^ static_cast<unsigned char>(name[i])) * 0x100000001b3ULL;
+        }
+        return h;
+    }
+
+    std::size_t slot_of(char const * const name, std::size_t const size) const noexcept {
+        std::size_t const mask = slots_.size() - 1;
+        std::size_t slot = static_cast<std::size_t>(hash(name, size)) & mask;
+        for (; slots_[slot] >= 0; slot = (slot + 1) & mask) {
+            std::string const& interned = names_[static_cast<std::size_t>(slots_[slot])];
+            if (interned.size() == size && std::memcmp(interned.data(), name, size) == 0) {
+                break;
+            }
+        }
+        return slot;
+    }
+
+    flag_type add(char const * const name, std::size_t const size) {
+        std::size_t const slot = slot_of(name, size);
+        if (slots_[slot] >= 0) {
+            return flags_[static_cast<std::size_t>(slots_[slot])];
+        }
+        if (flags_.size() == Bits) {
+            throw std::length_error("bitflags: flag registry is full");
+        }
+
+        names_.emplace_back(name, size);
+        slots_[slot] = static_cast<std::int32_t>(flags_.size());
+#if __cplusplus >= 201703L
+        flags_.emplace_back(flags_.size(), std::string_view(names_.back()));
+#else
+        flags_.emplace_back(flags_.size(), names_.back().c_str());
+#endif
+        return flags_.back();
+    }
+
+    flag_type const* find(char const * const name, std::size_t const size) const noexcept {
+        std::int32_t const index = slots_[slot_of(name, size)];
+        return index >= 0 ? &flags_[static_cast<std::size_t>(index)] : nullptr;
+    }
+
+    std::deque<std::string> names_;
+    std::vector<flag_type> flags_;
+    std::vector<std::int32_t> slots_;
+};
+
+#if __cplusplus < 201703L
+template <std::size_t Bits>
+constexpr std::size_t flag_registry<Bits>::capacity;
+#endif
+
+} // bf
+
+#endif // BITFLAGS_DYNAMIC_FLAGS_HPP
@@ -0,0 +1,650 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_FLAGS_MAP_HPP
+#define BITFLAGS_FLAGS_MAP_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bitflags.hpp"
+#include "hash.hpp"
+
+#if BITFLAGS_HAS_PMR
+#include <memory_resource>
+#endif
+
+/**
+ * Maximal number of declared bits for which the flags map and the
+ * flags set use a dense array indexed directly by the flags.
+ */
+#ifndef BITFLAGS_DENSE_MAP_BITS
+#define BITFLAGS_DENSE_MAP_BITS 12
+#endif
+
+namespace bf {
+
+namespace internal {
+
+/**
+ * struct no_value
+ *
+ * Mapped type of the storage used by the flags set.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+struct no_value {};
+
+/**
+ * Allocator AllocatorT rebound to the type U.
+ *
+ * NOTE: This alias is for internal use only.
+ */
+template <typename AllocatorT, typename U>
+using rebind_alloc = typename std::allocator_traits<AllocatorT>::template rebind_alloc<U>;
+
+/**
+ * struct key_bits
+ *
+ * Number of bits of the keys, i.e. the number of declared bits of
+ * the set of flags, and the mask applied to every key.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <typename BitflagsT>
+struct key_bits {
+    using underlying_type = typename BitflagsT::underlying_type;
+
+    static constexpr int width = BitflagsT::end_ - BitflagsT::begin_ - 2 < static_cast<int>(sizeof(underlying_type) * 8)
+        ? BitflagsT::end_ - BitflagsT::begin_ - 2
+        : static_cast<int>(sizeof(underlying_type) * 8);
+
+    static constexpr underlying_type mask = declared_mask<BitflagsT, underlying_type>();
+};
+
+/**
+ * class dense_storage
+ *
+ * Storage of the values indexed directly by the keys, together with
+ * the bitmap of present keys.
+ *
+ * NOTE: This class is for internal use only.
+ */
+template <typename T, typename V, int Width, typename AllocatorT>
+class dense_storage {
+public:
+    static constexpr std::size_t capacity = std::size_t{1} << Width;
+
+    explicit dense_storage(AllocatorT const& alloc)
+        : values_(alloc)
+        , present_((capacity + 63) / 64, 0, alloc)
+        , size_(0)
+    {
+        values_.resize(capacity);
+    }
+
+    NODISCARD AllocatorT get_allocator() const noexcept {
+        return AllocatorT(values_.get_allocator());
+    }
+
+    NODISCARD V* find(T const key) noexcept {
+        return contains(key) ? &values_[key] : nullptr;
+    }
+
+    NODISCARD V const* find(T const key) const noexcept {
+        return contains(key) ? &values_[key] : nullptr;
+    }
+
+    NODISCARD bool contains(T const key) const noexcept {
+        return (present_[key / 64] >> (key % 64)) & 1U;
+    }
+
+    std::pair<V*, bool> insert(T const key) {
+        bool const inserted = !contains(key);
+        if (inserted) {
+            present_[key / 64] |= std::uint64_t{1} << (key % 64);
+            ++size_;
+        }
+        return { &values_[key], inserted };
+    }
+
+    bool erase(T const key) {
+        if (!contains(key)) {
+            return false;
+        }
+        present_[key / 64] &= ~(std::uint64_t{1} << (key % 64));
+        values_[key] = V();
+        --size_;
+        return true;
+    }
+
+    void clear() {
+        for (std::size_t word = 0; word < present_.size(); ++word) {
+            for (std::uint64_t bits = present_[word]; bits != 0; bits &= bits - 1) {
+                values_[word * 64 + ctz(bits)] = V();
+            }
+            present_[word] = 0;
+        }
+        size_ = 0;
+    }
+
+    NODISCARD std::size_t size() const noexcept {
+        return size_;
+    }
+
+    template <typename F>
+    void for_each(F&& f) const {
+        for (std::size_t word = 0; word < present_.size(); ++word) {
+            for (std::uint64_t bits = present_[word]; bits != 0; bits &= bits - 1) {
+                std::size_t const key = word * 64 + ctz(bits);
+                f(static_cast<T>(key), values_[key]);
+            }
+        }
+    }
+
+private:
+    std::vector<V, rebind_alloc<AllocatorT, V>> values_;
+    std::vector<std::uint64_t, rebind_alloc<AllocatorT, std::uint64_t>> present_;
+    std::size_t size_;
+};
+
+/**
+ * Dense storage of the flags set keeps the bitmap only.
+ *
+ * NOTE: This class is for internal use only.
+ */
+template <typename T, int Width, typename AllocatorT>
+class dense_storage<T, no_value, Width, AllocatorT> {
+public:
+    static constexpr std::size_t capacity = std::size_t{1} << Width;
+
+    explicit dense_storage(AllocatorT const& alloc)
+        : present_((capacity + 63) / 64, 0, alloc)
+        , size_(0)
+    {}
+
+    NODISCARD AllocatorT get_allocator() const noexcept {
+        return AllocatorT(present_.get_allocator());
+    }
+
+    NODISCARD bool contains(T const key) const noexcept {
+        return (present_[key / 64] >> (key % 64)) & 1U;
+    }
+
+    std::pair<no_value*, bool> insert(T const key) {
+        bool const inserted = !contains(key);
+        if (inserted) {
+            present_[key / 64] |= std::uint64_t{1} << (key % 64);
+            ++size_;
+        }
+        return { nullptr, inserted };
+    }
+
+    bool erase(T const key) {
+        if (!contains(key)) {
+            return false;
+        }
+        present_[key / 64] &= ~(std::uint64_t{1} << (key % 64));
+        --size_;
+        return true;
+    }
+
+    void clear() {
+        std::fill(present_.begin(), present_.end(), 0);
+        size_ = 0;
+    }
+
+    NODISCARD std::size_t size() const noexcept {
+        return size_;
+    }
+
+    template <typename F>
+    void for_each(F&& f) const {
+        no_value const value{};
+        for (std::size_t word = 0; word < present_.size(); ++word) {
+            for (std::uint64_t bits = present_[word]; bits != 0; bits &= bits - 1) {
+                f(static_cast<T>(word * 64 + ctz(bits)), value);
+            }
+        }
+    }
+
+private:
+    std::vector<std::uint64_t, rebind_alloc<AllocatorT, std::uint64_t>> present_;
+    std::size_t size_;
+};
+
+/**
+ * class hashed_storage
+ *
+ * Open addressing hash table with linear probing and backward shift
+ * deletion, so that no tombstones are left behind. Capacity is a
+ * power of two and the table is kept at most half full.
+ *
+ * NOTE: This class is for internal use only.
+ */
+template <typename T, typename V, typename AllocatorT>
+class hashed_storage {
+public:
+    explicit hashed_storage(AllocatorT const& alloc) noexcept
+        : keys_(alloc)
+        , values_(alloc)
+        , used_(alloc)
+        , size_(0)
+    {}
+
+    NODISCARD AllocatorT get_allocator() const noexcept {
+        return AllocatorT(keys_.get_allocator());
+    }
+
+    NODISCARD V* find(T const key) noexcept {
+        std::size_t const slot = lookup(key);
+        return slot != npos ? &values_[slot] : nullptr;
+    }
+
+    NODISCARD V const* find(T const key) const noexcept {
+        std::size_t const slot = lookup(key);
+        return slot != npos ? &values_[slot] : nullptr;
+    }
+
+    NODISCARD bool contains(T const key) const noexcept {
+        return lookup(key) != npos;
+    }
+
+    std::pair<V*, bool> insert(T const key) {
+        if ((size_ + 1) * 2 > keys_.size()) {
+            rehash(keys_.empty() ? 16 : keys_.size() * 2);
+        }
+        std::size_t const mask = keys_.size() - 1;
+        std::size_t slot = hash_bits(key) & mask;
+        for (; used_[slot]; slot = (slot + 1) & mask) {
+            if (keys_[slot] == key) {
+                return { &values_[slot], false };
+            }
+        }
+        used_[slot] = 1;
+        keys_[slot] = key;
+        ++size_;
+        return { &values_[slot], true };
+    }
+
+    bool erase(T const key) {
+        std::size_t hole = lookup(key);
+        if (hole == npos) {
+            return false;
+        }
+
+        std::size_t const mask = keys_.size() - 1;
+        for (std::size_t slot = (hole + 1) & mask; used_[slot]; slot = (slot + 1) & mask) {
+            std::size_t const home = hash_bits(keys_[slot]) & mask;
+            // entry may be moved into the hole only if its home slot
+            // does not lie cyclically within (hole, slot]
+            if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+                keys_[hole] = keys_[slot];
+                values_[hole] = std::move(values_[slot]);
+                hole = slot;
+            }
+        }
+        used_[hole] = 0;
+        values_[hole] = V();
+        --size_;
+        return true;
+    }
+
+    void clear() {
+        keys_.clear();
+        values_.clear();
+        used_.clear();
+        size_ = 0;
+    }
+
+    NODISCARD std::size_t size() const noexcept {
+        return size_;
+    }
+
+    template <typename F>
+    void for_each(F&& f) const {
+        for (std::size_t slot = 0; slot < keys_.size(); ++slot) {
+            if (used_[slot]) {
+                f(keys_[slot], values_[slot]);
+            }
+        }
+    }
+
+private:
+    static constexpr std::size_t npos = ~std::size_t{};
+
+    std::size_t lookup(T const key) const noexcept {
+        if (size_ == 0) {
+            return npos;
+        }
+        std::size_t const mask = keys_.size() - 1;
+        for (std::size_t slot = hash_bits(key) & mask; used_[slot]; slot = (slot + 1) & mask) {
+            if (keys_[slot] == key) {
+                return slot;
+            }
+        }
+        return npos;
+    }
+
+    void rehash(std::size_t const capacity) {
+        std::vector<T, rebind_alloc<AllocatorT, T>> keys(capacity, T(), keys_.get_allocator());
+        std::vector<V, rebind_alloc<AllocatorT, V>> values(values_.get_allocator());
+        std::vector<std::uint8_t, rebind_alloc<AllocatorT, std::uint8_t>> used(capacity, 0, used_.get_allocator());
+        values.resize(capacity);
+
+        std::size_t const mask = capacity - 1;
+        for (std::size_t slot = 0; slot < keys_.size(); ++slot) {
+            if (used_[slot]) {
+                std::size_t target = hash_bits(keys_[slot]) & mask;
+                while (used[target]) {
+                    target = (target + 1) & mask;
+                }
+                used[target] = 1;
+                keys[target] = keys_[slot];
+                values[target] = std::move(values_[slot]);
+            }
+        }
+
+        keys_.swap(keys);
+        values_.swap(values);
+        used_.swap(used);
+    }
+
+    std::vector<T, rebind_alloc<AllocatorT, T>> keys_;
+    std::vector<V, rebind_alloc<AllocatorT, V>> values_;
+    std::vector<std::uint8_t, rebind_alloc<AllocatorT, std::uint8_t>> used_;
+    std::size_t size_;
+};
+
+/**
+ * Storage used for keys of the set of flags BitflagsT.
+ *
+ * NOTE: This alias is for internal use only.
+ */
+template <typename BitflagsT, typename V, typename AllocatorT>
+using flags_storage = typename std::conditional<
+    key_bits<BitflagsT>::width <= BITFLAGS_DENSE_MAP_BITS,
+    dense_storage<typename BitflagsT::underlying_type, V, key_bits<BitflagsT>::width, AllocatorT>,
+    hashed_storage<typename BitflagsT::underlying_type, V, AllocatorT>
+>::type;
+
+} // internal
+
+/**
+ * class flags_map
+ *
+ * Associative container keyed by sets of flags. Sets of flags with
+ * at most BITFLAGS_DENSE_MAP_BITS declared bits are kept in a dense
+ * array indexed directly by the flags, so that lookup is a single
+ * indexed load. Wider sets of flags are kept in an open addressing
+ * hash table. Bits outside of the declared flags are ignored. Values,
+ * as well as keys and bitmaps, are allocated by AllocatorT.
+ */
+template <typename BitflagsT, typename V, typename AllocatorT = std::allocator<V>>
+class flags_map {
+public:
+    using key_type        = BitflagsT;
+    using mapped_type     = V;
+    using underlying_type = typename BitflagsT::underlying_type;
+    using size_type       = std::size_t;
+    using allocator_type  = AllocatorT;
+
+    static constexpr bool is_dense = internal::key_bits<BitflagsT>::width <= BITFLAGS_DENSE_MAP_BITS;
+
+    flags_map()
+        : storage_(AllocatorT())
+    {}
+
+    explicit flags_map(AllocatorT const& alloc)
+        : storage_(alloc)
+    {}
+
+    NODISCARD allocator_type get_allocator() const noexcept {
+        return storage_.get_allocator();
+    }
+
+    /**
+     * Gets the value mapped to the specified flags.
+     *
+     * @param key Set of flags
+     *
+     * @return Pointer to the value, or nullptr if there is none
+     */
+    NODISCARD V* find(BitflagsT const& key) noexcept {
+        return storage_.find(index(key));
+    }
+
+    NODISCARD V const* find(BitflagsT const& key) const noexcept {
+        return storage_.find(index(key));
+    }
+
+    /**
+     * Checks whether any value is mapped to the specified flags.
+     *
+     * @param key Set of flags
+     *
+     * @return True if there is a value, otherwise false
+     */
+    NODISCARD bool contains(BitflagsT const& key) const noexcept {
+        return storage_.contains(index(key));
+    }
+
+    /**
+     * Gets the value mapped to the specified flags, inserting default
+     * constructed value if there is none.
+     *
+     * @param key Set of flags
+     *
+     * @return Reference to the value
+     */
+    V& operator[](BitflagsT const& key) {
+        return *storage_.insert(index(key)).first;
+    }
+
+    /**
+     * Maps the value to the specified flags, replacing existing one.
+     *
+     * @param key   Set of flags
+     * @param value Value to map
+     *
+     * @return True if the value has been inserted, false if replaced
+     */
+    bool insert_or_assign(BitflagsT const& key, V value) {
+        auto const result = storage_.insert(index(key));
+        *result.first = std::move(value);
+        return result.second;
+    }
+
+    /**
+     * Removes the value mapped to the specified flags.
+     *
+     * @param key Set of flags
+     *
+     * @return True if the value has been removed, otherwise false
+     */
+    bool erase(BitflagsT const& key) {
+        return storage_.erase(index(key));
+    }
+
+    /**
+     * Removes all the values.
+     */
+    void clear() {
+        storage_.clear();
+    }
+
+    NODISCARD size_type size() const noexcept {
+        return storage_.size();
+    }
+
+    NODISCARD bool empty() const noexcept {
+        return storage_.size() == 0;
+    }
+
+    /**
+     * Calls f with every set of flags and its value, in unspecified
+     * order.
+     *
+     * @param f Function called as f(BitflagsT, V const&)
+     */
+    template <typename F>
+    void for_each(F&& f) const {
+        storage_.for_each([&f](underlying_type const key, V const& value) {
+            f(BitflagsT(key), value);
+        });
+    }
+
+private:
+    static underlying_type index(BitflagsT const& key) noexcept {
+        return static_cast<underlying_type>(key.bits() & internal::key_bits<BitflagsT>::mask);
+    }
+
+    internal::flags_storage<BitflagsT, V, AllocatorT> storage_;
+};
+
+/**
+ * class flags_set
+ *
+ * Set of sets of flags. Uses the same storage as the flags map, i.e.
+ * a dense bitmap for sets of flags with at most
+ * BITFLAGS_DENSE_MAP_BITS declared bits and an open addressing hash
+ * table otherwise. Bits outside of the declared flags are ignored.
+ * Storage is allocated by AllocatorT.
+ */
+template <typename BitflagsT, typename AllocatorT = std::allocator<BitflagsT>>
+class flags_set {
+public:
+    using key_type        = BitflagsT;
+    using value_type      = BitflagsT;
+    using underlying_type = typename BitflagsT::underlying_type;
+    using size_type       = std::size_t;
+    using allocator_type  = AllocatorT;
+
+    static constexpr bool is_dense = internal::key_bits<BitflagsT>::width <= BITFLAGS_DENSE_MAP_BITS;
+
+    flags_set()
+        : storage_(AllocatorT())
+    {}
+
+    explicit flags_set(AllocatorT const& alloc)
+        : storage_(alloc)
+    {}
+
+    NODISCARD allocator_type get_allocator() const noexcept {
+        return storage_.get_allocator();
+    }
+
+    /**
+     * Checks whether the set contains the specified flags.
+     *
+     * @param key Set of flags
+     *
+     * @return True if the flags are contained, otherwise false
+     */
+    NODISCARD bool contains(BitflagsT const& key) const noexcept {
+        return storage_.contains(index(key));
+    }
+
+    /**
+     * Inserts the specified flags.
+     *
+     * @param key Set of flags
+     *
+     * @return True if the flags have been inserted, false if already present
+     */
+    bool insert(BitflagsT const& key) {
+        return storage_.insert(index(key)).second;
+    }
+
+    /**
+     * Removes the specified flags.
+     *
+     * @param key Set of flags
+     *
+     * @return True if the flags have been removed, otherwise false
+     */
+    bool erase(BitflagsT const& key) {
+        return storage_.erase(index(key));
+    }
+
+    /**
+     * Removes all the sets of flags.
+     */
+    void clear() {
+        storage_.clear();
+    }
+
+    NODISCARD size_type size() const noexcept {
+        return storage_.size();
+    }
+
+    NODISCARD bool empty() const noexcept {
+        return storage_.size() == 0;
+    }
+
+    /**
+     * Calls f with every set of flags, in unspecified order.
+     *
+     * @param f Function called as f(BitflagsT)
+     */
+    template <typename F>
+    void for_each(F&& f) const {
+        storage_.for_each([&f](underlying_type const key, internal::no_value const&) {
+            f(BitflagsT(key));
+        });
+    }
+
+private:
+    static underlying_type index(BitflagsT const& key) noexcept {
+        return static_cast<underlying_type>(key.bits() & internal::key_bits<BitflagsT>::mask);
+    }
+
+    internal::flags_storage<BitflagsT, internal::no_value, AllocatorT> storage_;
+};
+
+#if BITFLAGS_HAS_PMR
+namespace pmr {
+
+template <typename BitflagsT, typename V>
+using flags_map = bf::flags_map<BitflagsT, V, std::pmr::polymorphic_allocator<V>>;
+
+template <typename BitflagsT>
+using flags_set = bf::flags_set<BitflagsT, std::pmr::polymorphic_allocator<BitflagsT>>;
+
+} // pmr
+#endif
+
+} // bf
+
+#endif // BITFLAGS_FLAGS_MAP_HPP
@@ -0,0 +1,692 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_FLAGS_VIEW_HPP
+#define BITFLAGS_FLAGS_VIEW_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+#include <stdlib.h>
+#endif
+
+#if defined(__AVX2__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "bitflags.hpp"
+
+namespace bf {
+
+/**
+ * enum class endian
+ *
+ * Byte order of the flags stored in external memory.
+ */
+enum class endian {
+    little,
+    big,
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    native = big
+#else
+    native = little
+#endif
+};
+
+namespace internal {
+
+/**
+ * Reverses the order of bytes of the integer. Compiles to bswap, or
+ * to movbe when fused with the load or the store on CPUs supporting
+ * it.
+ *
+ * NOTE: These functions are for internal use only.
+ *
+ * @param x Integer
+ *
+ * @return Integer with reversed order of bytes
+ */
+inline std::uint8_t byteswap(std::uint8_t const x) noexcept {
+    return x;
+}
+
+inline std::uint16_t byteswap(std::uint16_t const x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap16(x);
+#elif defined(_MSC_VER)
+    return _byteswap_ushort(x);
+#else
+    return static_cast<std::uint16_t>((x << 8) | (x >> 8));
+#endif
+}
+
+inline std::uint32_t byteswap(std::uint32_t const x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap32(x);
+#elif defined(_MSC_VER)
+    return _byteswap_ulong(x);
+#else
+    return (x << 24) | ((x & 0xff00U) << 8) | ((x >> 8) & 0xff00U) | (x >> 24);
+#endif
+}
+
+inline std::uint64_t byteswap(std::uint64_t const x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap64(x);
+#elif defined(_MSC_VER)
+    return _byteswap_uint64(x);
+#else
+    return (static_cast<std::uint64_t>(byteswap(static_cast<std::uint32_t>(x))) << 32) | byteswap(static_cast<std::uint32_t>(x >> 32));
+#endif
+}
+
+/**
+ * Converts the integer between the native byte order and the byte
+ * order E. The conversion is its own inverse.
+ *
+ * NOTE: This function is for internal use only.
+ */
+template <endian E, typename T>
+inline T to_endian(T const x) noexcept {
+    return E == endian::native ? x : byteswap(x);
+}
+
+/**
+ * Loads the integer stored in the byte order E at possibly unaligned
+ * address.
+ *
+ * NOTE: This function is for internal use only.
+ */
+template <typename T, endian E>
+inline T load_field(unsigned char const* const src) noexcept {
+    T x;
+    std::memcpy(&x, src, sizeof(T));
+    return to_endian<E>(x);
+}
+
+/**
+ * Stores the integer in the byte order E at possibly unaligned
+ * address.
+ *
+ * NOTE: This function is for internal use only.
+ */
+template <typename T, endian E>
+inline void store_field(unsigned char* const dst, T const x) noexcept {
+    T const y = to_endian<E>(x);
+    std::memcpy(dst, &y, sizeof(T));
+}
+
+/**
+ * struct gather
+ *
+ * Bulk operations over strided fields of Size bytes by AVX2 gathers,
+ * eight 32-bit or four 64-bit fields at a time. Each function handles
+ * the leading multiple of the vector width and returns the number of
+ * fields processed, so that the caller finishes the rest. Masks are
+ * expected in the byte order of the fields. Without AVX2 or for
+ * narrower fields, nothing is processed here.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <std::size_t Size, std::size_t Stride, endian E>
+struct gather {
+    template <typename T>
+    static std::size_t count(unsigned char const*, std::size_t, T, std::size_t&) noexcept { return 0; }
+
+    template <typename T>
+    static std::size_t load(unsigned char const*, std::size_t, T*) noexcept { return 0; }
+};
+
+#if defined(__AVX2__) && defined(__x86_64__)
+template <std::size_t Stride, endian E>
+struct gather<4, Stride, E> {
+    static __m256i offsets() noexcept {
+        return _mm256_setr_epi32(
+            0, static_cast<int>(Stride), static_cast<int>(2 * Stride), static_cast<int>(3 * Stride),
+            static_cast<int>(4 * Stride), static_cast<int>(5 * Stride), static_cast<int>(6 * Stride), static_cast<int>(7 * Stride)
+        );
+    }
+
+    static std::size_t count(unsigned char const* const data, std::size_t const size, std::uint32_t const mask, std::size_t& result) noexcept {
+        __m256i const index = offsets();
+        __m256i const bits = _mm256_set1_epi32(static_cast<int>(mask));
+        std::size_t missing = 0;
+        std::size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            __m256i const fields = _mm256_i32gather_epi32(reinterpret_cast<int const*>(data + i * Stride), index, 1);
+            __m256i const none = _mm256_cmpeq_epi32(_mm256_and_si256(fields, bits), _mm256_setzero_si256());
+            missing += static_cast<std::size_t>(count_bits(static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(none)))));
+        }
+        result += i - missing;
+        return i;
+    }
+
+    static std::size_t load(unsigned char const* const data, std::size_t const size, std::uint32_t* const dst) noexcept {
+        __m256i const index = offsets();
+        __m256i const swap = _mm256_setr_epi8(
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+        );
+        std::size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            __m256i fields = _mm256_i32gather_epi32(reinterpret_cast<int const*>(data + i * Stride), index, 1);
+            if (E != endian::native) {
+                fields = _mm256_shuffle_epi8(fields, swap);
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), fields);
+        }
+        return i;
+    }
+};
+
+template <std::size_t Stride, endian E>
+struct gather<8, Stride, E> {
+    static __m256i offsets() noexcept {
+        return _mm256_setr_epi64x(
+            0, static_cast<long long>(Stride), static_cast<long long>(2 * Stride), static_cast<long long>(3 * Stride)
+        );
+    }
+
+    static std::size_t count(unsigned char const* const data, std::size_t const size, std::uint64_t const mask, std::size_t& result) noexcept {
+        __m256i const index = offsets();
+        __m256i const bits = _mm256_set1_epi64x(static_cast<long long>(mask));
+        std::size_t missing = 0;
+        std::size_t i = 0;
+        for (; i + 4 <= size; i += 4) {
+            __m256i const fields = _mm256_i64gather_epi64(reinterpret_cast<long long const*>(data + i * Stride), index, 1);
+            __m256i const none = _mm256_cmpeq_epi64(_mm256_and_si256(fields, bits), _mm256_setzero_si256());
+            missing += static_cast<std::size_t>(count_bits(static_cast<std::uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(none)))));
+        }
+        result += i - missing;
+        return i;
+    }
+
+    static std::size_t load(unsigned char const* const data, std::size_t const size, std::uint64_t* const dst) noexcept {
+        __m256i const index = offsets();
+        __m256i const swap = _mm256_setr_epi8(
+            7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+            7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8
+        );
+        std::size_t i = 0;
+        for (; i + 4 <= size; i += 4) {
+            __m256i fields = _mm256_i64gather_epi64(reinterpret_cast<long long const*>(data + i * Stride), index, 1);
+            if (E != endian::native) {
+                fields = _mm256_shuffle_epi8(fields, swap);
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), fields);
+        }
+        return i;
+    }
+};
+#endif
+
+/**
+ * Gets the pointers to bytes and to raw memory with constness of
+ * BitflagsT.
+ *
+ * NOTE: These aliases are for internal use only.
+ */
+template <typename BitflagsT>
+using byte_pointer = typename std::conditional<
+    std::is_const<BitflagsT>::value,
+    unsigned char const*,
+    unsigned char*
+>::type;
+
+template <typename BitflagsT>
+using void_pointer = typename std::conditional<
+    std::is_const<BitflagsT>::value,
+    void const*,
+    void*
+>::type;
+
+} // internal
+
+/**
+ * class flags_ref
+ *
+ * Non-owning reference to the set of flags BitflagsT stored in
+ * external memory in the byte order Endian, e.g. a field of a packet.
+ * All the operations are done in place. Checks and modifications by
+ * a flag convert the flag to the byte order of the field instead of
+ * converting the field itself. References to const BitflagsT support
+ * only non-modifying operations.
+ */
+template <typename BitflagsT, endian Endian = endian::native>
+class flags_ref {
+public:
+    using value_type      = typename std::remove_const<BitflagsT>::type;
+    using flag_type       = typename value_type::flag_type;
+    using underlying_type = typename value_type::underlying_type;
+    using pointer         = internal::byte_pointer<BitflagsT>;
+
+    explicit flags_ref(internal::void_pointer<BitflagsT> const data) noexcept
+        : data_(static_cast<pointer>(data))
+    {}
+
+    flags_ref(flags_ref const& rhs) = default;
+
+    flags_ref& operator=(flags_ref const& rhs) noexcept {
+        return *this = rhs.value();
+    }
+
+    flags_ref& operator=(value_type const& rhs) noexcept {
+        internal::store_field<underlying_type, Endian>(data_, rhs.bits());
+        return *this;
+    }
+
+    flags_ref& operator=(flag_type const& rhs) noexcept {
+        internal::store_field<underlying_type, Endian>(data_, rhs.bits);
+        return *this;
+    }
+
+    NODISCARD operator value_type() const noexcept {
+        return value();
+    }
+
+    NODISCARD bool operator==(flag_type const& rhs) const noexcept { return raw() == swapped(rhs); }
+    NODISCARD bool operator!=(flag_type const& rhs) const noexcept { return raw() != swapped(rhs); }
+
+    /**
+     * Bitwise operators overloads
+     *
+     *     <op> flags_ref
+     *
+     *     flags_ref <op>  flag_type
+     *
+     *     flags_ref <op>= flag_type
+     */
+
+    NODISCARD friend value_type operator~(flags_ref const& rhs) noexcept { return ~rhs.value(); }
+
+    NODISCARD friend value_type operator&(flags_ref const& lhs, flag_type const& rhs) noexcept { return lhs.value() & rhs; }
+    NODISCARD friend value_type operator|(flags_ref const& lhs, flag_type const& rhs) noexcept { return lhs.value() | rhs; }
+    NODISCARD friend value_type operator^(flags_ref const& lhs, flag_type const& rhs) noexcept { return lhs.value() ^ rhs; }
+
+    flags_ref& operator&=(flag_type const& rhs) noexcept {
+        store_raw(static_cast<underlying_type>(raw() & swapped(rhs)));
+        return *this;
+    }
+
+    flags_ref& operator|=(flag_type const& rhs) noexcept {
+        store_raw(static_cast<underlying_type>(raw() | swapped(rhs)));
+        return *this;
+    }
+
+    flags_ref& operator^=(flag_type const& rhs) noexcept {
+        store_raw(static_cast<underlying_type>(raw() ^ swapped(rhs)));
+        return *this;
+    }
+
+    /**
+     * Gets an underlying bits of the set of flags, in the native byte
+     * order.
+     *
+     * @return Underlying bits
+     */
+    NODISCARD underlying_type bits() const noexcept {
+        return internal::load_field<underlying_type, Endian>(data_);
+    }
+
+    /**
+     * Gets a copy of the set of flags.
+     *
+     * @return Set of flags
+     */
+    NODISCARD value_type value() const noexcept {
+        return value_type(bits());
+    }
+
+    /**
+     * Gets the address of the referenced set of flags.
+     *
+     * @return Address of the first byte
+     */
+    NODISCARD pointer data() const noexcept {
+        return data_;
+    }
+
+    /**
+     * Checks whether no flag is currently set.
+     *
+     * @return True if no flag is currently set, otherwise false
+     */
+    NODISCARD bool is_empty() const noexcept {
+        return raw() == 0;
+    }
+
+    /**
+     * Checks whether all flags are currently set.
+     *
+     * @return True if all flags are currently set, otherwise false
+     */
+    NODISCARD bool is_all() const noexcept {
+        return raw() == static_cast<underlying_type>(~underlying_type{});
+    }
+
+    /**
+     * Checks whether specified flag is contained within the current
+     * set of flags. Zero flags are treated as always present.
+     *
+     * @param rhs Flag to check
+     *
+     * @return True if the specified flags is contained within the
+     *         current set of flags, otherwise false
+     */
+    NODISCARD bool contains(flag_type const& rhs) const noexcept {
+        return (raw() & swapped(rhs)) != 0 || rhs.bits == 0;
+    }
+
+    /**
+     * Checks whether all the specified flags are contained within the
+     * current set of flags. Zero flags are treated as always present.
+     *
+     * @param rhs_1 First flag to check
+     * @param rhs_n Other flags to check
+     *
+     * @return True if all the specified flags are contained within the
+     *         current set of flags, otherwise false
+     */
+    template <typename ... U>
+    NODISCARD bool contains(flag_type const& rhs_1, U const& ... rhs_n) const noexcept {
+        return contains(rhs_1) && contains(rhs_n...);
+    }
+
+    /**
+     * Sets specified flag.
+     *
+     * @param rhs Flag to be set
+     */
+    void set(flag_type const& rhs) noexcept {
+        *this |= rhs;
+    }
+
+    /**
+     * Unsets specified flag.
+     *
+     * @param rhs Flag to be unset
+     */
+    void remove(flag_type const& rhs) noexcept {
+        store_raw(static_cast<underlying_type>(raw() & ~swapped(rhs)));
+    }
+
+    /**
+     * Sets specified flag if not already present.
+     * Otherwise, unsets the specified flag.
+     *
+     * @param rhs Flag to be toggled
+     */
+    void toggle(flag_type const& rhs) noexcept {
+        *this ^= rhs;
+    }
+
+    /**
+     * Clears all flags currently set.
+     */
+    void clear() noexcept {
+        store_raw(0);
+    }
+
+private:
+    static underlying_type swapped(flag_type const& rhs) noexcept {
+        return internal::to_endian<Endian>(static_cast<underlying_type>(rhs.bits));
+    }
+
+    underlying_type raw() const noexcept {
+        return internal::load_field<underlying_type, endian::native>(data_);
+    }
+
+    void store_raw(underlying_type const x) const noexcept {
+        internal::store_field<underlying_type, endian::native>(data_, x);
+    }
+
+    pointer data_;
+};
+
+/**
+ * class flags_view
+ *
+ * Non-owning view of the array of sets of flags BitflagsT stored in
+ * external memory in the byte order Endian, one set every Stride
+ * bytes, e.g. a field embedded within an array of structs. Elements
+ * are accessed in place through flags_ref. Bulk operations are
+ * simple loops of constant stride, which the compiler vectorizes by
+ * gathers where the target supports them. Views of const BitflagsT
+ * support only non-modifying operations.
+ *
+ * Fields embedded within records are viewed from the start of the
+ * array of records and the offset of the field within the record,
+ * e.g. view(reinterpret_cast<unsigned char*>(records.data()),
+ * offsetof(Record, flags), records.size()). A pointer to the field of
+ * the first record does not cover the records following it.
+ */
+template <
+    typename BitflagsT,
+    endian Endian = endian::native,
+    std::size_t Stride = sizeof(typename std::remove_const<BitflagsT>::type::underlying_type)
+>
+class flags_view {
+public:
+    using value_type      = typename std::remove_const<BitflagsT>::type;
+    using flag_type       = typename value_type::flag_type;
+    using underlying_type = typename value_type::underlying_type;
+    using reference       = flags_ref<BitflagsT, Endian>;
+    using pointer         = internal::byte_pointer<BitflagsT>;
+    using size_type       = std::size_t;
+
+    static_assert(Stride >= sizeof(underlying_type), "flags_view: stride smaller than the flags");
+
+    flags_view(internal::void_pointer<BitflagsT> const data, size_type const count) noexcept
+        : data_(static_cast<pointer>(data))
+        , count_(count)
+    {}
+
+    /**
+     * Creates the view of the field at the offset within each of the
+     * records placed Stride bytes apart.
+     *
+     * @param records Start of the array of records
+     * @param offset  Offset of the field within the record
+     * @param count   Number of records
+     */
+    flags_view(pointer const records, size_type const offset, size_type const count) noexcept
+        : data_(records + offset)
+        , count_(count)
+    {}
+
+    NODISCARD size_type size() const noexcept {
+        return count_;
+    }
+
+    NODISCARD bool empty() const noexcept {
+        return count_ == 0;
+    }
+
+    NODISCARD pointer data() const noexcept {
+        return data_;
+    }
+
+    /**
+     * Gets the reference to the set of flags at specified index.
+     *
+     * @param index Index less than size()
+     *
+     * @return Reference to the set of flags
+     */
+    NODISCARD reference operator[](size_type const index) const noexcept {
+        return reference(data_ + index * Stride);
+    }
+
+    /**
+     * Copies all the sets of flags out of the view, converted to the
+     * native byte order.
+     *
+     * @param dst Array of size() elements
+     */
+    void load(underlying_type* const dst) const noexcept {
+        size_type const done = internal::gather<sizeof(underlying_type), Stride, Endian>::load(data_, count_, dst);
+        for (size_type i = done; i < count_; ++i) {
+            dst[i] = internal::load_field<underlying_type, Endian>(data_ + i * Stride);
+        }
+    }
+
+    void load(value_type* const dst) const noexcept {
+        for (size_type i = 0; i < count_; ++i) {
+            dst[i] = value_type(internal::load_field<underlying_type, Endian>(data_ + i * Stride));
+        }
+    }
+
+    /**
+     * Copies all the sets of flags into the view, converted to its
+     * byte order.
+     *
+     * @param src Array of size() elements
+     */
+    void store(underlying_type const* const src) const noexcept {
+        for (size_type i = 0; i < count_; ++i) {
+            internal::store_field<underlying_type, Endian>(data_ + i * Stride, src[i]);
+        }
+    }
+
+    void store(value_type const* const src) const noexcept {
+        for (size_type i = 0; i < count_; ++i) {
+            internal::store_field<underlying_type, Endian>(data_ + i * Stride, src[i].bits());
+        }
+    }
+
+    /**
+     * Counts the sets of flags containing specified flag. Zero flags
+     * are treated as always present.
+     *
+     * @param rhs Flag to check
+     *
+     * @return Number of sets containing the flag
+     */
+    NODISCARD size_type count(flag_type const& rhs) const noexcept {
+        if (rhs.bits == 0) {
+            return count_;
+        }
+        underlying_type const mask = swapped(rhs);
+        size_type result = 0;
+        size_type const done = internal::gather<sizeof(underlying_type), Stride, Endian>::count(data_, count_, mask, result);
+        for (size_type i = done; i < count_; ++i) {
+            result += (raw(i) & mask) != 0 ? 1 : 0;
+        }
+        return result;
+    }
+
+    /**
+     * Collects the indices of the sets of flags containing specified
+     * flag. Zero flags are treated as always present.
+     *
+     * @param rhs     Flag to check
+     * @param indices Array of at least size() elements
+     *
+     * @return Number of indices written
+     */
+    size_type select(flag_type const& rhs, size_type* const indices) const noexcept {
+        underlying_type const mask = swapped(rhs);
+        bool const always = rhs.bits == 0;
+        size_type n = 0;
+        for (size_type i = 0; i < count_; ++i) {
+            // branchless, the index is always written and kept only on match
+            indices[n] = i;
+            n += ((raw(i) & mask) != 0 || always) ? 1 : 0;
+        }
+        return n;
+    }
+
+    /**
+     * Sets specified flag in all the sets of flags.
+     *
+     * @param rhs Flag to be set
+     */
+    void set(flag_type const& rhs) const noexcept {
+        underlying_type const mask = swapped(rhs);
+        for (size_type i = 0; i < count_; ++i) {
+            store_raw(i, static_cast<underlying_type>(raw(i) | mask));
+        }
+    }
+
+    /**
+     * Unsets specified flag in all the sets of flags.
+     *
+     * @param rhs Flag to be unset
+     */
+    void remove(flag_type const& rhs) const noexcept {
+        underlying_type const mask = static_cast<underlying_type>(~swapped(rhs));
+        for (size_type i = 0; i < count_; ++i) {
+            store_raw(i, static_cast<underlying_type>(raw(i) & mask));
+        }
+    }
+
+    /**
+     * Toggles specified flag in all the sets of flags.
+     *
+     * @param rhs Flag to be toggled
+     */
+    void toggle(flag_type const& rhs) const noexcept {
+        underlying_type const mask = swapped(rhs);
+        for (size_type i = 0; i < count_; ++i) {
+            store_raw(i, static_cast<underlying_type>(raw(i) ^ mask));
+        }
+    }
+
+    /**
+     * Clears all the sets of flags.
+     */
+    void clear() const noexcept {
+        for (size_type i = 0; i < count_; ++i) {
+            store_raw(i, 0);
+        }
+    }
+
+private:
+    static underlying_type swapped(flag_type const& rhs) noexcept {
+        return internal::to_endian<Endian>(static_cast<underlying_type>(rhs.bits));
+    }
+
+    underlying_type raw(size_type const index) const noexcept {
+        return internal::load_field<underlying_type, endian::native>(data_ + index * Stride);
+    }
+
+    void store_raw(size_type const index, underlying_type const x) const noexcept {
+        internal::store_field<underlying_type, endian::native>(data_ + index * Stride, x);
+    }
+
+    pointer data_;
+    size_type count_;
+};
+
+} // bf
+
+#endif // BITFLAGS_FLAGS_VIEW_HPP
@@ -0,0 +1,533 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_FREQUENCY_HPP
+#define BITFLAGS_FREQUENCY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "bitflags.hpp"
+#include "flags_map.hpp"
+#include "hash.hpp"
+
+#if BITFLAGS_HAS_PMR
+#include <memory_resource>
+#endif
+
+/**
+ * Maximal number of declared bits for which the frequency tracker
+ * counts every set of flags exactly. Wider sets of flags are counted
+ * approximately within the configured memory bound. Exact counting
+ * keeps a dense array of 2^bits counters, so the limit is capped by
+ * BITFLAGS_DENSE_MAP_BITS.
+ */
+#ifndef BITFLAGS_EXACT_FREQUENCY_BITS
+#define BITFLAGS_EXACT_FREQUENCY_BITS BITFLAGS_DENSE_MAP_BITS
+#endif
+
+namespace bf {
+
+/**
+ * struct flags_frequency
+ *
+ * Number of occurrences of the set of flags. The true number lies
+ * within [count - error, count], i.e. error is 0 if counted exactly.
+ */
+template <typename BitflagsT>
+struct flags_frequency {
+    BitflagsT flags;
+    std::uint64_t count;
+    std::uint64_t error;
+};
+
+namespace internal {
+
+/**
+ * Orders frequencies by decreasing count and then by increasing bits,
+ * so that the top of the same stream is always the same.
+ *
+ * NOTE: This function is for internal use only.
+ */
+template <typename BitflagsT>
+inline bool more_frequent(flags_frequency<BitflagsT> const& lhs, flags_frequency<BitflagsT> const& rhs) noexcept {
+    return lhs.count != rhs.count ? lhs.count > rhs.count : lhs.flags.bits() < rhs.flags.bits();
+}
+
+/**
+ * class exact_frequencies
+ *
+ * Exact counts of narrow sets of flags kept in the dense storage of
+ * the flags map, i.e. in a fixed array of a counter per set of flags.
+ *
+ * NOTE: This class is for internal use only.
+ */
+template <typename BitflagsT, typename AllocatorT>
+class exact_frequencies {
+public:
+    using underlying_type = typename BitflagsT::underlying_type;
+
+    exact_frequencies(std::size_t, std::size_t, AllocatorT const& alloc)
+        : counts_(alloc)
+    {}
+
+    NODISCARD AllocatorT get_allocator() const noexcept {
+        return counts_.get_allocator();
+    }
+
+    void add(underlying_type const key, std::uint64_t const n) {
+        *counts_.insert(key).first += n;
+    }
+
+    NODISCARD std::uint64_t count(underlying_type const key) const noexcept {
+        std::uint64_t const* const count = counts_.find(key);
+        return count != nullptr ? *count : 0;
+    }
+
+    NODISCARD std::vector<flags_frequency<BitflagsT>> top(std::size_t const k) const {
+        std::vector<flags_frequency<BitflagsT>> result;
+        result.reserve(counts_.size());
+        counts_.for_each([&result](underlying_type const key, std::uint64_t const count) {
+            result.push_back(flags_frequency<BitflagsT>{ BitflagsT(key), count, 0 });
+        });
+
+        std::size_t const n = std::min(k, result.size());
+        std::partial_sort(result.begin(), result.begin() + n, result.end(), &more_frequent<BitflagsT>);
+        result.resize(n);
+        return result;
+    }
+
+    void clear() {
+        counts_.clear();
+    }
+
+private:
+    flags_storage<BitflagsT, std::uint64_t, AllocatorT> counts_;
+};
+
+/**
+ * class sketch_frequencies
+ *
+ * Approximate counts of the sets of flags within the bounded memory.
+ * Count-min sketch of sketch_depth rows estimates the count of any set
+ * of flags from above, while space-saving keeps the heavy hitters,
+ * i.e. the candidates for the most frequent sets, together with the
+ * bound of their error. Unlike plain space-saving, the least frequent
+ * heavy hitter is replaced only by a set of flags estimated by the
+ * sketch to be more frequent. Heavy hitters form a min-heap by count,
+ * so that the least frequent one is replaced in logarithmic time, and
+ * their positions are found through an open addressing index.
+ *
+ * NOTE: This class is for internal use only.
+ */
+template <typename BitflagsT, typename AllocatorT>
+class sketch_frequencies {
+public:
+    using underlying_type = typename BitflagsT::underlying_type;
+
+    static constexpr std::size_t sketch_depth = 4;
+    static constexpr std::size_t min_sketch_width = 64;
+
+    sketch_frequencies(std::size_t const memory_bytes, std::size_t const heavy_hitters, AllocatorT const& alloc)
+        : width_(sketch_width(memory_bytes, heavy_hitters == 0 ? 1 : heavy_hitters))
+        , capacity_(heavy_hitters == 0 ? 1 : heavy_hitters)
+        , counters_(sketch_depth * width_, 0, alloc)
+        , entries_(alloc)
+        , slots_(index_size(capacity_), 0, alloc)
+    {
+        entries_.reserve(capacity_);
+    }
+
+    NODISCARD AllocatorT get_allocator() const noexcept {
+        return counters_.get_allocator();
+    }
+
+    void add(underlying_type const key, std::uint64_t const n) {
+        std::uint64_t const hash = hash_bits(key);
+        std::size_t const h1 = static_cast<std::size_t>(hash & 0xffffffffU);
+        std::size_t const h2 = static_cast<std::size_t>((hash >> 32) | 1U);
+        std::uint64_t estimate = ~std::uint64_t{};
+        for (std::size_t row = 0; row < sketch_depth; ++row) {
+            std::uint64_t& counter = counters_[row * width_ + ((h1 + row * h2) & (width_ - 1))];
+            counter += n;
+            estimate = std::min(estimate, counter);
+        }
+
+        // estimates never go below the counts of heavy hitters, so the
+        // set of flags estimated below the least frequent one is none
+        if (entries_.size() == capacity_ && estimate < entries_[0].count) {
+            return;
+        }
+
+        std::size_t slot = find_slot(key, static_cast<std::size_t>(hash));
+        if (slots_[slot] != 0) {
+            std::size_t const position = slots_[slot] - 1;
+            entries_[position].count += n;
+            sift_down(position);
+            return;
+        }
+
+        // the set of flags becomes a heavy hitter with its estimated
+        // count, only n of which is guaranteed
+        if (entries_.size() < capacity_) {
+            entries_.push_back(entry{ key, estimate, estimate - n, slot });
+            slots_[slot] = static_cast<std::uint32_t>(entries_.size());
+            sift_up(entries_.size() - 1);
+            return;
+        }
+
+        // replaces the least frequent heavy hitter only if estimated to
+        // be more frequent, so that the rare sets do not churn the heap
+        if (estimate > entries_[0].count) {
+            erase_slot(entries_[0].slot);
+            slot = find_slot(key, static_cast<std::size_t>(hash));
+            entries_[0] = entry{ key, estimate, estimate - n, slot };
+            slots_[slot] = 1;
+            sift_down(0);
+        }
+    }
+
+    NODISCARD std::uint64_t count(underlying_type const key) const noexcept {
+        std::uint64_t const estimate = sketch_estimate(key);
+        std::size_t const slot = find_slot(key, hash_bits(key));
+        return slots_[slot] != 0 ? std::min(estimate, entries_[slots_[slot] - 1].count) : estimate;
+    }
+
+    NODISCARD std::vector<flags_frequency<BitflagsT>> top(std::size_t const k) const {
+        std::vector<flags_frequency<BitflagsT>> result;
+        result.reserve(entries_.size());
+        for (auto const& e : entries_) {
+            std::uint64_t const count = std::min(e.count, sketch_estimate(e.key));
+            std::uint64_t const guaranteed = e.count - e.error;
+            result.push_back(flags_frequency<BitflagsT>{ BitflagsT(e.key), count, count - std::min(count, guaranteed) });
+        }
+
+        std::size_t const n = std::min(k, result.size());
+        std::partial_sort(result.begin(), result.begin() + n, result.end(), &more_frequent<BitflagsT>);
+        result.resize(n);
+        return result;
+    }
+
+    void clear() {
+        std::fill(counters_.begin(), counters_.end(), 0);
+        std::fill(slots_.begin(), slots_.end(), 0);
+        entries_.clear();
+    }
+
+private:
+    struct entry {
+        underlying_type key;
+        std::uint64_t count;
+        std::uint64_t error;
+        std::size_t slot;
+    };
+
+    static std::size_t index_size(std::size_t const capacity) noexcept {
+        std::size_t size = 16;
+        while (size < capacity * 2) {
+            size *= 2;
+        }
+        return size;
+    }
+
+    /**
+     * Largest power of two width of the rows such that the sketch
+     * together with the heavy hitters fits into memory_bytes.
+     */
+    static std::size_t sketch_width(std::size_t const memory_bytes, std::size_t const heavy_hitters) noexcept {
+        std::size_t const heavy_hitters_bytes = heavy_hitters * sizeof(entry) + index_size(heavy_hitters) * sizeof(std::uint32_t);
+        std::size_t const row_bytes = memory_bytes > heavy_hitters_bytes
+            ? (memory_bytes - heavy_hitters_bytes) / (sketch_depth * sizeof(std::uint64_t))
+            : 0;
+
+        std::size_t width = min_sketch_width;
+        while (width * 2 <= row_bytes) {
+            width *= 2;
+        }
+        return width;
+    }
+
+    std::uint64_t sketch_estimate(underlying_type const key) const noexcept {
+        std::uint64_t const hash = hash_bits(key);
+        std::size_t const h1 = static_cast<std::size_t>(hash & 0xffffffffU);
+        std::size_t const h2 = static_cast<std::size_t>((hash >> 32) | 1U);
+        std::uint64_t estimate = counters_[h1 & (width_ - 1)];
+        for (std::size_t row = 1; row < sketch_depth; ++row) {
+            estimate = std::min(estimate, counters_[row * width_ + ((h1 + row * h2) & (width_ - 1))]);
+        }
+        return estimate;
+    }
+
+    /**
+     * Finds the slot of the index holding the key, or the empty slot
+     * where the key belongs.
+     */
+    std::size_t find_slot(underlying_type const key, std::size_t const hash) const noexcept {
+        std::size_t const mask = slots_.size() - 1;
+        std::size_t slot = hash & mask;
+        for (; slots_[slot] != 0; slot = (slot + 1) & mask) {
+            if (entries_[slots_[slot] - 1].key == key) {
+                break;
+            }
+        }
+        return slot;
+    }
+
+    /**
+     * Removes the slot from the index by backward shift, the same as
+     * the hash table of the flags map.
+     */
+    void erase_slot(std::size_t hole) noexcept {
+        std::size_t const mask = slots_.size() - 1;
+        for (std::size_t slot = (hole + 1) & mask; slots_[slot] != 0; slot = (slot + 1) & mask) {
+            entry& moved = entries_[slots_[slot] - 1];
+            std::size_t const home = hash_bits(moved.key) & mask;
+            if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+                slots_[hole] = slots_[slot];
+                moved.slot = hole;
+                hole = slot;
+            }
+        }
+        slots_[hole] = 0;
+    }
+
+    void swap_entries(std::size_t const lhs, std::size_t const rhs) noexcept {
+        std::swap(entries_[lhs], entries_[rhs]);
+        slots_[entries_[lhs].slot] = static_cast<std::uint32_t>(lhs + 1);
+        slots_[entries_[rhs].slot] = static_cast<std::uint32_t>(rhs + 1);
+    }
+
+    void sift_up(std::size_t position) noexcept {
+        while (position > 0) {
+            std::size_t const parent = (position - 1) / 2;
+            if (entries_[parent].count <= entries_[position].count) {
+                break;
+            }
+            swap_entries(parent, position);
+            position = parent;
+        }
+    }
+
+    void sift_down(std::size_t position) noexcept {
+        std::size_t const size = entries_.size();
+        for (;;) {
+            std::size_t smallest = position;
+            std::size_t const left = 2 * position + 1;
+            if (left < size && entries_[left].count < entries_[smallest].count) {
+                smallest = left;
+            }
+            if (left + 1 < size && entries_[left + 1].count < entries_[smallest].count) {
+                smallest = left + 1;
+            }
+            if (smallest == position) {
+                break;
+            }
+            swap_entries(position, smallest);
+            position = smallest;
+        }
+    }
+
+    std::size_t width_;
+    std::size_t capacity_;
+    std::vector<std::uint64_t, rebind_alloc<AllocatorT, std::uint64_t>> counters_;
+    std::vector<entry, rebind_alloc<AllocatorT, entry>> entries_;
+    std::vector<std::uint32_t, rebind_alloc<AllocatorT, std::uint32_t>> slots_;
+};
+
+} // internal
+
+/**
+ * class frequency_tracker
+ *
+ * Online counts of the sets of flags seen in a stream, e.g. to find
+ * the combinations of flags dominating the traffic. Sets of flags with
+ * at most BITFLAGS_EXACT_FREQUENCY_BITS (and BITFLAGS_DENSE_MAP_BITS)
+ * declared bits are counted exactly in a fixed dense array. Wider sets of flags are counted by a count-min sketch,
+ * which never underestimates, and the most frequent ones are kept by
+ * space-saving, both within memory_bytes. Bits outside of the declared
+ * flags are ignored. Memory is allocated by AllocatorT.
+ */
+template <typename BitflagsT, typename AllocatorT = std::allocator<std::uint64_t>>
+class frequency_tracker {
+public:
+    using value_type      = BitflagsT;
+    using underlying_type = typename BitflagsT::underlying_type;
+    using size_type       = std::size_t;
+    using allocator_type  = AllocatorT;
+
+    static constexpr bool is_exact =
+        internal::key_bits<BitflagsT>::width <= BITFLAGS_EXACT_FREQUENCY_BITS &&
+        internal::key_bits<BitflagsT>::width <= BITFLAGS_DENSE_MAP_BITS;
+
+    static constexpr std::size_t default_memory_bytes = std::size_t{1} << 20;
+    static constexpr size_type default_heavy_hitters = 256;
+
+    frequency_tracker()
+        : frequency_tracker(default_memory_bytes)
+    {}
+
+    explicit frequency_tracker(AllocatorT const& alloc)
+        : frequency_tracker(default_memory_bytes, default_heavy_hitters, alloc)
+    {}
+
+    /**
+     * Creates the tracker. Approximate counting uses at most about
+     * memory_bytes, the more memory the smaller the error of the
+     * counts. Exact counting takes the fixed 8 * 2^bits bytes of its
+     * dense array instead, i.e. at most 32KB by default.
+     *
+     * @param memory_bytes  Bound of the memory used for counting
+     * @param heavy_hitters Number of the most frequent sets kept
+     * @param alloc         Allocator
+     */
+    explicit frequency_tracker(
+        std::size_t const memory_bytes,
+        size_type const heavy_hitters = default_heavy_hitters,
+        AllocatorT const& alloc = AllocatorT()
+    )
+        : storage_(memory_bytes, heavy_hitters, alloc)
+        , total_(0)
+    {}
+
+    NODISCARD allocator_type get_allocator() const noexcept {
+        return storage_.get_allocator();
+    }
+
+    /**
+     * Counts n occurrences of the set of flags.
+     *
+     * @param flags Set of flags
+     * @param n     Number of occurrences
+     */
+    void add(BitflagsT const& flags, std::uint64_t const n = 1) {
+        storage_.add(index(flags), n);
+        total_ += n;
+    }
+
+    /**
+     * Counts every set of flags in [first, last).
+     *
+     * @param first Beginning of the sets of flags
+     * @param last  End of the sets of flags
+     */
+    template <typename InputIt>
+    void add(InputIt first, InputIt const last) {
+        for (; first != last; ++first) {
+            add(*first);
+        }
+    }
+
+    /**
+     * Gets the number of occurrences of the set of flags. Approximate
+     * count is never lower than the true one.
+     *
+     * @param flags Set of flags
+     *
+     * @return Number of occurrences
+     */
+    NODISCARD std::uint64_t count(BitflagsT const& flags) const noexcept {
+        return storage_.count(index(flags));
+    }
+
+    /**
+     * Gets the number of all the occurrences counted so far.
+     *
+     * @return Number of occurrences
+     */
+    NODISCARD std::uint64_t total() const noexcept {
+        return total_;
+    }
+
+    /**
+     * Gets up to k most frequent sets of flags in the decreasing order
+     * of their counts. Approximate counting reports only the heavy
+     * hitters, i.e. k is limited by their number.
+     *
+     * @param k Number of the sets of flags
+     *
+     * @return Most frequent sets of flags
+     */
+    NODISCARD std::vector<flags_frequency<BitflagsT>> top(size_type const k) const {
+        return storage_.top(k);
+    }
+
+    /**
+     * Removes all the counts.
+     */
+    void clear() {
+        storage_.clear();
+        total_ = 0;
+    }
+
+private:
+    static underlying_type index(BitflagsT const& flags) noexcept {
+        return static_cast<underlying_type>(flags.bits() & internal::key_bits<BitflagsT>::mask);
+    }
+
+    typename std::conditional<
+        is_exact,
+        internal::exact_frequencies<BitflagsT, AllocatorT>,
+        internal::sketch_frequencies<BitflagsT, AllocatorT>
+    >::type storage_;
+    std::uint64_t total_;
+};
+
+#if __cplusplus < 201703L
+template <typename BitflagsT, typename AllocatorT>
+constexpr std::size_t internal::sketch_frequencies<BitflagsT, AllocatorT>::sketch_depth;
+
+template <typename BitflagsT, typename AllocatorT>
+constexpr std::size_t internal::sketch_frequencies<BitflagsT, AllocatorT>::min_sketch_width;
+
+template <typename BitflagsT, typename AllocatorT>
+constexpr bool frequency_tracker<BitflagsT, AllocatorT>::is_exact;
+
+template <typename BitflagsT, typename AllocatorT>
+constexpr std::size_t frequency_tracker<BitflagsT, AllocatorT>::default_memory_bytes;
+
+template <typename BitflagsT, typename AllocatorT>
+constexpr std::size_t frequency_tracker<BitflagsT, AllocatorT>::default_heavy_hitters;
+#endif
+
+#if BITFLAGS_HAS_PMR
+namespace pmr {
+
+template <typename BitflagsT>
+using frequency_tracker = bf::frequency_tracker<BitflagsT, std::pmr::polymorphic_allocator<std::uint64_t>>;
+
+} // pmr
+#endif
+
+} // bf
+
+#endif // BITFLAGS_FREQUENCY_HPP
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_HASH_HPP
+#define BITFLAGS_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "bitflags.hpp"
+
+namespace bf {
+
+namespace internal {
+
+/**
+ * Hashes underlying bits of the set of flags. Sets of up to 16 bits
+ * are hashed by identity since every value already differs in the
+ * low bits. Wider sets are mixed by the 64-bit finalizer of
+ * MurmurHash3 so that all the bits affect the low bits of the hash,
+ * as required by power-of-two sized tables.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param bits Underlying bits
+ *
+ * @return Hash of the bits
+ */
+template <typename T>
+inline std::size_t hash_bits(T const bits) noexcept {
+    if (sizeof(T) <= 2) {
+        return static_cast<std::size_t>(bits);
+    }
+    std::uint64_t x = static_cast<std::uint64_t>(bits);
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return static_cast<std::size_t>(x);
+}
+
+} // internal
+
+} // bf
+
+namespace std {
+
+/**
+ * struct hash
+ *
+ * Specialization of std::hash for any set of flags.
+ */
+template <
+    typename ImplT,
+    typename T,
+#if __cplusplus >= 201703L
+    template <typename, typename> typename FlagT,
+#else
+    template <typename, typename> class FlagT,
+#endif
+    typename PolicyT
+>
+struct hash<bf::bitflags<ImplT, T, FlagT, PolicyT>> {
+    NODISCARD std::size_t operator()(bf::bitflags<ImplT, T, FlagT, PolicyT> const& flags) const noexcept {
+        return bf::internal::hash_bits(flags.bits());
+    }
+};
+
+} // std
+
+#endif // BITFLAGS_HASH_HPP
@@ -0,0 +1,723 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_HYBRID_FLAGS_HPP
+#define BITFLAGS_HYBRID_FLAGS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bitflags.hpp"
+#include "dynamic_flags.hpp"
+
+namespace bf {
+
+/**
+ * enum class representation
+ *
+ * Representation currently used by the hybrid set of flags.
+ */
+enum class representation : std::uint8_t {
+    sparse, // sorted inline array of bits
+    runs,   // sorted heap array of runs of consecutive bits
+    dense   // heap bitmap of the whole universe
+};
+
+/**
+ * class hybrid_flags
+ *
+ * Set of flags drawn from a large universe of Bits flags that switches
+ * its representation by cardinality and layout of the flags:
+ *
+ *  - up to Inline flags are kept sorted within the object itself, so
+ *    that typical small sets do not allocate at all,
+ *  - larger sets made of few runs of consecutive flags are kept as
+ *    a sorted array of runs,
+ *  - others are kept as a bitmap of the whole universe.
+ *
+ * Sets shrink back to the inline array once their cardinality drops
+ * to half of the inline capacity, so that a set oscillating around
+ * the capacity does not convert on every change.
+ */
+template <std::size_t Bits, std::size_t Inline = 12>
+class hybrid_flags {
+    static_assert(Bits > 0, "hybrid_flags: universe has to hold at least one flag");
+    static_assert(Bits <= 0xffffffffULL, "hybrid_flags: universe does not fit into 32 bits");
+    static_assert(Inline > 0, "hybrid_flags: inline capacity has to be at least one flag");
+
+public:
+    using index_type = typename std::conditional<Bits <= 0x10000, std::uint16_t, std::uint32_t>::type;
+    using flag_type  = dynamic_flag<Bits>;
+    using size_type  = std::size_t;
+
+    static constexpr std::size_t words_count     = (Bits + 63) / 64;
+    static constexpr std::size_t inline_capacity = Inline;
+
+    /**
+     * Maximal number of runs kept in the run form. Each run takes
+     * 8 bytes, i.e. the run form takes at most half of the bitmap.
+     */
+    static constexpr std::size_t max_runs = words_count / 2;
+
+    hybrid_flags() noexcept
+        : kind_(representation::sparse)
+        , size_(0)
+        , inline_()
+    {}
+
+    hybrid_flags(std::initializer_list<std::size_t> bits)
+        : hybrid_flags()
+    {
+        for (std::size_t const bit : bits) {
+            set(bit);
+        }
+    }
+
+    explicit hybrid_flags(dynamic_flags<Bits> const& flags)
+        : hybrid_flags()
+    {
+        std::vector<std::uint64_t> words(flags.bits().begin(), flags.bits().end());
+        std::size_t count = 0;
+        for (std::uint64_t const word : words) {
+            count += static_cast<std::size_t>(internal::count_bits(word));
+        }
+        assign_words(std::move(words), count);
+    }
+
+    /**
+     * Gets the number of flags currently set.
+     *
+     * @return Cardinality of the set
+     */
+    NODISCARD size_type size() const noexcept {
+        return size_;
+    }
+
+    NODISCARD bool is_empty() const noexcept {
+        return size_ == 0;
+    }
+
+    /**
+     * Gets the representation currently used.
+     *
+     * @return Representation of the set
+     */
+    NODISCARD representation kind() const noexcept {
+        return kind_;
+    }
+
+    /**
+     * Checks whether the flag at specified bit is set.
+     *
+     * @param bit Bit of the flag, less than Bits
+     *
+     * @return True if the flag is set, otherwise false
+     */
+    NODISCARD bool contains(std::size_t const bit) const noexcept {
+        switch (kind_) {
+        case representation::sparse: {
+            // unused slots repeat the last bit, so that the whole array
+            // is compared by a loop of fixed trip count, which is unrolled
+            // and vectorized
+            index_type const key = static_cast<index_type>(bit);
+            index_type found = 0;
+            for (std::size_t i = 0; i < Inline; ++i) {
+                found = static_cast<index_type>(found | static_cast<index_type>(inline_[i] == key));
+            }
+            return found != 0 && size_ != 0;
+        }
+        case representation::runs: {
+            std::size_t const position = find_run(bit);
+            return position != 0 && run_last(heap_[position - 1]) >= bit;
+        }
+        default:
+            return (heap_[bit / 64] >> (bit % 64)) & 1U;
+        }
+    }
+
+    /**
+     * Checks whether the runtime flag is set. Empty flag is treated as
+     * always present.
+     *
+     * @param rhs Flag to check
+     *
+     * @return True if the flag is set, otherwise false
+     */
+    NODISCARD bool contains(flag_type const& rhs) const noexcept {
+        return rhs.mask == 0 || contains(rhs.bit());
+    }
+
+    /**
+     * Sets the flag at specified bit.
+     *
+     * @param bit Bit of the flag, less than Bits
+     */
+    void set(std::size_t const bit) {
+        switch (kind_) {
+        case representation::sparse:
+            set_sparse(bit);
+            break;
+        case representation::runs:
+            set_runs(bit);
+            break;
+        default:
+            if (!((heap_[bit / 64] >> (bit % 64)) & 1U)) {
+                heap_[bit / 64] |= std::uint64_t{1} << (bit % 64);
+                ++size_;
+            }
+            break;
+        }
+    }
+
+    void set(flag_type const& rhs) {
+        if (rhs.mask != 0) {
+            set(rhs.bit());
+        }
+    }
+
+    /**
+     * Unsets the flag at specified bit.
+     *
+     * @param bit Bit of the flag, less than Bits
+     */
+    void remove(std::size_t const bit) {
+        switch (kind_) {
+        case representation::sparse:
+            remove_sparse(bit);
+            return;
+        case representation::runs:
+            remove_runs(bit);
+            break;
+        default:
+            if ((heap_[bit / 64] >> (bit % 64)) & 1U) {
+                heap_[bit / 64] &= ~(std::uint64_t{1} << (bit % 64));
+                --size_;
+            }
+            break;
+        }
+        if (size_ <= Inline / 2) {
+            shrink();
+        }
+    }
+
+    void remove(flag_type const& rhs) {
+        if (rhs.mask != 0) {
+            remove(rhs.bit());
+        }
+    }
+
+    /**
+     * Clears all flags currently set.
+     */
+    void clear() noexcept {
+        kind_ = representation::sparse;
+        size_ = 0;
+        heap_.clear();
+        heap_.shrink_to_fit();
+    }
+
+    /**
+     * Calls f with the bit of every flag currently set, in ascending
+     * order.
+     *
+     * @param f Function called as f(std::size_t)
+     */
+    template <typename F>
+    void for_each_bit(F&& f) const {
+        switch (kind_) {
+        case representation::sparse:
+            for (std::size_t i = 0; i < size_; ++i) {
+                f(static_cast<std::size_t>(inline_[i]));
+            }
+            break;
+        case representation::runs:
+            for (std::uint64_t const run : heap_) {
+                for (std::size_t bit = run_first(run); bit <= run_last(run); ++bit) {
+                    f(bit);
+                }
+            }
+            break;
+        default:
+            for (std::size_t i = 0; i < words_count; ++i) {
+                for (std::uint64_t word = heap_[i]; word != 0; word &= word - 1) {
+                    f(i * 64 + static_cast<std::size_t>(internal::ctz(word)));
+                }
+            }
+            break;
+        }
+    }
+
+    NODISCARD friend bool operator==(hybrid_flags const& lhs, hybrid_flags const& rhs) noexcept {
+        if (lhs.size_ != rhs.size_) {
+            return false;
+        }
+        if (lhs.kind_ == rhs.kind_) {
+            return lhs.kind_ == representation::sparse
+                ? std::equal(lhs.inline_, lhs.inline_ + lhs.size_, rhs.inline_)
+                : lhs.heap_ == rhs.heap_;
+        }
+        // same cardinality, so lhs is equal to rhs once it is a subset
+        bool subset = true;
+        lhs.for_each_bit([&rhs, &subset](std::size_t const bit) {
+            subset = subset && rhs.contains(bit);
+        });
+        return subset;
+    }
+
+    NODISCARD friend bool operator!=(hybrid_flags const& lhs, hybrid_flags const& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+    /**
+     * Set operators overloads
+     *
+     *     hybrid_flags<Bits, Inline> <op>  hybrid_flags<Bits, Inline>
+     *
+     *     hybrid_flags<Bits, Inline> <op>= hybrid_flags<Bits, Inline>
+     *
+     * Operands of any representations are combined directly, without
+     * converting the sparse operands.
+     */
+
+    NODISCARD friend hybrid_flags operator&(hybrid_flags lhs, hybrid_flags const& rhs) { return lhs &= rhs; }
+    NODISCARD friend hybrid_flags operator|(hybrid_flags lhs, hybrid_flags const& rhs) { return lhs |= rhs; }
+
+    hybrid_flags& operator&=(hybrid_flags const& rhs) {
+        if (kind_ == representation::sparse) {
+            keep_contained(rhs);
+        } else if (rhs.kind_ == representation::sparse) {
+            hybrid_flags result(rhs);
+            result.keep_contained(*this);
+            *this = std::move(result);
+        } else if (kind_ == representation::runs && rhs.kind_ == representation::runs) {
+            intersect_runs(rhs);
+        } else {
+            combine_dense(rhs, false);
+        }
+        return *this;
+    }
+
+    hybrid_flags& operator|=(hybrid_flags const& rhs) {
+        if (kind_ == representation::sparse && rhs.kind_ == representation::sparse) {
+            unite_sparse(rhs);
+        } else if (rhs.kind_ == representation::sparse) {
+            for (std::size_t i = 0; i < rhs.size_; ++i) {
+                set(rhs.inline_[i]);
+            }
+        } else if (kind_ == representation::sparse) {
+            hybrid_flags result(rhs);
+            for (std::size_t i = 0; i < size_; ++i) {
+                result.set(inline_[i]);
+            }
+            *this = std::move(result);
+        } else if (kind_ == representation::runs && rhs.kind_ == representation::runs) {
+            unite_runs(rhs);
+        } else {
+            combine_dense(rhs, true);
+        }
+        return *this;
+    }
+
+private:
+    static std::uint64_t make_run(std::size_t const first, std::size_t const last) noexcept {
+        return (static_cast<std::uint64_t>(first) << 32) | static_cast<std::uint64_t>(last);
+    }
+
+    static std::size_t run_first(std::uint64_t const run) noexcept {
+        return static_cast<std::size_t>(run >> 32);
+    }
+
+    static std::size_t run_last(std::uint64_t const run) noexcept {
+        return static_cast<std::size_t>(run & 0xffffffffU);
+    }
+
+    /**
+     * Finds the position of the first run starting after the bit, by
+     * branchless binary search.
+     */
+    std::size_t find_run(std::size_t const bit) const noexcept {
+        if (heap_.empty()) {
+            return 0;
+        }
+        std::uint64_t const key = make_run(bit, 0xffffffffU);
+        std::uint64_t const* base = heap_.data();
+        for (std::size_t n = heap_.size(); n > 1; n -= n / 2) {
+            base += static_cast<std::size_t>(base[n / 2 - 1] <= key) * (n / 2);
+        }
+        return static_cast<std::size_t>(base - heap_.data()) + static_cast<std::size_t>(*base <= key);
+    }
+
+    /**
+     * Gets the bitmap of the set, whatever its representation.
+     */
+    std::vector<std::uint64_t> to_words() const {
+        if (kind_ == representation::dense) {
+            return heap_;
+        }
+        std::vector<std::uint64_t> words(words_count);
+        if (kind_ == representation::sparse) {
+            for (std::size_t i = 0; i < size_; ++i) {
+                words[inline_[i] / 64] |= std::uint64_t{1} << (inline_[i] % 64);
+            }
+        } else {
+            for (std::uint64_t const run : heap_) {
+                fill(words, run_first(run), run_last(run));
+            }
+        }
+        return words;
+    }
+
+    static void fill(std::vector<std::uint64_t>& words, std::size_t const first, std::size_t const last) noexcept {
+        for (std::size_t i = first / 64; i <= last / 64; ++i) {
+            std::size_t const low = i == first / 64 ? first % 64 : 0;
+            std::size_t const high = i == last / 64 ? last % 64 : 63;
+            words[i] |= (~std::uint64_t{0} >> (63 - high)) & (~std::uint64_t{0} << low);
+        }
+    }
+
+    /**
+     * Takes over the bitmap of count flags in the most suitable
+     * representation.
+     */
+    void assign_words(std::vector<std::uint64_t>&& words, std::size_t const count) {
+        size_ = static_cast<std::uint32_t>(count);
+
+        if (count <= Inline) {
+            kind_ = representation::sparse;
+            std::size_t n = 0;
+            for (std::size_t i = 0; i < words_count; ++i) {
+                for (std::uint64_t word = words[i]; word != 0; word &= word - 1) {
+                    inline_[n++] = static_cast<index_type>(i * 64 + static_cast<std::size_t>(internal::ctz(word)));
+                }
+            }
+            pad();
+            heap_.clear();
+            heap_.shrink_to_fit();
+            return;
+        }
+
+        // a run starts at every set bit whose lower neighbour is unset
+        std::size_t runs = 0;
+        std::uint64_t carry = 0;
+        for (std::size_t i = 0; i < words_count && runs <= max_runs; ++i) {
+            runs += static_cast<std::size_t>(internal::count_bits(words[i] & ~((words[i] << 1) | carry)));
+            carry = words[i] >> 63;
+        }
+
+        if (runs > max_runs) {
+            kind_ = representation::dense;
+            heap_ = std::move(words);
+            return;
+        }
+
+        kind_ = representation::runs;
+        heap_.clear();
+        for_each_run(words, [this](std::size_t const first, std::size_t const last) {
+            heap_.push_back(make_run(first, last));
+        });
+        heap_.shrink_to_fit();
+    }
+
+    /**
+     * Takes over the canonical runs of count flags in the most suitable
+     * representation.
+     */
+    void assign_runs(std::vector<std::uint64_t>&& runs, std::size_t const count) {
+        if (count <= Inline || runs.size() > max_runs) {
+            std::vector<std::uint64_t> words(words_count);
+            for (std::uint64_t const run : runs) {
+                fill(words, run_first(run), run_last(run));
+            }
+            assign_words(std::move(words), count);
+            return;
+        }
+        kind_ = representation::runs;
+        size_ = static_cast<std::uint32_t>(count);
+        heap_ = std::move(runs);
+    }
+
+    template <typename F>
+    static void for_each_run(std::vector<std::uint64_t> const& words, F&& f) {
+        std::size_t bit = 0;
+        while (bit < words_count * 64) {
+            std::uint64_t const set = words[bit / 64] >> (bit % 64);
+            if (set == 0) {
+                bit = (bit / 64 + 1) * 64;
+                continue;
+            }
+            std::size_t const first = bit + static_cast<std::size_t>(internal::ctz(set));
+            std::size_t last = first;
+            for (;;) {
+                std::uint64_t const unset = ~words[last / 64] >> (last % 64);
+                if (unset != 0) {
+                    last += static_cast<std::size_t>(internal::ctz(unset));
+                    break;
+                }
+                last = (last / 64 + 1) * 64;
+                if (last == words_count * 64) {
+                    break;
+                }
+            }
+            f(first, last - 1);
+            bit = last;
+        }
+    }
+
+    /**
+     * Fills the unused inline slots by the last bit.
+     */
+    void pad() noexcept {
+        std::fill(inline_ + size_, inline_ + Inline, size_ != 0 ? inline_[size_ - 1] : index_type{});
+    }
+
+    void set_sparse(std::size_t const bit) {
+        std::size_t position = 0;
+        while (position < size_ && inline_[position] < bit) {
+            ++position;
+        }
+        if (position < size_ && inline_[position] == bit) {
+            return;
+        }
+        if (size_ < Inline) {
+            std::copy_backward(inline_ + position, inline_ + size_, inline_ + size_ + 1);
+            inline_[position] = static_cast<index_type>(bit);
+            ++size_;
+            pad();
+            return;
+        }
+        std::vector<std::uint64_t> words = to_words();
+        words[bit / 64] |= std::uint64_t{1} << (bit % 64);
+        assign_words(std::move(words), size_ + 1);
+    }
+
+    void remove_sparse(std::size_t const bit) {
+        std::size_t position = 0;
+        while (position < size_ && inline_[position] < bit) {
+            ++position;
+        }
+        if (position < size_ && inline_[position] == bit) {
+            std::copy(inline_ + position + 1, inline_ + size_, inline_ + position);
+            --size_;
+            pad();
+        }
+    }
+
+    void set_runs(std::size_t const bit) {
+        auto const next = heap_.begin() + static_cast<std::ptrdiff_t>(find_run(bit));
+        bool const has_prev = next != heap_.begin();
+        bool const has_next = next != heap_.end();
+        if (has_prev && run_last(*(next - 1)) >= bit) {
+            return;
+        }
+        ++size_;
+
+        bool const joins_prev = has_prev && run_last(*(next - 1)) + 1 == bit;
+        bool const joins_next = has_next && run_first(*next) == bit + 1;
+        if (joins_prev && joins_next) {
+            *(next - 1) = make_run(run_first(*(next - 1)), run_last(*next));
+            heap_.erase(next);
+        } else if (joins_prev) {
+            *(next - 1) = make_run(run_first(*(next - 1)), bit);
+        } else if (joins_next) {
+            *next = make_run(bit, run_last(*next));
+        } else {
+            heap_.insert(next, make_run(bit, bit));
+            if (heap_.size() > max_runs) {
+                densify();
+            }
+        }
+    }
+
+    void remove_runs(std::size_t const bit) {
+        auto const next = heap_.begin() + static_cast<std::ptrdiff_t>(find_run(bit));
+        if (next == heap_.begin() || run_last(*(next - 1)) < bit) {
+            return;
+        }
+        --size_;
+
+        auto const run = next - 1;
+        std::size_t const first = run_first(*run);
+        std::size_t const last = run_last(*run);
+        if (first == last) {
+            heap_.erase(run);
+        } else if (first == bit) {
+            *run = make_run(bit + 1, last);
+        } else if (last == bit) {
+            *run = make_run(first, bit - 1);
+        } else {
+            *run = make_run(first, bit - 1);
+            heap_.insert(next, make_run(bit + 1, last));
+            if (heap_.size() > max_runs) {
+                densify();
+            }
+        }
+    }
+
+    void densify() {
+        std::vector<std::uint64_t> words = to_words();
+        kind_ = representation::dense;
+        heap_ = std::move(words);
+    }
+
+    void shrink() {
+        if (kind_ != representation::sparse) {
+            assign_words(to_words(), size_);
+        }
+    }
+
+    /**
+     * Keeps only the inline bits contained within the other set.
+     */
+    void keep_contained(hybrid_flags const& rhs) noexcept {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < size_; ++i) {
+            if (rhs.contains(inline_[i])) {
+                inline_[n++] = inline_[i];
+            }
+        }
+        size_ = static_cast<std::uint32_t>(n);
+        pad();
+    }
+
+    /**
+     * Combines the bitmap of the set with the other set in place. The
+     * result stays dense unless it fits into the inline array.
+     */
+    void combine_dense(hybrid_flags const& rhs, bool const unite) {
+        if (kind_ != representation::dense) {
+            densify();
+        }
+        std::vector<std::uint64_t> storage;
+        std::uint64_t const* other = rhs.heap_.data();
+        if (rhs.kind_ != representation::dense) {
+            storage = rhs.to_words();
+            other = storage.data();
+        }
+
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < words_count; ++i) {
+            heap_[i] = unite ? heap_[i] | other[i] : heap_[i] & other[i];
+            count += static_cast<std::size_t>(internal::count_bits(heap_[i]));
+        }
+        size_ = static_cast<std::uint32_t>(count);
+
+        if (count <= Inline) {
+            std::vector<std::uint64_t> words;
+            words.swap(heap_);
+            assign_words(std::move(words), count);
+        }
+    }
+
+    void unite_sparse(hybrid_flags const& rhs) {
+        index_type merged[2 * Inline];
+        index_type* const last = std::set_union(inline_, inline_ + size_, rhs.inline_, rhs.inline_ + rhs.size_, merged);
+        std::size_t const count = static_cast<std::size_t>(last - merged);
+        if (count <= Inline) {
+            std::copy(merged, last, inline_);
+            size_ = static_cast<std::uint32_t>(count);
+            pad();
+            return;
+        }
+
+        std::vector<std::uint64_t> runs;
+        for (index_type const* it = merged; it != last; ++it) {
+            if (!runs.empty() && run_last(runs.back()) + 1 == *it) {
+                runs.back() = make_run(run_first(runs.back()), *it);
+            } else {
+                runs.push_back(make_run(*it, *it));
+            }
+        }
+        assign_runs(std::move(runs), count);
+    }
+
+    void intersect_runs(hybrid_flags const& rhs) {
+        std::vector<std::uint64_t> runs;
+        std::size_t count = 0;
+        auto lhs_it = heap_.cbegin();
+        auto rhs_it = rhs.heap_.cbegin();
+        while (lhs_it != heap_.cend() && rhs_it != rhs.heap_.cend()) {
+            std::size_t const first = std::max(run_first(*lhs_it), run_first(*rhs_it));
+            std::size_t const last = std::min(run_last(*lhs_it), run_last(*rhs_it));
+            if (first <= last) {
+                runs.push_back(make_run(first, last));
+                count += last - first + 1;
+            }
+            if (run_last(*lhs_it) < run_last(*rhs_it)) {
+                ++lhs_it;
+            } else {
+                ++rhs_it;
+            }
+        }
+        assign_runs(std::move(runs), count);
+    }
+
+    void unite_runs(hybrid_flags const& rhs) {
+        std::vector<std::uint64_t> merged(heap_.size() + rhs.heap_.size());
+        std::merge(heap_.cbegin(), heap_.cend(), rhs.heap_.cbegin(), rhs.heap_.cend(), merged.begin());
+
+        std::vector<std::uint64_t> runs;
+        std::size_t count = 0;
+        for (std::uint64_t const run : merged) {
+            if (!runs.empty() && run_first(run) <= run_last(runs.back()) + 1) {
+                std::size_t const last = std::max(run_last(runs.back()), run_last(run));
+                count += last - run_last(runs.back());
+                runs.back() = make_run(run_first(runs.back()), last);
+            } else {
+                runs.push_back(run);
+                count += run_last(run) - run_first(run) + 1;
+            }
+        }
+        assign_runs(std::move(runs), count);
+    }
+
+    representation kind_;
+    std::uint32_t size_;
+    index_type inline_[Inline];
+    std::vector<std::uint64_t> heap_;
+};
+
+#if __cplusplus < 201703L
+template <std::size_t Bits, std::size_t Inline>
+constexpr std::size_t hybrid_flags<Bits, Inline>::words_count;
+
+template <std::size_t Bits, std::size_t Inline>
+constexpr std::size_t hybrid_flags<Bits, Inline>::inline_capacity;
+
+template <std::size_t Bits, std::size_t Inline>
+constexpr std::size_t hybrid_flags<Bits, Inline>::max_runs;
+#endif
+
+} // bf
+
+#endif // BITFLAGS_HYBRID_FLAGS_HPP
@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_INSTRUMENTATION_HPP
+#define BITFLAGS_INSTRUMENTATION_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include "bitflags.hpp"
+
+namespace bf {
+
+/**
+ * Events counted per flag by the flag_counters policy.
+ */
+enum class flag_event : std::size_t {
+    set,
+    remove,
+    toggle,
+    contains
+};
+
+namespace internal {
+
+constexpr std::size_t flag_events_count = 4;
+
+/**
+ * struct counter_block
+ *
+ * Counters of all the events for all the bits of the set of flags,
+ * owned by a single thread. Block is aligned to the cache line so
+ * that the blocks of different threads never share one. Only the
+ * owning thread writes to the counters, hence relaxed load and store
+ * are enough and no locked instruction is needed.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <typename T>
+struct alignas(64) counter_block {
+    static constexpr std::size_t bits_count = sizeof(T) * 8;
+
+    std::atomic<std::uint64_t> counts[flag_events_count][bits_count];
+
+    counter_block() noexcept {
+        reset();
+    }
+
+    void reset() noexcept {
+        for (auto& event : counts) {
+            for (auto& count : event) {
+                count.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+/**
+ * class counter_registry
+ *
+ * Keeps track of the counter blocks of all the threads using the set
+ * of flags. Counts of exited threads are accumulated separately so
+ * that they do not get lost.
+ *
+ * NOTE: This class is for internal use only.
+ */
+template <typename ImplT, typename T>
+class counter_registry {
+public:
+    static constexpr std::size_t bits_count = counter_block<T>::bits_count;
+
+    using totals_type = std::vector<std::uint64_t>;
+
+    static counter_registry& instance() {
+        static counter_registry registry;
+        return registry;
+    }
+
+    void attach(counter_block<T>* block) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        blocks_.push_back(block);
+    }
+
+    void detach(counter_block<T>* block) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        accumulate(*block, retired_);
+        blocks_.erase(std::remove(blocks_.begin(), blocks_.end(), block), blocks_.end());
+    }
+
+    totals_type totals() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        totals_type result(retired_);
+        for (auto const block : blocks_) {
+            accumulate(*block, result);
+        }
+        return result;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::fill(retired_.begin(), retired_.end(), 0);
+        for (auto const block : blocks_) {
+            block->reset();
+        }
+    }
+
+private:
+    counter_registry()
+        : retired_(flag_events_count * bits_count, 0)
+    {}
+
+    static void accumulate(counter_block<T> const& block, totals_type& totals) noexcept {
+        for (std::size_t event = 0; event < flag_events_count; ++event) {
+            for (std::size_t bit = 0; bit < bits_count; ++bit) {
+                totals[event * bits_count + bit] += block.counts[event][bit].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::mutex mutex_;
+    std::vector<counter_block<T>*> blocks_;
+    totals_type retired_;
+};
+
+/**
+ * struct thread_counters
+ *
+ * Counter block of the current thread, registered for the lifetime
+ * of the thread.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <typename ImplT, typename T>
+struct thread_counters {
+    thread_counters() {
+        counter_registry<ImplT, T>::instance().attach(&block);
+    }
+
+    ~thread_counters() {
+        counter_registry<ImplT, T>::instance().detach(&block);
+    }
+
+    thread_counters(thread_counters const&) = delete;
+    thread_counters& operator=(thread_counters const&) = delete;
+
+    static counter_block<T>& local() {
+        static thread_local thread_counters counters;
+        return counters.block;
+    }
+
+    counter_block<T> block;
+};
+
+/**
+ * Counts an event for each bit of the flag.
+ *
+ * NOTE: This function is for internal use only.
+ */
+template <typename ImplT, typename T>
+inline void count_event(flag_event const event, T const bits) noexcept {
+    auto& counts = thread_counters<ImplT, T>::local().counts[static_cast<std::size_t>(event)];
+    std::uint64_t remaining = bits;
+    while (remaining) {
+        auto& count = counts[ctz(remaining)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        remaining &= remaining - 1;
+    }
+}
+
+} // internal
+
+/**
+ * struct flag_counters
+ *
+ * Instrumentation policy that counts how many times each of the flags
+ * has been set, removed, toggled and checked. Multi-bit flags count
+ * the event for every bit they consist of, empty flags are not
+ * counted. Counts go to per-thread counters, so the instrumented
+ * flags remain cheap to use from many threads at once.
+ */
+struct flag_counters : no_instrumentation {
+    template <typename ImplT, typename T>
+    static bool on_set(T const bits) noexcept {
+        internal::count_event<ImplT>(flag_event::set, bits);
+        return true;
+    }
+
+    template <typename ImplT, typename T>
+    static bool on_remove(T const bits) noexcept {
+        internal::count_event<ImplT>(flag_event::remove, bits);
+        return true;
+    }
+
+    template <typename ImplT, typename T>
+    static bool on_toggle(T const bits) noexcept {
+        internal::count_event<ImplT>(flag_event::toggle, bits);
+        return true;
+    }
+
+    template <typename ImplT, typename T>
+    static bool on_contains(T const bits) noexcept {
+        internal::count_event<ImplT>(flag_event::contains, bits);
+        return true;
+    }
+};
+
+/**
+ * Same set of flags as BitflagsT, counting events per flag.
+ */
+template <typename BitflagsT>
+using instrumented = with_policy<BitflagsT, flag_counters>;
+
+/**
+ * struct flag_count
+ *
+ * Counts of events of a single flag, summed over all the threads.
+ */
+template <typename BitflagsT>
+struct flag_count {
+    typename BitflagsT::flag_type flag;
+    std::uint64_t set;
+    std::uint64_t remove;
+    std::uint64_t toggle;
+    std::uint64_t contains;
+};
+
+/**
+ * Gets the counts of events of every single-bit flag declared within
+ * the set of flags, in the order of their declaration. Counts are
+ * shared by all the instrumented variants of the set of flags.
+ *
+ * NOTE: In C++11, all the flags need to be defined by DEFINE_FLAG.
+ *
+ * @return Counts of events per declared flag
+ */
+template <typename BitflagsT>
+std::vector<flag_count<BitflagsT>> flag_counts() {
+    using impl_type = typename BitflagsT::impl_type;
+    using underlying_type = typename BitflagsT::underlying_type;
+    using registry_type = internal::counter_registry<impl_type, underlying_type>;
+
+    auto const totals = registry_type::instance().totals();
+
+    std::vector<flag_count<BitflagsT>> result;
+    for (auto const& flag : declared_flags<BitflagsT>()) {
+        if (flag.bits == 0 || (flag.bits & (flag.bits - 1)) != 0) {
+            continue;
+        }
+
+        std::size_t const bit = static_cast<std::size_t>(internal::ctz(flag.bits));
+        result.push_back(flag_count<BitflagsT>{
+            flag,
+            totals[static_cast<std::size_t>(flag_event::set) * registry_type::bits_count + bit],
+            totals[static_cast<std::size_t>(flag_event::remove) * registry_type::bits_count + bit],
+            totals[static_cast<std::size_t>(flag_event::toggle) * registry_type::bits_count + bit],
+            totals[static_cast<std::size_t>(flag_event::contains) * registry_type::bits_count + bit]
+        });
+    }
+    return result;
+}
+
+/**
+ * Resets the counts of events of the set of flags in all the threads.
+ */
+template <typename BitflagsT>
+void reset_flag_counts() {
+    using impl_type = typename BitflagsT::impl_type;
+    internal::counter_registry<impl_type, typename BitflagsT::underlying_type>::instance().reset();
+}
+
+namespace internal {
+
+/**
+ * Writes the flag to the stream, by name if it has one.
+ *
+ * NOTE: These functions are for internal use only.
+ */
+template <typename ImplT, typename T>
+void write_flag(std::ostream& os, flag<ImplT, T> const& f) {
+    os << f.name;
+}
+
+template <typename ImplT, typename T>
+void write_flag(std::ostream& os, raw_flag<ImplT, T> const& f) {
+    os << "bit " << ctz(f.bits);
+}
+
+} // internal
+
+/**
+ * Writes the counts of events of the set of flags to the stream, one
+ * flag per line.
+ *
+ * @param os Output stream
+ */
+template <typename BitflagsT>
+void dump_flag_counts(std::ostream& os) {
+    for (auto const& count : flag_counts<BitflagsT>()) {
+        internal::write_flag(os, count.flag);
+        os << ": set=" << count.set
+           << " remove=" << count.remove
+           << " toggle=" << count.toggle
+           << " contains=" << count.contains << '\n';
+    }
+}
+
+} // bf
+
+#endif // BITFLAGS_INSTRUMENTATION_HPP
@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_MASK_MATCHER_HPP
+#define BITFLAGS_MASK_MATCHER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "bitflags.hpp"
+
+#if BITFLAGS_HAS_PMR
+#include <memory_resource>
+#endif
+
+namespace bf {
+
+/**
+ * class mask_matcher
+ *
+ * Index of many (required, forbidden) pairs of flags that finds all
+ * the pairs matched by an incoming set of flags, i.e. the ones whose
+ * required flags are all set and whose forbidden flags are all unset.
+ *
+ * Pairs are stored bit-sliced: for each group of 64 pairs and each
+ * bit there is one word telling which pairs reject the bit when it is
+ * set and one word telling which pairs reject it when it is unset.
+ * Matching therefore costs roughly the number of bits times the number
+ * of pairs divided by 64 instead of one test per pair.
+ *
+ * All the internal arrays are allocated by AllocatorT, rebound to
+ * their element types.
+ */
+template <typename BitflagsT, typename AllocatorT = std::allocator<BitflagsT>>
+class mask_matcher {
+public:
+    using value_type      = BitflagsT;
+    using underlying_type = typename BitflagsT::underlying_type;
+    using id_type         = std::size_t;
+    using size_type       = std::size_t;
+    using allocator_type  = AllocatorT;
+
+    static constexpr int bits_count = static_cast<int>(sizeof(underlying_type) * 8);
+
+    mask_matcher() noexcept
+        : size_(0)
+        , used_bits_(0)
+        , uses_()
+    {}
+
+    explicit mask_matcher(AllocatorT const& alloc) noexcept
+        : size_(0)
+        , used_bits_(0)
+        , uses_()
+        , masks_(alloc)
+        , active_(alloc)
+        , slices_(alloc)
+        , free_(alloc)
+    {}
+
+    NODISCARD allocator_type get_allocator() const noexcept {
+        return allocator_type(masks_.get_allocator());
+    }
+
+    /**
+     * Gets the number of registered pairs.
+     *
+     * @return Number of registered pairs
+     */
+    NODISCARD size_type size() const noexcept {
+        return size_;
+    }
+
+    /**
+     * Checks whether there are no registered pairs.
+     *
+     * @return True if there are no registered pairs, otherwise false
+     */
+    NODISCARD bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    /**
+     * Registers new pair of flags. Identifiers of removed pairs are
+     * reused.
+     *
+     * @param required  Flags that need to be set
+     * @param forbidden Flags that need to be unset
+     *
+     * @return Identifier of the pair
+     */
+    id_type add(BitflagsT const& required, BitflagsT const& forbidden) {
+        id_type id;
+        if (!free_.empty()) {
+            id = free_.back();
+            free_.pop_back();
+        } else {
+            id = masks_.size();
+            masks_.push_back(mask_pair{});
+            if (id % 64 == 0) {
+                active_.push_back(0);
+                slices_.resize(slices_.size() + 2 * bits_count, 0);
+            }
+        }
+
+        active_[id / 64] |= std::uint64_t{1} << (id % 64);
+        assign(id, required.bits(), forbidden.bits());
+        ++size_;
+        return id;
+    }
+
+    /**
+     * Replaces flags of the registered pair.
+     *
+     * @param id        Identifier of the pair
+     * @param required  Flags that need to be set
+     * @param forbidden Flags that need to be unset
+     *
+     * @return True if the pair has been updated, false if it has not
+     *         been registered
+     */
+    bool update(id_type const id, BitflagsT const& required, BitflagsT const& forbidden) noexcept {
+        if (!is_registered(id)) {
+            return false;
+        }
+
+        assign(id, required.bits(), forbidden.bits());
+        return true;
+    }
+
+    /**
+     * Unregisters the pair.
+     *
+     * @param id Identifier of the pair
+     *
+     * @return True if the pair has been removed, false if it has not
+     *         been registered
+     */
+    bool remove(id_type const id) {
+        if (!is_registered(id)) {
+            return false;
+        }
+
+        assign(id, underlying_type{}, underlying_type{});
+        active_[id / 64] &= ~(std::uint64_t{1} << (id % 64));
+        free_.push_back(id);
+        --size_;
+        return true;
+    }
+
+    /**
+     * Unregisters all the pairs.
+     */
+    void clear() noexcept {
+        masks_.clear();
+        active_.clear();
+        slices_.clear();
+        free_.clear();
+        size_ = 0;
+        used_bits_ = 0;
+        uses_.fill(0);
+    }
+
+    /**
+     * Gets the bits referenced by any of the registered pairs, i.e. the
+     * only bits matching looks at.
+     *
+     * @return Mask of the used bits
+     */
+    NODISCARD std::uint64_t used_bits() const noexcept {
+        return used_bits_;
+    }
+
+    /**
+     * Calls the callback with identifier of each pair matched by the
+     * flags, in the increasing order of identifiers.
+     *
+     * @param flags    Flags to match
+     * @param callback Function called as callback(id_type)
+     */
+    template <typename CallbackT>
+    void match(BitflagsT const& flags, CallbackT&& callback) const {
+        underlying_type const value = flags.bits();
+
+        // per bit, offset of the word that rejects pairs for the
+        // current value of the bit
+        int offsets[bits_count];
+        int count = 0;
+        for (std::uint64_t used = used_bits_; used; used &= used - 1) {
+            int const bit = internal::ctz(used);
+            offsets[count++] = 2 * bit + static_cast<int>((value >> bit) & 1U);
+        }
+
+        for (std::size_t w = 0; w < active_.size(); ++w) {
+            std::uint64_t candidates = active_[w];
+            std::uint64_t const* slice = &slices_[w * 2 * bits_count];
+
+            for (int i = 0; i < count && candidates; ++i) {
+                candidates &= ~slice[offsets[i]];
+            }
+
+            while (candidates) {
+                callback(static_cast<id_type>(w * 64 + static_cast<std::size_t>(internal::ctz(candidates))));
+                candidates &= candidates - 1;
+            }
+        }
+    }
+
+    /**
+     * Appends identifiers of all the pairs matched by the flags.
+     *
+     * @param flags Flags to match
+     * @param out   Output vector
+     */
+    template <typename OutAllocatorT>
+    void match(BitflagsT const& flags, std::vector<id_type, OutAllocatorT>& out) const {
+        match(flags, appender<OutAllocatorT>{ out });
+    }
+
+private:
+    struct mask_pair {
+        underlying_type required;
+        underlying_type forbidden;
+    };
+
+    template <typename U>
+    using rebind_type = typename std::allocator_traits<AllocatorT>::template rebind_alloc<U>;
+
+    template <typename OutAllocatorT>
+    struct appender {
+        std::vector<id_type, OutAllocatorT>& out;
+
+        void operator()(id_type const id) const {
+            out.push_back(id);
+        }
+    };
+
+    bool is_registered(id_type const id) const noexcept {
+        return id < masks_.size() && ((active_[id / 64] >> (id % 64)) & 1U) != 0;
+    }
+
+    void assign(id_type const id, underlying_type const required, underlying_type const forbidden) noexcept {
+        std::uint64_t* slice = &slices_[(id / 64) * 2 * bits_count];
+        std::uint64_t const bit = std::uint64_t{1} << (id % 64);
+
+        // pairs reject unset bits they require and set bits they forbid
+        mask_pair& masks = masks_[id];
+        for (std::uint64_t old = masks.required; old; old &= old - 1) {
+            slice[2 * internal::ctz(old)] &= ~bit;
+        }
+        for (std::uint64_t old = masks.forbidden; old; old &= old - 1) {
+            slice[2 * internal::ctz(old) + 1] &= ~bit;
+        }
+        for (std::uint64_t now = required; now; now &= now - 1) {
+            slice[2 * internal::ctz(now)] |= bit;
+        }
+        for (std::uint64_t now = forbidden; now; now &= now - 1) {
+            slice[2 * internal::ctz(now) + 1] |= bit;
+        }
+
+        // bits stay used while referenced by any of the pairs
+        for (std::uint64_t old = static_cast<std::uint64_t>(masks.required | masks.forbidden); old; old &= old - 1) {
+            int const b = internal::ctz(old);
+            if (--uses_[b] == 0) {
+                used_bits_ &= ~(std::uint64_t{1} << b);
+            }
+        }
+        for (std::uint64_t now = static_cast<std::uint64_t>(required | forbidden); now; now &= now - 1) {
+            int const b = internal::ctz(now);
+            if (uses_[b]++ == 0) {
+                used_bits_ |= std::uint64_t{1} << b;
+            }
+        }
+
+        masks.required = required;
+        masks.forbidden = forbidden;
+    }
+
+    size_type size_;
+    std::uint64_t used_bits_;
+    std::array<size_type, bits_count> uses_;
+    std::vector<mask_pair, rebind_type<mask_pair>> masks_;
+    std::vector<std::uint64_t, rebind_type<std::uint64_t>> active_;
+    std::vector<std::uint64_t, rebind_type<std::uint64_t>> slices_;
+    std::vector<id_type, rebind_type<id_type>> free_;
+};
+
+#if __cplusplus < 201703L
+template <typename BitflagsT, typename AllocatorT>
+constexpr int mask_matcher<BitflagsT, AllocatorT>::bits_count;
+#endif
+
+#if BITFLAGS_HAS_PMR
+namespace pmr {
+
+template <typename BitflagsT>
+using mask_matcher = bf::mask_matcher<BitflagsT, std::pmr::polymorphic_allocator<BitflagsT>>;
+
+} // pmr
+#endif
+
+} // bf
+
+#endif // BITFLAGS_MASK_MATCHER_HPP
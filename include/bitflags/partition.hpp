@@ -0,0 +1,520 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_PARTITION_HPP
+#define BITFLAGS_PARTITION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bitflags.hpp"
+#include "flags_map.hpp"
+
+#if BITFLAGS_HAS_PMR
+#include <memory_resource>
+#endif
+
+namespace bf {
+
+namespace internal {
+
+/**
+ * struct keyed_index
+ *
+ * Key of the record together with its index within the input, sorted
+ * instead of the records themselves.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+struct keyed_index {
+    std::uint32_t key;
+    std::uint32_t index;
+};
+
+/**
+ * struct write_combining
+ *
+ * Tells whether the values of type V are scattered through software
+ * write-combining buffers, i.e. staged per bucket in a cache line
+ * aligned buffer and copied out once the line is full, and how many
+ * values fit into the line. Used for small trivially copyable values
+ * only.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <typename V>
+struct write_combining {
+    static constexpr std::size_t line_size = 64;
+    static constexpr bool enabled = std::is_trivially_copyable<V>::value && sizeof(V) <= line_size / 2;
+    static constexpr std::size_t values_per_line = enabled ? line_size / sizeof(V) : 1;
+
+    /**
+     * Gets the first cache line boundary within the buffer, which has
+     * to be at least line_size - 1 bytes longer than its lines.
+     *
+     * @param buffer Staging buffer
+     *
+     * @return Start of the first aligned line
+     */
+    static unsigned char* align(unsigned char* const buffer) noexcept {
+        return buffer + (0 - reinterpret_cast<std::uintptr_t>(buffer)) % line_size;
+    }
+};
+
+} // internal
+
+/**
+ * class radix_partition
+ *
+ * Stable partitioning of records by the combination of their flags
+ * selected by the Mask, i.e. group-by of the records by flags, in
+ * linear time. Keys are the selected bits compressed by pext, so that
+ * there is a bucket per combination of the selected flags. Keys of up
+ * to 11 bits are distributed by a single counting pass, wider keys by
+ * two least significant digit passes.
+ *
+ * Records are either scattered into the output grouped by their keys
+ * or only the permutation grouping them is computed. Small records are
+ * scattered through software write-combining buffers, i.e. staged in
+ * a cache line aligned line per bucket and copied into the output a
+ * full line of values at a time. Large inputs are split
+ * among the threads, each of them counting and scattering its own
+ * part into its own range of every bucket.
+ *
+ * Buffers are kept between calls, so that partitioning batches of
+ * similar sizes does not allocate, and are allocated by AllocatorT.
+ * Threads are not pooled: each parallel step of a call starts and
+ * joins its own threads, i.e. a call costs a few thread creations per
+ * thread, which pays off for large inputs only. Inputs are limited to
+ * 2^32 records.
+ */
+template <
+    typename BitflagsT,
+    typename BitflagsT::underlying_type Mask =
+        internal::declared_mask<BitflagsT, typename BitflagsT::underlying_type>(),
+    typename AllocatorT = std::allocator<BitflagsT>
+>
+class radix_partition {
+public:
+    using value_type      = BitflagsT;
+    using underlying_type = typename BitflagsT::underlying_type;
+    using size_type       = std::size_t;
+    using index_type      = std::uint32_t;
+    using allocator_type  = AllocatorT;
+
+    static constexpr int key_bits = internal::count_bits(Mask);
+    static constexpr size_type buckets_count = size_type{1} << key_bits;
+    static constexpr int passes_count = key_bits <= 11 ? 1 : 2;
+
+    static_assert(Mask != 0, "radix_partition: at least one flag has to be selected");
+    static_assert(key_bits <= 16, "radix_partition: up to 16 flags can be selected, select them by Mask");
+
+    /**
+     * Minimal number of records per thread, smaller inputs use fewer
+     * threads.
+     */
+    static constexpr size_type min_records_per_thread = size_type{1} << 16;
+
+    /**
+     * struct group
+     *
+     * Records of the same combination of flags, at positions
+     * [first, last) of the output.
+     */
+    struct group {
+        BitflagsT flags;
+        size_type first;
+        size_type last;
+    };
+
+    using groups_type = std::vector<group, internal::rebind_alloc<AllocatorT, group>>;
+
+    /**
+     * Creates the partitioning.
+     *
+     * @param threads Maximal number of threads used for large inputs
+     * @param alloc   Allocator of the buffers
+     */
+    explicit radix_partition(size_type const threads = 1, AllocatorT const& alloc = AllocatorT())
+        : threads_(threads == 0 ? 1 : threads)
+        , keys_(alloc)
+        , keyed_(alloc)
+        , sorted_(alloc)
+        , counts_(alloc)
+        , totals_(alloc)
+        , staging_(alloc)
+        , fill_(alloc)
+        , groups_(alloc)
+    {}
+
+    explicit radix_partition(AllocatorT const& alloc)
+        : radix_partition(1, alloc)
+    {}
+
+    NODISCARD allocator_type get_allocator() const noexcept {
+        return allocator_type(keys_.get_allocator());
+    }
+
+    /**
+     * Gets the key of the flags, i.e. the selected bits compressed
+     * into the lowest bits.
+     *
+     * @param flags Set of flags
+     *
+     * @return Key of the flags
+     */
+    NODISCARD static index_type key(BitflagsT const& flags) noexcept {
+        return (Mask & (Mask + 1)) == 0
+            ? static_cast<index_type>(flags.bits() & Mask)
+            : static_cast<index_type>(internal::extract_bits(flags.bits(), Mask));
+    }
+
+    /**
+     * Computes the stable permutation grouping the records by their
+     * flags, i.e. records[perm[0]], records[perm[1]], ... are grouped.
+     *
+     * @param records  Records to partition
+     * @param count    Number of records
+     * @param flags_of Function returning flags of the record
+     * @param perm     Permutation of count indices
+     */
+    template <typename RecordT, typename FlagsOfT>
+    void permutation(RecordT const* const records, size_type const count, FlagsOfT&& flags_of, index_type* const perm) {
+        sort_keys(records, count, flags_of);
+        internal::keyed_index const* const sorted = sorted_.data();
+        parallel(count, [sorted, perm](size_type, size_type const first, size_type const last) {
+            for (size_type i = first; i < last; ++i) {
+                perm[i] = sorted[i].index;
+            }
+        });
+        collect_groups(count);
+    }
+
+    /**
+     * Copies the records into the output grouped by their flags,
+     * preserving their order within each group.
+     *
+     * @param records  Records to partition
+     * @param count    Number of records
+     * @param flags_of Function returning flags of the record
+     * @param out      Output of count records
+     */
+    template <typename RecordT, typename FlagsOfT>
+    void scatter(RecordT const* const records, size_type const count, FlagsOfT&& flags_of, RecordT* const out) {
+        if (passes_count == 1) {
+            keys_.resize(count);
+            std::uint32_t* const keys = keys_.data();
+            parallel(count, [records, keys, &flags_of](size_type, size_type const first, size_type const last) {
+                for (size_type i = first; i < last; ++i) {
+                    keys[i] = key(flags_of(records[i]));
+                }
+            });
+            distribute(records, count, buckets_count, [keys](size_type const i) { return keys[i]; }, out);
+            collect_groups(count);
+            return;
+        }
+
+        sort_keys(records, count, flags_of);
+        internal::keyed_index const* const sorted = sorted_.data();
+        parallel(count, [records, sorted, out](size_type, size_type const first, size_type const last) {
+            for (size_type i = first; i < last; ++i) {
+                out[i] = records[sorted[i].index];
+            }
+        });
+        collect_groups(count);
+    }
+
+    /**
+     * Computes the stable permutation grouping the sets of flags.
+     *
+     * @param flags Sets of flags to partition
+     * @param count Number of sets
+     * @param perm  Permutation of count indices
+     */
+    void permutation(BitflagsT const* const flags, size_type const count, index_type* const perm) {
+        permutation(flags, count, identity{}, perm);
+    }
+
+    /**
+     * Copies the sets of flags into the output grouped, i.e. sorted by
+     * the selected flags.
+     *
+     * @param flags Sets of flags to partition
+     * @param count Number of sets
+     * @param out   Output of count sets
+     */
+    void scatter(BitflagsT const* const flags, size_type const count, BitflagsT* const out) {
+        scatter(flags, count, identity{}, out);
+    }
+
+    /**
+     * Gets the non-empty groups of the last partitioning, in the
+     * increasing order of their keys.
+     *
+     * @return Groups of records
+     */
+    NODISCARD groups_type const& groups() const noexcept {
+        return groups_;
+    }
+
+private:
+    struct identity {
+        BitflagsT const& operator()(BitflagsT const& flags) const noexcept { return flags; }
+    };
+
+    static constexpr int low_bits = passes_count == 1 ? key_bits : (key_bits + 1) / 2;
+
+    /**
+     * Calls f(thread, first, last) on contiguous parts of [0, count),
+     * one part per thread. Threads are started and joined by every
+     * call.
+     */
+    template <typename F>
+    void parallel(size_type const count, F&& f) const {
+        size_type const parts = parts_count(count);
+        if (parts == 1) {
+            f(0, 0, count);
+            return;
+        }
+
+        std::vector<std::thread> workers;
+        workers.reserve(parts - 1);
+        for (size_type t = 1; t < parts; ++t) {
+            workers.emplace_back([&f, t, parts, count] {
+                f(t, count * t / parts, count * (t + 1) / parts);
+            });
+        }
+        f(0, 0, count / parts);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    size_type parts_count(size_type const count) const noexcept {
+        size_type const parts = count / min_records_per_thread;
+        return parts == 0 ? 1 : parts < threads_ ? parts : threads_;
+    }
+
+    /**
+     * Sorts the keys of the records together with their indices.
+     */
+    template <typename RecordT, typename FlagsOfT>
+    void sort_keys(RecordT const* const records, size_type const count, FlagsOfT& flags_of) {
+        keyed_.resize(count);
+        sorted_.resize(count);
+
+        internal::keyed_index* const keyed = keyed_.data();
+        parallel(count, [records, keyed, &flags_of](size_type, size_type const first, size_type const last) {
+            for (size_type i = first; i < last; ++i) {
+                keyed[i].key = key(flags_of(records[i]));
+                keyed[i].index = static_cast<index_type>(i);
+            }
+        });
+
+        size_type const low_radix = size_type{1} << low_bits;
+        distribute(keyed, count, low_radix, [keyed, low_radix](size_type const i) {
+            return keyed[i].key & (low_radix - 1);
+        }, sorted_.data());
+
+        if (passes_count == 2) {
+            internal::keyed_index const* const sorted = sorted_.data();
+            distribute(sorted, count, buckets_count >> low_bits, [sorted](size_type const i) {
+                return sorted[i].key >> low_bits;
+            }, keyed);
+            keyed_.swap(sorted_);
+        }
+    }
+
+    /**
+     * Scatters the values into out by their digits, stable. Each
+     * thread counts the digits of its part, and then scatters its part
+     * into the range of every bucket following the parts of the
+     * preceding threads.
+     */
+    template <typename V, typename DigitT>
+    void distribute(V const* const in, size_type const count, size_type const radix, DigitT digit, V* const out) {
+        size_type const parts = parts_count(count);
+        counts_.assign(parts * radix, 0);
+        size_type* const counts = counts_.data();
+
+        parallel(count, [counts, radix, &digit](size_type const t, size_type const first, size_type const last) {
+            size_type* const histogram = counts + t * radix;
+            for (size_type i = first; i < last; ++i) {
+                ++histogram[digit(i)];
+            }
+        });
+
+        totals_.assign(radix, 0);
+        size_type position = 0;
+        for (size_type b = 0; b < radix; ++b) {
+            for (size_type t = 0; t < parts; ++t) {
+                size_type const n = counts[t * radix + b];
+                counts[t * radix + b] = position;
+                position += n;
+                totals_[b] += n;
+            }
+        }
+
+        using wc = internal::write_combining<V>;
+        if (wc::enabled && radix >= 64) {
+            // one more line for aligning the start of the buffer
+            staging_.resize((parts * radix + 1) * wc::line_size);
+            fill_.assign(parts * radix, 0);
+        }
+
+        parallel(count, [this, in, out, counts, radix, &digit](size_type const t, size_type const first, size_type const last) {
+            scatter_part(in, first, last, digit, counts + t * radix, radix, out, t);
+        });
+    }
+
+    template <typename V, typename DigitT>
+    void scatter_part(
+        V const* const in, size_type const first, size_type const last, DigitT& digit,
+        size_type* const positions, size_type const radix, V* const out, size_type const t
+    ) {
+        using wc = internal::write_combining<V>;
+        if (!wc::enabled || radix < 64) {
+            for (size_type i = first; i < last; ++i) {
+                out[positions[digit(i)]++] = in[i];
+            }
+            return;
+        }
+
+        constexpr size_type line = wc::values_per_line;
+        unsigned char* const staging = wc::align(staging_.data()) + t * radix * wc::line_size;
+        std::uint8_t* const fill = fill_.data() + t * radix;
+
+        for (size_type i = first; i < last; ++i) {
+            size_type const d = digit(i);
+            unsigned char* const slots = staging + d * wc::line_size;
+            std::memcpy(slots + fill[d] * sizeof(V), in + i, sizeof(V));
+            if (++fill[d] == line) {
+                std::memcpy(static_cast<void*>(out + positions[d]), slots, line * sizeof(V));
+                positions[d] += line;
+                fill[d] = 0;
+            }
+        }
+
+        for (size_type d = 0; d < radix; ++d) {
+            std::memcpy(static_cast<void*>(out + positions[d]), staging + d * wc::line_size, fill[d] * sizeof(V));
+            positions[d] += fill[d];
+        }
+    }
+
+    /**
+     * Collects the non-empty groups from the counts of the last pass
+     * and, for two passes, from the sorted keys.
+     */
+    void collect_groups(size_type const count) {
+        groups_.clear();
+        if (passes_count == 1) {
+            size_type first = 0;
+            for (size_type k = 0; k < buckets_count; ++k) {
+                if (totals_[k] != 0) {
+                    groups_.push_back(group{ flags_of_key(k), first, first + totals_[k] });
+                    first += totals_[k];
+                }
+            }
+            return;
+        }
+
+        for (size_type first = 0; first < count; ) {
+            std::uint32_t const k = sorted_[first].key;
+            size_type last = first + 1;
+            while (last < count && sorted_[last].key == k) {
+                ++last;
+            }
+            groups_.push_back(group{ flags_of_key(k), first, last });
+            first = last;
+        }
+    }
+
+    static BitflagsT flags_of_key(size_type const k) noexcept {
+        return BitflagsT(static_cast<underlying_type>((Mask & (Mask + 1)) == 0 ? k : internal::deposit_bits(k, Mask)));
+    }
+
+    size_type threads_;
+    std::vector<std::uint32_t, internal::rebind_alloc<AllocatorT, std::uint32_t>> keys_;
+    std::vector<internal::keyed_index, internal::rebind_alloc<AllocatorT, internal::keyed_index>> keyed_;
+    std::vector<internal::keyed_index, internal::rebind_alloc<AllocatorT, internal::keyed_index>> sorted_;
+    std::vector<size_type, internal::rebind_alloc<AllocatorT, size_type>> counts_;
+    std::vector<size_type, internal::rebind_alloc<AllocatorT, size_type>> totals_;
+    std::vector<unsigned char, internal::rebind_alloc<AllocatorT, unsigned char>> staging_;
+    std::vector<std::uint8_t, internal::rebind_alloc<AllocatorT, std::uint8_t>> fill_;
+    groups_type groups_;
+};
+
+#if __cplusplus < 201703L
+template <typename V>
+constexpr std::size_t internal::write_combining<V>::line_size;
+
+template <typename V>
+constexpr bool internal::write_combining<V>::enabled;
+
+template <typename V>
+constexpr std::size_t internal::write_combining<V>::values_per_line;
+
+template <typename BitflagsT, typename BitflagsT::underlying_type Mask, typename AllocatorT>
+constexpr int radix_partition<BitflagsT, Mask, AllocatorT>::key_bits;
+
+template <typename BitflagsT, typename BitflagsT::underlying_type Mask, typename AllocatorT>
+constexpr std::size_t radix_partition<BitflagsT, Mask, AllocatorT>::buckets_count;
+
+template <typename BitflagsT, typename BitflagsT::underlying_type Mask, typename AllocatorT>
+constexpr int radix_partition<BitflagsT, Mask, AllocatorT>::passes_count;
+
+template <typename BitflagsT, typename BitflagsT::underlying_type Mask, typename AllocatorT>
+constexpr std::size_t radix_partition<BitflagsT, Mask, AllocatorT>::min_records_per_thread;
+
+template <typename BitflagsT, typename BitflagsT::underlying_type Mask, typename AllocatorT>
+constexpr int radix_partition<BitflagsT, Mask, AllocatorT>::low_bits;
+#endif
+
+#if BITFLAGS_HAS_PMR
+namespace pmr {
+
+template <
+    typename BitflagsT,
+    typename BitflagsT::underlying_type Mask =
+        internal::declared_mask<BitflagsT, typename BitflagsT::underlying_type>()
+>
+using radix_partition = bf::radix_partition<BitflagsT, Mask, std::pmr::polymorphic_allocator<BitflagsT>>;
+
+} // pmr
+#endif
+
+} // bf
+
+#endif // BITFLAGS_PARTITION_HPP
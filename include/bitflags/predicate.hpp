@@ -0,0 +1,573 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_PREDICATE_HPP
+#define BITFLAGS_PREDICATE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+#include "bitflags.hpp"
+
+namespace bf {
+
+namespace internal {
+
+/**
+ * Compares the flag name with the identifier.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param name   Name of the flag
+ * @param text   Identifier
+ * @param length Length of the identifier
+ *
+ * @return True if the name equals the identifier, otherwise false
+ */
+#if __cplusplus >= 201703L
+constexpr bool name_equals(std::string_view const name, char const* text, std::size_t const length) noexcept {
+    return name == std::string_view(text, length);
+}
+#else
+NON_CONST_CONSTEXPR bool name_equals(char const* name, char const* text, std::size_t const length) noexcept {
+    for (std::size_t i = 0; i < length; ++i) {
+        if (name[i] != text[i]) {
+            return false;
+        }
+    }
+    return name[length] == '\0';
+}
+#endif
+
+/**
+ * class predicate_compiler
+ *
+ * Parses boolean expression over flag names and minimizes it into
+ * the disjunction of (bits & mask) == value terms.
+ *
+ * Expression is evaluated for every assignment of the referenced
+ * flags and the resulting truth table is covered by prime implicants
+ * found by greedy expansion of uncovered minterms, followed by the
+ * removal of redundant implicants.
+ *
+ * NOTE: This class is for internal use only.
+ */
+template <typename BitflagsT>
+class predicate_compiler {
+public:
+    using underlying_type = typename BitflagsT::underlying_type;
+
+    static constexpr int max_nodes = 128;
+    static constexpr int max_vars  = 16;
+    static constexpr int max_cubes = 256;
+
+    struct cube {
+        std::uint32_t care;
+        std::uint32_t value;
+    };
+
+    NON_CONST_CONSTEXPR predicate_compiler(char const* text, std::size_t const length)
+        : text_(text)
+        , length_(length)
+        , pos_(0)
+        , nodes_{}
+        , nodes_count_(0)
+        , vars_{}
+        , vars_count_(0)
+        , root_(0)
+        , table_{}
+        , covered_{}
+        , cubes_{}
+        , cubes_count_(0)
+    {
+        root_ = parse_or();
+        skip_spaces();
+        if (pos_ != length_) {
+            throw std::invalid_argument("bitflags: unexpected character in expression");
+        }
+        minimize();
+    }
+
+    NODISCARD constexpr int cubes_count() const noexcept {
+        return cubes_count_;
+    }
+
+    /**
+     * Translates the cube over referenced flags into the mask and
+     * the value over underlying bits.
+     */
+    NON_CONST_CONSTEXPR void term(int const index, underlying_type& mask, underlying_type& value) const noexcept {
+        mask = 0;
+        value = 0;
+        for (int v = 0; v < vars_count_; ++v) {
+            if ((cubes_[index].care >> v) & 1U) {
+                mask = static_cast<underlying_type>(mask | vars_[v]);
+                if ((cubes_[index].value >> v) & 1U) {
+                    value = static_cast<underlying_type>(value | vars_[v]);
+                }
+            }
+        }
+    }
+
+private:
+    enum node_kind : int { kind_var, kind_true, kind_false, kind_not, kind_and, kind_xor, kind_or };
+
+    struct node {
+        int kind;
+        int lhs;
+        int rhs;
+    };
+
+    NON_CONST_CONSTEXPR int add(int const kind, int const lhs, int const rhs) {
+        if (nodes_count_ == max_nodes) {
+            throw std::invalid_argument("bitflags: expression is too long");
+        }
+        nodes_[nodes_count_] = node{ kind, lhs, rhs };
+        return nodes_count_++;
+    }
+
+    NON_CONST_CONSTEXPR void skip_spaces() noexcept {
+        while (pos_ < length_ && (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r')) {
+            ++pos_;
+        }
+    }
+
+    NON_CONST_CONSTEXPR bool accept(char const c) noexcept {
+        skip_spaces();
+        if (pos_ < length_ && text_[pos_] == c) {
+            ++pos_;
+            // C-like doubled operators are accepted as well
+            if ((c == '&' || c == '|') && pos_ < length_ && text_[pos_] == c) {
+                ++pos_;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    NON_CONST_CONSTEXPR int parse_or() {
+        int lhs = parse_xor();
+        while (accept('|')) {
+            lhs = add(kind_or, lhs, parse_xor());
+        }
+        return lhs;
+    }
+
+    NON_CONST_CONSTEXPR int parse_xor() {
+        int lhs = parse_and();
+        while (accept('^')) {
+            lhs = add(kind_xor, lhs, parse_and());
+        }
+        return lhs;
+    }
+
+    NON_CONST_CONSTEXPR int parse_and() {
+        int lhs = parse_unary();
+        while (accept('&')) {
+            lhs = add(kind_and, lhs, parse_unary());
+        }
+        return lhs;
+    }
+
+    NON_CONST_CONSTEXPR int parse_unary() {
+        if (accept('!') || accept('~')) {
+            return add(kind_not, parse_unary(), 0);
+        }
+        if (accept('(')) {
+            int const inner = parse_or();
+            if (!accept(')')) {
+                throw std::invalid_argument("bitflags: missing closing parenthesis in expression");
+            }
+            return inner;
+        }
+        return parse_identifier();
+    }
+
+    NON_CONST_CONSTEXPR int parse_identifier() {
+        skip_spaces();
+
+        std::size_t const start = pos_;
+        while (pos_ < length_ && (
+            (text_[pos_] >= 'a' && text_[pos_] <= 'z') ||
+            (text_[pos_] >= 'A' && text_[pos_] <= 'Z') ||
+            (text_[pos_] >= '0' && text_[pos_] <= '9') ||
+            text_[pos_] == '_'
+        )) {
+            ++pos_;
+        }
+
+        if (start == pos_) {
+            throw std::invalid_argument("bitflags: expected flag name in expression");
+        }
+
+        char const* name = text_ + start;
+        std::size_t const length = pos_ - start;
+
+        if (name_equals("true", name, length)) {
+            return add(kind_true, 0, 0);
+        }
+        if (name_equals("false", name, length)) {
+            return add(kind_false, 0, 0);
+        }
+
+        for (auto const& flag : declared_flags<BitflagsT>()) {
+            if (name_equals(flag.name, name, length)) {
+                // zero flags are treated as always present
+                return flag.bits ? add(kind_var, variable(flag.bits), 0) : add(kind_true, 0, 0);
+            }
+        }
+
+        throw std::invalid_argument("bitflags: unknown flag name in expression");
+    }
+
+    NON_CONST_CONSTEXPR int variable(underlying_type const bits) {
+        for (int v = 0; v < vars_count_; ++v) {
+            if (vars_[v] == bits) {
+                return v;
+            }
+        }
+        if (vars_count_ == max_vars) {
+            throw std::invalid_argument("bitflags: expression refers to too many flags");
+        }
+        vars_[vars_count_] = bits;
+        return vars_count_++;
+    }
+
+    NON_CONST_CONSTEXPR bool evaluate(int const index, std::uint32_t const assignment) const noexcept {
+        node const& n = nodes_[index];
+        switch (n.kind) {
+            case kind_var:   return (assignment >> n.lhs) & 1U;
+            case kind_true:  return true;
+            case kind_false: return false;
+            case kind_not:   return !evaluate(n.lhs, assignment);
+            case kind_and:   return evaluate(n.lhs, assignment) && evaluate(n.rhs, assignment);
+            case kind_xor:   return evaluate(n.lhs, assignment) != evaluate(n.rhs, assignment);
+            default:         return evaluate(n.lhs, assignment) || evaluate(n.rhs, assignment);
+        }
+    }
+
+    NON_CONST_CONSTEXPR bool is_on(std::uint32_t const point) const noexcept {
+        return (table_[point / 64] >> (point % 64)) & 1U;
+    }
+
+    NON_CONST_CONSTEXPR bool is_covered(std::uint32_t const point) const noexcept {
+        return (covered_[point / 64] >> (point % 64)) & 1U;
+    }
+
+    /**
+     * Checks whether all the points of the cube evaluate to true.
+     */
+    NON_CONST_CONSTEXPR bool is_implicant(std::uint32_t const care, std::uint32_t const value, std::uint32_t const full) const noexcept {
+        std::uint32_t const free = full & ~care;
+        for (std::uint32_t s = free;; s = (s - 1) & free) {
+            if (!is_on(value | s)) {
+                return false;
+            }
+            if (!s) {
+                return true;
+            }
+        }
+    }
+
+    /**
+     * Checks whether all the points of the cube are covered by the
+     * other kept cubes.
+     */
+    NON_CONST_CONSTEXPR bool is_redundant(int const index, bool const* kept, std::uint32_t const full) const noexcept {
+        std::uint32_t const free = full & ~cubes_[index].care;
+        for (std::uint32_t s = free;; s = (s - 1) & free) {
+            std::uint32_t const point = cubes_[index].value | s;
+
+            bool covered = false;
+            for (int j = 0; j < cubes_count_ && !covered; ++j) {
+                covered = j != index && kept[j] && (point & cubes_[j].care) == cubes_[j].value;
+            }
+            if (!covered) {
+                return false;
+            }
+            if (!s) {
+                return true;
+            }
+        }
+    }
+
+    NON_CONST_CONSTEXPR void minimize() {
+        std::uint32_t const points = std::uint32_t{1} << vars_count_;
+        std::uint32_t const full = points - 1;
+
+        for (std::uint32_t p = 0; p < points; ++p) {
+            if (evaluate(root_, p)) {
+                table_[p / 64] |= std::uint64_t{1} << (p % 64);
+            }
+        }
+
+        // expand each uncovered minterm into a prime implicant
+        for (std::uint32_t p = 0; p < points; ++p) {
+            if (!is_on(p) || is_covered(p)) {
+                continue;
+            }
+
+            std::uint32_t care = full;
+            std::uint32_t value = p;
+            for (int v = 0; v < vars_count_; ++v) {
+                std::uint32_t const bit = std::uint32_t{1} << v;
+                if (is_implicant(care & ~bit, value & ~bit, full)) {
+                    care &= ~bit;
+                    value &= ~bit;
+                }
+            }
+
+            if (cubes_count_ == max_cubes) {
+                throw std::invalid_argument("bitflags: expression is too complex");
+            }
+            cubes_[cubes_count_++] = cube{ care, value };
+
+            std::uint32_t const free = full & ~care;
+            for (std::uint32_t s = free;; s = (s - 1) & free) {
+                covered_[(value | s) / 64] |= std::uint64_t{1} << ((value | s) % 64);
+                if (!s) {
+                    break;
+                }
+            }
+        }
+
+        // drop implicants covered by the other ones
+        bool kept[max_cubes] = {};
+        for (int i = 0; i < cubes_count_; ++i) {
+            kept[i] = true;
+        }
+        for (int i = cubes_count_ - 1; i >= 0; --i) {
+            if (is_redundant(i, kept, full)) {
+                kept[i] = false;
+            }
+        }
+
+        int count = 0;
+        for (int i = 0; i < cubes_count_; ++i) {
+            if (kept[i]) {
+                cubes_[count++] = cubes_[i];
+            }
+        }
+        cubes_count_ = count;
+    }
+
+    char const* text_;
+    std::size_t length_;
+    std::size_t pos_;
+
+    node nodes_[max_nodes];
+    int nodes_count_;
+
+    underlying_type vars_[max_vars];
+    int vars_count_;
+
+    int root_;
+
+    std::uint64_t table_[(1 << max_vars) / 64];
+    std::uint64_t covered_[(1 << max_vars) / 64];
+
+    cube cubes_[max_cubes];
+    int cubes_count_;
+};
+
+} // internal
+
+/**
+ * class predicate
+ *
+ * Boolean expression over flag names compiled into a small
+ * disjunction of (bits & mask) == value terms, e.g.
+ *
+ *     (flag_a & !flag_b) | flag_c
+ *
+ * Supported operators, from the lowest to the highest precedence,
+ * are OR (| or ||), XOR (^), AND (& or &&) and NOT (! or ~), together
+ * with parentheses and true / false constants. Expression may refer to
+ * at most 16 distinct flags.
+ *
+ * Compiling an invalid expression throws std::invalid_argument. Since
+ * C++14, expressions can be compiled at compile time, in which case
+ * an invalid expression is a compilation error.
+ *
+ * NOTE: Only flags with string representation can be referred to.
+ */
+template <typename BitflagsT, std::size_t MaxTerms = 16>
+class predicate {
+public:
+    using underlying_type = typename BitflagsT::underlying_type;
+
+    struct term {
+        underlying_type mask;
+        underlying_type value;
+    };
+
+    NON_CONST_CONSTEXPR explicit predicate(char const* expression)
+        : predicate(expression, length(expression))
+    {}
+
+    NON_CONST_CONSTEXPR predicate(char const* expression, std::size_t const length)
+        : terms_{}
+        , size_(0)
+    {
+        internal::predicate_compiler<BitflagsT> const compiler(expression, length);
+
+        if (compiler.cubes_count() > static_cast<int>(MaxTerms)) {
+            throw std::invalid_argument("bitflags: expression does not fit into the maximum number of terms");
+        }
+
+        for (int i = 0; i < compiler.cubes_count(); ++i) {
+            underlying_type mask = 0;
+            underlying_type value = 0;
+            compiler.term(i, mask, value);
+            terms_[size_++] = term{ mask, value };
+        }
+    }
+
+#if __cplusplus >= 201703L
+    constexpr explicit predicate(std::string_view const expression)
+        : predicate(expression.data(), expression.size())
+    {}
+#endif
+
+    /**
+     * Gets the number of terms.
+     *
+     * @return Number of terms
+     */
+    NODISCARD constexpr std::size_t size() const noexcept {
+        return size_;
+    }
+
+    NODISCARD constexpr term const* begin() const noexcept { return terms_; }
+    NODISCARD constexpr term const* end() const noexcept { return terms_ + size_; }
+
+    /**
+     * Evaluates the predicate.
+     *
+     * @param flags Flags to evaluate the predicate on
+     *
+     * @return True if the flags satisfy the predicate, otherwise false
+     */
+    NODISCARD NON_CONST_CONSTEXPR bool operator()(BitflagsT const& flags) const noexcept {
+        for (std::size_t i = 0; i < size_; ++i) {
+            if ((flags.bits() & terms_[i].mask) == terms_[i].value) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Evaluates the predicate on each of the flags. Terms are applied
+     * to a whole block of flags at once so that the evaluation is
+     * vectorized by the compiler.
+     *
+     * @param flags Flags to evaluate the predicate on
+     * @param count Number of flags
+     * @param out   Output array with the capacity of at least count results
+     */
+    void evaluate(BitflagsT const* flags, std::size_t const count, bool* out) const noexcept {
+        constexpr std::size_t block = 64;
+
+        underlying_type values[block];
+        unsigned char results[block];
+
+        for (std::size_t offset = 0; offset < count; offset += block) {
+            std::size_t const n = count - offset < block ? count - offset : block;
+
+            internal::load_bits(flags + offset, n, values);
+            apply(values, n, results);
+
+            for (std::size_t i = 0; i < n; ++i) {
+                out[offset + i] = results[i] != 0;
+            }
+        }
+    }
+
+    /**
+     * Counts the flags satisfying the predicate.
+     *
+     * @param flags Flags to evaluate the predicate on
+     * @param count Number of flags
+     *
+     * @return Number of flags satisfying the predicate
+     */
+    NODISCARD std::size_t count(BitflagsT const* flags, std::size_t const count) const noexcept {
+        constexpr std::size_t block = 64;
+
+        underlying_type values[block];
+        unsigned char results[block];
+
+        std::size_t total = 0;
+        for (std::size_t offset = 0; offset < count; offset += block) {
+            std::size_t const n = count - offset < block ? count - offset : block;
+
+            internal::load_bits(flags + offset, n, values);
+            apply(values, n, results);
+
+            for (std::size_t i = 0; i < n; ++i) {
+                total += results[i];
+            }
+        }
+        return total;
+    }
+
+private:
+    static NON_CONST_CONSTEXPR std::size_t length(char const* expression) noexcept {
+        std::size_t n = 0;
+        while (expression[n] != '\0') {
+            ++n;
+        }
+        return n;
+    }
+
+    void apply(underlying_type const* values, std::size_t const n, unsigned char* results) const noexcept {
+        for (std::size_t i = 0; i < n; ++i) {
+            results[i] = 0;
+        }
+        for (std::size_t t = 0; t < size_; ++t) {
+            underlying_type const mask = terms_[t].mask;
+            underlying_type const value = terms_[t].value;
+            for (std::size_t i = 0; i < n; ++i) {
+                results[i] = static_cast<unsigned char>(results[i] | ((values[i] & mask) == value));
+            }
+        }
+    }
+
+    term terms_[MaxTerms];
+    std::size_t size_;
+};
+
+} // bf
+
+#endif // BITFLAGS_PREDICATE_HPP
@@ -0,0 +1,668 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_SHARED_FLAGS_HPP
+#define BITFLAGS_SHARED_FLAGS_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include "atomic.hpp"
+#include "bitflags.hpp"
+
+namespace bf {
+
+namespace internal {
+
+/**
+ * Magic number and layout version of the shared segments of flags.
+ *
+ * NOTE: These constants are for internal use only.
+ */
+constexpr std::uint64_t shared_magic = 0x7367656d73666c62; // "blfsmegs"
+constexpr std::uint32_t shared_version = 1;
+
+/**
+ * Size of the cache line, each set of flags within the shared segment
+ * occupies its own one.
+ *
+ * NOTE: This constant is for internal use only.
+ */
+constexpr std::size_t cache_line_size = 64;
+
+/**
+ * struct shared_header
+ *
+ * Header at the beginning of the shared segment, describing the schema
+ * of the flags and the layout of the rest of the segment. Magic number
+ * is written last, once the segment is fully initialized.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+struct shared_header {
+    std::atomic<std::uint64_t> magic;
+    std::uint64_t fingerprint;
+    std::uint32_t version;
+    std::uint32_t underlying_size;
+    std::uint64_t count;
+    std::uint64_t names_offset;
+    std::uint64_t names_size;
+    std::uint64_t slots_offset;
+};
+
+/**
+ * struct shared_slot
+ *
+ * Set of flags within the shared segment. Epoch is advanced on every
+ * change of the flags and serves as the futex word, so that waiters
+ * can not miss a change made between their check and their sleep.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <typename BitflagsT>
+struct alignas(cache_line_size) shared_slot {
+    atomic_bitflags<BitflagsT> flags;
+    std::atomic<std::uint32_t> epoch;
+    std::atomic<std::uint32_t> waiters;
+
+    shared_slot() noexcept
+        : flags()
+        , epoch(0)
+        , waiters(0)
+    {}
+};
+
+/**
+ * Gets the name of the flag, or an empty string for raw flags.
+ *
+ * NOTE: These functions are for internal use only.
+ */
+template <typename ImplT, typename T>
+std::string flag_name(flag<ImplT, T> const& f) {
+    return std::string(f.name);
+}
+
+template <typename ImplT, typename T>
+std::string flag_name(raw_flag<ImplT, T> const&) {
+    return std::string();
+}
+
+/**
+ * Hashes the bytes into the running FNV-1a hash.
+ *
+ * NOTE: This function is for internal use only.
+ */
+inline std::uint64_t fnv1a(std::uint64_t hash, void const* const data, std::size_t const size) noexcept {
+    unsigned char const* bytes = static_cast<unsigned char const*>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+/**
+ * Gets the names of all the declared flags, each terminated by the
+ * null character, in the order of their declaration.
+ *
+ * NOTE: This function is for internal use only.
+ */
+template <typename BitflagsT>
+std::string schema_names() {
+    std::string names;
+    for (auto const& f : declared_flags<BitflagsT>()) {
+        names += flag_name(f);
+        names += '\0';
+    }
+    return names;
+}
+
+/**
+ * Gets the fingerprint of the schema of the flags, i.e. of the size of
+ * the underlying type and of the bits and the names of all the
+ * declared flags.
+ *
+ * NOTE: This function is for internal use only.
+ */
+template <typename BitflagsT>
+std::uint64_t schema_fingerprint() {
+    using underlying_type = typename BitflagsT::underlying_type;
+
+    std::uint64_t hash = 14695981039346656037ull;
+    std::uint32_t const size = sizeof(underlying_type);
+    hash = fnv1a(hash, &size, sizeof(size));
+    for (auto const& f : declared_flags<BitflagsT>()) {
+        underlying_type const bits = f.bits;
+        std::string const name = flag_name(f);
+        hash = fnv1a(hash, &bits, sizeof(bits));
+        hash = fnv1a(hash, name.c_str(), name.size() + 1);
+    }
+    return hash;
+}
+
+/**
+ * Rounds the size up to the multiple of the cache line.
+ *
+ * NOTE: This function is for internal use only.
+ */
+constexpr std::size_t align_to_cache_line(std::size_t const size) noexcept {
+    return (size + cache_line_size - 1) / cache_line_size * cache_line_size;
+}
+
+/**
+ * Blocks while the futex word equals to the expected value, at most
+ * for the specified time if any. May return spuriously. Without
+ * futexes, sleeps for a short while instead.
+ *
+ * NOTE: This function is for internal use only.
+ */
+inline void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t const expected, timespec const* const timeout) noexcept {
+#if defined(__linux__)
+    // shared futex, since the word is mapped into multiple processes
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT, expected, timeout, nullptr, 0);
+#else
+    (void)timeout;
+    if (word.load(std::memory_order_acquire) == expected) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+#endif
+}
+
+/**
+ * Wakes all the waiters blocked on the futex word.
+ *
+ * NOTE: This function is for internal use only.
+ */
+inline void futex_wake(std::atomic<std::uint32_t>& word) noexcept {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "bitflags: futex word has to be a plain 32-bit integer");
+
+} // internal
+
+/**
+ * class shared_flags
+ *
+ * Array of sets of flags within the POSIX shared memory segment, so
+ * that multiple processes on the same host may signal each other by
+ * flipping flags. Setting, removing and checking flags are single
+ * lock-free atomic operations on the mapped memory, without any
+ * system call unless another process waits for a change.
+ *
+ * The segment starts with the header carrying the fingerprint of the
+ * schema of the flags and their names, so that attaching with
+ * a different set of flags is refused. Each set of flags occupies its
+ * own cache line.
+ *
+ * Segments are created by create() and attached to by attach(), both
+ * throwing std::system_error if the segment can not be opened or
+ * mapped and std::runtime_error if it does not match the flags. The
+ * segment is detached on destruction and stays in the system until
+ * removed by unlink().
+ *
+ * NOTE: In C++11, all the flags need to be defined by DEFINE_FLAG.
+ */
+template <typename BitflagsT>
+class shared_flags {
+public:
+    using value_type      = BitflagsT;
+    using flag_type       = typename BitflagsT::flag_type;
+    using underlying_type = typename BitflagsT::underlying_type;
+    using size_type       = std::size_t;
+
+#if __cplusplus >= 201703L
+    static_assert(std::atomic<underlying_type>::is_always_lock_free, "bitflags: shared flags need lock-free atomics");
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "bitflags: shared flags need lock-free atomics");
+#endif
+
+    shared_flags() noexcept
+        : base_(nullptr)
+        , bytes_(0)
+        , slots_(nullptr)
+        , count_(0)
+    {}
+
+    shared_flags(shared_flags&& rhs) noexcept
+        : base_(rhs.base_)
+        , bytes_(rhs.bytes_)
+        , slots_(rhs.slots_)
+        , count_(rhs.count_)
+    {
+        rhs.release();
+    }
+
+    shared_flags& operator=(shared_flags&& rhs) noexcept {
+        if (this != &rhs) {
+            detach();
+            base_ = rhs.base_;
+            bytes_ = rhs.bytes_;
+            slots_ = rhs.slots_;
+            count_ = rhs.count_;
+            rhs.release();
+        }
+        return *this;
+    }
+
+    shared_flags(shared_flags const& rhs) = delete;
+    shared_flags& operator=(shared_flags const& rhs) = delete;
+
+    ~shared_flags() {
+        detach();
+    }
+
+    /**
+     * Creates new shared segment with the specified number of empty
+     * sets of flags and attaches to it.
+     *
+     * @param name  Name of the segment, e.g. "/service_flags"
+     * @param count Number of sets of flags
+     * @param mode  Access permissions of the segment
+     *
+     * @return Attached segment
+     */
+    static shared_flags create(std::string const& name, size_type const count, mode_t const mode = 0600) {
+        if (count == 0) {
+            throw std::invalid_argument("bitflags: shared segment needs at least one set of flags");
+        }
+
+        std::string const names = internal::schema_names<BitflagsT>();
+        size_type const names_offset = sizeof(internal::shared_header);
+        size_type const slots_offset = internal::align_to_cache_line(names_offset + names.size());
+        size_type const bytes = slots_offset + count * sizeof(slot_type);
+
+        int const fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, mode);
+        if (fd < 0) {
+            throw_error("bitflags: can not create shared segment");
+        }
+        if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            int const error = errno;
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            throw std::system_error(error, std::generic_category(), "bitflags: can not resize shared segment");
+        }
+
+        void* const base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        int const error = errno;
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            ::shm_unlink(name.c_str());
+            throw std::system_error(error, std::generic_category(), "bitflags: can not map shared segment");
+        }
+
+        unsigned char* const bytes_ptr = static_cast<unsigned char*>(base);
+        internal::shared_header* const header = new (base) internal::shared_header;
+        header->fingerprint = internal::schema_fingerprint<BitflagsT>();
+        header->version = internal::shared_version;
+        header->underlying_size = sizeof(underlying_type);
+        header->count = count;
+        header->names_offset = names_offset;
+        header->names_size = names.size();
+        header->slots_offset = slots_offset;
+        names.copy(reinterpret_cast<char*>(bytes_ptr + names_offset), names.size());
+
+        slot_type* const slots = reinterpret_cast<slot_type*>(bytes_ptr + slots_offset);
+        for (size_type i = 0; i < count; ++i) {
+            new (slots + i) slot_type;
+        }
+
+        header->magic.store(internal::shared_magic, std::memory_order_release);
+        return shared_flags(base, bytes, slots, count);
+    }
+
+    /**
+     * Attaches to the existing shared segment created for the same
+     * set of flags.
+     *
+     * @param name Name of the segment
+     *
+     * @return Attached segment
+     */
+    static shared_flags attach(std::string const& name) {
+        int const fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            throw_error("bitflags: can not open shared segment");
+        }
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            int const error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "bitflags: can not stat shared segment");
+        }
+        size_type const bytes = static_cast<size_type>(info.st_size);
+        if (bytes < sizeof(internal::shared_header)) {
+            ::close(fd);
+            throw std::runtime_error("bitflags: shared segment is not initialized");
+        }
+
+        void* const base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        int const error = errno;
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            throw std::system_error(error, std::generic_category(), "bitflags: can not map shared segment");
+        }
+
+        shared_flags result(base, bytes, nullptr, 0);
+        internal::shared_header const& header = result.header();
+        if (header.magic.load(std::memory_order_acquire) != internal::shared_magic) {
+            throw std::runtime_error("bitflags: shared segment is not initialized");
+        }
+        if (header.version != internal::shared_version) {
+            throw std::runtime_error("bitflags: shared segment has different layout version");
+        }
+        if (header.underlying_size != sizeof(underlying_type) || header.fingerprint != internal::schema_fingerprint<BitflagsT>()) {
+            throw std::runtime_error("bitflags: shared segment has different schema of flags");
+        }
+        if (header.slots_offset + header.count * sizeof(slot_type) > bytes) {
+            throw std::runtime_error("bitflags: shared segment is truncated");
+        }
+
+        result.slots_ = reinterpret_cast<slot_type*>(static_cast<unsigned char*>(base) + header.slots_offset);
+        result.count_ = static_cast<size_type>(header.count);
+        return result;
+    }
+
+    /**
+     * Removes the shared segment from the system. Processes attached
+     * to it keep using it until they detach.
+     *
+     * @param name Name of the segment
+     *
+     * @return True if the segment has been removed, otherwise false
+     */
+    static bool unlink(std::string const& name) noexcept {
+        return ::shm_unlink(name.c_str()) == 0;
+    }
+
+    /**
+     * Unmaps the shared segment. Does nothing if not attached.
+     */
+    void detach() noexcept {
+        if (base_ != nullptr) {
+            ::munmap(base_, bytes_);
+            release();
+        }
+    }
+
+    NODISCARD bool attached() const noexcept {
+        return base_ != nullptr;
+    }
+
+    NODISCARD size_type size() const noexcept {
+        return count_;
+    }
+
+    /**
+     * Gets the names of all the flags declared by the creator of the
+     * shared segment, in the order of their declaration. Names of raw
+     * flags are empty.
+     *
+     * @return Names of the declared flags
+     */
+    NODISCARD std::vector<std::string> names() const {
+        internal::shared_header const& h = header();
+        char const* const first = static_cast<char const*>(base_) + h.names_offset;
+        char const* const last = first + h.names_size;
+
+        std::vector<std::string> result;
+        for (char const* name = first; name < last; ) {
+            result.emplace_back(name);
+            name += result.back().size() + 1;
+        }
+        return result;
+    }
+
+    /**
+     * Gets a copy of the set of flags.
+     *
+     * @param index Index of the set of flags
+     *
+     * @return Current set of flags
+     */
+    NODISCARD BitflagsT load(size_type const index) const noexcept {
+        return slots_[index].flags.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Checks whether specified flag is contained within the set of
+     * flags. Zero flags are treated as always present.
+     *
+     * @param index Index of the set of flags
+     * @param rhs   Flag to check
+     *
+     * @return True if the flag is contained, otherwise false
+     */
+    NODISCARD bool contains(size_type const index, flag_type const& rhs) const noexcept {
+        return slots_[index].flags.contains(rhs, std::memory_order_acquire);
+    }
+
+    /**
+     * Replaces the set of flags and wakes its waiters if it changed.
+     *
+     * @param index Index of the set of flags
+     * @param rhs   New set of flags
+     *
+     * @return Previous set of flags
+     */
+    BitflagsT store(size_type const index, BitflagsT const& rhs) noexcept {
+        BitflagsT const prev = slots_[index].flags.exchange(rhs);
+        notify(index, prev.bits(), rhs.bits());
+        return prev;
+    }
+
+    /**
+     * Sets specified flag and wakes the waiters if it changed.
+     *
+     * @param index Index of the set of flags
+     * @param rhs   Flag to be set
+     *
+     * @return Previous set of flags
+     */
+    BitflagsT set(size_type const index, flag_type const& rhs) noexcept {
+        BitflagsT const prev = slots_[index].flags.set(rhs);
+        notify(index, prev.bits(), static_cast<underlying_type>(prev.bits() | rhs.bits));
+        return prev;
+    }
+
+    /**
+     * Unsets specified flag and wakes the waiters if it changed.
+     *
+     * @param index Index of the set of flags
+     * @param rhs   Flag to be unset
+     *
+     * @return Previous set of flags
+     */
+    BitflagsT remove(size_type const index, flag_type const& rhs) noexcept {
+        BitflagsT const prev = slots_[index].flags.remove(rhs);
+        notify(index, prev.bits(), static_cast<underlying_type>(prev.bits() & ~rhs.bits));
+        return prev;
+    }
+
+    /**
+     * Toggles specified flag and wakes the waiters.
+     *
+     * @param index Index of the set of flags
+     * @param rhs   Flag to be toggled
+     *
+     * @return Previous set of flags
+     */
+    BitflagsT toggle(size_type const index, flag_type const& rhs) noexcept {
+        BitflagsT const prev = slots_[index].flags.toggle(rhs);
+        notify(index, prev.bits(), static_cast<underlying_type>(prev.bits() ^ rhs.bits));
+        return prev;
+    }
+
+    /**
+     * Clears all the flags and wakes the waiters if it changed.
+     *
+     * @param index Index of the set of flags
+     *
+     * @return Previous set of flags
+     */
+    BitflagsT clear(size_type const index) noexcept {
+        BitflagsT const prev = slots_[index].flags.clear();
+        notify(index, prev.bits(), 0);
+        return prev;
+    }
+
+    /**
+     * Blocks until specified flag is contained within the set of
+     * flags. Returns immediately if it already is.
+     *
+     * @param index Index of the set of flags
+     * @param rhs   Flag to wait for
+     */
+    void wait(size_type const index, flag_type const& rhs) const noexcept {
+        slot_type& slot = slots_[index];
+        for (;;) {
+            std::uint32_t const epoch = slot.epoch.load(std::memory_order_acquire);
+            if (slot.flags.contains(rhs, std::memory_order_acquire)) {
+                return;
+            }
+            sleep(slot, epoch, nullptr);
+        }
+    }
+
+    /**
+     * Blocks until specified flag is contained within the set of flags
+     * or the timeout expires.
+     *
+     * @param index   Index of the set of flags
+     * @param rhs     Flag to wait for
+     * @param timeout Maximum time to wait
+     *
+     * @return True if the flag is contained, otherwise false
+     */
+    template <typename RepT, typename PeriodT>
+    bool wait_for(size_type const index, flag_type const& rhs, std::chrono::duration<RepT, PeriodT> const& timeout) const noexcept {
+        using clock = std::chrono::steady_clock;
+        clock::time_point const deadline = clock::now() + std::chrono::duration_cast<clock::duration>(timeout);
+
+        slot_type& slot = slots_[index];
+        for (;;) {
+            std::uint32_t const epoch = slot.epoch.load(std::memory_order_acquire);
+            if (slot.flags.contains(rhs, std::memory_order_acquire)) {
+                return true;
+            }
+
+            clock::time_point const now = clock::now();
+            if (now >= deadline) {
+                return false;
+            }
+
+            std::chrono::nanoseconds const left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now);
+            timespec remaining;
+            remaining.tv_sec = static_cast<std::time_t>(left.count() / 1000000000);
+            remaining.tv_nsec = static_cast<long>(left.count() % 1000000000);
+            sleep(slot, epoch, &remaining);
+        }
+    }
+
+private:
+    using slot_type = internal::shared_slot<BitflagsT>;
+
+    shared_flags(void* const base, size_type const bytes, slot_type* const slots, size_type const count) noexcept
+        : base_(base)
+        , bytes_(bytes)
+        , slots_(slots)
+        , count_(count)
+    {}
+
+    [[noreturn]] static void throw_error(char const* const what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    internal::shared_header const& header() const noexcept {
+        return *static_cast<internal::shared_header const*>(base_);
+    }
+
+    void release() noexcept {
+        base_ = nullptr;
+        bytes_ = 0;
+        slots_ = nullptr;
+        count_ = 0;
+    }
+
+    /**
+     * Advances the epoch of the set of flags if its bits changed, and
+     * wakes its waiters if there are any. Sequentially consistent
+     * ordering guarantees that either the waiter sees the new epoch
+     * before going to sleep or the waker sees the waiter.
+     */
+    void notify(size_type const index, underlying_type const prev, underlying_type const next) noexcept {
+        if (prev == next) {
+            return;
+        }
+        slot_type& slot = slots_[index];
+        slot.epoch.fetch_add(1);
+        if (slot.waiters.load() != 0) {
+            internal::futex_wake(slot.epoch);
+        }
+    }
+
+    static void sleep(slot_type& slot, std::uint32_t const epoch, timespec const* const timeout) noexcept {
+        slot.waiters.fetch_add(1);
+        internal::futex_wait(slot.epoch, epoch, timeout);
+        slot.waiters.fetch_sub(1);
+    }
+
+    void* base_;
+    size_type bytes_;
+    slot_type* slots_;
+    size_type count_;
+};
+
+} // bf
+
+#endif // BITFLAGS_SHARED_FLAGS_HPP
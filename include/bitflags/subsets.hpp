@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_SUBSETS_HPP
+#define BITFLAGS_SUBSETS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include "bitflags.hpp"
+
+namespace bf {
+
+namespace internal {
+
+/**
+ * Computes binomial coefficient by rows of the Pascal's triangle,
+ * so that no intermediate result overflows for n <= 64.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param n Number of elements
+ * @param k Number of chosen elements
+ *
+ * @return Number of k-combinations of n elements
+ */
+inline std::uint64_t binomial(int const n, int const k) noexcept {
+    if (k < 0 || k > n) {
+        return 0;
+    }
+    std::uint64_t row[65] = { 1 };
+    for (int i = 1; i <= n; ++i) {
+        for (int j = (i < k ? i : k); j > 0; --j) {
+            row[j] += row[j - 1];
+        }
+    }
+    return row[k];
+}
+
+/**
+ * Gets the k-combination of rank index in colexicographic order,
+ * i.e. in the order generated by Gosper's hack.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param index Rank of the combination
+ * @param n     Number of elements
+ * @param k     Number of chosen elements
+ *
+ * @return Combination as the lowest n bits
+ */
+inline std::uint64_t unrank_combination(std::uint64_t index, int const n, int const k) noexcept {
+    std::uint64_t result = 0;
+    int top = n - 1;
+    for (int i = k; i > 0; --i) {
+        while (binomial(top, i) > index) {
+            --top;
+        }
+        result |= std::uint64_t{1} << top;
+        index -= binomial(top, i);
+        --top;
+    }
+    return result;
+}
+
+/**
+ * Splits the range of indices into parts of nearly equal size.
+ *
+ * NOTE: This function is for internal use only.
+ *
+ * @param size  Number of indices
+ * @param part  Index of the part
+ * @param parts Number of parts
+ *
+ * @return First index of the part
+ */
+inline std::uint64_t split_point(std::uint64_t const size, std::uint64_t const part, std::uint64_t const parts) noexcept {
+    return size / parts * part + (part < size % parts ? part : size % parts);
+}
+
+} // internal
+
+/**
+ * class submask_range
+ *
+ * Range over all the sets of flags that contain the fixed flags base
+ * together with any subset of the free flags, in ascending order of
+ * their bits. Submasks are enumerated by (s - free) & free, which is
+ * the ascending counterpart of the (s - 1) & free trick. Free flags
+ * must not have all 64 bits set.
+ */
+template <typename BitflagsT>
+class submask_range {
+public:
+    using value_type      = BitflagsT;
+    using underlying_type = typename BitflagsT::underlying_type;
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type        = BitflagsT;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = void;
+        using reference         = BitflagsT;
+
+        constexpr iterator(underlying_type const free, underlying_type const base, underlying_type const bits, std::uint64_t const index) noexcept
+            : free_(free)
+            , base_(base)
+            , bits_(bits)
+            , index_(index)
+        {}
+
+        NODISCARD constexpr BitflagsT operator*() const noexcept {
+            return BitflagsT(static_cast<underlying_type>(bits_ | base_));
+        }
+
+        NON_CONST_CONSTEXPR iterator& operator++() noexcept {
+            bits_ = static_cast<underlying_type>((bits_ - free_) & free_);
+            ++index_;
+            return *this;
+        }
+
+        NON_CONST_CONSTEXPR iterator operator++(int) noexcept {
+            iterator it = *this;
+            ++*this;
+            return it;
+        }
+
+        NODISCARD constexpr bool operator==(iterator const& rhs) const noexcept { return index_ == rhs.index_; }
+        NODISCARD constexpr bool operator!=(iterator const& rhs) const noexcept { return index_ != rhs.index_; }
+
+    private:
+        underlying_type free_;
+        underlying_type base_;
+        underlying_type bits_;
+        std::uint64_t index_;
+    };
+
+    submask_range(underlying_type const free, underlying_type const base) noexcept
+        : submask_range(free, base, 0, std::uint64_t{1} << internal::count_bits(free))
+    {}
+
+    submask_range(underlying_type const free, underlying_type const base, std::uint64_t const first, std::uint64_t const last) noexcept
+        : free_(free)
+        , base_(static_cast<underlying_type>(base & ~free))
+        , first_(first)
+        , last_(last)
+    {}
+
+    NODISCARD iterator begin() const noexcept {
+        return iterator(free_, base_, static_cast<underlying_type>(internal::deposit_bits(first_, free_)), first_);
+    }
+
+    NODISCARD iterator end() const noexcept {
+        return iterator(free_, base_, 0, last_);
+    }
+
+    /**
+     * Gets the number of sets of flags within the range.
+     *
+     * @return Number of sets of flags
+     */
+    NODISCARD std::uint64_t size() const noexcept {
+        return last_ - first_;
+    }
+
+    /**
+     * Gets one of parts nearly equal in size, e.g. to enumerate them
+     * in parallel. Parts are disjoint and together cover the range.
+     *
+     * @param part  Index of the part
+     * @param parts Number of parts
+     *
+     * @return Part of the range
+     */
+    NODISCARD submask_range split(std::uint64_t const part, std::uint64_t const parts) const noexcept {
+        return submask_range(
+            free_,
+            base_,
+            first_ + internal::split_point(size(), part, parts),
+            first_ + internal::split_point(size(), part + 1, parts)
+        );
+    }
+
+private:
+    underlying_type free_;
+    underlying_type base_;
+    std::uint64_t first_;
+    std::uint64_t last_;
+};
+
+/**
+ * class combination_range
+ *
+ * Range over all the sets of exactly k flags chosen from the flags
+ * of the universe, in colexicographic order. Combinations are
+ * enumerated by Gosper's hack over the lowest n bits and scattered
+ * to the bits of the universe.
+ */
+template <typename BitflagsT>
+class combination_range {
+public:
+    using value_type      = BitflagsT;
+    using underlying_type = typename BitflagsT::underlying_type;
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type        = BitflagsT;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = void;
+        using reference         = BitflagsT;
+
+        constexpr iterator(underlying_type const universe, std::uint64_t const pattern, std::uint64_t const index) noexcept
+            : universe_(universe)
+            , pattern_(pattern)
+            , index_(index)
+        {}
+
+        NODISCARD BitflagsT operator*() const noexcept {
+            return BitflagsT(static_cast<underlying_type>(internal::deposit_bits(pattern_, universe_)));
+        }
+
+        iterator& operator++() noexcept {
+            if (pattern_ != 0) {
+                std::uint64_t const lowest = pattern_ & (0 - pattern_);
+                std::uint64_t const ripple = pattern_ + lowest;
+                pattern_ = (((ripple ^ pattern_) >> 2) / lowest) | ripple;
+            }
+            ++index_;
+            return *this;
+        }
+
+        iterator operator++(int) noexcept {
+            iterator it = *this;
+            ++*this;
+            return it;
+        }
+
+        NODISCARD constexpr bool operator==(iterator const& rhs) const noexcept { return index_ == rhs.index_; }
+        NODISCARD constexpr bool operator!=(iterator const& rhs) const noexcept { return index_ != rhs.index_; }
+
+    private:
+        underlying_type universe_;
+        std::uint64_t pattern_;
+        std::uint64_t index_;
+    };
+
+    combination_range(underlying_type const universe, int const k) noexcept
+        : combination_range(universe, k, 0, internal::binomial(internal::count_bits(universe), k))
+    {}
+
+    combination_range(underlying_type const universe, int const k, std::uint64_t const first, std::uint64_t const last) noexcept
+        : universe_(universe)
+        , k_(k)
+        , first_(first)
+        , last_(last)
+    {}
+
+    NODISCARD iterator begin() const noexcept {
+        return iterator(
+            universe_,
+            first_ == last_ ? 0 : internal::unrank_combination(first_, internal::count_bits(universe_), k_),
+            first_
+        );
+    }
+
+    NODISCARD iterator end() const noexcept {
+        return iterator(universe_, 0, last_);
+    }
+
+    /**
+     * Gets the number of combinations within the range.
+     *
+     * @return Number of combinations
+     */
+    NODISCARD std::uint64_t size() const noexcept {
+        return last_ - first_;
+    }
+
+    /**
+     * Gets one of parts nearly equal in size, e.g. to enumerate them
+     * in parallel. Parts are disjoint and together cover the range.
+     *
+     * @param part  Index of the part
+     * @param parts Number of parts
+     *
+     * @return Part of the range
+     */
+    NODISCARD combination_range split(std::uint64_t const part, std::uint64_t const parts) const noexcept {
+        return combination_range(
+            universe_,
+            k_,
+            first_ + internal::split_point(size(), part, parts),
+            first_ + internal::split_point(size(), part + 1, parts)
+        );
+    }
+
+private:
+    underlying_type universe_;
+    int k_;
+    std::uint64_t first_;
+    std::uint64_t last_;
+};
+
+/**
+ * Gets the range over all subsets of the specified flags, including
+ * the empty set and the flags themselves.
+ *
+ * @param mask Set of flags
+ *
+ * @return Range of subsets
+ */
+template <typename BitflagsT>
+NODISCARD inline submask_range<BitflagsT> submasks(BitflagsT const& mask) noexcept {
+    return submask_range<BitflagsT>(mask.bits(), 0);
+}
+
+/**
+ * Gets the range over all supersets of the specified flags within
+ * the universe, including the flags themselves.
+ *
+ * @param mask     Set of flags
+ * @param universe Flags that may be added
+ *
+ * @return Range of supersets
+ */
+template <typename BitflagsT>
+NODISCARD inline submask_range<BitflagsT> supersets(BitflagsT const& mask, BitflagsT const& universe) noexcept {
+    return submask_range<BitflagsT>(
+        static_cast<typename BitflagsT::underlying_type>(universe.bits() & ~mask.bits()),
+        mask.bits()
+    );
+}
+
+/**
+ * Gets the range over all the sets of exactly k flags chosen from
+ * the universe.
+ *
+ * @param universe Flags to choose from
+ * @param k        Number of chosen flags
+ *
+ * @return Range of combinations
+ */
+template <typename BitflagsT>
+NODISCARD inline combination_range<BitflagsT> combinations(BitflagsT const& universe, int const k) noexcept {
+    return combination_range<BitflagsT>(universe.bits(), k);
+}
+
+/**
+ * Gets the range over all the sets of exactly k flags chosen from
+ * all the declared flags.
+ *
+ * @param k Number of chosen flags
+ *
+ * @return Range of combinations
+ */
+template <typename BitflagsT>
+NODISCARD inline combination_range<BitflagsT> combinations(int const k) noexcept {
+    return combination_range<BitflagsT>(
+        internal::declared_mask<BitflagsT, typename BitflagsT::underlying_type>(), k
+    );
+}
+
+} // bf
+
+#endif // BITFLAGS_SUBSETS_HPP
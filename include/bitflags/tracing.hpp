@@ -0,0 +1,396 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BITFLAGS_TRACING_HPP
+#define BITFLAGS_TRACING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#   include <x86intrin.h>
+#endif
+
+#include "bitflags.hpp"
+#include "instrumentation.hpp"
+
+/**
+ * Number of records kept per thread and per set of flags. Older
+ * records get overwritten. Must be a power of 2.
+ */
+#ifndef BITFLAGS_TRACE_CAPACITY
+#   define BITFLAGS_TRACE_CAPACITY 4096
+#endif
+
+namespace bf {
+
+/**
+ * struct trace_record
+ *
+ * Single modification of the set of flags, as recorded by the
+ * flag_tracer policy.
+ */
+template <typename BitflagsT>
+struct trace_record {
+    using underlying_type = typename BitflagsT::underlying_type;
+
+    std::uint64_t timestamp; // TSC ticks where available, steady clock ticks otherwise
+    std::size_t thread;      // sequential number of the modifying thread
+    void const* object;      // address of the modified object
+    underlying_type before;
+    underlying_type after;
+};
+
+namespace internal {
+
+/**
+ * Gets the current timestamp, as cheap as possible.
+ *
+ * NOTE: This function is for internal use only.
+ */
+inline std::uint64_t timestamp() noexcept {
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    return __rdtsc();
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+/**
+ * Gets the sequential number of the current thread, shared by all
+ * the sets of flags.
+ *
+ * NOTE: This function is for internal use only.
+ */
+inline std::size_t thread_number() noexcept {
+    static std::atomic<std::size_t> next{ 0 };
+    static thread_local std::size_t const number = next.fetch_add(1, std::memory_order_relaxed);
+    return number;
+}
+
+/**
+ * class trace_buffer
+ *
+ * Ring buffer of the records of a single thread. Only the owning
+ * thread appends records, while any other thread may collect them
+ * without locking. Every slot is guarded by its own sequence number,
+ * which is invalidated before the slot gets overwritten, so that the
+ * collector can detect and drop records torn by a concurrent append.
+ *
+ * NOTE: This class is for internal use only.
+ */
+template <typename T>
+class trace_buffer {
+public:
+    static constexpr std::size_t capacity = BITFLAGS_TRACE_CAPACITY;
+
+    static_assert(capacity != 0 && (capacity & (capacity - 1)) == 0, "BITFLAGS_TRACE_CAPACITY must be a power of 2");
+
+    explicit trace_buffer(std::size_t const thread) noexcept
+        : thread_(thread)
+        , head_(0)
+        , floor_(0)
+    {
+        for (auto& slot : slots_) {
+            slot.sequence.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void append(void const* object, T const before, T const after) noexcept {
+        std::uint64_t const index = head_.load(std::memory_order_relaxed);
+        slot& s = slots_[index & (capacity - 1)];
+
+        s.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        s.timestamp.store(timestamp(), std::memory_order_relaxed);
+        s.object.store(object, std::memory_order_relaxed);
+        s.before.store(before, std::memory_order_relaxed);
+        s.after.store(after, std::memory_order_relaxed);
+
+        s.sequence.store(index + 1, std::memory_order_release);
+        head_.store(index + 1, std::memory_order_relaxed);
+    }
+
+    template <typename BitflagsT>
+    void collect(std::vector<trace_record<BitflagsT>>& records) const {
+        std::uint64_t const floor = floor_.load(std::memory_order_relaxed);
+
+        for (auto const& s : slots_) {
+            std::uint64_t const sequence = s.sequence.load(std::memory_order_acquire);
+            if (sequence <= floor) {
+                continue;
+            }
+
+            trace_record<BitflagsT> record{
+                s.timestamp.load(std::memory_order_relaxed),
+                thread_,
+                s.object.load(std::memory_order_relaxed),
+                s.before.load(std::memory_order_relaxed),
+                s.after.load(std::memory_order_relaxed)
+            };
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.sequence.load(std::memory_order_relaxed) == sequence) {
+                records.push_back(record);
+            }
+        }
+    }
+
+    void clear() noexcept {
+        floor_.store(head_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+private:
+    struct slot {
+        std::atomic<std::uint64_t> sequence; // index + 1 of the record, 0 while being written
+        std::atomic<std::uint64_t> timestamp;
+        std::atomic<void const*> object;
+        std::atomic<T> before;
+        std::atomic<T> after;
+    };
+
+    std::size_t const thread_;
+    std::atomic<std::uint64_t> head_;
+    std::atomic<std::uint64_t> floor_;
+    slot slots_[capacity];
+};
+
+/**
+ * class trace_registry
+ *
+ * Owns the trace buffers of all the threads modifying the set of
+ * flags. Buffers of exited threads are kept until cleared, so their
+ * history is not lost.
+ *
+ * NOTE: This class is for internal use only.
+ */
+template <typename ImplT, typename T>
+class trace_registry {
+public:
+    static trace_registry& instance() {
+        static trace_registry registry;
+        return registry;
+    }
+
+    trace_buffer<T>* attach() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffers_.emplace_back(std::unique_ptr<trace_buffer<T>>(new trace_buffer<T>(thread_number())), true);
+        return buffers_.back().first.get();
+    }
+
+    void detach(trace_buffer<T> const* buffer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& entry : buffers_) {
+            if (entry.first.get() == buffer) {
+                entry.second = false;
+            }
+        }
+    }
+
+    template <typename BitflagsT>
+    std::vector<trace_record<BitflagsT>> collect() {
+        std::vector<trace_record<BitflagsT>> records;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto const& entry : buffers_) {
+                entry.first->collect(records);
+            }
+        }
+
+        std::stable_sort(records.begin(), records.end(), [](trace_record<BitflagsT> const& lhs, trace_record<BitflagsT> const& rhs) {
+            return lhs.timestamp < rhs.timestamp;
+        });
+        return records;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffers_.erase(
+            std::remove_if(buffers_.begin(), buffers_.end(), [](entry_type const& entry) { return !entry.second; }),
+            buffers_.end()
+        );
+        for (auto const& entry : buffers_) {
+            entry.first->clear();
+        }
+    }
+
+private:
+    // buffer and whether its thread is still alive
+    using entry_type = std::pair<std::unique_ptr<trace_buffer<T>>, bool>;
+
+    trace_registry() = default;
+
+    std::mutex mutex_;
+    std::vector<entry_type> buffers_;
+};
+
+/**
+ * struct thread_trace
+ *
+ * Trace buffer of the current thread, registered for the lifetime
+ * of the thread.
+ *
+ * NOTE: This struct is for internal use only.
+ */
+template <typename ImplT, typename T>
+struct thread_trace {
+    thread_trace()
+        : buffer(trace_registry<ImplT, T>::instance().attach())
+    {}
+
+    ~thread_trace() {
+        trace_registry<ImplT, T>::instance().detach(buffer);
+    }
+
+    thread_trace(thread_trace const&) = delete;
+    thread_trace& operator=(thread_trace const&) = delete;
+
+    static trace_buffer<T>& local() {
+        static thread_local thread_trace trace;
+        return *trace.buffer;
+    }
+
+    trace_buffer<T>* const buffer;
+};
+
+} // internal
+
+/**
+ * struct flag_tracer
+ *
+ * Instrumentation policy that records every modification changing
+ * the flags into the per-thread ring buffer: timestamp, address of
+ * the object and bits before and after the modification. Appending
+ * a record takes no locks, so tracing costs only a few nanoseconds
+ * per modification.
+ */
+struct flag_tracer : no_instrumentation {
+    template <typename ImplT, typename T>
+    static bool on_change(void const* object, T const before, T const after) noexcept {
+        if (before != after) {
+            internal::thread_trace<ImplT, T>::local().append(object, before, after);
+        }
+        return true;
+    }
+};
+
+/**
+ * Same set of flags as BitflagsT, tracing its modifications.
+ */
+template <typename BitflagsT>
+using traced = with_policy<BitflagsT, flag_tracer>;
+
+/**
+ * Gets the records of the set of flags from all the threads, ordered
+ * by timestamp. Only the last BITFLAGS_TRACE_CAPACITY records of each
+ * thread are kept. Records are shared by all the traced variants of
+ * the set of flags.
+ *
+ * @return Records ordered by timestamp
+ */
+template <typename BitflagsT>
+std::vector<trace_record<BitflagsT>> trace_records() {
+    using impl_type = typename BitflagsT::impl_type;
+    using underlying_type = typename BitflagsT::underlying_type;
+    return internal::trace_registry<impl_type, underlying_type>::instance().template collect<BitflagsT>();
+}
+
+/**
+ * Drops all the records of the set of flags.
+ */
+template <typename BitflagsT>
+void clear_traces() {
+    using impl_type = typename BitflagsT::impl_type;
+    internal::trace_registry<impl_type, typename BitflagsT::underlying_type>::instance().clear();
+}
+
+namespace internal {
+
+/**
+ * Writes the declared flag occupying the bit to the stream.
+ *
+ * NOTE: This function is for internal use only.
+ */
+template <typename BitflagsT>
+void write_bit(std::ostream& os, std::uint64_t const bit) {
+    for (auto const& flag : declared_flags<BitflagsT>()) {
+        if (static_cast<std::uint64_t>(flag.bits) == bit) {
+            write_flag(os, flag);
+            return;
+        }
+    }
+    os << "bit " << ctz(bit);
+}
+
+} // internal
+
+/**
+ * Writes the records of the set of flags to the stream, one record
+ * per line, decoding the raised and cleared bits into flag names,
+ * e.g.:
+ *
+ *     1234567890 thread=0 object=0x7ffc0a1b2c30 +flag_a -flag_c
+ *
+ * NOTE: In C++11, all the flags need to be defined by DEFINE_FLAG.
+ *
+ * @param os Output stream
+ */
+template <typename BitflagsT>
+void dump_traces(std::ostream& os) {
+    for (auto const& record : trace_records<BitflagsT>()) {
+        os << record.timestamp << " thread=" << record.thread << " object=" << record.object;
+
+        std::uint64_t const before = record.before;
+        std::uint64_t const after = record.after;
+
+        for (std::uint64_t raised = after & ~before; raised; raised &= raised - 1) {
+            os << " +";
+            internal::write_bit<BitflagsT>(os, raised & (~raised + 1));
+        }
+        for (std::uint64_t cleared = before & ~after; cleared; cleared &= cleared - 1) {
+            os << " -";
+            internal::write_bit<BitflagsT>(os, cleared & (~cleared + 1));
+        }
+        os << '\n';
+    }
+}
+
+} // bf
+
+#endif // BITFLAGS_TRACING_HPP
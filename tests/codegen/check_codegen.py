@@ -0,0 +1,155 @@
+import re
+import sys
+import argparse
+import subprocess
+
+# budget annotation in the source, e.g.:
+#   // codegen raw_or: instructions<=3 memory<=0 branches<=0 calls<=0
+BUDGET_PATTERN = re.compile(r'//\s*codegen\s+(\w+):\s*(.*)$')
+LIMIT_PATTERN = re.compile(r'(\w+)<=(\d+)')
+
+SYMBOL_PATTERN = re.compile(r'^[0-9a-f]+ <(\S+)>:$')
+INSTRUCTION_PATTERN = re.compile(r'^\s*[0-9a-f]+:\s+(\S+)\s*(.*)$')
+RELOCATION_PATTERN = re.compile(r'^\s*[0-9a-f]+:\s+R_\w+\s+(\S+)$')
+
+CLASSES = [ 'instructions', 'memory', 'branches', 'calls' ]
+
+class Instruction:
+    def __init__(self, mnemonic, operands):
+        self.mnemonic = mnemonic
+        self.operands = operands
+        self.relocation = None
+
+    def is_padding(self):
+        # alignment between functions, e.g. "data16 cs nop WORD PTR [...]"
+        if self.mnemonic in ('int3', 'data16', 'cs'):
+            return self.mnemonic == 'int3' or 'nop' in self.operands
+        return self.mnemonic.startswith('nop') or (self.mnemonic == 'xchg' and self.operands == 'ax,ax')
+
+    def is_call(self):
+        # direct and indirect calls, tail calls to other symbols and
+        # indirect jumps (e.g. calls through function pointer)
+        if self.mnemonic.startswith('call'):
+            return True
+        if self.mnemonic.startswith('jmp'):
+            return self.relocation is not None or not re.match(r'^[0-9a-f]+ <', self.operands)
+        return False
+
+    def is_branch(self):
+        return self.mnemonic.startswith('j') and not self.is_call()
+
+    def is_memory(self):
+        return 'PTR [' in self.operands and not self.mnemonic.startswith('lea')
+
+def create_argument_parser():
+    parser = argparse.ArgumentParser(description='Check instruction budgets of disassembled functions')
+
+    parser.add_argument(
+        "-s", "--source",
+        required=True, type=str,
+        help='Source file with codegen budget annotations',
+        metavar='SOURCE', dest='source'
+    )
+
+    parser.add_argument(
+        "-d", "--objdump",
+        default='objdump', type=str,
+        help='objdump executable (default: %(default)s)',
+        metavar='OBJDUMP', dest='objdump'
+    )
+
+    parser.add_argument(
+        'objects', nargs='+',
+        help='Object files compiled from the source'
+    )
+
+    return parser
+
+def parse_budgets(source):
+    budgets = {}
+    with open(source, encoding='utf-8', mode='r') as source_file:
+        for line in source_file:
+            match = BUDGET_PATTERN.search(line)
+            if match:
+                budgets[match.group(1)] = { c: int(l) for c, l in LIMIT_PATTERN.findall(match.group(2)) }
+    return budgets
+
+def disassemble(objdump, filename):
+    output = subprocess.check_output(
+        [ objdump, '-d', '-r', '-M', 'intel', '--no-show-raw-insn', filename ],
+        universal_newlines=True
+    )
+
+    functions = {}
+    current = None
+
+    for line in output.splitlines():
+        match = SYMBOL_PATTERN.match(line)
+        if match:
+            current = functions.setdefault(match.group(1), [])
+            continue
+
+        if current is None:
+            continue
+
+        match = RELOCATION_PATTERN.match(line)
+        if match:
+            if current:
+                current[-1].relocation = match.group(1)
+            continue
+
+        match = INSTRUCTION_PATTERN.match(line)
+        if match:
+            current.append(Instruction(match.group(1), match.group(2)))
+
+    return functions
+
+def measure(instructions):
+    instructions = [ i for i in instructions if not i.is_padding() ]
+    return {
+        'instructions': len(instructions),
+        'memory': len([ i for i in instructions if i.is_memory() ]),
+        'branches': len([ i for i in instructions if i.is_branch() ]),
+        'calls': len([ i for i in instructions if i.is_call() ])
+    }
+
+def check(objdump, filename, budgets):
+    functions = disassemble(objdump, filename)
+    failures = 0
+
+    print(filename)
+    for name in sorted(budgets.keys()):
+        if name not in functions:
+            print('  {:<24} MISSING'.format(name))
+            failures += 1
+            continue
+
+        counts = measure(functions[name])
+        exceeded = [
+            '{} {} > {}'.format(c, counts[c], budgets[name][c])
+            for c in CLASSES if c in budgets[name] and counts[c] > budgets[name][c]
+        ]
+
+        print('  {:<24} {}  {}'.format(
+            name,
+            ' '.join('{}={}'.format(c, counts[c]) for c in CLASSES),
+            'FAILED: ' + ', '.join(exceeded) if exceeded else 'ok'
+        ))
+        failures += 1 if exceeded else 0
+
+    return failures
+
+if __name__ == "__main__":
+    parser = create_argument_parser()
+    args = parser.parse_args()
+
+    budgets = parse_budgets(args.source)
+    if not budgets:
+        print('No codegen budgets found in {}'.format(args.source))
+        sys.exit(1)
+
+    failures = 0
+    for filename in args.objects:
+        failures += check(args.objdump, filename, budgets)
+
+    sys.exit(1 if failures > 0 else 0)
@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Representative flag operations checked by check_codegen.py. Every
+// function is compiled into an object file and disassembled, and each
+// "codegen" comment declares the budget of instructions (without
+// alignment padding), memory accesses, branches and calls the function
+// must fit into. Budgets are tight on purpose: a change that adds a
+// load, a branch or a call to any of these operations fails the test.
+
+#include <cstddef>
+#include <cstdint>
+
+#include <bitflags/bitfields.hpp>
+#include <bitflags/bitflags.hpp>
+#include <bitflags/composite.hpp>
+#include <bitflags/counted_flags.hpp>
+#include <bitflags/diff.hpp>
+#include <bitflags/dispatch_table.hpp>
+#include <bitflags/dynamic_flags.hpp>
+#include <bitflags/flags_map.hpp>
+#include <bitflags/flags_view.hpp>
+#include <bitflags/predicate.hpp>
+#include <bitflags/shared_flags.hpp>
+
+BEGIN_RAW_BITFLAGS(RawFlags)
+    RAW_FLAG(none)
+    RAW_FLAG(flag_a)
+    RAW_FLAG(flag_b)
+    RAW_FLAG(flag_c)
+END_RAW_BITFLAGS(RawFlags)
+
+DEFINE_FLAG(RawFlags, none)
+DEFINE_FLAG(RawFlags, flag_a)
+DEFINE_FLAG(RawFlags, flag_b)
+DEFINE_FLAG(RawFlags, flag_c)
+
+BEGIN_BITFLAGS(Flags)
+    FLAG(none)
+    FLAG(flag_a)
+    FLAG(flag_b)
+    FLAG(flag_c)
+END_BITFLAGS(Flags)
+
+DEFINE_FLAG(Flags, none)
+DEFINE_FLAG(Flags, flag_a)
+DEFINE_FLAG(Flags, flag_b)
+DEFINE_FLAG(Flags, flag_c)
+
+BEGIN_RAW_BITFLAGS(TaskFlags)
+    RAW_FLAG(none)
+    RAW_FLAG(idle)
+    RAW_FLAG(running)
+    RAW_FLAG(draining)
+    RAW_FLAG(urgent)
+    GROUP(phase, idle, running, draining)
+END_RAW_BITFLAGS(TaskFlags)
+
+DEFINE_FLAG(TaskFlags, running)
+DEFINE_GROUP(TaskFlags, phase)
+
+BEGIN_RAW_BITFLAGS(Capabilities)
+    RAW_FLAG(none)
+    RAW_FLAG(read)
+    RAW_FLAG(write)
+    RAW_FLAG(admin)
+    IMPLIES(admin, write)
+    IMPLIES(write, read)
+END_RAW_BITFLAGS(Capabilities)
+
+DEFINE_FLAG(Capabilities, admin)
+
+BEGIN_BITFIELDS(Record)
+    FIELD_FLAG(valid)
+    FIELD(priority, 3)
+    FIELD(state, 4)
+END_BITFIELDS(Record)
+
+DEFINE_FLAG(Record, valid)
+
+using Packed = bf::composite<RawFlags, Record>;
+
+using raw_type = RawFlags::underlying_type;
+using flags_type = Flags::underlying_type;
+
+extern "C" {
+
+// Operators
+
+// codegen raw_not: instructions<=3 memory<=0 branches<=0 calls<=0
+raw_type raw_not(raw_type const bits) { return (~RawFlags(bits)).bits(); }
+
+// codegen raw_and: instructions<=3 memory<=0 branches<=0 calls<=0
+raw_type raw_and(raw_type const bits) { return (RawFlags(bits) & RawFlags::flag_b).bits(); }
+
+// codegen raw_or: instructions<=3 memory<=0 branches<=0 calls<=0
+raw_type raw_or(raw_type const bits) { return (RawFlags(bits) | RawFlags::flag_b).bits(); }
+
+// codegen raw_xor: instructions<=3 memory<=0 branches<=0 calls<=0
+raw_type raw_xor(raw_type const bits) { return (RawFlags(bits) ^ RawFlags::flag_b).bits(); }
+
+// codegen flags_or: instructions<=3 memory<=0 branches<=0 calls<=0
+flags_type flags_or(flags_type const bits) { return (Flags(bits) | Flags::flag_b).bits(); }
+
+// Queries
+
+// codegen raw_contains: instructions<=4 memory<=0 branches<=0 calls<=0
+bool raw_contains(raw_type const bits) { return RawFlags(bits).contains(RawFlags::flag_b); }
+
+// codegen raw_contains_all: instructions<=4 memory<=0 branches<=0 calls<=0
+bool raw_contains_all(raw_type const bits) { return RawFlags(bits).contains(RawFlags::flag_a, RawFlags::flag_c); }
+
+// codegen raw_is_empty: instructions<=3 memory<=0 branches<=0 calls<=0
+bool raw_is_empty(raw_type const bits) { return RawFlags(bits).is_empty(); }
+
+// codegen raw_is_all: instructions<=3 memory<=0 branches<=0 calls<=0
+bool raw_is_all(raw_type const bits) { return RawFlags(bits).is_all(); }
+
+// codegen flags_contains: instructions<=4 memory<=0 branches<=0 calls<=0
+bool flags_contains(flags_type const bits) { return Flags(bits).contains(Flags::flag_b); }
+
+// Modifiers
+
+// codegen raw_set: instructions<=2 memory<=1 branches<=0 calls<=0
+void raw_set(RawFlags* flags) { flags->set(RawFlags::flag_b); }
+
+// codegen raw_remove: instructions<=2 memory<=1 branches<=0 calls<=0
+void raw_remove(RawFlags* flags) { flags->remove(RawFlags::flag_b); }
+
+// codegen raw_toggle: instructions<=2 memory<=1 branches<=0 calls<=0
+void raw_toggle(RawFlags* flags) { flags->toggle(RawFlags::flag_b); }
+
+// codegen raw_clear: instructions<=2 memory<=1 branches<=0 calls<=0
+void raw_clear(RawFlags* flags) { flags->clear(); }
+
+// codegen flags_set: instructions<=2 memory<=1 branches<=0 calls<=0
+void flags_set(Flags* flags) { flags->set(Flags::flag_b); }
+
+// Copies
+
+// codegen raw_copy: instructions<=3 memory<=2 branches<=0 calls<=0
+void raw_copy(RawFlags const* from, RawFlags* to) { *to = *from; }
+
+// Ordinary flags carry the name next to the bits, so copying them
+// moves the whole name as well.
+// codegen flags_copy: instructions<=5 memory<=4 branches<=0 calls<=0
+void flags_copy(Flags const* from, Flags* to) { *to = *from; }
+
+// Iteration
+
+// codegen raw_declared_mask: instructions<=2 memory<=0 branches<=0 calls<=0
+raw_type raw_declared_mask() {
+    raw_type mask = 0;
+    for (auto const& flag : bf::declared_flags<RawFlags>()) {
+        mask = static_cast<raw_type>(mask | flag.bits);
+    }
+    return mask;
+}
+
+// Bulk kernels
+
+// codegen raw_diff: calls<=0
+std::size_t raw_diff(RawFlags const* prev, RawFlags const* curr, std::size_t const count, bf::flag_change<RawFlags>* out) {
+    return bf::diff(prev, curr, count, out);
+}
+
+// codegen raw_predicate_count: calls<=0
+std::size_t raw_predicate_count(bf::predicate<RawFlags> const* predicate, RawFlags const* flags, std::size_t const count) {
+    return predicate->count(flags, count);
+}
+
+// Counters are only touched when the flag really changes.
+// codegen raw_counted_set: instructions<=20 memory<=5 branches<=1 calls<=0
+void raw_counted_set(bf::counted_flags<RawFlags>* flags, std::size_t const index) {
+    flags->set(index, RawFlags::flag_b);
+}
+
+// Lookup and the indirect call are the only work done on dispatch.
+// codegen raw_dispatch: instructions<=3 memory<=1 branches<=0 calls<=1
+int raw_dispatch(bf::dispatch_table<RawFlags, int()> const* table, RawFlags const key) {
+    return (*table)(key);
+}
+
+// Switching within the group is a single masked write.
+// codegen task_switch_to: instructions<=4 memory<=0 branches<=0 calls<=0
+TaskFlags::underlying_type task_switch_to(TaskFlags flags) {
+    flags.switch_to(TaskFlags::running);
+    return flags.bits();
+}
+
+// codegen task_which: instructions<=3 memory<=0 branches<=0 calls<=0
+TaskFlags::underlying_type task_which(TaskFlags const flags) { return flags.which(TaskFlags::phase).bits; }
+
+// Implied flags of a known flag are folded into a single OR.
+// codegen capabilities_set_with_implied: instructions<=3 memory<=0 branches<=0 calls<=0
+Capabilities::underlying_type capabilities_set_with_implied(Capabilities flags) {
+    flags.set_with_implied(Capabilities::admin);
+    return flags.bits();
+}
+
+// Bulk closure, one implying bit at a time over blocks of the array.
+void capabilities_normalize(Capabilities* flags, std::size_t const count) {
+    bf::normalize(flags, count);
+}
+
+// Fields are a shift and a mask, setting them a masked merge.
+// codegen record_get: instructions<=4 memory<=0 branches<=0 calls<=0
+std::uint8_t record_get(Record const record) { return record.get(Record::state); }
+
+// codegen record_set: instructions<=8 memory<=0 branches<=0 calls<=0
+Record::underlying_type record_set(Record record, std::uint8_t const state) {
+    record.set(Record::state, state);
+    return record.bits();
+}
+
+// Bulk extraction, a shift and a mask per record.
+void record_extract(Record const* records, std::size_t const count, std::uint8_t* states) {
+    bf::extract(records, count, Record::state, states);
+}
+
+// Member sets of the composite are accessed within the single word.
+// codegen packed_contains: instructions<=4 memory<=0 branches<=0 calls<=0
+bool packed_contains(Packed const packed) { return packed.get<Record>().contains(Record::valid); }
+
+// codegen packed_set: instructions<=3 memory<=0 branches<=0 calls<=0
+Packed::underlying_type packed_set(Packed packed) {
+    packed.get<RawFlags>().set(RawFlags::flag_b);
+    return packed.bits();
+}
+
+// Lookup in the dense flags map is a bitmap test and an indexed load.
+// codegen raw_map_find: instructions<=12 memory<=3 branches<=1 calls<=0
+int const* raw_map_find(bf::flags_map<RawFlags, int> const& map, RawFlags const flags) { return map.find(flags); }
+
+// Checking a runtime registered flag is a single mask test.
+// codegen dynamic_contains: instructions<=7 memory<=3 branches<=0 calls<=0
+bool dynamic_contains(bf::dynamic_flags<256> const& flags, bf::dynamic_flag<256> const& f) { return flags.contains(f); }
+
+// Big-endian field is tested against the byte-swapped mask in place.
+// codegen wire_contains: instructions<=4 memory<=1 branches<=0 calls<=0
+bool wire_contains(void const* data) { return bf::flags_ref<RawFlags const, bf::endian::big>(data).contains(RawFlags::flag_b); }
+
+// Checking the flags shared between processes is a plain load, without
+// any system call.
+// codegen shared_contains: instructions<=6 memory<=2 branches<=0 calls<=0
+bool shared_contains(bf::shared_flags<RawFlags> const& flags, std::size_t const index) { return flags.contains(index, RawFlags::flag_b); }
+
+} // extern "C"
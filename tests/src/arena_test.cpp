@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <bitflags/arena.hpp>
+#include <bitflags/counted_flags.hpp>
+#include <bitflags/flags_map.hpp>
+#include <bitflags/mask_matcher.hpp>
+#include <bitflags/partition.hpp>
+
+namespace
+{
+
+    BEGIN_RAW_BITFLAGS(RawFlags)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_a)
+        RAW_FLAG(flag_b)
+        RAW_FLAG(flag_c)
+    END_RAW_BITFLAGS(RawFlags)
+
+    DEFINE_FLAG(RawFlags, none)
+    DEFINE_FLAG(RawFlags, flag_a)
+    DEFINE_FLAG(RawFlags, flag_b)
+    DEFINE_FLAG(RawFlags, flag_c)
+
+    BEGIN_RAW_BITFLAGS(WideFlags)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_0)
+        RAW_FLAG(flag_1)
+        RAW_FLAG(flag_2)
+        RAW_FLAG(flag_3)
+        RAW_FLAG(flag_4)
+        RAW_FLAG(flag_5)
+        RAW_FLAG(flag_6)
+        RAW_FLAG(flag_7)
+        RAW_FLAG(flag_8)
+        RAW_FLAG(flag_9)
+        RAW_FLAG(flag_10)
+        RAW_FLAG(flag_11)
+        RAW_FLAG(flag_12)
+        RAW_FLAG(flag_13)
+        RAW_FLAG(flag_14)
+        RAW_FLAG(flag_15)
+    END_RAW_BITFLAGS(WideFlags)
+
+    bool is_aligned(void const* const ptr, std::size_t const alignment) {
+        return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+    }
+
+    // builds per-request structures, all of them released before the
+    // arena is reset
+    void handle_request(bf::pool_arena& pool) {
+        using allocator = bf::arena_allocator<RawFlags, bf::pool_arena>;
+
+        bf::counted_flags<RawFlags, allocator> flags{ allocator(pool) };
+        for (int i = 0; i < 100; ++i) {
+            flags.push_back(i % 2 ? RawFlags::flag_a : RawFlags::flag_b);
+        }
+        EXPECT_EQ(flags.count(RawFlags::flag_a), 50u);
+        EXPECT_EQ(flags.get_allocator().arena(), &pool);
+
+        bf::flags_map<RawFlags, int, bf::arena_allocator<int, bf::pool_arena>> map{ allocator(pool) };
+        map[RawFlags::flag_a | RawFlags::flag_b] = 3;
+        EXPECT_EQ(*map.find(RawFlags::flag_a | RawFlags::flag_b), 3);
+
+        bf::flags_set<WideFlags, bf::arena_allocator<WideFlags, bf::pool_arena>> set{ allocator(pool) };
+        for (std::uint16_t i = 0; i < 200; ++i) {
+            set.insert(WideFlags(i));
+        }
+        EXPECT_EQ(set.size(), 200u);
+        EXPECT_TRUE(set.contains(WideFlags(199)));
+
+        bf::mask_matcher<RawFlags, allocator> matcher{ allocator(pool) };
+        matcher.add(RawFlags::flag_a, RawFlags::flag_c);
+        matcher.add(RawFlags::flag_b, RawFlags::none);
+        std::vector<std::size_t, bf::arena_allocator<std::size_t, bf::pool_arena>> ids{ allocator(pool) };
+        matcher.match(RawFlags::flag_a | RawFlags::flag_b, ids);
+        EXPECT_EQ(ids.size(), 2u);
+
+        bf::radix_partition<WideFlags, 0x00ff, bf::arena_allocator<WideFlags, bf::pool_arena>> partition{ allocator(pool) };
+        std::vector<WideFlags> const input(200, WideFlags(3));
+        std::vector<WideFlags> grouped(input.size());
+        partition.scatter(input.data(), input.size(), grouped.data());
+        EXPECT_EQ(partition.groups().size(), 1u);
+        EXPECT_EQ(partition.get_allocator().arena(), &pool);
+    }
+
+} // namespace
+
+TEST(ArenaTest, BumpArena) {
+    bf::bump_arena arena(256);
+    EXPECT_EQ(arena.capacity(), 0u);
+
+    void* const a = arena.allocate(3, 1);
+    void* const b = arena.allocate(8, 8);
+    EXPECT_TRUE(is_aligned(b, 8));
+    EXPECT_GE(static_cast<unsigned char*>(b) - static_cast<unsigned char*>(a), 3);
+    EXPECT_TRUE(is_aligned(arena.allocate(16, 64), 64));
+
+    // the most recent allocation is given back
+    void* const c = arena.allocate(32, 8);
+    arena.deallocate(c, 32, 8);
+    EXPECT_EQ(arena.allocate(32, 8), c);
+
+    // larger allocations get a chunk of their own
+    void* const large = arena.allocate(1000);
+    EXPECT_TRUE(is_aligned(large, alignof(std::max_align_t)));
+    std::size_t const capacity = arena.capacity();
+    EXPECT_GE(capacity, 1256u);
+
+    // reset keeps the largest chunk only
+    arena.reset();
+    EXPECT_LT(arena.capacity(), capacity);
+    EXPECT_GE(arena.capacity(), 1000u);
+    std::size_t const kept = arena.capacity();
+    EXPECT_NE(arena.allocate(500), nullptr);
+    EXPECT_NE(arena.allocate(400), nullptr);
+    EXPECT_EQ(arena.capacity(), kept);
+
+    arena.release();
+    EXPECT_EQ(arena.capacity(), 0u);
+}
+
+TEST(ArenaTest, BumpArenaBuffer) {
+    alignas(std::max_align_t) unsigned char buffer[128];
+    bf::bump_arena arena(buffer, sizeof(buffer));
+
+    void* const a = arena.allocate(64);
+    EXPECT_EQ(a, buffer);
+    EXPECT_EQ(arena.capacity(), 0u);
+
+    EXPECT_NE(arena.allocate(100), nullptr);
+    EXPECT_GT(arena.capacity(), 0u);
+
+    arena.release();
+    EXPECT_EQ(arena.allocate(16), buffer);
+}
+
+TEST(ArenaTest, PoolArena) {
+    bf::pool_arena pool(1024);
+
+    void* const a = pool.allocate(5, 1);
+    void* const b = pool.allocate(8, 8);
+    void* const c = pool.allocate(24, 8);
+    EXPECT_NE(a, b);
+    EXPECT_TRUE(is_aligned(c, 16));
+
+    // freed blocks are reused within their size class
+    pool.deallocate(b, 8, 8);
+    EXPECT_EQ(pool.allocate(7, 4), b);
+    pool.deallocate(c, 24, 8);
+    EXPECT_NE(pool.allocate(8, 8), c);
+    EXPECT_EQ(pool.allocate(32, 8), c);
+
+    // larger blocks come from the arena directly
+    void* const large = pool.allocate(4096);
+    pool.deallocate(large, 4096);
+    EXPECT_EQ(pool.allocate(4096), large);
+
+    pool.reset();
+    EXPECT_GT(pool.capacity(), 0u);
+    pool.release();
+    EXPECT_EQ(pool.capacity(), 0u);
+}
+
+TEST(ArenaTest, Containers) {
+    bf::pool_arena pool;
+    std::size_t capacity = 0;
+
+    for (int round = 0; round < 3; ++round) {
+        handle_request(pool);
+
+        // the same workload fits into the chunk kept by reset
+        if (round > 1) {
+            EXPECT_EQ(pool.capacity(), capacity);
+        }
+        pool.reset();
+        capacity = pool.capacity();
+    }
+}
+
+#if BITFLAGS_HAS_PMR
+TEST(ArenaTest, PolymorphicAllocator) {
+    bf::bump_arena arena;
+    bf::arena_resource<bf::bump_arena> resource(arena);
+
+    bf::pmr::counted_flags<RawFlags> flags(&resource);
+    flags.push_back(RawFlags::flag_a);
+    EXPECT_EQ(flags.get_allocator().resource(), &resource);
+
+    bf::pmr::flags_map<RawFlags, std::pmr::string> names(&resource);
+    names[RawFlags::flag_a] = "flag a, long enough not to fit into the small string";
+    EXPECT_EQ(*names.find(RawFlags::flag_a), "flag a, long enough not to fit into the small string");
+
+    bf::pmr::flags_set<WideFlags> set(&resource);
+    set.insert(WideFlags(7));
+    EXPECT_TRUE(set.contains(WideFlags(7)));
+
+    bf::pmr::mask_matcher<RawFlags> matcher(&resource);
+    matcher.add(RawFlags::flag_a, RawFlags::none);
+    std::pmr::vector<std::size_t> ids(&resource);
+    matcher.match(RawFlags::flag_a, ids);
+    EXPECT_EQ(ids.size(), 1u);
+
+    bf::pmr::radix_partition<RawFlags> partition(&resource);
+    RawFlags const input[3] = { RawFlags::flag_b, RawFlags::flag_a, RawFlags::flag_b };
+    RawFlags grouped[3];
+    partition.scatter(input, 3, grouped);
+    EXPECT_EQ(partition.groups().size(), 2u);
+    EXPECT_EQ(partition.get_allocator().resource(), &resource);
+
+    EXPECT_GT(arena.capacity(), 0u);
+    EXPECT_TRUE(resource.is_equal(resource));
+
+    std::pmr::monotonic_buffer_resource monotonic;
+    bf::pmr::flags_map<WideFlags, int> map(&monotonic);
+    for (std::uint16_t i = 0; i < 100; ++i) {
+        map[WideFlags(i)] = i;
+    }
+    EXPECT_EQ(map.size(), 100u);
+}
+#endif
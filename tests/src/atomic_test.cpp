@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <bitflags/atomic.hpp>
+
+namespace
+{
+
+    BEGIN_RAW_BITFLAGS(Flags)
+        RAW_FLAG(none)
+        RAW_FLAG(idle)
+        RAW_FLAG(running)
+        RAW_FLAG(draining)
+        RAW_FLAG(urgent)
+        GROUP(phase, idle, running, draining)
+    END_RAW_BITFLAGS(Flags)
+
+    DEFINE_FLAG(Flags, none)
+    DEFINE_FLAG(Flags, idle)
+    DEFINE_FLAG(Flags, running)
+    DEFINE_FLAG(Flags, draining)
+    DEFINE_FLAG(Flags, urgent)
+    DEFINE_GROUP(Flags, phase)
+
+} // namespace
+
+TEST(AtomicTest, LoadStore) {
+    bf::atomic_bitflags<Flags> flags;
+    EXPECT_TRUE(flags.load().is_empty());
+
+    flags.store(Flags::idle | Flags::urgent);
+    EXPECT_EQ((Flags::idle | Flags::urgent).bits, flags.load().bits());
+
+    Flags const previous = flags.exchange(Flags::running);
+    EXPECT_EQ((Flags::idle | Flags::urgent).bits, previous.bits());
+    EXPECT_EQ(Flags::running.bits, flags.load().bits());
+}
+
+TEST(AtomicTest, CompareExchange) {
+    bf::atomic_bitflags<Flags> flags(Flags::idle);
+
+    Flags expected = Flags::running;
+    EXPECT_FALSE(flags.compare_exchange(expected, Flags::draining));
+    EXPECT_EQ(Flags::idle.bits, expected.bits());
+
+    EXPECT_TRUE(flags.compare_exchange(expected, Flags::draining));
+    EXPECT_EQ(Flags::draining.bits, flags.load().bits());
+}
+
+TEST(AtomicTest, SetRemoveToggle) {
+    bf::atomic_bitflags<Flags> flags;
+
+    EXPECT_TRUE(flags.set(Flags::urgent).is_empty());
+    EXPECT_TRUE(flags.contains(Flags::urgent));
+    EXPECT_TRUE(flags.contains(Flags::none));
+    EXPECT_FALSE(flags.contains(Flags::idle));
+
+    flags.toggle(Flags::idle);
+    EXPECT_TRUE(flags.contains(Flags::idle));
+
+    Flags const previous = flags.remove(Flags::urgent);
+    EXPECT_EQ((Flags::idle | Flags::urgent).bits, previous.bits());
+    EXPECT_FALSE(flags.contains(Flags::urgent));
+
+    flags.clear();
+    EXPECT_TRUE(flags.load().is_empty());
+}
+
+TEST(AtomicTest, SwitchTo) {
+    bf::atomic_bitflags<Flags> flags(Flags::idle | Flags::urgent);
+
+    Flags const previous = flags.switch_to(Flags::running);
+    EXPECT_EQ((Flags::idle | Flags::urgent).bits, previous.bits());
+    EXPECT_EQ((Flags::running | Flags::urgent).bits, flags.load().bits());
+    EXPECT_TRUE(flags.which(Flags::phase) == Flags::running);
+
+    flags.switch_to(Flags::draining);
+    EXPECT_TRUE(flags.which(Flags::phase) == Flags::draining);
+}
+
+TEST(AtomicTest, ConcurrentSwitchTo) {
+    bf::atomic_bitflags<Flags> flags(Flags::idle);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&flags, t] {
+            Flags::flag_type const targets[] = { Flags::idle, Flags::running, Flags::draining };
+            for (int i = 0; i < 10000; ++i) {
+                flags.switch_to(targets[(i + t) % 3]);
+                if (t == 0) {
+                    flags.toggle(Flags::urgent);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // exactly one flag of the group is set after every transition
+    unsigned const phase = flags.load().bits() & Flags::phase.mask;
+    EXPECT_NE(0u, phase);
+    EXPECT_EQ(0u, phase & (phase - 1));
+    EXPECT_FALSE(flags.contains(Flags::urgent));
+}
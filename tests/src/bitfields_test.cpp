@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <bitflags/bitfields.hpp>
+
+namespace
+{
+
+    enum class State : std::uint8_t {
+        idle,
+        running,
+        blocked,
+        finished
+    };
+
+    BEGIN_BITFIELDS(Record)
+        FIELD_FLAG(valid)
+        FIELD(priority, 3)
+        FIELD_FLAG(dirty)
+        TYPED_FIELD(state, State, 4)
+    END_BITFIELDS(Record)
+
+    DEFINE_FLAG(Record, valid)
+    DEFINE_FLAG(Record, dirty)
+
+    BEGIN_BITFIELDS(WideRecord)
+        FIELD(low, 30)
+        FIELD_FLAG(marker)
+        FIELD(high, 20)
+    END_BITFIELDS(WideRecord)
+
+    DEFINE_FLAG(WideRecord, marker)
+
+} // namespace
+
+TEST(BitfieldsTest, Layout) {
+    EXPECT_EQ(1, decltype(Record::priority)::offset);
+    EXPECT_EQ(3, decltype(Record::priority)::width);
+    EXPECT_EQ(5, decltype(Record::state)::offset);
+    EXPECT_EQ(4, decltype(Record::state)::width);
+
+    EXPECT_EQ(0x01, Record::valid.bits);
+    EXPECT_EQ(0x10, Record::dirty.bits);
+    EXPECT_EQ(0x0e, decltype(Record::priority)::mask());
+    EXPECT_EQ(0x1e0, decltype(Record::state)::mask());
+
+    static_assert(Record::bits_ == 9, "");
+    static_assert(WideRecord::bits_ == 51, "");
+    EXPECT_EQ(0x40000000u, static_cast<std::uint64_t>(WideRecord::marker.bits));
+    EXPECT_EQ(31, decltype(WideRecord::high)::offset);
+}
+
+TEST(BitfieldsTest, UnderlyingType) {
+    EXPECT_TRUE((std::is_same<Record::underlying_type, std::uint16_t>::value));
+    EXPECT_TRUE((std::is_same<WideRecord::underlying_type, std::uint64_t>::value));
+    EXPECT_EQ(sizeof(std::uint16_t), sizeof(Record));
+    EXPECT_EQ(sizeof(std::uint64_t), sizeof(WideRecord));
+
+    EXPECT_TRUE((std::is_same<decltype(Record::priority)::value_type, std::uint8_t>::value));
+    EXPECT_TRUE((std::is_same<decltype(Record::state)::value_type, State>::value));
+    EXPECT_TRUE((std::is_same<decltype(WideRecord::low)::value_type, std::uint32_t>::value));
+}
+
+TEST(BitfieldsTest, GetAndSet) {
+    Record record;
+    EXPECT_EQ(0, record.get(Record::priority));
+    EXPECT_EQ(State::idle, record.get(Record::state));
+
+    record.set(Record::priority, 5);
+    record.set(Record::state, State::blocked);
+    EXPECT_EQ(5, record.get(Record::priority));
+    EXPECT_EQ(State::blocked, record.get(Record::state));
+    EXPECT_EQ(0x4a, record.bits());
+
+    record.set(Record::priority, 2);
+    EXPECT_EQ(2, record.get(Record::priority));
+    EXPECT_EQ(State::blocked, record.get(Record::state));
+
+    // bits not fitting into the field are ignored
+    record.set(Record::priority, 0xff);
+    EXPECT_EQ(7, record.get(Record::priority));
+    EXPECT_EQ(State::blocked, record.get(Record::state));
+    EXPECT_FALSE(record.contains(Record::valid));
+    EXPECT_FALSE(record.contains(Record::dirty));
+}
+
+TEST(BitfieldsTest, FlagsAlongsideFields) {
+    Record record = Record::valid | Record::dirty;
+    record.set(Record::priority, 7);
+    EXPECT_TRUE(record.contains(Record::valid, Record::dirty));
+
+    record.remove(Record::valid);
+    EXPECT_FALSE(record.contains(Record::valid));
+    EXPECT_EQ(7, record.get(Record::priority));
+
+    record.toggle(Record::dirty);
+    EXPECT_FALSE(record.contains(Record::dirty));
+    EXPECT_EQ(7, record.get(Record::priority));
+
+    record.set(Record::valid);
+    Record masked = record & Record::valid;
+    EXPECT_EQ(Record::valid.bits, masked.bits());
+    EXPECT_EQ(0, masked.get(Record::priority));
+
+    record.clear();
+    EXPECT_TRUE(record.is_empty());
+}
+
+TEST(BitfieldsTest, Wide) {
+    WideRecord record;
+    record.set(WideRecord::low, 0x3fffffffu);
+    record.set(WideRecord::high, 0x12345u);
+    record.set(WideRecord::marker);
+
+    EXPECT_EQ(0x3fffffffu, record.get(WideRecord::low));
+    EXPECT_EQ(0x12345u, record.get(WideRecord::high));
+    EXPECT_TRUE(record.contains(WideRecord::marker));
+
+    record.set(WideRecord::low, 0);
+    EXPECT_EQ(0u, record.get(WideRecord::low));
+    EXPECT_EQ(0x12345u, record.get(WideRecord::high));
+    EXPECT_TRUE(record.contains(WideRecord::marker));
+}
+
+TEST(BitfieldsTest, DeclaredFlags) {
+    auto const flags = bf::declared_flags<Record>();
+    ASSERT_EQ(10u, flags.size());
+    EXPECT_EQ(Record::valid.bits, flags[1].bits);
+    EXPECT_EQ(Record::dirty.bits, flags[5].bits);
+    EXPECT_EQ(0, flags[2].bits);
+    EXPECT_EQ(0x1ff, (bf::internal::declared_mask<Record, Record::underlying_type>()));
+}
+
+TEST(BitfieldsTest, Extract) {
+    std::vector<Record> records(100);
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        records[i].set(Record::priority, static_cast<std::uint8_t>(i % 8));
+        records[i].set(Record::state, static_cast<State>(i % 4));
+        if (i % 3 == 0) {
+            records[i].set(Record::valid);
+        }
+    }
+
+    std::vector<std::uint8_t> priorities(records.size());
+    bf::extract(records.data(), records.size(), Record::priority, priorities.data());
+
+    std::vector<State> states(records.size());
+    bf::extract(records.data(), records.size(), Record::state, states.data());
+
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        EXPECT_EQ(i % 8, priorities[i]);
+        EXPECT_EQ(static_cast<State>(i % 4), states[i]);
+    }
+}
+
+#if __cplusplus >= 201402L
+namespace
+{
+
+    constexpr Record make_record() {
+        Record record{ Record::valid };
+        record.set(Record::priority, 3);
+        return record;
+    }
+
+} // namespace
+
+TEST(BitfieldsTest, Constexpr) {
+    constexpr Record record = make_record();
+    static_assert(record.get(Record::priority) == 3, "");
+    static_assert(record.contains(Record::valid), "");
+    EXPECT_EQ(0x07, record.bits());
+}
+#endif
@@ -27,6 +27,8 @@
  *
  */
 
+#include <vector>
+
 #include <gtest/gtest.h>
 #include <bitflags/bitflags.hpp>
 
@@ -57,6 +59,97 @@ namespace
     DEFINE_FLAG(Flags, flag_b)
     DEFINE_FLAG(Flags, flag_c)
 
+    BEGIN_RAW_BITFLAGS(WideRawFlags)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_0)
+        RAW_FLAG(flag_1)
+        RAW_FLAG(flag_2)
+        RAW_FLAG(flag_3)
+        RAW_FLAG(flag_4)
+        RAW_FLAG(flag_5)
+        RAW_FLAG(flag_6)
+        RAW_FLAG(flag_7)
+        RAW_FLAG(flag_8)
+        RAW_FLAG(flag_9)
+        RAW_FLAG(flag_10)
+        RAW_FLAG(flag_11)
+        RAW_FLAG(flag_12)
+        RAW_FLAG(flag_13)
+        RAW_FLAG(flag_14)
+        RAW_FLAG(flag_15)
+        RAW_FLAG(flag_16)
+        RAW_FLAG(flag_17)
+        RAW_FLAG(flag_18)
+        RAW_FLAG(flag_19)
+        RAW_FLAG(flag_20)
+        RAW_FLAG(flag_21)
+        RAW_FLAG(flag_22)
+        RAW_FLAG(flag_23)
+        RAW_FLAG(flag_24)
+        RAW_FLAG(flag_25)
+        RAW_FLAG(flag_26)
+        RAW_FLAG(flag_27)
+        RAW_FLAG(flag_28)
+        RAW_FLAG(flag_29)
+        RAW_FLAG(flag_30)
+        RAW_FLAG(flag_31)
+        RAW_FLAG(flag_32)
+        RAW_FLAG(flag_33)
+        RAW_FLAG(flag_34)
+        RAW_FLAG(flag_35)
+        RAW_FLAG(flag_36)
+        RAW_FLAG(flag_37)
+        RAW_FLAG(flag_38)
+        RAW_FLAG(flag_39)
+    END_RAW_BITFLAGS(WideRawFlags)
+
+    DEFINE_FLAG(WideRawFlags, flag_7)
+    DEFINE_FLAG(WideRawFlags, flag_39)
+
+    BEGIN_BITFLAGS(TaskFlags)
+        FLAG(none)
+        FLAG(idle)
+        FLAG(running)
+        FLAG(draining)
+        FLAG(urgent)
+        FLAG(low)
+        FLAG(high)
+        GROUP(phase, idle, running, draining)
+        GROUP(priority, low, high)
+    END_BITFLAGS(TaskFlags)
+
+    DEFINE_FLAG(TaskFlags, none)
+    DEFINE_FLAG(TaskFlags, idle)
+    DEFINE_FLAG(TaskFlags, running)
+    DEFINE_FLAG(TaskFlags, draining)
+    DEFINE_FLAG(TaskFlags, urgent)
+    DEFINE_FLAG(TaskFlags, low)
+    DEFINE_FLAG(TaskFlags, high)
+    DEFINE_GROUP(TaskFlags, phase)
+    DEFINE_GROUP(TaskFlags, priority)
+
+    BEGIN_RAW_BITFLAGS(Capabilities)
+        RAW_FLAG(none)
+        RAW_FLAG(read)
+        RAW_FLAG(write)
+        RAW_FLAG(admin)
+        RAW_FLAG(audit)
+        RAW_FLAG(guest)
+        RAW_FLAG(banned)
+        IMPLIES(admin, write, audit)
+        IMPLIES(write, read)
+        CONFLICTS(guest, admin)
+        CONFLICTS(banned, read)
+    END_RAW_BITFLAGS(Capabilities)
+
+    DEFINE_FLAG(Capabilities, none)
+    DEFINE_FLAG(Capabilities, read)
+    DEFINE_FLAG(Capabilities, write)
+    DEFINE_FLAG(Capabilities, admin)
+    DEFINE_FLAG(Capabilities, audit)
+    DEFINE_FLAG(Capabilities, guest)
+    DEFINE_FLAG(Capabilities, banned)
+
 } // namespace
 
 TEST(BitflagsTest, Bits) {
@@ -426,3 +519,140 @@ TEST(BitflagsTest, Clear) {
     EXPECT_FALSE(flags.contains(Flags::flag_b));
     EXPECT_FALSE(flags.contains(Flags::flag_c));
 }
+
+TEST(BitflagsTest, DeclaredFlags) {
+    // raw flags (without string representation)
+    auto const raw_flags = bf::declared_flags<RawFlags>();
+
+    ASSERT_EQ(4U, raw_flags.size());
+    EXPECT_EQ(RawFlags::none, raw_flags[0]);
+    EXPECT_EQ(RawFlags::flag_a, raw_flags[1]);
+    EXPECT_EQ(RawFlags::flag_b, raw_flags[2]);
+    EXPECT_EQ(RawFlags::flag_c, raw_flags[3]);
+
+    // flags (with string representation)
+    auto const flags = bf::declared_flags<Flags>();
+
+    ASSERT_EQ(4U, flags.size());
+#if __cplusplus >= 201703L
+    EXPECT_EQ("none", flags[0].name);
+    EXPECT_EQ("flag_a", flags[1].name);
+    EXPECT_EQ("flag_b", flags[2].name);
+    EXPECT_EQ("flag_c", flags[3].name);
+#else
+    EXPECT_STREQ("none", flags[0].name);
+    EXPECT_STREQ("flag_a", flags[1].name);
+    EXPECT_STREQ("flag_b", flags[2].name);
+    EXPECT_STREQ("flag_c", flags[3].name);
+#endif
+
+    Flags::underlying_type all = 0;
+    for (auto const& flag : flags) {
+        all = static_cast<Flags::underlying_type>(all | flag.bits);
+    }
+    EXPECT_EQ((Flags::flag_a | Flags::flag_b | Flags::flag_c).bits, all);
+}
+
+TEST(BitflagsTest, WideBits) {
+    static_assert(sizeof(WideRawFlags::underlying_type) == 8, "WideRawFlags should be 64-bit");
+
+    std::uint64_t const flag_31 = WideRawFlags::flag_31.bits;
+    std::uint64_t const flag_32 = WideRawFlags::flag_32.bits;
+    std::uint64_t const flag_39 = WideRawFlags::flag_39.bits;
+
+    EXPECT_EQ(std::uint64_t{1} << 31, flag_31);
+    EXPECT_EQ(std::uint64_t{1} << 32, flag_32);
+    EXPECT_EQ(std::uint64_t{1} << 39, flag_39);
+
+    WideRawFlags flags(flag_39);
+    EXPECT_TRUE(flags.contains(WideRawFlags::flag_39));
+    EXPECT_FALSE(flags.contains(WideRawFlags::flag_7));
+}
+
+TEST(BitflagsTest, SwitchTo) {
+    EXPECT_EQ((TaskFlags::idle | TaskFlags::running | TaskFlags::draining).bits, TaskFlags::phase.mask);
+    EXPECT_EQ((TaskFlags::low | TaskFlags::high).bits, TaskFlags::priority.mask);
+
+    TaskFlags flags = TaskFlags::idle | TaskFlags::urgent | TaskFlags::low;
+
+    flags.switch_to(TaskFlags::running);
+    EXPECT_EQ((TaskFlags::running | TaskFlags::urgent | TaskFlags::low).bits, flags.bits());
+
+    flags.switch_to(TaskFlags::draining);
+    flags.switch_to(TaskFlags::high);
+    EXPECT_EQ((TaskFlags::draining | TaskFlags::urgent | TaskFlags::high).bits, flags.bits());
+
+    // flags outside of any group are just set
+    flags.remove(TaskFlags::urgent);
+    flags.switch_to(TaskFlags::urgent);
+    EXPECT_EQ((TaskFlags::draining | TaskFlags::urgent | TaskFlags::high).bits, flags.bits());
+
+    RawFlags raw_flags(RawFlags::flag_a);
+    raw_flags.switch_to(RawFlags::flag_b);
+    EXPECT_EQ((RawFlags::flag_a | RawFlags::flag_b).bits, raw_flags.bits());
+}
+
+TEST(BitflagsTest, Which) {
+    TaskFlags flags = TaskFlags::urgent;
+    EXPECT_TRUE(flags.which(TaskFlags::phase) == TaskFlags::none);
+    EXPECT_TRUE(flags.which(TaskFlags::priority) == TaskFlags::none);
+
+    flags.switch_to(TaskFlags::running);
+    flags.switch_to(TaskFlags::low);
+    EXPECT_TRUE(flags.which(TaskFlags::phase) == TaskFlags::running);
+    EXPECT_TRUE(flags.which(TaskFlags::priority) == TaskFlags::low);
+#if __cplusplus >= 201703L
+    EXPECT_EQ("running", flags.which(TaskFlags::phase).name);
+#else
+    EXPECT_STREQ("running", flags.which(TaskFlags::phase).name);
+#endif
+
+    flags.switch_to(TaskFlags::idle);
+    EXPECT_TRUE(flags.which(TaskFlags::phase) == TaskFlags::idle);
+}
+
+TEST(BitflagsTest, SetWithImplied) {
+    Capabilities flags;
+    flags.set_with_implied(Capabilities::write);
+    EXPECT_EQ((Capabilities::write | Capabilities::read).bits, flags.bits());
+
+    flags.clear();
+    flags.set_with_implied(Capabilities::admin);
+    EXPECT_EQ((Capabilities::admin | Capabilities::write | Capabilities::read | Capabilities::audit).bits, flags.bits());
+
+    flags.clear();
+    flags.set_with_implied(Capabilities::guest | Capabilities::none);
+    EXPECT_EQ(Capabilities::guest.bits, flags.bits());
+}
+
+TEST(BitflagsTest, Closure) {
+    EXPECT_TRUE(bf::closure(Capabilities()).is_empty());
+    EXPECT_EQ((Capabilities::read | Capabilities::write | Capabilities::guest).bits,
+              bf::closure(Capabilities(Capabilities::write | Capabilities::guest)).bits());
+    EXPECT_EQ((Capabilities::read | Capabilities::write | Capabilities::admin | Capabilities::audit).bits,
+              bf::closure(Capabilities(Capabilities::admin)).bits());
+
+    EXPECT_FALSE(bf::has_conflicts(Capabilities(Capabilities::admin)));
+    EXPECT_FALSE(bf::has_conflicts(Capabilities(Capabilities::guest | Capabilities::read)));
+    EXPECT_TRUE(bf::has_conflicts(Capabilities(Capabilities::guest | Capabilities::admin)));
+    EXPECT_TRUE(bf::has_conflicts(Capabilities(Capabilities::admin | Capabilities::banned)));
+    EXPECT_TRUE(bf::has_conflicts(Capabilities(Capabilities::read | Capabilities::banned)));
+}
+
+TEST(BitflagsTest, Normalize) {
+    std::vector<Capabilities> flags(1000);
+    for (std::size_t i = 0; i < flags.size(); ++i) {
+        flags[i] = Capabilities(static_cast<Capabilities::underlying_type>(i & 0x3f));
+    }
+
+    bf::normalize(flags.data(), flags.size());
+
+    for (std::size_t i = 0; i < flags.size(); ++i) {
+        Capabilities const expected = bf::closure(Capabilities(static_cast<Capabilities::underlying_type>(i & 0x3f)));
+        EXPECT_EQ(expected.bits(), flags[i].bits());
+    }
+
+    std::vector<Flags> named(3, Flags(Flags::flag_a));
+    bf::normalize(named.data(), named.size());
+    EXPECT_EQ(Flags::flag_a.bits, named[2].bits());
+}
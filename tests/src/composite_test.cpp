@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <cstdint>
+#include <type_traits>
+
+#include <gtest/gtest.h>
+#include <bitflags/composite.hpp>
+
+namespace
+{
+
+    BEGIN_RAW_BITFLAGS(Access)
+        RAW_FLAG(none)
+        RAW_FLAG(read)
+        RAW_FLAG(write)
+        RAW_FLAG(execute)
+    END_RAW_BITFLAGS(Access)
+
+    DEFINE_FLAG(Access, none)
+    DEFINE_FLAG(Access, read)
+    DEFINE_FLAG(Access, write)
+    DEFINE_FLAG(Access, execute)
+
+    BEGIN_BITFLAGS(State)
+        FLAG(none)
+        FLAG(loaded)
+        FLAG(dirty)
+        FLAG(locked)
+        FLAG(pinned)
+        FLAG(evicted)
+    END_BITFLAGS(State)
+
+    DEFINE_FLAG(State, none)
+    DEFINE_FLAG(State, loaded)
+    DEFINE_FLAG(State, dirty)
+    DEFINE_FLAG(State, locked)
+    DEFINE_FLAG(State, pinned)
+    DEFINE_FLAG(State, evicted)
+
+    BEGIN_RAW_BITFLAGS(Hints)
+        RAW_FLAG(none)
+        RAW_FLAG(hint_0)
+        RAW_FLAG(hint_1)
+        RAW_FLAG(hint_2)
+        RAW_FLAG(hint_3)
+        RAW_FLAG(hint_4)
+        RAW_FLAG(hint_5)
+        RAW_FLAG(hint_6)
+    END_RAW_BITFLAGS(Hints)
+
+    DEFINE_FLAG(Hints, none)
+    DEFINE_FLAG(Hints, hint_0)
+    DEFINE_FLAG(Hints, hint_3)
+    DEFINE_FLAG(Hints, hint_6)
+
+    using Packed = bf::composite<Access, State, Hints>;
+
+} // namespace
+
+TEST(CompositeTest, Layout) {
+    EXPECT_TRUE((std::is_same<Packed::underlying_type, std::uint16_t>::value));
+    EXPECT_EQ(sizeof(std::uint16_t), sizeof(Packed));
+    EXPECT_TRUE((std::is_same<bf::composite<Access, State>::underlying_type, std::uint8_t>::value));
+
+    EXPECT_EQ(0x0007, Packed::view_type<Access>::mask());
+    EXPECT_EQ(0x00f8, Packed::view_type<State>::mask());
+    EXPECT_EQ(0x7f00, Packed::view_type<Hints>::mask());
+}
+
+TEST(CompositeTest, Construct) {
+    Packed packed;
+    EXPECT_TRUE(packed.is_empty());
+
+    Packed members(Access::read | Access::write, State::dirty, Hints::hint_6);
+    EXPECT_EQ(0x4013, members.bits());
+    EXPECT_TRUE(members.get<Access>().contains(Access::read, Access::write));
+    EXPECT_TRUE(members.get<State>().contains(State::dirty));
+    EXPECT_TRUE(members.get<Hints>().contains(Hints::hint_6));
+
+    members.clear();
+    EXPECT_TRUE(members.is_empty());
+    EXPECT_EQ(packed, members);
+}
+
+TEST(CompositeTest, SetRemoveToggle) {
+    Packed packed;
+    packed.get<State>().set(State::loaded);
+    packed.get<Hints>().set(Hints::hint_0);
+    packed.get<Access>().set(Access::execute);
+
+    EXPECT_TRUE(packed.get<State>().contains(State::loaded));
+    EXPECT_FALSE(packed.get<State>().contains(State::dirty));
+    EXPECT_TRUE(packed.get<Hints>().contains(Hints::hint_0));
+    EXPECT_FALSE(packed.get<Hints>().contains(Hints::hint_3));
+    EXPECT_TRUE(packed.get<Access>().contains(Access::execute));
+    EXPECT_TRUE(packed.get<Access>().contains(Access::none));
+
+    packed.get<State>().remove(State::loaded);
+    EXPECT_TRUE(packed.get<State>().is_empty());
+    EXPECT_FALSE(packed.get<Hints>().is_empty());
+
+    packed.get<Hints>().toggle(Hints::hint_0);
+    packed.get<Hints>().toggle(Hints::hint_3);
+    EXPECT_FALSE(packed.get<Hints>().contains(Hints::hint_0));
+    EXPECT_TRUE(packed.get<Hints>().contains(Hints::hint_3));
+
+    packed.get<Hints>().clear();
+    EXPECT_TRUE(packed.get<Hints>().is_empty());
+    EXPECT_TRUE(packed.get<Access>().contains(Access::execute));
+}
+
+TEST(CompositeTest, Operators) {
+    Packed packed(Access::read, State::loaded | State::pinned, Hints::hint_3);
+
+    auto state = packed.get<State>();
+    state |= State::dirty;
+    EXPECT_EQ((State::loaded | State::pinned | State::dirty).bits, state.bits());
+
+    state &= State::dirty | State::pinned;
+    EXPECT_EQ((State::pinned | State::dirty).bits, state.bits());
+
+    // bits outside of the declared flags do not leak into neighbours
+    state &= ~State::dirty;
+    EXPECT_EQ(State::pinned.bits, state.bits());
+    EXPECT_TRUE(packed.get<Access>() == Access::read);
+    EXPECT_TRUE(packed.get<Hints>() == Hints::hint_3);
+
+    state ^= State::pinned | State::evicted;
+    EXPECT_TRUE(state == State::evicted);
+    EXPECT_TRUE(state != State::pinned);
+
+    State const copy = state | State::locked;
+    EXPECT_EQ((State::evicted | State::locked).bits, copy.bits());
+    EXPECT_EQ(State::evicted.bits, (state & State::evicted).bits());
+    EXPECT_EQ((State::evicted | State::dirty).bits, (state ^ State::dirty).bits());
+    EXPECT_EQ(State::evicted.bits, static_cast<State>(state).bits());
+}
+
+TEST(CompositeTest, Assign) {
+    Packed packed(Access::read, State::loaded, Hints::hint_0);
+
+    packed.get<State>() = State(State::dirty | State::locked);
+    EXPECT_EQ((State::dirty | State::locked).bits, packed.get<State>().bits());
+
+    packed.get<Access>() = Access::write;
+    EXPECT_TRUE(packed.get<Access>() == Access::write);
+
+    packed.get<Hints>() = Hints::all();
+    EXPECT_TRUE(packed.get<Hints>().is_all());
+    EXPECT_TRUE(packed.get<Access>() == Access::write);
+    EXPECT_EQ((State::dirty | State::locked).bits, packed.get<State>().bits());
+
+    Packed other;
+    other.get<State>() = packed.get<State>();
+    EXPECT_EQ((State::dirty | State::locked).bits, other.get<State>().bits());
+    EXPECT_TRUE(other.get<Hints>().is_empty());
+}
+
+TEST(CompositeTest, ConstView) {
+    Packed const packed(Access::write, State::locked, Hints::hint_6);
+
+    EXPECT_TRUE(packed.get<Access>().contains(Access::write));
+    EXPECT_FALSE(packed.get<State>().contains(State::dirty));
+    EXPECT_EQ(Hints::hint_6.bits, packed.get<Hints>().value().bits());
+}
+
+#if __cplusplus >= 201402L
+TEST(CompositeTest, Constexpr) {
+    constexpr Packed packed(Access::read, State::dirty, Hints::hint_0);
+    static_assert(packed.get<State>().contains(State::dirty), "");
+    static_assert(!packed.get<Access>().contains(Access::write), "");
+    EXPECT_EQ(0x0111, packed.bits());
+}
+#endif
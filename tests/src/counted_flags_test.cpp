@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <bitflags/counted_flags.hpp>
+
+namespace
+{
+
+    BEGIN_RAW_BITFLAGS(RawFlags)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_a)
+        RAW_FLAG(flag_b)
+        RAW_FLAG(flag_c)
+    END_RAW_BITFLAGS(RawFlags)
+
+    DEFINE_FLAG(RawFlags, none)
+    DEFINE_FLAG(RawFlags, flag_a)
+    DEFINE_FLAG(RawFlags, flag_b)
+    DEFINE_FLAG(RawFlags, flag_c)
+
+    BEGIN_BITFLAGS(Flags)
+        FLAG(none)
+        FLAG(flag_a)
+        FLAG(flag_b)
+        FLAG(flag_c)
+    END_BITFLAGS(Flags)
+
+    DEFINE_FLAG(Flags, none)
+    DEFINE_FLAG(Flags, flag_a)
+    DEFINE_FLAG(Flags, flag_b)
+    DEFINE_FLAG(Flags, flag_c)
+
+} // namespace
+
+TEST(CountedFlagsTest, Construct) {
+    // raw flags (without string representation)
+    bf::counted_flags<RawFlags> raw_flags(10, RawFlags::flag_a | RawFlags::flag_c);
+
+    EXPECT_EQ(10U, raw_flags.size());
+    EXPECT_EQ(10U, raw_flags.count(RawFlags::none));
+    EXPECT_EQ(10U, raw_flags.count(RawFlags::flag_a));
+    EXPECT_EQ(0U, raw_flags.count(RawFlags::flag_b));
+    EXPECT_EQ(10U, raw_flags.count(RawFlags::flag_c));
+
+    // flags (with string representation)
+    std::vector<Flags> values;
+    values.push_back(Flags::flag_a);
+    values.push_back(Flags::flag_a | Flags::flag_b);
+    values.push_back(Flags::flag_c);
+
+    bf::counted_flags<Flags> flags(values.begin(), values.end());
+
+    EXPECT_EQ(3U, flags.size());
+    EXPECT_EQ(2U, flags.count(Flags::flag_a));
+    EXPECT_EQ(1U, flags.count(Flags::flag_b));
+    EXPECT_EQ(1U, flags.count(Flags::flag_c));
+}
+
+TEST(CountedFlagsTest, SetRemoveToggle) {
+    // raw flags (without string representation)
+    bf::counted_flags<RawFlags> raw_flags(4);
+
+    raw_flags.set(0, RawFlags::flag_a);
+    raw_flags.set(1, RawFlags::flag_a | RawFlags::flag_b);
+    raw_flags.set(1, RawFlags::flag_a);
+
+    EXPECT_EQ(2U, raw_flags.count(RawFlags::flag_a));
+    EXPECT_EQ(1U, raw_flags.count(RawFlags::flag_b));
+
+    raw_flags.remove(1, RawFlags::flag_a);
+    raw_flags.remove(2, RawFlags::flag_a);
+
+    EXPECT_EQ(1U, raw_flags.count(RawFlags::flag_a));
+    EXPECT_EQ(1U, raw_flags.count(RawFlags::flag_b));
+
+    raw_flags.toggle(3, RawFlags::flag_b | RawFlags::flag_c);
+    raw_flags.toggle(1, RawFlags::flag_b);
+
+    EXPECT_EQ(1U, raw_flags.count(RawFlags::flag_b));
+    EXPECT_EQ(1U, raw_flags.count(RawFlags::flag_c));
+    EXPECT_TRUE(raw_flags[3].contains(RawFlags::flag_b, RawFlags::flag_c));
+
+    // flags (with string representation)
+    bf::counted_flags<Flags> flags(4);
+
+    flags.set(0, Flags::flag_c);
+    flags.set(2, Flags::flag_c);
+    flags.toggle(2, Flags::flag_c);
+    flags.remove(3, Flags::flag_c);
+
+    EXPECT_EQ(1U, flags.count(Flags::flag_c));
+    EXPECT_EQ(0U, flags.count(Flags::flag_a));
+}
+
+TEST(CountedFlagsTest, AssignAndClear) {
+    bf::counted_flags<Flags> flags(3, Flags::flag_a);
+
+    flags.assign(0, Flags::flag_b | Flags::flag_c);
+    flags.assign(1, Flags::flag_a | Flags::flag_c);
+
+    EXPECT_EQ(2U, flags.count(Flags::flag_a));
+    EXPECT_EQ(1U, flags.count(Flags::flag_b));
+    EXPECT_EQ(2U, flags.count(Flags::flag_c));
+
+    flags.clear(1);
+
+    EXPECT_EQ(1U, flags.count(Flags::flag_a));
+    EXPECT_EQ(1U, flags.count(Flags::flag_c));
+    EXPECT_TRUE(flags[1].is_empty());
+
+    flags.clear();
+
+    EXPECT_TRUE(flags.empty());
+    EXPECT_EQ(0U, flags.count(Flags::flag_a));
+}
+
+TEST(CountedFlagsTest, PushAndPop) {
+    bf::counted_flags<RawFlags> raw_flags;
+
+    raw_flags.push_back(RawFlags::flag_a);
+    raw_flags.push_back(RawFlags::flag_a | RawFlags::flag_b);
+
+    EXPECT_EQ(2U, raw_flags.count(RawFlags::flag_a));
+    EXPECT_EQ(1U, raw_flags.count(RawFlags::flag_b));
+    EXPECT_EQ(1U, raw_flags.counts()[1]);
+
+    raw_flags.pop_back();
+
+    EXPECT_EQ(1U, raw_flags.size());
+    EXPECT_EQ(1U, raw_flags.count(RawFlags::flag_a));
+    EXPECT_EQ(0U, raw_flags.count(RawFlags::flag_b));
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <bitflags/diff.hpp>
+
+namespace
+{
+
+    BEGIN_RAW_BITFLAGS(RawFlags)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_a)
+        RAW_FLAG(flag_b)
+        RAW_FLAG(flag_c)
+    END_RAW_BITFLAGS(RawFlags)
+
+    DEFINE_FLAG(RawFlags, none)
+    DEFINE_FLAG(RawFlags, flag_a)
+    DEFINE_FLAG(RawFlags, flag_b)
+    DEFINE_FLAG(RawFlags, flag_c)
+
+    BEGIN_BITFLAGS(Flags)
+        FLAG(none)
+        FLAG(flag_a)
+        FLAG(flag_b)
+        FLAG(flag_c)
+    END_BITFLAGS(Flags)
+
+    DEFINE_FLAG(Flags, none)
+    DEFINE_FLAG(Flags, flag_a)
+    DEFINE_FLAG(Flags, flag_b)
+    DEFINE_FLAG(Flags, flag_c)
+
+    template <typename BitflagsT>
+    struct batch_collector {
+        std::vector<bf::flag_change<BitflagsT>>* changes;
+        std::size_t* batches;
+
+        void operator()(bf::flag_change<BitflagsT> const* batch, std::size_t size) {
+            changes->insert(changes->end(), batch, batch + size);
+            ++*batches;
+        }
+    };
+
+} // namespace
+
+TEST(DiffTest, NoChanges) {
+    // raw flags (without string representation)
+    std::vector<RawFlags> raw_prev(1000, RawFlags::flag_a | RawFlags::flag_b);
+    std::vector<RawFlags> raw_curr(raw_prev);
+    std::vector<bf::flag_change<RawFlags>> raw_changes(raw_prev.size());
+
+    EXPECT_EQ(0U, bf::diff(raw_prev.data(), raw_curr.data(), raw_prev.size(), raw_changes.data()));
+
+    // flags (with string representation)
+    std::vector<Flags> prev(1000, Flags::flag_a | Flags::flag_b);
+    std::vector<Flags> curr(prev);
+    std::vector<bf::flag_change<Flags>> changes(prev.size());
+
+    EXPECT_EQ(0U, bf::diff(prev.data(), curr.data(), prev.size(), changes.data()));
+}
+
+TEST(DiffTest, RaisedAndCleared) {
+    // raw flags (without string representation)
+    std::vector<RawFlags> raw_prev(200, RawFlags::flag_a);
+    std::vector<RawFlags> raw_curr(raw_prev);
+    std::vector<bf::flag_change<RawFlags>> raw_changes(raw_prev.size());
+
+    raw_curr[0] = RawFlags::flag_b;
+    raw_curr[63] = RawFlags::flag_a | RawFlags::flag_c;
+    raw_curr[64] = RawFlags::none;
+    raw_curr[199] = RawFlags::flag_b | RawFlags::flag_c;
+
+    ASSERT_EQ(4U, bf::diff(raw_prev.data(), raw_curr.data(), raw_prev.size(), raw_changes.data()));
+
+    EXPECT_EQ(0U, raw_changes[0].index);
+    EXPECT_EQ(RawFlags::flag_b.bits, raw_changes[0].raised);
+    EXPECT_EQ(RawFlags::flag_a.bits, raw_changes[0].cleared);
+
+    EXPECT_EQ(63U, raw_changes[1].index);
+    EXPECT_EQ(RawFlags::flag_c.bits, raw_changes[1].raised);
+    EXPECT_EQ(RawFlags::none.bits, raw_changes[1].cleared);
+
+    EXPECT_EQ(64U, raw_changes[2].index);
+    EXPECT_EQ(RawFlags::none.bits, raw_changes[2].raised);
+    EXPECT_EQ(RawFlags::flag_a.bits, raw_changes[2].cleared);
+
+    EXPECT_EQ(199U, raw_changes[3].index);
+    EXPECT_EQ((RawFlags::flag_b | RawFlags::flag_c).bits, raw_changes[3].raised);
+    EXPECT_EQ(RawFlags::flag_a.bits, raw_changes[3].cleared);
+
+    // flags (with string representation)
+    std::vector<Flags> prev(200, Flags::flag_a);
+    std::vector<Flags> curr(prev);
+    std::vector<bf::flag_change<Flags>> changes(prev.size());
+
+    curr[5] = Flags::flag_a | Flags::flag_b;
+    curr[130] = Flags::flag_c;
+
+    ASSERT_EQ(2U, bf::diff(prev.data(), curr.data(), prev.size(), changes.data()));
+
+    EXPECT_EQ(5U, changes[0].index);
+    EXPECT_EQ(Flags::flag_b.bits, changes[0].raised);
+    EXPECT_EQ(Flags::none.bits, changes[0].cleared);
+
+    EXPECT_EQ(130U, changes[1].index);
+    EXPECT_EQ(Flags::flag_c.bits, changes[1].raised);
+    EXPECT_EQ(Flags::flag_a.bits, changes[1].cleared);
+}
+
+TEST(DiffTest, Batched) {
+    std::vector<RawFlags> prev(1000, RawFlags::none);
+    std::vector<RawFlags> curr(prev);
+
+    for (std::size_t i = 0; i < curr.size(); i += 3) {
+        curr[i] = RawFlags::flag_c;
+    }
+
+    std::vector<bf::flag_change<RawFlags>> changes;
+    std::size_t batches = 0;
+
+    std::size_t const total = bf::diff_batched<100>(
+        prev.data(), curr.data(), prev.size(),
+        batch_collector<RawFlags>{ &changes, &batches }
+    );
+
+    EXPECT_EQ(334U, total);
+    EXPECT_EQ(334U, changes.size());
+    EXPECT_EQ(4U, batches);
+
+    for (std::size_t i = 0; i < changes.size(); ++i) {
+        EXPECT_EQ(i * 3, changes[i].index);
+        EXPECT_EQ(RawFlags::flag_c.bits, changes[i].raised);
+        EXPECT_EQ(RawFlags::none.bits, changes[i].cleared);
+    }
+}
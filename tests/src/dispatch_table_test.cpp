@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <bitflags/dispatch_table.hpp>
+
+namespace
+{
+
+    BEGIN_RAW_BITFLAGS(RawFlags)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_a)
+        RAW_FLAG(flag_b)
+        RAW_FLAG(flag_c)
+    END_RAW_BITFLAGS(RawFlags)
+
+    DEFINE_FLAG(RawFlags, none)
+    DEFINE_FLAG(RawFlags, flag_a)
+    DEFINE_FLAG(RawFlags, flag_b)
+    DEFINE_FLAG(RawFlags, flag_c)
+
+    BEGIN_BITFLAGS(Flags)
+        FLAG(none)
+        FLAG(flag_a)
+        FLAG(flag_b)
+        FLAG(flag_c)
+    END_BITFLAGS(Flags)
+
+    DEFINE_FLAG(Flags, none)
+    DEFINE_FLAG(Flags, flag_a)
+    DEFINE_FLAG(Flags, flag_b)
+    DEFINE_FLAG(Flags, flag_c)
+
+    int on_default(int x) { return x; }
+    int on_a(int x) { return x + 1; }
+    int on_b(int x) { return x + 2; }
+    int on_a_b(int x) { return x + 3; }
+
+    struct selector {
+        NON_CONST_CONSTEXPR int (*operator()(RawFlags const& flags) const)(int) {
+            return flags.contains(RawFlags::flag_a, RawFlags::flag_b) ? &on_a_b
+                 : flags.contains(RawFlags::flag_a) ? &on_a
+                 : flags.contains(RawFlags::flag_b) ? &on_b
+                 : &on_default;
+        }
+    };
+
+} // namespace
+
+TEST(DispatchTableTest, Assign) {
+    // raw flags (without string representation)
+    bf::dispatch_table<RawFlags, int(int)> raw_table(&on_default);
+
+    EXPECT_EQ(8U, raw_table.size);
+
+    raw_table.assign(RawFlags::flag_a, &on_a);
+    raw_table.assign(RawFlags::flag_a | RawFlags::flag_b, &on_a_b);
+
+    EXPECT_EQ(10, raw_table(RawFlags::none, 10));
+    EXPECT_EQ(11, raw_table(RawFlags::flag_a, 10));
+    EXPECT_EQ(10, raw_table(RawFlags::flag_b, 10));
+    EXPECT_EQ(13, raw_table(RawFlags::flag_a | RawFlags::flag_b, 10));
+    EXPECT_EQ(10, raw_table(RawFlags::flag_a | RawFlags::flag_b | RawFlags::flag_c, 10));
+
+    // flags (with string representation)
+    bf::dispatch_table<Flags, int(int)> table(&on_default);
+
+    table.assign(Flags::flag_b, &on_b);
+
+    EXPECT_EQ(&on_b, table[Flags::flag_b]);
+    EXPECT_EQ(&on_default, table[Flags::flag_c]);
+    EXPECT_EQ(12, table(Flags::flag_b, 10));
+}
+
+TEST(DispatchTableTest, Selector) {
+    bf::dispatch_table<RawFlags, int(int)> table{ selector{} };
+
+    EXPECT_EQ(10, table(RawFlags::none, 10));
+    EXPECT_EQ(11, table(RawFlags::flag_a, 10));
+    EXPECT_EQ(11, table(RawFlags::flag_a | RawFlags::flag_c, 10));
+    EXPECT_EQ(12, table(RawFlags::flag_b | RawFlags::flag_c, 10));
+    EXPECT_EQ(13, table(RawFlags::flag_a | RawFlags::flag_b, 10));
+}
+
+TEST(DispatchTableTest, RelevantMask) {
+    // only flag_a and flag_c are relevant, flag_b is ignored
+    bf::dispatch_table<RawFlags, int(int), 0x05> table{ selector{} };
+
+    EXPECT_EQ(4U, table.size);
+
+    EXPECT_EQ(10, table(RawFlags::none, 10));
+    EXPECT_EQ(10, table(RawFlags::flag_b, 10));
+    EXPECT_EQ(11, table(RawFlags::flag_a, 10));
+    EXPECT_EQ(11, table(RawFlags::flag_a | RawFlags::flag_b, 10));
+    EXPECT_EQ(11, table(RawFlags::flag_a | RawFlags::flag_c, 10));
+}
+
+#if __cplusplus >= 201402L
+TEST(DispatchTableTest, CompileTime) {
+    constexpr bf::dispatch_table<RawFlags, int(int)> table{ selector{} };
+
+    EXPECT_EQ(13, table(RawFlags::flag_a | RawFlags::flag_b, 10));
+}
+#endif
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <bitflags/dynamic_flags.hpp>
+
+namespace
+{
+
+    using registry_type = bf::flag_registry<100>;
+    using flags_type    = registry_type::flags_type;
+    using flag_type     = registry_type::flag_type;
+
+} // namespace
+
+static_assert(flags_type::words_count == 2, "");
+
+TEST(DynamicFlagsTest, Registry) {
+    registry_type registry;
+    EXPECT_EQ(registry.size(), 0u);
+    EXPECT_EQ(registry.find("beta"), nullptr);
+
+    flag_type const alpha = registry.add("alpha");
+    flag_type const beta = registry.add(std::string("beta"));
+    EXPECT_EQ(registry.size(), 2u);
+    EXPECT_EQ(alpha.bit(), 0u);
+    EXPECT_EQ(beta.bit(), 1u);
+    EXPECT_EQ(std::string(beta.name), "beta");
+
+    // registering the same name again yields the same flag
+    EXPECT_EQ(registry.add("alpha"), alpha);
+    EXPECT_EQ(registry.size(), 2u);
+
+    ASSERT_NE(registry.find("alpha"), nullptr);
+    EXPECT_EQ(*registry.find("alpha"), alpha);
+    EXPECT_EQ(*registry.find(std::string("beta")), beta);
+    EXPECT_EQ(registry.find("gamma"), nullptr);
+    EXPECT_EQ(registry[1], beta);
+    EXPECT_EQ(flag_type().bit(), 100u);
+}
+
+TEST(DynamicFlagsTest, Full) {
+    registry_type registry;
+    for (std::size_t i = 0; i < registry_type::capacity; ++i) {
+        EXPECT_EQ(registry.add("flag_" + std::to_string(i)).bit(), i);
+    }
+    EXPECT_THROW(registry.add("overflow"), std::length_error);
+    EXPECT_EQ(registry.size(), registry_type::capacity);
+    EXPECT_EQ(registry.find("overflow"), nullptr);
+    EXPECT_EQ(registry.add("flag_99").bit(), 99u);
+
+    for (std::size_t i = 0; i < registry_type::capacity; ++i) {
+        EXPECT_EQ(registry.find("flag_" + std::to_string(i))->bit(), i);
+    }
+    EXPECT_TRUE(registry.all().is_all());
+
+    std::size_t index = 0;
+    for (flag_type const& f : registry.declared_flags()) {
+        EXPECT_EQ(f.bit(), index++);
+    }
+    EXPECT_EQ(index, registry_type::capacity);
+}
+
+TEST(DynamicFlagsTest, Operators) {
+    registry_type registry;
+    for (std::size_t i = 0; i < 70; ++i) {
+        registry.add("flag_" + std::to_string(i));
+    }
+    flag_type const low = *registry.find("flag_3");
+    flag_type const high = *registry.find("flag_68");
+
+    flags_type flags = low | high;
+    EXPECT_TRUE(flags.contains(low));
+    EXPECT_TRUE(flags.contains(high));
+    EXPECT_TRUE(flags.contains(low, high, flag_type()));
+    EXPECT_FALSE(flags.contains(*registry.find("flag_4")));
+    EXPECT_EQ(flags.bits()[0], 0x8u);
+    EXPECT_EQ(flags.bits()[1], 0x10u);
+
+    EXPECT_EQ(flags & flags_type(low), flags_type(low));
+    EXPECT_EQ(flags ^ flags_type(low), flags_type(high));
+    EXPECT_TRUE((low & high).is_empty());
+
+    flags_type const complement = ~flags;
+    EXPECT_FALSE(complement.contains(low));
+    EXPECT_TRUE(complement.contains(*registry.find("flag_4")));
+    EXPECT_EQ(complement.bits()[1] >> 36, 0u);
+    EXPECT_TRUE((complement | flags).is_all());
+
+    EXPECT_TRUE(flags.contains_all(flags_type(high)));
+    EXPECT_FALSE(flags_type(high).contains_all(flags));
+
+    flags.remove(low);
+    EXPECT_EQ(flags, flags_type(high));
+    flags.toggle(low);
+    flags.toggle(high);
+    EXPECT_EQ(flags, flags_type(low));
+    flags.set(high);
+    flags &= flags_type(high);
+    EXPECT_EQ(flags, flags_type(high));
+    flags |= low;
+    flags ^= high;
+    EXPECT_EQ(flags, flags_type(low));
+    flags.clear();
+    EXPECT_TRUE(flags.is_empty());
+    EXPECT_EQ(flags, flags_type::empty());
+}
+
+TEST(DynamicFlagsTest, Formatting) {
+    registry_type registry;
+    flag_type const read = registry.add("read");
+    flag_type const write = registry.add("write");
+    flag_type const exec = registry.add("exec");
+
+    EXPECT_EQ(registry.to_string(exec | read), "read | exec");
+    EXPECT_EQ(registry.to_string(write | exec, ","), "write,exec");
+    EXPECT_EQ(registry.to_string(flags_type()), "");
+
+    // bits without registered flags are skipped
+    EXPECT_EQ(registry.to_string(flags_type::all()), "read | write | exec");
+
+    std::vector<std::string> names;
+    registry.for_each(read | write, [&names](flag_type const& f) { names.emplace_back(f.name); });
+    EXPECT_EQ(names, (std::vector<std::string>{ "read", "write" }));
+
+    std::vector<std::size_t> bits;
+    (read | exec).for_each_bit([&bits](std::size_t const bit) { bits.push_back(bit); });
+    EXPECT_EQ(bits, (std::vector<std::size_t>{ 0, 2 }));
+}
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <bitflags/flags_map.hpp>
+
+namespace
+{
+
+    BEGIN_RAW_BITFLAGS(RawFlags)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_a)
+        RAW_FLAG(flag_b)
+        RAW_FLAG(flag_c)
+    END_RAW_BITFLAGS(RawFlags)
+
+    DEFINE_FLAG(RawFlags, none)
+    DEFINE_FLAG(RawFlags, flag_a)
+    DEFINE_FLAG(RawFlags, flag_b)
+    DEFINE_FLAG(RawFlags, flag_c)
+
+    BEGIN_BITFLAGS(Flags)
+        FLAG(none)
+        FLAG(flag_a)
+        FLAG(flag_b)
+        FLAG(flag_c)
+    END_BITFLAGS(Flags)
+
+    DEFINE_FLAG(Flags, none)
+    DEFINE_FLAG(Flags, flag_a)
+    DEFINE_FLAG(Flags, flag_b)
+    DEFINE_FLAG(Flags, flag_c)
+
+    BEGIN_RAW_BITFLAGS(WideFlags)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_0)
+        RAW_FLAG(flag_1)
+        RAW_FLAG(flag_2)
+        RAW_FLAG(flag_3)
+        RAW_FLAG(flag_4)
+        RAW_FLAG(flag_5)
+        RAW_FLAG(flag_6)
+        RAW_FLAG(flag_7)
+        RAW_FLAG(flag_8)
+        RAW_FLAG(flag_9)
+        RAW_FLAG(flag_10)
+        RAW_FLAG(flag_11)
+        RAW_FLAG(flag_12)
+        RAW_FLAG(flag_13)
+        RAW_FLAG(flag_14)
+        RAW_FLAG(flag_15)
+    END_RAW_BITFLAGS(WideFlags)
+
+    DEFINE_FLAG(WideFlags, flag_0)
+    DEFINE_FLAG(WideFlags, flag_1)
+    DEFINE_FLAG(WideFlags, flag_15)
+
+} // namespace
+
+static_assert(bf::flags_map<RawFlags, int>::is_dense, "");
+static_assert(bf::flags_map<Flags, int>::is_dense, "");
+static_assert(!bf::flags_map<WideFlags, int>::is_dense, "");
+static_assert(bf::flags_set<RawFlags>::is_dense, "");
+static_assert(!bf::flags_set<WideFlags>::is_dense, "");
+
+TEST(FlagsMapTest, Hash) {
+    std::hash<RawFlags> const raw_hash{};
+    EXPECT_EQ(raw_hash(RawFlags::flag_a | RawFlags::flag_c), std::size_t{5});
+
+    std::hash<Flags> const hash{};
+    EXPECT_EQ(hash(Flags::flag_a), hash(Flags(Flags::flag_a)));
+
+    std::unordered_set<WideFlags> set;
+    set.insert(WideFlags::flag_0);
+    set.insert(WideFlags::flag_0 | WideFlags::flag_15);
+    set.insert(WideFlags::flag_0);
+    EXPECT_EQ(set.size(), 2u);
+    EXPECT_EQ(set.count(WideFlags::flag_0 | WideFlags::flag_15), 1u);
+    EXPECT_EQ(set.count(WideFlags::flag_1), 0u);
+}
+
+TEST(FlagsMapTest, Dense) {
+    bf::flags_map<Flags, std::string> map;
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.find(Flags::flag_a), nullptr);
+
+    map[Flags::flag_a] = "a";
+    map[Flags::flag_a | Flags::flag_b] = "ab";
+    EXPECT_TRUE(map.insert_or_assign(Flags::none, "none"));
+    EXPECT_FALSE(map.insert_or_assign(Flags::flag_a, "A"));
+
+    EXPECT_EQ(map.size(), 3u);
+    EXPECT_TRUE(map.contains(Flags::none));
+    EXPECT_FALSE(map.contains(Flags::flag_b));
+    ASSERT_NE(map.find(Flags::flag_a), nullptr);
+    EXPECT_EQ(*map.find(Flags::flag_a), "A");
+    EXPECT_EQ(*map.find(Flags::flag_a | Flags::flag_b), "ab");
+
+    EXPECT_TRUE(map.erase(Flags::flag_a));
+    EXPECT_FALSE(map.erase(Flags::flag_a));
+    EXPECT_EQ(map.size(), 2u);
+
+    // value of erased key is reset
+    EXPECT_EQ(map[Flags::flag_a], "");
+
+    std::map<std::uint8_t, std::string> visited;
+    map.for_each([&visited](Flags const& key, std::string const& value) {
+        visited[key.bits()] = value;
+    });
+    EXPECT_EQ(visited.size(), 3u);
+    EXPECT_EQ(visited[0], "none");
+    EXPECT_EQ(visited[(Flags::flag_a | Flags::flag_b).bits], "ab");
+
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_FALSE(map.contains(Flags::none));
+}
+
+TEST(FlagsMapTest, UndeclaredBitsIgnored) {
+    bf::flags_map<RawFlags, int> map;
+    map[RawFlags(static_cast<std::uint8_t>(0xf9))] = 1;
+    EXPECT_TRUE(map.contains(RawFlags::flag_a));
+    EXPECT_EQ(*map.find(RawFlags::flag_a), 1);
+}
+
+TEST(FlagsMapTest, Hashed) {
+    bf::flags_map<WideFlags, std::uint32_t> map;
+    std::map<std::uint16_t, std::uint32_t> expected;
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<std::uint32_t> dist(0, 0xffff);
+
+    for (int i = 0; i < 20000; ++i) {
+        auto const key = static_cast<std::uint16_t>(dist(gen) & 0x3ff);
+        auto const value = dist(gen);
+        if (value % 3 == 0) {
+            EXPECT_EQ(map.erase(WideFlags(key)), expected.erase(key) == 1);
+        } else {
+            map[WideFlags(key)] = value;
+            expected[key] = value;
+        }
+    }
+
+    EXPECT_EQ(map.size(), expected.size());
+    for (std::uint32_t key = 0; key <= 0x3ff; ++key) {
+        auto const it = expected.find(static_cast<std::uint16_t>(key));
+        auto const found = map.find(WideFlags(static_cast<std::uint16_t>(key)));
+        if (it == expected.end()) {
+            EXPECT_EQ(found, nullptr);
+        } else {
+            ASSERT_NE(found, nullptr);
+            EXPECT_EQ(*found, it->second);
+        }
+    }
+
+    std::size_t visited = 0;
+    map.for_each([&](WideFlags const& key, std::uint32_t const value) {
+        EXPECT_EQ(expected[key.bits()], value);
+        ++visited;
+    });
+    EXPECT_EQ(visited, expected.size());
+
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.find(WideFlags::flag_0), nullptr);
+}
+
+TEST(FlagsSetTest, DenseAndHashed) {
+    bf::flags_set<RawFlags> dense;
+    EXPECT_TRUE(dense.insert(RawFlags::flag_a | RawFlags::flag_b));
+    EXPECT_FALSE(dense.insert(RawFlags::flag_a | RawFlags::flag_b));
+    EXPECT_TRUE(dense.insert(RawFlags::none));
+    EXPECT_TRUE(dense.contains(RawFlags::flag_a | RawFlags::flag_b));
+    EXPECT_FALSE(dense.contains(RawFlags::flag_a));
+    EXPECT_EQ(dense.size(), 2u);
+
+    std::vector<std::uint8_t> keys;
+    dense.for_each([&keys](RawFlags const& key) { keys.push_back(key.bits()); });
+    EXPECT_EQ(keys, (std::vector<std::uint8_t>{ 0, 3 }));
+
+    EXPECT_TRUE(dense.erase(RawFlags::none));
+    EXPECT_EQ(dense.size(), 1u);
+    dense.clear();
+    EXPECT_TRUE(dense.empty());
+
+    bf::flags_set<WideFlags> hashed;
+    for (std::uint32_t key = 0; key < 1000; ++key) {
+        EXPECT_TRUE(hashed.insert(WideFlags(static_cast<std::uint16_t>(key * 61))));
+    }
+    EXPECT_EQ(hashed.size(), 1000u);
+    for (std::uint32_t key = 0; key < 1000; key += 2) {
+        EXPECT_TRUE(hashed.erase(WideFlags(static_cast<std::uint16_t>(key * 61))));
+    }
+    for (std::uint32_t key = 0; key < 1000; ++key) {
+        EXPECT_EQ(hashed.contains(WideFlags(static_cast<std::uint16_t>(key * 61))), key % 2 == 1);
+    }
+}
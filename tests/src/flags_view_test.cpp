@@ -0,0 +1,324 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <bitflags/flags_view.hpp>
+
+namespace
+{
+
+    BEGIN_RAW_BITFLAGS(RawFlags)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_a)
+        RAW_FLAG(flag_b)
+        RAW_FLAG(flag_c)
+    END_RAW_BITFLAGS(RawFlags)
+
+    DEFINE_FLAG(RawFlags, none)
+    DEFINE_FLAG(RawFlags, flag_a)
+    DEFINE_FLAG(RawFlags, flag_b)
+    DEFINE_FLAG(RawFlags, flag_c)
+
+    BEGIN_BITFLAGS(Flags)
+        FLAG(none)
+        FLAG(flag_a)
+        FLAG(flag_b)
+        FLAG(flag_c)
+        FLAG(flag_d)
+        FLAG(flag_e)
+        FLAG(flag_f)
+        FLAG(flag_g)
+        FLAG(flag_h)
+        FLAG(flag_i)
+    END_BITFLAGS(Flags)
+
+    DEFINE_FLAG(Flags, none)
+    DEFINE_FLAG(Flags, flag_a)
+    DEFINE_FLAG(Flags, flag_b)
+    DEFINE_FLAG(Flags, flag_i)
+
+    BEGIN_RAW_BITFLAGS(Flags32)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_0)
+        RAW_FLAG(flag_1)
+        RAW_FLAG(flag_2)
+        RAW_FLAG(flag_3)
+        RAW_FLAG(flag_4)
+        RAW_FLAG(flag_5)
+        RAW_FLAG(flag_6)
+        RAW_FLAG(flag_7)
+        RAW_FLAG(flag_8)
+        RAW_FLAG(flag_9)
+        RAW_FLAG(flag_10)
+        RAW_FLAG(flag_11)
+        RAW_FLAG(flag_12)
+        RAW_FLAG(flag_13)
+        RAW_FLAG(flag_14)
+        RAW_FLAG(flag_15)
+        RAW_FLAG(flag_16)
+        RAW_FLAG(flag_17)
+        RAW_FLAG(flag_18)
+        RAW_FLAG(flag_19)
+    END_RAW_BITFLAGS(Flags32)
+
+    DEFINE_FLAG(Flags32, none)
+    DEFINE_FLAG(Flags32, flag_0)
+    DEFINE_FLAG(Flags32, flag_19)
+
+    BEGIN_RAW_BITFLAGS(Flags64)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_0)
+        RAW_FLAG(flag_1)
+        RAW_FLAG(flag_2)
+        RAW_FLAG(flag_3)
+        RAW_FLAG(flag_4)
+        RAW_FLAG(flag_5)
+        RAW_FLAG(flag_6)
+        RAW_FLAG(flag_7)
+        RAW_FLAG(flag_8)
+        RAW_FLAG(flag_9)
+        RAW_FLAG(flag_10)
+        RAW_FLAG(flag_11)
+        RAW_FLAG(flag_12)
+        RAW_FLAG(flag_13)
+        RAW_FLAG(flag_14)
+        RAW_FLAG(flag_15)
+        RAW_FLAG(flag_16)
+        RAW_FLAG(flag_17)
+        RAW_FLAG(flag_18)
+        RAW_FLAG(flag_19)
+        RAW_FLAG(flag_20)
+        RAW_FLAG(flag_21)
+        RAW_FLAG(flag_22)
+        RAW_FLAG(flag_23)
+        RAW_FLAG(flag_24)
+        RAW_FLAG(flag_25)
+        RAW_FLAG(flag_26)
+        RAW_FLAG(flag_27)
+        RAW_FLAG(flag_28)
+        RAW_FLAG(flag_29)
+        RAW_FLAG(flag_30)
+        RAW_FLAG(flag_31)
+        RAW_FLAG(flag_32)
+        RAW_FLAG(flag_33)
+        RAW_FLAG(flag_34)
+        RAW_FLAG(flag_35)
+        RAW_FLAG(flag_36)
+        RAW_FLAG(flag_37)
+        RAW_FLAG(flag_38)
+        RAW_FLAG(flag_39)
+    END_RAW_BITFLAGS(Flags64)
+
+    DEFINE_FLAG(Flags64, none)
+    DEFINE_FLAG(Flags64, flag_0)
+    DEFINE_FLAG(Flags64, flag_39)
+
+#pragma pack(push, 1)
+    struct Packet {
+        std::uint8_t kind;
+        std::uint8_t flags[2]; // big-endian Flags
+        std::uint32_t payload;
+    };
+#pragma pack(pop)
+
+} // namespace
+
+static_assert(sizeof(Flags::underlying_type) == 2, "");
+static_assert(sizeof(Flags32::underlying_type) == 4, "");
+static_assert(sizeof(Flags64::underlying_type) == 8, "");
+static_assert(sizeof(Packet) == 7, "");
+
+TEST(FlagsViewTest, BigEndianField) {
+    // flag_i is bit 8, i.e. the low bit of the first byte on the wire
+    unsigned char bytes[2] = { 0x01, 0x02 };
+    bf::flags_ref<Flags, bf::endian::big> ref(bytes);
+
+    EXPECT_EQ(ref.bits(), 0x0102);
+    EXPECT_TRUE(ref.contains(Flags::flag_i));
+    EXPECT_TRUE(ref.contains(Flags::flag_b));
+    EXPECT_FALSE(ref.contains(Flags::flag_a));
+    EXPECT_TRUE(ref.contains(Flags::flag_b, Flags::flag_i, Flags::none));
+    EXPECT_FALSE(ref.is_empty());
+    EXPECT_FALSE(ref.is_all());
+
+    ref.set(Flags::flag_a);
+    EXPECT_EQ(bytes[0], 0x01);
+    EXPECT_EQ(bytes[1], 0x03);
+
+    ref.remove(Flags::flag_i);
+    EXPECT_EQ(bytes[0], 0x00);
+
+    ref.toggle(Flags::flag_i);
+    EXPECT_EQ(bytes[0], 0x01);
+
+    ref = Flags::flag_b;
+    EXPECT_EQ(bytes[0], 0x00);
+    EXPECT_EQ(bytes[1], 0x02);
+    EXPECT_TRUE(ref == Flags::flag_b);
+    EXPECT_TRUE(ref != Flags::flag_a);
+
+    ref |= Flags::flag_i;
+    ref &= Flags::flag_i;
+    EXPECT_EQ(ref.bits(), 0x0100);
+    ref ^= Flags::flag_a;
+    EXPECT_EQ((ref & Flags::flag_a).bits(), 0x0001);
+    EXPECT_EQ((ref | Flags::flag_b).bits(), 0x0103);
+    EXPECT_EQ((ref ^ Flags::flag_a).bits(), 0x0100);
+    EXPECT_EQ((~ref).bits(), 0xfefe);
+
+    Flags const copy = ref;
+    EXPECT_EQ(copy.bits(), 0x0101);
+
+    ref.clear();
+    EXPECT_TRUE(ref.is_empty());
+    EXPECT_EQ(bytes[0], 0x00);
+    EXPECT_EQ(bytes[1], 0x00);
+}
+
+TEST(FlagsViewTest, ConstField) {
+    unsigned char const bytes[1] = { 0x05 };
+    bf::flags_ref<RawFlags const> ref(bytes);
+    EXPECT_TRUE(ref.contains(RawFlags::flag_a, RawFlags::flag_c));
+    EXPECT_FALSE(ref.contains(RawFlags::flag_b));
+    EXPECT_EQ(ref.value().bits(), 0x05);
+}
+
+TEST(FlagsViewTest, StridedArray) {
+    std::vector<Packet> packets(10);
+    for (std::size_t i = 0; i < packets.size(); ++i) {
+        packets[i].kind = static_cast<std::uint8_t>(i);
+        packets[i].flags[0] = static_cast<std::uint8_t>(i % 2);  // flag_i on odd packets
+        packets[i].flags[1] = static_cast<std::uint8_t>(i % 3 == 0 ? 0x02 : 0x00); // flag_b
+        packets[i].payload = 0xdeadbeef;
+    }
+
+    bf::flags_view<Flags, bf::endian::big, sizeof(Packet)> view(
+        reinterpret_cast<unsigned char*>(packets.data()), offsetof(Packet, flags), packets.size());
+    EXPECT_EQ(view.size(), 10u);
+    EXPECT_FALSE(view.empty());
+    EXPECT_TRUE(view[3].contains(Flags::flag_i, Flags::flag_b));
+    EXPECT_FALSE(view[4].contains(Flags::flag_i));
+
+    EXPECT_EQ(view.count(Flags::flag_i), 5u);
+    EXPECT_EQ(view.count(Flags::flag_b), 4u);
+    EXPECT_EQ(view.count(Flags::none), 10u);
+
+    std::vector<std::size_t> indices(view.size());
+    indices.resize(view.select(Flags::flag_b, indices.data()));
+    EXPECT_EQ(indices, (std::vector<std::size_t>{ 0, 3, 6, 9 }));
+
+    std::vector<std::uint16_t> bits(view.size());
+    view.load(bits.data());
+    EXPECT_EQ(bits[3], 0x0102);
+    EXPECT_EQ(bits[4], 0x0000);
+
+    view.set(Flags::flag_a);
+    view.remove(Flags::flag_i);
+    view.toggle(Flags::flag_b);
+    for (std::size_t i = 0; i < packets.size(); ++i) {
+        EXPECT_EQ(packets[i].kind, i);
+        EXPECT_EQ(packets[i].payload, 0xdeadbeef);
+        EXPECT_EQ(packets[i].flags[0], 0x00);
+        EXPECT_EQ(packets[i].flags[1], i % 3 == 0 ? 0x01 : 0x03);
+    }
+
+    std::vector<Flags> flags(view.size(), Flags(Flags::flag_i));
+    view.store(flags.data());
+    EXPECT_EQ(view.count(Flags::flag_i), 10u);
+    EXPECT_EQ(packets[7].flags[0], 0x01);
+    EXPECT_EQ(packets[7].flags[1], 0x00);
+
+    std::vector<Flags> loaded(view.size());
+    view.load(loaded.data());
+    EXPECT_EQ(loaded[2].bits(), 0x0100);
+
+    view.clear();
+    EXPECT_EQ(view.count(Flags::flag_i), 0u);
+    EXPECT_EQ(packets[9].payload, 0xdeadbeef);
+}
+
+TEST(FlagsViewTest, NativeEndian) {
+    std::vector<std::uint32_t> words = { 0x0100, 0x0001, 0x0101 };
+    bf::flags_view<Flags const, bf::endian::native, sizeof(std::uint32_t)> view(words.data(), words.size());
+    EXPECT_EQ(view.count(Flags::flag_a), 2u);
+    EXPECT_EQ(view.count(Flags::flag_i), 2u);
+    EXPECT_EQ(view[2].bits(), 0x0101);
+}
+
+template <typename FlagsT>
+void check_wide_fields()
+{
+    using underlying_type = typename FlagsT::underlying_type;
+    constexpr std::size_t width = sizeof(underlying_type);
+    constexpr std::size_t stride = width + 3;
+
+    // enough fields for several vector iterations and a scalar tail
+    std::size_t const size = 37;
+    std::vector<unsigned char> bytes(size * stride, 0xaa);
+    for (std::size_t i = 0; i < size; ++i) {
+        for (std::size_t b = 0; b < width; ++b) {
+            bytes[i * stride + b] = 0;
+        }
+        // last flag in the most significant byte, first flag in the least one
+        bytes[i * stride] = static_cast<unsigned char>(i % 2 == 0 ? 0x80 : 0x00);
+        bytes[i * stride + width - 1] = static_cast<unsigned char>(i % 3 == 0 ? 0x01 : 0x00);
+    }
+
+    bf::flags_view<FlagsT, bf::endian::big, stride> view(bytes.data(), size);
+    EXPECT_EQ(view.count(FlagsT::flag_0), 13u);
+    EXPECT_EQ(view.count(FlagsT::none), size);
+
+    std::vector<underlying_type> bits(size);
+    view.load(bits.data());
+    for (std::size_t i = 0; i < size; ++i) {
+        underlying_type expected = 0;
+        if (i % 2 == 0) {
+            expected |= static_cast<underlying_type>(underlying_type(0x80) << (8 * (width - 1)));
+        }
+        if (i % 3 == 0) {
+            expected |= FlagsT::flag_0.bits;
+        }
+        EXPECT_EQ(bits[i], expected) << i;
+        EXPECT_EQ(bytes[i * stride + width], 0xaa);
+    }
+}
+
+TEST(FlagsViewTest, WideFields) {
+    check_wide_fields<Flags32>();
+    check_wide_fields<Flags64>();
+
+    std::vector<std::uint64_t> words(21, Flags64::flag_39.bits);
+    bf::flags_view<Flags64 const> view(words.data(), words.size());
+    EXPECT_EQ(view.count(Flags64::flag_39), 21u);
+    EXPECT_EQ(view.count(Flags64::flag_0), 0u);
+}
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <bitflags/frequency.hpp>
+
+namespace
+{
+
+    BEGIN_RAW_BITFLAGS(RawFlags)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_a)
+        RAW_FLAG(flag_b)
+        RAW_FLAG(flag_c)
+    END_RAW_BITFLAGS(RawFlags)
+
+    DEFINE_FLAG(RawFlags, none)
+    DEFINE_FLAG(RawFlags, flag_a)
+    DEFINE_FLAG(RawFlags, flag_b)
+    DEFINE_FLAG(RawFlags, flag_c)
+
+    BEGIN_RAW_BITFLAGS(Flags32)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_0)
+        RAW_FLAG(flag_1)
+        RAW_FLAG(flag_2)
+        RAW_FLAG(flag_3)
+        RAW_FLAG(flag_4)
+        RAW_FLAG(flag_5)
+        RAW_FLAG(flag_6)
+        RAW_FLAG(flag_7)
+        RAW_FLAG(flag_8)
+        RAW_FLAG(flag_9)
+        RAW_FLAG(flag_10)
+        RAW_FLAG(flag_11)
+        RAW_FLAG(flag_12)
+        RAW_FLAG(flag_13)
+        RAW_FLAG(flag_14)
+        RAW_FLAG(flag_15)
+        RAW_FLAG(flag_16)
+        RAW_FLAG(flag_17)
+        RAW_FLAG(flag_18)
+        RAW_FLAG(flag_19)
+    END_RAW_BITFLAGS(Flags32)
+
+    DEFINE_FLAG(Flags32, none)
+
+    BEGIN_RAW_BITFLAGS(Flags64)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_0)
+        RAW_FLAG(flag_1)
+        RAW_FLAG(flag_2)
+        RAW_FLAG(flag_3)
+        RAW_FLAG(flag_4)
+        RAW_FLAG(flag_5)
+        RAW_FLAG(flag_6)
+        RAW_FLAG(flag_7)
+        RAW_FLAG(flag_8)
+        RAW_FLAG(flag_9)
+        RAW_FLAG(flag_10)
+        RAW_FLAG(flag_11)
+        RAW_FLAG(flag_12)
+        RAW_FLAG(flag_13)
+        RAW_FLAG(flag_14)
+        RAW_FLAG(flag_15)
+        RAW_FLAG(flag_16)
+        RAW_FLAG(flag_17)
+        RAW_FLAG(flag_18)
+        RAW_FLAG(flag_19)
+        RAW_FLAG(flag_20)
+        RAW_FLAG(flag_21)
+        RAW_FLAG(flag_22)
+        RAW_FLAG(flag_23)
+        RAW_FLAG(flag_24)
+        RAW_FLAG(flag_25)
+        RAW_FLAG(flag_26)
+        RAW_FLAG(flag_27)
+        RAW_FLAG(flag_28)
+        RAW_FLAG(flag_29)
+        RAW_FLAG(flag_30)
+        RAW_FLAG(flag_31)
+        RAW_FLAG(flag_32)
+        RAW_FLAG(flag_33)
+        RAW_FLAG(flag_34)
+        RAW_FLAG(flag_35)
+        RAW_FLAG(flag_36)
+        RAW_FLAG(flag_37)
+        RAW_FLAG(flag_38)
+        RAW_FLAG(flag_39)
+    END_RAW_BITFLAGS(Flags64)
+
+    DEFINE_FLAG(Flags64, none)
+    DEFINE_FLAG(Flags64, flag_0)
+    DEFINE_FLAG(Flags64, flag_39)
+
+    template <typename BitflagsT>
+    std::vector<BitflagsT> random_flags(std::size_t const count, std::uint64_t const distinct, int const width, std::uint32_t const seed) {
+        std::mt19937_64 generator(seed);
+        std::vector<typename BitflagsT::underlying_type> values(distinct);
+        for (auto& value : values) {
+            value = static_cast<typename BitflagsT::underlying_type>(generator() & ((std::uint64_t{1} << width) - 1));
+        }
+
+        // skewed towards the first values
+        std::vector<BitflagsT> flags;
+        flags.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            std::uint64_t const r = generator() % distinct;
+            flags.emplace_back(values[(r * r) / distinct]);
+        }
+        return flags;
+    }
+
+} // namespace
+
+TEST(FrequencyTest, ExactDense) {
+    bf::frequency_tracker<RawFlags> tracker;
+    EXPECT_TRUE(tracker.is_exact);
+
+    tracker.add(RawFlags::flag_a);
+    tracker.add(RawFlags::flag_a | RawFlags::flag_b, 3);
+    tracker.add(RawFlags::flag_a);
+    tracker.add(RawFlags::none);
+
+    EXPECT_EQ(6U, tracker.total());
+    EXPECT_EQ(2U, tracker.count(RawFlags::flag_a));
+    EXPECT_EQ(3U, tracker.count(RawFlags::flag_a | RawFlags::flag_b));
+    EXPECT_EQ(1U, tracker.count(RawFlags::none));
+    EXPECT_EQ(0U, tracker.count(RawFlags::flag_c));
+
+    auto const top = tracker.top(2);
+    ASSERT_EQ(2U, top.size());
+    EXPECT_EQ(RawFlags(RawFlags::flag_a | RawFlags::flag_b), top[0].flags);
+    EXPECT_EQ(3U, top[0].count);
+    EXPECT_EQ(0U, top[0].error);
+    EXPECT_EQ(RawFlags(RawFlags::flag_a), top[1].flags);
+    EXPECT_EQ(2U, top[1].count);
+    EXPECT_EQ(3U, tracker.top(10).size());
+
+    tracker.clear();
+    EXPECT_EQ(0U, tracker.total());
+    EXPECT_EQ(0U, tracker.count(RawFlags::flag_a));
+    EXPECT_TRUE(tracker.top(10).empty());
+}
+
+TEST(FrequencyTest, WideWithinMemory) {
+    // wider than the dense storage, so counted by the sketch
+    auto const flags = random_flags<Flags32>(50000, 2000, 20, 1);
+
+    bf::frequency_tracker<Flags32> tracker;
+    EXPECT_FALSE(tracker.is_exact);
+    tracker.add(flags.begin(), flags.end());
+
+    std::map<std::uint32_t, std::uint64_t> expected;
+    for (auto const& f : flags) {
+        ++expected[f.bits()];
+    }
+
+    EXPECT_EQ(flags.size(), tracker.total());
+    for (auto const& e : expected) {
+        EXPECT_GE(tracker.count(Flags32(e.first)), e.second);
+    }
+
+    auto const top = tracker.top(20);
+    ASSERT_EQ(20U, top.size());
+    for (std::size_t i = 0; i < top.size(); ++i) {
+        std::uint64_t const count = expected[top[i].flags.bits()];
+        EXPECT_LE(count, top[i].count);
+        EXPECT_GE(count, top[i].count - top[i].error);
+        if (i > 0) {
+            EXPECT_GE(top[i - 1].count, top[i].count);
+        }
+    }
+
+    std::uint64_t max_count = 0;
+    for (auto const& e : expected) {
+        max_count = std::max(max_count, e.second);
+    }
+    EXPECT_EQ(max_count, expected[top[0].flags.bits()]);
+}
+
+TEST(FrequencyTest, Sketch) {
+    // ten heavy hitters among uniformly distributed sets
+    std::vector<Flags64> flags;
+    auto const noise = random_flags<Flags64>(100000, 20000, 40, 3);
+    for (std::uint64_t i = 0; i < 10; ++i) {
+        flags.insert(flags.end(), 10000 - 800 * i, Flags64((i + 1) << 32));
+    }
+    flags.insert(flags.end(), noise.begin(), noise.end());
+    std::shuffle(flags.begin(), flags.end(), std::mt19937(4));
+
+    bf::frequency_tracker<Flags64> tracker(64 * 1024, 64);
+    EXPECT_FALSE(tracker.is_exact);
+    tracker.add(flags.begin(), flags.end());
+
+    std::map<std::uint64_t, std::uint64_t> expected;
+    for (auto const& f : flags) {
+        ++expected[f.bits()];
+    }
+
+    // never underestimates
+    EXPECT_EQ(flags.size(), tracker.total());
+    for (auto const& e : expected) {
+        ASSERT_GE(tracker.count(Flags64(e.first)), e.second);
+    }
+
+    // true counts lie within the reported bounds
+    auto const top = tracker.top(64);
+    ASSERT_EQ(64U, top.size());
+    for (auto const& f : top) {
+        std::uint64_t const count = expected[f.flags.bits()];
+        EXPECT_LE(count, f.count);
+        EXPECT_GE(count, f.count - f.error);
+    }
+
+    // every set occurring more than total / heavy hitters times is kept
+    std::vector<std::uint64_t> reported;
+    for (auto const& f : top) {
+        reported.push_back(f.flags.bits());
+    }
+    for (auto const& e : expected) {
+        if (e.second > flags.size() / 64) {
+            EXPECT_NE(reported.end(), std::find(reported.begin(), reported.end(), e.first)) << e.first;
+        }
+    }
+
+    // the most frequent sets are ranked first
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> ranked;
+    for (auto const& e : expected) {
+        ranked.emplace_back(e.second, e.first);
+    }
+    std::sort(ranked.rbegin(), ranked.rend());
+    auto const top3 = tracker.top(3);
+    for (std::size_t i = 0; i < top3.size(); ++i) {
+        EXPECT_EQ(ranked[i].second, top3[i].flags.bits());
+    }
+
+    tracker.clear();
+    EXPECT_EQ(0U, tracker.total());
+    EXPECT_EQ(0U, tracker.count(Flags64::flag_0));
+    EXPECT_TRUE(tracker.top(10).empty());
+}
+
+TEST(FrequencyTest, SketchMemoryBound) {
+    bf::frequency_tracker<Flags64> tracker(0, 4);
+    for (std::uint64_t i = 0; i < 1000; ++i) {
+        tracker.add(Flags64(i));
+        tracker.add(Flags64::flag_0 | Flags64::flag_39);
+    }
+
+    EXPECT_EQ(2000U, tracker.total());
+    EXPECT_LE(tracker.top(10).size(), 4U);
+    EXPECT_EQ(Flags64(Flags64::flag_0 | Flags64::flag_39), tracker.top(1)[0].flags);
+    EXPECT_GE(tracker.count(Flags64::flag_0 | Flags64::flag_39), 1000U);
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <bitflags/hybrid_flags.hpp>
+
+namespace
+{
+
+    using flags_type = bf::hybrid_flags<4096, 8>;
+
+    std::vector<std::size_t> bits_of(flags_type const& flags) {
+        std::vector<std::size_t> bits;
+        flags.for_each_bit([&bits](std::size_t const bit) { bits.push_back(bit); });
+        return bits;
+    }
+
+    flags_type range(std::size_t const first, std::size_t const last) {
+        flags_type flags;
+        for (std::size_t bit = first; bit <= last; ++bit) {
+            flags.set(bit);
+        }
+        return flags;
+    }
+
+} // namespace
+
+static_assert(flags_type::words_count == 64, "");
+static_assert(flags_type::max_runs == 32, "");
+
+TEST(HybridFlagsTest, Sparse) {
+    flags_type flags{ 4000, 7, 300 };
+    EXPECT_EQ(flags.kind(), bf::representation::sparse);
+    EXPECT_EQ(flags.size(), 3u);
+    EXPECT_TRUE(flags.contains(7));
+    EXPECT_TRUE(flags.contains(4000));
+    EXPECT_FALSE(flags.contains(8));
+    EXPECT_EQ(bits_of(flags), (std::vector<std::size_t>{ 7, 300, 4000 }));
+
+    flags.set(7);
+    EXPECT_EQ(flags.size(), 3u);
+    flags.remove(300);
+    flags.remove(301);
+    EXPECT_EQ(bits_of(flags), (std::vector<std::size_t>{ 7, 4000 }));
+
+    flags.clear();
+    EXPECT_TRUE(flags.is_empty());
+    EXPECT_FALSE(flags.contains(7));
+}
+
+TEST(HybridFlagsTest, SwitchesRepresentation) {
+    // beyond inline capacity, a few runs stay in run form
+    flags_type flags = range(100, 199);
+    EXPECT_EQ(flags.kind(), bf::representation::runs);
+    EXPECT_EQ(flags.size(), 100u);
+    EXPECT_TRUE(flags.contains(100));
+    EXPECT_TRUE(flags.contains(199));
+    EXPECT_FALSE(flags.contains(99));
+    EXPECT_FALSE(flags.contains(200));
+
+    // splitting runs until there are too many of them
+    for (std::size_t bit = 101; bit < 199; bit += 2) {
+        flags.remove(bit);
+    }
+    EXPECT_EQ(flags.kind(), bf::representation::dense);
+    EXPECT_EQ(flags.size(), 51u);
+    EXPECT_TRUE(flags.contains(102));
+    EXPECT_FALSE(flags.contains(103));
+
+    // shrinking back to the inline array at half of its capacity
+    for (std::size_t bit = 100; bit < 190; ++bit) {
+        flags.remove(bit);
+    }
+    EXPECT_EQ(flags.kind(), bf::representation::dense);
+    EXPECT_EQ(flags.size(), 6u);
+    flags.remove(190);
+    flags.remove(192);
+    EXPECT_EQ(flags.kind(), bf::representation::sparse);
+    EXPECT_EQ(bits_of(flags), (std::vector<std::size_t>{ 194, 196, 198, 199 }));
+}
+
+TEST(HybridFlagsTest, RunEdits) {
+    flags_type flags = range(10, 29);
+    flags.set(31);
+    flags.set(30);
+    flags.set(8);
+    flags.set(9);
+    EXPECT_EQ(flags.kind(), bf::representation::runs);
+    EXPECT_EQ(flags.size(), 24u);
+    EXPECT_EQ(flags, range(8, 31));
+
+    flags.remove(8);
+    flags.remove(31);
+    flags.remove(20);
+    EXPECT_EQ(flags.size(), 21u);
+    EXPECT_FALSE(flags.contains(20));
+    EXPECT_TRUE(flags.contains(19));
+    EXPECT_TRUE(flags.contains(21));
+    EXPECT_EQ(flags, range(9, 19) | range(21, 30));
+}
+
+TEST(HybridFlagsTest, Operators) {
+    flags_type const sparse{ 5, 150, 1000 };
+    flags_type const runs = range(100, 199) | range(900, 1099);
+    flags_type dense;
+    for (std::size_t bit = 0; bit < 4096; bit += 3) {
+        dense.set(bit);
+    }
+    ASSERT_EQ(runs.kind(), bf::representation::runs);
+    ASSERT_EQ(dense.kind(), bf::representation::dense);
+
+    EXPECT_EQ(bits_of(sparse & runs), (std::vector<std::size_t>{ 150, 1000 }));
+    EXPECT_EQ(bits_of(runs & sparse), (std::vector<std::size_t>{ 150, 1000 }));
+    EXPECT_EQ((sparse & runs).kind(), bf::representation::sparse);
+    EXPECT_EQ(bits_of(sparse & dense), (std::vector<std::size_t>{ 150 }));
+
+    flags_type const both = runs & dense;
+    EXPECT_EQ(both.size(), 33u + 67u);
+    EXPECT_TRUE(both.contains(102));
+    EXPECT_FALSE(both.contains(101));
+
+    EXPECT_EQ((sparse | runs).size(), 301u);
+    EXPECT_EQ((runs | sparse), (sparse | runs));
+    EXPECT_EQ((runs | range(200, 899)), range(100, 1099));
+    EXPECT_EQ((runs | range(200, 899)).kind(), bf::representation::runs);
+    EXPECT_EQ((runs & range(150, 949)), range(150, 199) | range(900, 949));
+    EXPECT_EQ((dense | sparse).size(), dense.size() + 2);
+    EXPECT_EQ((dense | runs) & runs, runs);
+
+    EXPECT_TRUE((sparse & flags_type{ 6 }).is_empty());
+    EXPECT_NE(sparse, runs);
+}
+
+TEST(HybridFlagsTest, RandomizedAgainstSet) {
+    std::mt19937 gen(7);
+    for (std::size_t max : { 16u, 200u, 4096u }) {
+        std::uniform_int_distribution<std::size_t> dist(0, max - 1);
+        flags_type flags;
+        flags_type other;
+        std::set<std::size_t> expected;
+        std::set<std::size_t> expected_other;
+
+        for (int i = 0; i < 3000; ++i) {
+            std::size_t const bit = dist(gen);
+            if (gen() % 3 == 0) {
+                flags.remove(bit);
+                expected.erase(bit);
+            } else {
+                flags.set(bit);
+                expected.insert(bit);
+            }
+            if (gen() % 2 == 0) {
+                other.set(bit / 2);
+                expected_other.insert(bit / 2);
+            }
+            ASSERT_EQ(flags.size(), expected.size());
+        }
+
+        EXPECT_EQ(bits_of(flags), std::vector<std::size_t>(expected.begin(), expected.end()));
+
+        std::vector<std::size_t> united;
+        std::set_union(expected.begin(), expected.end(), expected_other.begin(), expected_other.end(), std::back_inserter(united));
+        EXPECT_EQ(bits_of(flags | other), united);
+
+        std::vector<std::size_t> intersected;
+        std::set_intersection(expected.begin(), expected.end(), expected_other.begin(), expected_other.end(), std::back_inserter(intersected));
+        EXPECT_EQ(bits_of(flags & other), intersected);
+    }
+}
+
+TEST(HybridFlagsTest, RuntimeFlags) {
+    bf::flag_registry<4096> registry;
+    auto const alpha = registry.add("alpha");
+    auto const beta = registry.add("beta");
+
+    flags_type flags;
+    flags.set(beta);
+    flags.set(bf::dynamic_flag<4096>());
+    EXPECT_EQ(flags.size(), 1u);
+    EXPECT_TRUE(flags.contains(beta));
+    EXPECT_FALSE(flags.contains(alpha));
+    EXPECT_TRUE(flags.contains(bf::dynamic_flag<4096>()));
+
+    flags_type const from_dynamic(alpha | beta);
+    EXPECT_EQ(bits_of(from_dynamic), (std::vector<std::size_t>{ 0, 1 }));
+
+    flags.remove(beta);
+    EXPECT_TRUE(flags.is_empty());
+}
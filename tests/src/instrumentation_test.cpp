@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <sstream>
+#include <thread>
+#include <type_traits>
+
+#include <gtest/gtest.h>
+#include <bitflags/instrumentation.hpp>
+
+namespace
+{
+
+    BEGIN_RAW_BITFLAGS(RawFlags)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_a)
+        RAW_FLAG(flag_b)
+        RAW_FLAG(flag_c)
+    END_RAW_BITFLAGS(RawFlags)
+
+    DEFINE_FLAG(RawFlags, none)
+    DEFINE_FLAG(RawFlags, flag_a)
+    DEFINE_FLAG(RawFlags, flag_b)
+    DEFINE_FLAG(RawFlags, flag_c)
+
+    BEGIN_BITFLAGS(Flags)
+        FLAG(none)
+        FLAG(flag_a)
+        FLAG(flag_b)
+        FLAG(flag_c)
+    END_BITFLAGS(Flags)
+
+    DEFINE_FLAG(Flags, none)
+    DEFINE_FLAG(Flags, flag_a)
+    DEFINE_FLAG(Flags, flag_b)
+    DEFINE_FLAG(Flags, flag_c)
+
+} // namespace
+
+TEST(InstrumentationTest, DefaultPolicy) {
+    static_assert(std::is_same<RawFlags::policy_type, bf::no_instrumentation>::value, "RawFlags should not be instrumented");
+    static_assert(std::is_same<Flags::policy_type, bf::no_instrumentation>::value, "Flags should not be instrumented");
+
+    static_assert(std::is_same<bf::instrumented<Flags>::policy_type, bf::flag_counters>::value, "Flags should be instrumented");
+    static_assert(std::is_same<bf::instrumented<Flags>::flag_type, Flags::flag_type>::value, "Flags should share flag type");
+
+    static_assert(sizeof(bf::instrumented<RawFlags>) == sizeof(RawFlags), "instrumentation should not change the size");
+}
+
+TEST(InstrumentationTest, Counts) {
+    // raw flags (without string representation)
+    bf::reset_flag_counts<RawFlags>();
+
+    bf::instrumented<RawFlags> raw_flags;
+    raw_flags.set(RawFlags::flag_a);
+    raw_flags.set(RawFlags::flag_b | RawFlags::flag_c);
+    raw_flags.remove(RawFlags::flag_b);
+    raw_flags.toggle(RawFlags::flag_c);
+    raw_flags.toggle(RawFlags::flag_c);
+    EXPECT_TRUE(raw_flags.contains(RawFlags::flag_a));
+    EXPECT_TRUE(raw_flags.contains(RawFlags::none));
+
+    auto const raw_counts = bf::flag_counts<RawFlags>();
+    ASSERT_EQ(3U, raw_counts.size());
+
+    EXPECT_EQ(RawFlags::flag_a, raw_counts[0].flag);
+    EXPECT_EQ(1U, raw_counts[0].set);
+    EXPECT_EQ(0U, raw_counts[0].remove);
+    EXPECT_EQ(0U, raw_counts[0].toggle);
+    EXPECT_EQ(1U, raw_counts[0].contains);
+
+    EXPECT_EQ(RawFlags::flag_b, raw_counts[1].flag);
+    EXPECT_EQ(1U, raw_counts[1].set);
+    EXPECT_EQ(1U, raw_counts[1].remove);
+    EXPECT_EQ(0U, raw_counts[1].toggle);
+    EXPECT_EQ(0U, raw_counts[1].contains);
+
+    EXPECT_EQ(RawFlags::flag_c, raw_counts[2].flag);
+    EXPECT_EQ(1U, raw_counts[2].set);
+    EXPECT_EQ(0U, raw_counts[2].remove);
+    EXPECT_EQ(2U, raw_counts[2].toggle);
+    EXPECT_EQ(0U, raw_counts[2].contains);
+
+    // not instrumented flags don't count
+    RawFlags plain_flags;
+    plain_flags.set(RawFlags::flag_a);
+    EXPECT_EQ(1U, bf::flag_counts<RawFlags>()[0].set);
+
+    bf::reset_flag_counts<RawFlags>();
+    EXPECT_EQ(0U, bf::flag_counts<RawFlags>()[0].set);
+
+    // flags (with string representation)
+    bf::reset_flag_counts<Flags>();
+
+    bf::instrumented<Flags> flags;
+    flags.set(Flags::flag_b);
+    EXPECT_FALSE(flags.contains(Flags::flag_c));
+
+    auto const counts = bf::flag_counts<Flags>();
+    ASSERT_EQ(3U, counts.size());
+    EXPECT_EQ(1U, counts[1].set);
+    EXPECT_EQ(1U, counts[2].contains);
+}
+
+TEST(InstrumentationTest, Threads) {
+    bf::reset_flag_counts<RawFlags>();
+
+    auto const work = [] {
+        bf::instrumented<RawFlags> flags;
+        for (int i = 0; i < 1000; ++i) {
+            flags.toggle(RawFlags::flag_b);
+        }
+    };
+
+    std::thread first(work);
+    std::thread second(work);
+    first.join();
+    second.join();
+
+    // counts of exited threads are kept
+    EXPECT_EQ(2000U, bf::flag_counts<RawFlags>()[1].toggle);
+
+    work();
+    EXPECT_EQ(3000U, bf::flag_counts<RawFlags>()[1].toggle);
+}
+
+TEST(InstrumentationTest, Dump) {
+    bf::reset_flag_counts<Flags>();
+
+    bf::instrumented<Flags> flags;
+    flags.set(Flags::flag_a);
+    flags.set(Flags::flag_a);
+    flags.remove(Flags::flag_c);
+
+    std::ostringstream os;
+    bf::dump_flag_counts<Flags>(os);
+
+    EXPECT_EQ(
+        "flag_a: set=2 remove=0 toggle=0 contains=0\n"
+        "flag_b: set=0 remove=0 toggle=0 contains=0\n"
+        "flag_c: set=0 remove=1 toggle=0 contains=0\n",
+        os.str()
+    );
+
+    std::ostringstream raw_os;
+    bf::dump_flag_counts<RawFlags>(raw_os);
+    EXPECT_EQ(0U, raw_os.str().find("bit 0: "));
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <bitflags/mask_matcher.hpp>
+
+namespace
+{
+
+    BEGIN_RAW_BITFLAGS(RawFlags)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_a)
+        RAW_FLAG(flag_b)
+        RAW_FLAG(flag_c)
+    END_RAW_BITFLAGS(RawFlags)
+
+    DEFINE_FLAG(RawFlags, none)
+    DEFINE_FLAG(RawFlags, flag_a)
+    DEFINE_FLAG(RawFlags, flag_b)
+    DEFINE_FLAG(RawFlags, flag_c)
+
+    BEGIN_BITFLAGS(Flags)
+        FLAG(none)
+        FLAG(flag_a)
+        FLAG(flag_b)
+        FLAG(flag_c)
+    END_BITFLAGS(Flags)
+
+    DEFINE_FLAG(Flags, none)
+    DEFINE_FLAG(Flags, flag_a)
+    DEFINE_FLAG(Flags, flag_b)
+    DEFINE_FLAG(Flags, flag_c)
+
+    template <typename BitflagsT>
+    std::vector<std::size_t> match(bf::mask_matcher<BitflagsT> const& matcher, BitflagsT const& flags) {
+        std::vector<std::size_t> ids;
+        matcher.match(flags, ids);
+        return ids;
+    }
+
+} // namespace
+
+TEST(MaskMatcherTest, Match) {
+    // raw flags (without string representation)
+    bf::mask_matcher<RawFlags> raw_matcher;
+
+    std::size_t const any = raw_matcher.add(RawFlags::none, RawFlags::none);
+    std::size_t const a = raw_matcher.add(RawFlags::flag_a, RawFlags::none);
+    std::size_t const a_not_b = raw_matcher.add(RawFlags::flag_a, RawFlags::flag_b);
+    std::size_t const b_c = raw_matcher.add(RawFlags::flag_b | RawFlags::flag_c, RawFlags::none);
+
+    EXPECT_EQ(4U, raw_matcher.size());
+
+    EXPECT_EQ(std::vector<std::size_t>({ any }), match<RawFlags>(raw_matcher, RawFlags::none));
+    EXPECT_EQ(std::vector<std::size_t>({ any, a, a_not_b }), match<RawFlags>(raw_matcher, RawFlags::flag_a));
+    EXPECT_EQ(std::vector<std::size_t>({ any, a }), match<RawFlags>(raw_matcher, RawFlags::flag_a | RawFlags::flag_b));
+    EXPECT_EQ(std::vector<std::size_t>({ any, b_c }), match<RawFlags>(raw_matcher, RawFlags::flag_b | RawFlags::flag_c));
+    EXPECT_EQ(std::vector<std::size_t>({ any, a, b_c }), match<RawFlags>(raw_matcher, RawFlags::all()));
+
+    // flags (with string representation)
+    bf::mask_matcher<Flags> matcher;
+
+    std::size_t const not_c = matcher.add(Flags::none, Flags::flag_c);
+
+    EXPECT_EQ(std::vector<std::size_t>({ not_c }), match<Flags>(matcher, Flags::flag_a | Flags::flag_b));
+    EXPECT_TRUE(match<Flags>(matcher, Flags::flag_c).empty());
+}
+
+TEST(MaskMatcherTest, UpdateAndRemove) {
+    bf::mask_matcher<RawFlags> matcher;
+
+    std::size_t const first = matcher.add(RawFlags::flag_a, RawFlags::none);
+    std::size_t const second = matcher.add(RawFlags::flag_b, RawFlags::none);
+
+    EXPECT_TRUE(matcher.update(first, RawFlags::flag_c, RawFlags::flag_b));
+
+    EXPECT_TRUE(match<RawFlags>(matcher, RawFlags::flag_a).empty());
+    EXPECT_EQ(std::vector<std::size_t>({ first }), match<RawFlags>(matcher, RawFlags::flag_c));
+    EXPECT_EQ(std::vector<std::size_t>({ second }), match<RawFlags>(matcher, RawFlags::flag_b | RawFlags::flag_c));
+
+    EXPECT_TRUE(matcher.remove(second));
+
+    EXPECT_EQ(1U, matcher.size());
+    EXPECT_TRUE(match<RawFlags>(matcher, RawFlags::flag_b).empty());
+
+    // identifier of the removed pair is reused
+    EXPECT_EQ(second, matcher.add(RawFlags::none, RawFlags::none));
+    EXPECT_EQ(std::vector<std::size_t>({ second }), match<RawFlags>(matcher, RawFlags::flag_b));
+
+    matcher.clear();
+
+    EXPECT_TRUE(matcher.empty());
+    EXPECT_TRUE(match<RawFlags>(matcher, RawFlags::flag_b).empty());
+}
+
+TEST(MaskMatcherTest, UsedBits) {
+    bf::mask_matcher<RawFlags> matcher;
+    EXPECT_EQ(0U, matcher.used_bits());
+
+    std::size_t const first = matcher.add(RawFlags::flag_a, RawFlags::flag_b);
+    std::size_t const second = matcher.add(RawFlags::flag_a, RawFlags::none);
+    EXPECT_EQ(std::uint64_t{RawFlags(RawFlags::flag_a | RawFlags::flag_b).bits()}, matcher.used_bits());
+
+    // bits no longer referenced by any pair are not scanned any more
+    EXPECT_TRUE(matcher.update(first, RawFlags::flag_c, RawFlags::none));
+    EXPECT_EQ(std::uint64_t{RawFlags(RawFlags::flag_a | RawFlags::flag_c).bits()}, matcher.used_bits());
+
+    EXPECT_TRUE(matcher.remove(second));
+    EXPECT_EQ(std::uint64_t{RawFlags::flag_c.bits}, matcher.used_bits());
+
+    matcher.clear();
+    EXPECT_EQ(0U, matcher.used_bits());
+}
+
+TEST(MaskMatcherTest, RemoveUnregistered) {
+    bf::mask_matcher<RawFlags> matcher;
+
+    std::size_t const first = matcher.add(RawFlags::flag_a, RawFlags::none);
+    std::size_t const second = matcher.add(RawFlags::flag_b, RawFlags::none);
+
+    // removing the pair twice does not free its identifier twice
+    EXPECT_TRUE(matcher.remove(second));
+    EXPECT_FALSE(matcher.remove(second));
+    EXPECT_FALSE(matcher.remove(second + 100));
+    EXPECT_EQ(1U, matcher.size());
+
+    // unregistered pairs are not updated
+    EXPECT_FALSE(matcher.update(second, RawFlags::flag_c, RawFlags::none));
+    EXPECT_FALSE(matcher.update(second + 100, RawFlags::flag_c, RawFlags::none));
+    EXPECT_TRUE(match<RawFlags>(matcher, RawFlags::flag_b).empty());
+
+    std::size_t const third = matcher.add(RawFlags::flag_c, RawFlags::none);
+    std::size_t const fourth = matcher.add(RawFlags::flag_b, RawFlags::none);
+    EXPECT_EQ(second, third);
+    EXPECT_NE(third, fourth);
+    EXPECT_NE(first, fourth);
+    EXPECT_EQ(3U, matcher.size());
+    EXPECT_EQ(std::vector<std::size_t>({ third }), match<RawFlags>(matcher, RawFlags::flag_c));
+    EXPECT_EQ(std::vector<std::size_t>({ fourth }), match<RawFlags>(matcher, RawFlags::flag_b));
+}
+
+TEST(MaskMatcherTest, ManyPairs) {
+    bf::mask_matcher<RawFlags> matcher;
+
+    for (std::size_t i = 0; i < 1000; ++i) {
+        RawFlags::underlying_type const required = static_cast<RawFlags::underlying_type>(i % 8);
+        RawFlags::underlying_type const forbidden = static_cast<RawFlags::underlying_type>((i / 8) % 8 & ~required);
+        matcher.add(required, forbidden);
+    }
+
+    for (unsigned value = 0; value < 8; ++value) {
+        std::vector<std::size_t> expected;
+        for (std::size_t i = 0; i < 1000; ++i) {
+            unsigned const required = i % 8;
+            unsigned const forbidden = (i / 8) % 8 & ~required;
+            if ((value & required) == required && !(value & forbidden)) {
+                expected.push_back(i);
+            }
+        }
+
+        EXPECT_EQ(expected, match<RawFlags>(matcher, static_cast<RawFlags::underlying_type>(value)));
+    }
+}
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <bitflags/partition.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+
+    BEGIN_RAW_BITFLAGS(RawFlags)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_a)
+        RAW_FLAG(flag_b)
+        RAW_FLAG(flag_c)
+    END_RAW_BITFLAGS(RawFlags)
+
+    DEFINE_FLAG(RawFlags, none)
+    DEFINE_FLAG(RawFlags, flag_a)
+    DEFINE_FLAG(RawFlags, flag_b)
+    DEFINE_FLAG(RawFlags, flag_c)
+
+    BEGIN_RAW_BITFLAGS(WideFlags)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_0)
+        RAW_FLAG(flag_1)
+        RAW_FLAG(flag_2)
+        RAW_FLAG(flag_3)
+        RAW_FLAG(flag_4)
+        RAW_FLAG(flag_5)
+        RAW_FLAG(flag_6)
+        RAW_FLAG(flag_7)
+        RAW_FLAG(flag_8)
+        RAW_FLAG(flag_9)
+        RAW_FLAG(flag_10)
+        RAW_FLAG(flag_11)
+        RAW_FLAG(flag_12)
+    END_RAW_BITFLAGS(WideFlags)
+
+    DEFINE_FLAG(WideFlags, none)
+    DEFINE_FLAG(WideFlags, flag_0)
+    DEFINE_FLAG(WideFlags, flag_1)
+    DEFINE_FLAG(WideFlags, flag_2)
+    DEFINE_FLAG(WideFlags, flag_3)
+    DEFINE_FLAG(WideFlags, flag_4)
+    DEFINE_FLAG(WideFlags, flag_5)
+    DEFINE_FLAG(WideFlags, flag_6)
+    DEFINE_FLAG(WideFlags, flag_7)
+    DEFINE_FLAG(WideFlags, flag_8)
+    DEFINE_FLAG(WideFlags, flag_9)
+    DEFINE_FLAG(WideFlags, flag_10)
+    DEFINE_FLAG(WideFlags, flag_11)
+    DEFINE_FLAG(WideFlags, flag_12)
+
+    template <typename BitflagsT>
+    struct record {
+        BitflagsT flags;
+        std::uint32_t id;
+    };
+
+    struct flags_of {
+        template <typename BitflagsT>
+        BitflagsT const& operator()(record<BitflagsT> const& r) const { return r.flags; }
+    };
+
+    template <typename BitflagsT>
+    std::vector<record<BitflagsT>> generate(std::size_t const count) {
+        using underlying_type = typename BitflagsT::underlying_type;
+
+        std::vector<record<BitflagsT>> records(count);
+        std::uint32_t state = 12345;
+        for (std::size_t i = 0; i < count; ++i) {
+            state = state * 1664525U + 1013904223U;
+            records[i].flags = BitflagsT(static_cast<underlying_type>(state >> 16));
+            records[i].id = static_cast<std::uint32_t>(i);
+        }
+        return records;
+    }
+
+    // reference: records stably sorted by the selected bits
+    template <typename BitflagsT>
+    std::vector<record<BitflagsT>> expected(std::vector<record<BitflagsT>> records, typename BitflagsT::underlying_type const mask) {
+        std::stable_sort(records.begin(), records.end(), [mask](record<BitflagsT> const& lhs, record<BitflagsT> const& rhs) {
+            return (lhs.flags.bits() & mask) < (rhs.flags.bits() & mask);
+        });
+        return records;
+    }
+
+    template <typename BitflagsT>
+    void expect_equal_ids(std::vector<record<BitflagsT>> const& lhs, std::vector<record<BitflagsT>> const& rhs) {
+        ASSERT_EQ(lhs.size(), rhs.size());
+        for (std::size_t i = 0; i < lhs.size(); ++i) {
+            ASSERT_EQ(lhs[i].id, rhs[i].id) << "at " << i;
+        }
+    }
+
+} // namespace
+
+TEST(PartitionTest, Scatter) {
+    std::vector<RawFlags> flags = {
+        RawFlags::flag_b, RawFlags::flag_a, RawFlags::none, RawFlags::flag_a | RawFlags::flag_b,
+        RawFlags::flag_a, RawFlags::flag_c, RawFlags::flag_b, RawFlags::none
+    };
+    std::vector<RawFlags> out(flags.size());
+
+    bf::radix_partition<RawFlags> partition;
+    EXPECT_EQ(3, partition.key_bits);
+    EXPECT_EQ(8U, partition.buckets_count);
+    EXPECT_EQ(1, partition.passes_count);
+
+    partition.scatter(flags.data(), flags.size(), out.data());
+
+    std::vector<RawFlags> sorted = flags;
+    std::stable_sort(sorted.begin(), sorted.end(), [](RawFlags const& lhs, RawFlags const& rhs) {
+        return lhs.bits() < rhs.bits();
+    });
+    EXPECT_EQ(sorted, out);
+
+    auto const& groups = partition.groups();
+    ASSERT_EQ(5U, groups.size());
+    EXPECT_EQ(RawFlags(RawFlags::none), groups[0].flags);
+    EXPECT_EQ(0U, groups[0].first);
+    EXPECT_EQ(2U, groups[0].last);
+    EXPECT_EQ(RawFlags(RawFlags::flag_a), groups[1].flags);
+    EXPECT_EQ(RawFlags(RawFlags::flag_b), groups[2].flags);
+    EXPECT_EQ(RawFlags(RawFlags::flag_a | RawFlags::flag_b), groups[3].flags);
+    EXPECT_EQ(RawFlags(RawFlags::flag_c), groups[4].flags);
+    EXPECT_EQ(7U, groups[4].first);
+    EXPECT_EQ(8U, groups[4].last);
+}
+
+TEST(PartitionTest, Permutation) {
+    auto const records = generate<RawFlags>(1000);
+    std::vector<std::uint32_t> perm(records.size());
+
+    bf::radix_partition<RawFlags> partition;
+    partition.permutation(records.data(), records.size(), flags_of{}, perm.data());
+
+    std::vector<record<RawFlags>> permuted;
+    for (auto const i : perm) {
+        permuted.push_back(records[i]);
+    }
+    expect_equal_ids(expected(records, 0x07), permuted);
+
+    std::size_t total = 0;
+    for (auto const& group : partition.groups()) {
+        EXPECT_LT(group.first, group.last);
+        for (std::size_t i = group.first; i < group.last; ++i) {
+            EXPECT_EQ(group.flags.bits(), permuted[i].flags.bits() & 0x07);
+        }
+        total += group.last - group.first;
+    }
+    EXPECT_EQ(records.size(), total);
+}
+
+TEST(PartitionTest, SelectedFlags) {
+    // scattered flags, keyed by the compressed bits
+    using partition_type = bf::radix_partition<WideFlags, 0x0AAA | 0x1001>;
+    EXPECT_EQ(8, partition_type::key_bits);
+
+    auto const records = generate<WideFlags>(5000);
+    std::vector<record<WideFlags>> out(records.size());
+
+    partition_type partition;
+    partition.scatter(records.data(), records.size(), flags_of{}, out.data());
+    expect_equal_ids(expected(records, 0x0AAA | 0x1001), out);
+
+    EXPECT_EQ(256U, partition.groups().size());
+    for (auto const& group : partition.groups()) {
+        EXPECT_EQ(0, group.flags.bits() & ~(0x0AAA | 0x1001));
+        for (std::size_t i = group.first; i < group.last; ++i) {
+            EXPECT_EQ(group.flags.bits(), out[i].flags.bits() & (0x0AAA | 0x1001));
+        }
+    }
+}
+
+TEST(PartitionTest, TwoPasses) {
+    bf::radix_partition<WideFlags> partition;
+    EXPECT_EQ(13, partition.key_bits);
+    EXPECT_EQ(2, partition.passes_count);
+
+    auto const records = generate<WideFlags>(20000);
+    std::vector<record<WideFlags>> out(records.size());
+    partition.scatter(records.data(), records.size(), flags_of{}, out.data());
+    expect_equal_ids(expected(records, 0x1FFF), out);
+
+    std::vector<std::uint32_t> perm(records.size());
+    partition.permutation(records.data(), records.size(), flags_of{}, perm.data());
+    for (std::size_t i = 0; i < perm.size(); ++i) {
+        ASSERT_EQ(out[i].id, perm[i]);
+    }
+
+    std::size_t total = 0;
+    for (auto const& group : partition.groups()) {
+        EXPECT_EQ(group.flags.bits(), out[group.first].flags.bits() & 0x1FFF);
+        EXPECT_EQ(group.flags.bits(), out[group.last - 1].flags.bits() & 0x1FFF);
+        total += group.last - group.first;
+    }
+    EXPECT_EQ(records.size(), total);
+}
+
+TEST(PartitionTest, Parallel) {
+    std::size_t const count = 4 * bf::radix_partition<WideFlags>::min_records_per_thread + 123;
+    auto const records = generate<WideFlags>(count);
+
+    std::vector<record<WideFlags>> sequential_out(count);
+    bf::radix_partition<WideFlags, 0x00FF> sequential;
+    sequential.scatter(records.data(), count, flags_of{}, sequential_out.data());
+
+    std::vector<record<WideFlags>> parallel_out(count);
+    bf::radix_partition<WideFlags, 0x00FF> parallel(4);
+    parallel.scatter(records.data(), count, flags_of{}, parallel_out.data());
+    expect_equal_ids(sequential_out, parallel_out);
+    EXPECT_EQ(sequential.groups().size(), parallel.groups().size());
+
+    // two passes
+    std::vector<std::uint32_t> sequential_perm(count);
+    bf::radix_partition<WideFlags> wide_sequential;
+    wide_sequential.permutation(records.data(), count, flags_of{}, sequential_perm.data());
+
+    std::vector<std::uint32_t> parallel_perm(count);
+    bf::radix_partition<WideFlags> wide_parallel(3);
+    wide_parallel.permutation(records.data(), count, flags_of{}, parallel_perm.data());
+    EXPECT_EQ(sequential_perm, parallel_perm);
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <bitflags/predicate.hpp>
+
+namespace
+{
+
+    BEGIN_BITFLAGS(Flags)
+        FLAG(none)
+        FLAG(flag_a)
+        FLAG(flag_b)
+        FLAG(flag_c)
+    END_BITFLAGS(Flags)
+
+    DEFINE_FLAG(Flags, none)
+    DEFINE_FLAG(Flags, flag_a)
+    DEFINE_FLAG(Flags, flag_b)
+    DEFINE_FLAG(Flags, flag_c)
+
+    bool a(unsigned v) { return v & 0x01; }
+    bool b(unsigned v) { return v & 0x02; }
+    bool c(unsigned v) { return v & 0x04; }
+
+} // namespace
+
+TEST(PredicateTest, Evaluate) {
+    bf::predicate<Flags> const p_1("(flag_a & !flag_b) | flag_c");
+    bf::predicate<Flags> const p_2("flag_a && flag_b || !flag_c");
+    bf::predicate<Flags> const p_3("flag_a ^ ~(flag_b | flag_c)");
+    bf::predicate<Flags> const p_4("none & flag_b");
+
+    for (unsigned v = 0; v < 8; ++v) {
+        Flags const flags(static_cast<Flags::underlying_type>(v));
+
+        EXPECT_EQ((a(v) && !b(v)) || c(v), p_1(flags));
+        EXPECT_EQ((a(v) && b(v)) || !c(v), p_2(flags));
+        EXPECT_EQ(a(v) != !(b(v) || c(v)), p_3(flags));
+        EXPECT_EQ(b(v), p_4(flags));
+    }
+}
+
+TEST(PredicateTest, Minimize) {
+    EXPECT_EQ(1U, bf::predicate<Flags>("(flag_a & flag_b) | (flag_a & !flag_b)").size());
+    EXPECT_EQ(2U, bf::predicate<Flags>("(flag_a & !flag_b) | flag_c").size());
+
+    bf::predicate<Flags> const p("flag_a & (flag_b | !flag_b) & !flag_c");
+
+    ASSERT_EQ(1U, p.size());
+    EXPECT_EQ((Flags::flag_a | Flags::flag_c).bits, p.begin()->mask);
+    EXPECT_EQ(Flags::flag_a.bits, p.begin()->value);
+
+    // constants
+    bf::predicate<Flags> const always("flag_a | !flag_a");
+
+    ASSERT_EQ(1U, always.size());
+    EXPECT_EQ(0U, always.begin()->mask);
+    EXPECT_TRUE(always(Flags::none));
+
+    bf::predicate<Flags> const never("flag_a & false");
+
+    EXPECT_EQ(0U, never.size());
+    EXPECT_FALSE(never(Flags::flag_a));
+}
+
+TEST(PredicateTest, InvalidExpression) {
+    EXPECT_THROW(bf::predicate<Flags>("flag_a & flag_d"), std::invalid_argument);
+    EXPECT_THROW(bf::predicate<Flags>("flag_a &"), std::invalid_argument);
+    EXPECT_THROW(bf::predicate<Flags>("(flag_a | flag_b"), std::invalid_argument);
+    EXPECT_THROW(bf::predicate<Flags>("flag_a flag_b"), std::invalid_argument);
+    EXPECT_THROW(bf::predicate<Flags>(""), std::invalid_argument);
+
+    // too many terms
+    EXPECT_THROW((bf::predicate<Flags, 1>("flag_a ^ flag_b")), std::invalid_argument);
+}
+
+TEST(PredicateTest, Batch) {
+    std::vector<Flags> flags;
+    for (unsigned i = 0; i < 1000; ++i) {
+        flags.push_back(static_cast<Flags::underlying_type>(i % 8));
+    }
+
+    bf::predicate<Flags> const p("(flag_a & !flag_b) | flag_c");
+
+    std::unique_ptr<bool[]> results(new bool[flags.size()]);
+    p.evaluate(flags.data(), flags.size(), results.get());
+
+    std::size_t expected = 0;
+    for (std::size_t i = 0; i < flags.size(); ++i) {
+        unsigned const v = flags[i].bits();
+        bool const matched = (a(v) && !b(v)) || c(v);
+        EXPECT_EQ(matched, results[i]);
+        expected += matched;
+    }
+
+    EXPECT_EQ(expected, p.count(flags.data(), flags.size()));
+}
+
+#if __cplusplus >= 201402L
+TEST(PredicateTest, CompileTime) {
+    constexpr bf::predicate<Flags> p("(flag_a & !flag_b) | flag_c");
+
+    static_assert(p.size() == 2, "expression should be minimized into 2 terms");
+    static_assert(p(Flags::flag_a), "flag_a satisfies the expression");
+    static_assert(!p(Flags::flag_a | Flags::flag_b), "flag_a | flag_b does not satisfy the expression");
+
+    EXPECT_TRUE(p(Flags::flag_c));
+}
+#endif
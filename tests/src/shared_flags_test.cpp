@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include <bitflags/shared_flags.hpp>
+
+namespace
+{
+
+    BEGIN_BITFLAGS(Status)
+        FLAG(none)
+        FLAG(ready)
+        FLAG(draining)
+        FLAG(stopped)
+    END_BITFLAGS(Status)
+
+    DEFINE_FLAG(Status, none)
+    DEFINE_FLAG(Status, ready)
+    DEFINE_FLAG(Status, draining)
+    DEFINE_FLAG(Status, stopped)
+
+    BEGIN_BITFLAGS(OtherStatus)
+        FLAG(none)
+        FLAG(ready)
+        FLAG(stopped)
+        FLAG(draining)
+    END_BITFLAGS(OtherStatus)
+
+    DEFINE_FLAG(OtherStatus, none)
+    DEFINE_FLAG(OtherStatus, ready)
+    DEFINE_FLAG(OtherStatus, stopped)
+    DEFINE_FLAG(OtherStatus, draining)
+
+    std::string segment_name(char const* const test) {
+        return "/bitflags_" + std::string(test) + "_" + std::to_string(::getpid());
+    }
+
+    // removes the segment at the end of the test, even if it fails
+    struct segment_guard {
+        std::string name;
+        ~segment_guard() { bf::shared_flags<Status>::unlink(name); }
+    };
+
+} // namespace
+
+TEST(SharedFlagsTest, CreateAndAttach) {
+    segment_guard const guard{ segment_name("attach") };
+
+    auto control = bf::shared_flags<Status>::create(guard.name, 4);
+    EXPECT_TRUE(control.attached());
+    EXPECT_EQ(control.size(), 4u);
+    EXPECT_EQ(control.load(3), Status(Status::none));
+
+    auto worker = bf::shared_flags<Status>::attach(guard.name);
+    EXPECT_EQ(worker.size(), 4u);
+    EXPECT_EQ(worker.names(), (std::vector<std::string>{ "none", "ready", "draining", "stopped" }));
+
+    control.set(1, Status::ready);
+    control.set(1, Status::draining);
+    EXPECT_TRUE(worker.contains(1, Status::ready));
+    EXPECT_TRUE(worker.contains(1, Status::none));
+    EXPECT_FALSE(worker.contains(0, Status::ready));
+
+    EXPECT_EQ(worker.remove(1, Status::draining), Status::ready | Status::draining);
+    EXPECT_EQ(control.load(1), Status(Status::ready));
+    EXPECT_EQ(worker.toggle(2, Status::stopped), Status(Status::none));
+    EXPECT_EQ(control.store(2, Status::ready | Status::draining), Status(Status::stopped));
+    EXPECT_EQ(worker.clear(2), Status::ready | Status::draining);
+    EXPECT_EQ(control.load(2), Status(Status::none));
+
+    worker.detach();
+    EXPECT_FALSE(worker.attached());
+    EXPECT_TRUE(control.contains(1, Status::ready));
+
+    bf::shared_flags<Status> moved(std::move(control));
+    EXPECT_FALSE(control.attached());
+    EXPECT_TRUE(moved.contains(1, Status::ready));
+}
+
+TEST(SharedFlagsTest, Errors) {
+    segment_guard const guard{ segment_name("errors") };
+
+    EXPECT_THROW(bf::shared_flags<Status>::attach(guard.name), std::system_error);
+    EXPECT_THROW(bf::shared_flags<Status>::create(guard.name, 0), std::invalid_argument);
+
+    auto control = bf::shared_flags<Status>::create(guard.name, 1);
+    EXPECT_THROW(bf::shared_flags<Status>::create(guard.name, 1), std::system_error);
+
+    // same underlying type and flag names, but different bits
+    EXPECT_THROW(bf::shared_flags<OtherStatus>::attach(guard.name), std::runtime_error);
+
+    EXPECT_TRUE(bf::shared_flags<Status>::unlink(guard.name));
+    EXPECT_FALSE(bf::shared_flags<Status>::unlink(guard.name));
+    EXPECT_TRUE(control.contains(0, Status::none));
+}
+
+TEST(SharedFlagsTest, WaitForTimeout) {
+    segment_guard const guard{ segment_name("timeout") };
+
+    auto control = bf::shared_flags<Status>::create(guard.name, 1);
+    EXPECT_FALSE(control.wait_for(0, Status::stopped, std::chrono::milliseconds(10)));
+
+    control.set(0, Status::stopped);
+    EXPECT_TRUE(control.wait_for(0, Status::stopped, std::chrono::milliseconds(10)));
+    control.wait(0, Status::stopped);
+}
+
+TEST(SharedFlagsTest, WaitAcrossThreads) {
+    segment_guard const guard{ segment_name("threads") };
+
+    auto control = bf::shared_flags<Status>::create(guard.name, 2);
+    auto worker = bf::shared_flags<Status>::attach(guard.name);
+
+    std::thread waiter([&worker] {
+        worker.wait(1, Status::draining);
+        worker.set(0, Status::stopped);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    control.set(1, Status::ready);
+    control.set(1, Status::draining);
+    EXPECT_TRUE(control.wait_for(0, Status::stopped, std::chrono::seconds(10)));
+    waiter.join();
+}
+
+TEST(SharedFlagsTest, WaitAcrossProcesses) {
+    segment_guard const guard{ segment_name("processes") };
+
+    auto control = bf::shared_flags<Status>::create(guard.name, 1);
+
+    pid_t const pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        auto worker = bf::shared_flags<Status>::attach(guard.name);
+        worker.set(0, Status::ready);
+        bool const drained = worker.wait_for(0, Status::draining, std::chrono::seconds(10));
+        worker.set(0, Status::stopped);
+        ::_exit(drained ? 0 : 1);
+    }
+
+    EXPECT_TRUE(control.wait_for(0, Status::ready, std::chrono::seconds(10)));
+    control.set(0, Status::draining);
+    EXPECT_TRUE(control.wait_for(0, Status::stopped, std::chrono::seconds(10)));
+
+    int status = 0;
+    ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+}
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <bitflags/subsets.hpp>
+
+namespace
+{
+
+    BEGIN_RAW_BITFLAGS(RawFlags)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_a)
+        RAW_FLAG(flag_b)
+        RAW_FLAG(flag_c)
+        RAW_FLAG(flag_d)
+        RAW_FLAG(flag_e)
+    END_RAW_BITFLAGS(RawFlags)
+
+    DEFINE_FLAG(RawFlags, none)
+    DEFINE_FLAG(RawFlags, flag_a)
+    DEFINE_FLAG(RawFlags, flag_b)
+    DEFINE_FLAG(RawFlags, flag_c)
+    DEFINE_FLAG(RawFlags, flag_d)
+    DEFINE_FLAG(RawFlags, flag_e)
+
+    BEGIN_BITFLAGS(Flags)
+        FLAG(none)
+        FLAG(flag_a)
+        FLAG(flag_b)
+        FLAG(flag_c)
+    END_BITFLAGS(Flags)
+
+    DEFINE_FLAG(Flags, none)
+    DEFINE_FLAG(Flags, flag_a)
+    DEFINE_FLAG(Flags, flag_b)
+    DEFINE_FLAG(Flags, flag_c)
+
+    BEGIN_RAW_BITFLAGS(WideFlags)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_0)
+        RAW_FLAG(flag_1)
+        RAW_FLAG(flag_2)
+        RAW_FLAG(flag_3)
+        RAW_FLAG(flag_4)
+        RAW_FLAG(flag_5)
+        RAW_FLAG(flag_6)
+        RAW_FLAG(flag_7)
+        RAW_FLAG(flag_8)
+        RAW_FLAG(flag_9)
+        RAW_FLAG(flag_10)
+        RAW_FLAG(flag_11)
+        RAW_FLAG(flag_12)
+        RAW_FLAG(flag_13)
+        RAW_FLAG(flag_14)
+        RAW_FLAG(flag_15)
+    END_RAW_BITFLAGS(WideFlags)
+
+    template <typename RangeT>
+    std::vector<std::uint64_t> collect(RangeT const& range) {
+        std::vector<std::uint64_t> result;
+        for (auto const& flags : range) {
+            result.push_back(flags.bits());
+        }
+        return result;
+    }
+
+    int popcount(std::uint64_t bits) {
+        int count = 0;
+        for (; bits != 0; bits &= bits - 1) {
+            ++count;
+        }
+        return count;
+    }
+
+} // namespace
+
+TEST(SubsetsTest, Submasks) {
+    RawFlags const mask = RawFlags::flag_a | RawFlags::flag_c | RawFlags::flag_d;
+
+    auto const range = bf::submasks(mask);
+    EXPECT_EQ(8u, range.size());
+
+    std::vector<std::uint64_t> const expected = { 0x00, 0x01, 0x04, 0x05, 0x08, 0x09, 0x0c, 0x0d };
+    EXPECT_EQ(expected, collect(range));
+
+    EXPECT_EQ(std::vector<std::uint64_t>{ 0 }, collect(bf::submasks(RawFlags())));
+}
+
+TEST(SubsetsTest, Supersets) {
+    RawFlags const mask = RawFlags::flag_b;
+    RawFlags const universe = RawFlags::flag_a | RawFlags::flag_b | RawFlags::flag_e;
+
+    auto const range = bf::supersets(mask, universe);
+    EXPECT_EQ(4u, range.size());
+
+    std::vector<std::uint64_t> const expected = { 0x02, 0x03, 0x12, 0x13 };
+    EXPECT_EQ(expected, collect(range));
+}
+
+TEST(SubsetsTest, Combinations) {
+    auto const range = bf::combinations<RawFlags>(2);
+    EXPECT_EQ(10u, range.size());
+
+    auto const combinations = collect(range);
+    ASSERT_EQ(10u, combinations.size());
+    EXPECT_TRUE(std::is_sorted(combinations.begin(), combinations.end()));
+    for (auto const bits : combinations) {
+        EXPECT_EQ(2, popcount(bits));
+        EXPECT_EQ(0u, bits & ~std::uint64_t{0x1f});
+    }
+
+    RawFlags const universe = RawFlags::flag_b | RawFlags::flag_d | RawFlags::flag_e;
+    std::vector<std::uint64_t> const expected = { 0x0a, 0x12, 0x18 };
+    EXPECT_EQ(expected, collect(bf::combinations(universe, 2)));
+
+    EXPECT_EQ(std::vector<std::uint64_t>{ 0 }, collect(bf::combinations(universe, 0)));
+    EXPECT_EQ(std::vector<std::uint64_t>{ 0x1a }, collect(bf::combinations(universe, 3)));
+    EXPECT_TRUE(collect(bf::combinations(universe, 4)).empty());
+}
+
+TEST(SubsetsTest, NamedFlags) {
+    std::vector<std::uint64_t> bits;
+    for (Flags const& flags : bf::submasks(Flags(Flags::flag_a | Flags::flag_b))) {
+        bits.push_back(flags.bits());
+    }
+    std::vector<std::uint64_t> const expected = { 0x0, 0x1, 0x2, 0x3 };
+    EXPECT_EQ(expected, bits);
+}
+
+TEST(SubsetsTest, Split) {
+    RawFlags const mask = RawFlags::flag_a | RawFlags::flag_b | RawFlags::flag_c | RawFlags::flag_e;
+    auto const range = bf::submasks(mask);
+
+    for (std::uint64_t parts = 1; parts <= 20; ++parts) {
+        std::vector<std::uint64_t> joined;
+        for (std::uint64_t part = 0; part < parts; ++part) {
+            auto const bits = collect(range.split(part, parts));
+            joined.insert(joined.end(), bits.begin(), bits.end());
+        }
+        EXPECT_EQ(collect(range), joined);
+    }
+
+    auto const combinations = bf::combinations<RawFlags>(3);
+    for (std::uint64_t parts = 1; parts <= 12; ++parts) {
+        std::vector<std::uint64_t> joined;
+        for (std::uint64_t part = 0; part < parts; ++part) {
+            auto const bits = collect(combinations.split(part, parts));
+            joined.insert(joined.end(), bits.begin(), bits.end());
+        }
+        EXPECT_EQ(collect(combinations), joined);
+    }
+}
+
+TEST(SubsetsTest, ParallelSplit) {
+    auto const range = bf::combinations<WideFlags>(8);
+    EXPECT_EQ(12870u, range.size());
+
+    std::uint64_t const parts = 4;
+    std::vector<std::uint64_t> counts(parts);
+    std::vector<std::uint64_t> sums(parts);
+    std::vector<std::thread> threads;
+    for (std::uint64_t part = 0; part < parts; ++part) {
+        threads.emplace_back([&, part] {
+            for (auto const& flags : range.split(part, parts)) {
+                ++counts[part];
+                sums[part] += flags.bits();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::uint64_t count = 0;
+    std::uint64_t sum = 0;
+    for (auto const& flags : range) {
+        ++count;
+        sum += flags.bits();
+    }
+    EXPECT_EQ(count, counts[0] + counts[1] + counts[2] + counts[3]);
+    EXPECT_EQ(sum, sums[0] + sums[1] + sums[2] + sums[3]);
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2020, Marin Peko
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+#include <bitflags/tracing.hpp>
+
+namespace
+{
+
+    BEGIN_RAW_BITFLAGS(RawFlags)
+        RAW_FLAG(none)
+        RAW_FLAG(flag_a)
+        RAW_FLAG(flag_b)
+        RAW_FLAG(flag_c)
+    END_RAW_BITFLAGS(RawFlags)
+
+    DEFINE_FLAG(RawFlags, none)
+    DEFINE_FLAG(RawFlags, flag_a)
+    DEFINE_FLAG(RawFlags, flag_b)
+    DEFINE_FLAG(RawFlags, flag_c)
+
+    BEGIN_BITFLAGS(Flags)
+        FLAG(none)
+        FLAG(flag_a)
+        FLAG(flag_b)
+        FLAG(flag_c)
+    END_BITFLAGS(Flags)
+
+    DEFINE_FLAG(Flags, none)
+    DEFINE_FLAG(Flags, flag_a)
+    DEFINE_FLAG(Flags, flag_b)
+    DEFINE_FLAG(Flags, flag_c)
+
+} // namespace
+
+TEST(TracingTest, Records) {
+    // raw flags (without string representation)
+    bf::clear_traces<RawFlags>();
+
+    bf::traced<RawFlags> raw_flags;
+    raw_flags.set(RawFlags::flag_a);
+    raw_flags.set(RawFlags::flag_a); // no change, not recorded
+    raw_flags |= RawFlags::flag_c;
+    raw_flags.toggle(RawFlags::flag_a);
+    raw_flags.clear();
+
+    auto const raw_records = bf::trace_records<RawFlags>();
+    ASSERT_EQ(4U, raw_records.size());
+
+    EXPECT_EQ(&raw_flags, raw_records[0].object);
+    EXPECT_EQ(0x00U, raw_records[0].before);
+    EXPECT_EQ(0x01U, raw_records[0].after);
+    EXPECT_EQ(0x01U, raw_records[1].before);
+    EXPECT_EQ(0x05U, raw_records[1].after);
+    EXPECT_EQ(0x05U, raw_records[2].before);
+    EXPECT_EQ(0x04U, raw_records[2].after);
+    EXPECT_EQ(0x04U, raw_records[3].before);
+    EXPECT_EQ(0x00U, raw_records[3].after);
+
+    for (std::size_t i = 1; i < raw_records.size(); ++i) {
+        EXPECT_LE(raw_records[i - 1].timestamp, raw_records[i].timestamp);
+        EXPECT_EQ(raw_records[0].thread, raw_records[i].thread);
+    }
+
+    bf::clear_traces<RawFlags>();
+    EXPECT_TRUE(bf::trace_records<RawFlags>().empty());
+
+    // flags (with string representation)
+    bf::clear_traces<Flags>();
+
+    bf::traced<Flags> flags(Flags::flag_b);
+    flags.remove(Flags::flag_b);
+
+    auto const records = bf::trace_records<Flags>();
+    ASSERT_EQ(1U, records.size());
+    EXPECT_EQ(0x02U, records[0].before);
+    EXPECT_EQ(0x00U, records[0].after);
+}
+
+TEST(TracingTest, Overwrite) {
+    bf::clear_traces<RawFlags>();
+
+    bf::traced<RawFlags> flags;
+    for (std::size_t i = 0; i < BITFLAGS_TRACE_CAPACITY + 10; ++i) {
+        flags.toggle(RawFlags::flag_b);
+    }
+
+    auto const records = bf::trace_records<RawFlags>();
+    ASSERT_EQ(static_cast<std::size_t>(BITFLAGS_TRACE_CAPACITY), records.size());
+
+    // the oldest records have been overwritten
+    EXPECT_EQ(0x00U, records.front().before);
+    EXPECT_EQ(0x02U, records.front().after);
+    EXPECT_EQ(0x02U, records.back().before);
+    EXPECT_EQ(0x00U, records.back().after);
+}
+
+TEST(TracingTest, Threads) {
+    bf::clear_traces<RawFlags>();
+
+    auto const work = [] {
+        bf::traced<RawFlags> flags;
+        for (int i = 0; i < 100; ++i) {
+            flags.toggle(RawFlags::flag_c);
+        }
+    };
+
+    std::thread first(work);
+    std::thread second(work);
+
+    // collecting while other threads are appending is safe
+    std::size_t const collected = bf::trace_records<RawFlags>().size();
+    EXPECT_LE(collected, 200U);
+
+    first.join();
+    second.join();
+
+    // records of exited threads are kept
+    auto const records = bf::trace_records<RawFlags>();
+    ASSERT_EQ(200U, records.size());
+    std::size_t first_thread = 0;
+    for (auto const& record : records) {
+        first_thread += record.thread == records.front().thread;
+    }
+    EXPECT_EQ(100U, first_thread);
+}
+
+TEST(TracingTest, Dump) {
+    bf::clear_traces<Flags>();
+
+    bf::traced<Flags> flags;
+    flags.set(Flags::flag_a | Flags::flag_c);
+    flags = Flags::flag_b;
+
+    std::ostringstream os;
+    bf::dump_traces<Flags>(os);
+
+    std::string const dump = os.str();
+    EXPECT_NE(std::string::npos, dump.find(" +flag_a +flag_c\n"));
+    EXPECT_NE(std::string::npos, dump.find(" +flag_b -flag_a -flag_c\n"));
+    EXPECT_NE(std::string::npos, dump.find(" thread="));
+
+    bf::clear_traces<RawFlags>();
+
+    bf::traced<RawFlags> raw_flags;
+    raw_flags.set(RawFlags::flag_b);
+
+    std::ostringstream raw_os;
+    bf::dump_traces<RawFlags>(raw_os);
+    EXPECT_NE(std::string::npos, raw_os.str().find(" +bit 1\n"));
+}